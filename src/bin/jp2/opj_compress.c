@@ -253,6 +253,8 @@ static void encode_help_display(void) {
     fprintf(stdout,"    Currently supports only RPCL order.\n");
     fprintf(stdout,"-C <comment>\n");
     fprintf(stdout,"    Add <comment> in the comment marker segment.\n");
+    fprintf(stdout,"-threads <num_threads>\n");
+    fprintf(stdout,"    Number of threads to use for encoding.\n");
     /* UniPG>> */
 #ifdef USE_JPWL
     fprintf(stdout,"-W <params>\n");
@@ -469,7 +471,8 @@ static char get_next_file(int imageno,dircnt_t *dirptr,img_fol_t *img_fol, opj_c
 /* ------------------------------------------------------------------------------------ */
 
 static int parse_cmdline_encoder(int argc, char **argv, opj_cparameters_t *parameters,
-                                 img_fol_t *img_fol, raw_cparameters_t *raw_cp, char *indexfilename) {
+                                 img_fol_t *img_fol, raw_cparameters_t *raw_cp, char *indexfilename,
+                                 int *num_threads) {
     OPJ_UINT32 i, j;
     int totlen, c;
     opj_option_t long_option[]={
@@ -483,7 +486,8 @@ static int parse_cmdline_encoder(int argc, char **argv, opj_cparameters_t *param
         {"POC",REQ_ARG, NULL ,'P'},
         {"ROI",REQ_ARG, NULL ,'R'},
         {"jpip",NO_ARG, NULL, 'J'},
-        {"mct",REQ_ARG, NULL, 'Y'}
+        {"mct",REQ_ARG, NULL, 'Y'},
+        {"threads",REQ_ARG, NULL, 'H'}
     };
 
     /* parse the command line */
@@ -1431,6 +1435,16 @@ static int parse_cmdline_encoder(int argc, char **argv, opj_cparameters_t *param
             break;
             /* ------------------------------------------------------ */
 
+        case 'H':			/* Number of threads */
+        {
+            if (sscanf(opj_optarg, "%d", num_threads) != 1 || *num_threads < 0) {
+                fprintf(stderr, "[ERROR] Invalid number of threads: %s\n", opj_optarg);
+                return 1;
+            }
+        }
+            break;
+            /* ------------------------------------------------------ */
+
 
         default:
             fprintf(stderr, "[WARNING] An invalid option has been ignored\n");
@@ -1558,6 +1572,7 @@ int main(int argc, char **argv) {
     OPJ_BOOL bSuccess;
     OPJ_BOOL bUseTiles = OPJ_FALSE; /* OPJ_TRUE */
     OPJ_UINT32 l_nb_tiles = 4;
+    int num_threads = 0;
 
     /* set encoding parameters to default values */
     opj_set_default_encoder_parameters(&parameters);
@@ -1576,7 +1591,7 @@ int main(int argc, char **argv) {
 
     /* parse input and get user encoding parameters */
     parameters.tcp_mct = (char) 255; /* This will be set later according to the input image or the provided option */
-    if(parse_cmdline_encoder(argc, argv, &parameters,&img_fol, &raw_cp, indexfilename) == 1) {
+    if(parse_cmdline_encoder(argc, argv, &parameters,&img_fol, &raw_cp, indexfilename, &num_threads) == 1) {
         return 1;
     }
 
@@ -1770,6 +1785,13 @@ int main(int argc, char **argv) {
         }
         opj_setup_encoder(l_codec, &parameters, image);
 
+        if (num_threads > 1 && !opj_codec_set_threads(l_codec, num_threads)) {
+            fprintf(stderr, "failed to set the number of threads\n");
+            opj_destroy_codec(l_codec);
+            opj_image_destroy(image);
+            return 1;
+        }
+
         /* open a byte stream for writing and allocate memory for all tiles */
         l_stream = opj_stream_create_default_file_stream(parameters.outfile,OPJ_FALSE);
         if (! l_stream){
@@ -142,6 +142,8 @@ typedef struct opj_decompress_params
 	int force_rgb;
 	/* upsample components according to their dx/dy values */
 	int upsample;
+	/* number of threads used to decode the code-blocks */
+	int num_threads;
 }opj_decompress_parameters;
 
 /* -------------------------------------------------------------------------- */
@@ -215,6 +217,11 @@ static void decode_help_display(void) {
 	               "    Force output image colorspace to RGB\n"
 	               "  -upsample\n"
 	               "    Downsampled components will be upsampled to image size\n"
+	               "  -threads <num_threads>\n"
+	               "    Number of threads to use for decoding.\n"
+	               "  -max-memory <megabytes>\n"
+	               "    Maximum memory the decoding of an image may use. Images estimated\n"
+	               "    to need more are not decoded.\n"
 	               "\n");
 /* UniPG>> */
 #ifdef USE_JPWL
@@ -503,7 +510,9 @@ int parse_cmdline_decoder(int argc, char **argv, opj_decompress_parameters *para
 		{"ImgDir",    REQ_ARG, NULL ,'y'},
 		{"OutFor",    REQ_ARG, NULL ,'O'},
 		{"force-rgb", NO_ARG,  &(parameters->force_rgb), 1},
-		{"upsample",  NO_ARG,  &(parameters->upsample),  1}
+		{"upsample",  NO_ARG,  &(parameters->upsample),  1},
+		{"threads",   REQ_ARG, NULL ,'T'},
+		{"max-memory",REQ_ARG, NULL ,'M'}
 	};
 
 	const char optlist[] = "i:o:r:l:x:d:t:p:"
@@ -685,6 +694,30 @@ int parse_cmdline_decoder(int argc, char **argv, opj_decompress_parameters *para
 
 				/* ----------------------------------------------------- */								
 
+			case 'T':     		/* Number of threads */
+			{
+				if (sscanf(opj_optarg, "%d", &parameters->num_threads) != 1 || parameters->num_threads < 0) {
+					fprintf(stderr, "[ERROR] Invalid number of threads: %s\n", opj_optarg);
+					return 1;
+				}
+			}
+			break;
+
+				/* ----------------------------------------------------- */
+
+			case 'M':     		/* Memory budget, in megabytes */
+			{
+				unsigned int l_megabytes;
+				if (sscanf(opj_optarg, "%u", &l_megabytes) != 1) {
+					fprintf(stderr, "[ERROR] Invalid memory budget: %s\n", opj_optarg);
+					return 1;
+				}
+				parameters->core.max_memory = (OPJ_SIZE_T)l_megabytes << 20;
+			}
+			break;
+
+				/* ----------------------------------------------------- */
+
 			case 'x':			/* Creation of index file */
 				{
 					char *index = opj_optarg;
@@ -1248,6 +1281,13 @@ int main(int argc, char **argv)
 			return EXIT_FAILURE;
 		}
 
+		if (parameters.num_threads > 1 && !opj_codec_set_threads(l_codec, parameters.num_threads)) {
+			fprintf(stderr, "ERROR -> opj_decompress: failed to set the number of threads\n");
+			destroy_parameters(&parameters);
+			opj_stream_destroy(l_stream);
+			opj_destroy_codec(l_codec);
+			return EXIT_FAILURE;
+		}
 
 		/* Read the main header of the codestream and if necessary the JP2 boxes*/
 		if(! opj_read_header(l_stream, l_codec, &image)){
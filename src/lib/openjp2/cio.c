@@ -184,6 +184,168 @@ opj_stream_t* OPJ_CALLCONV opj_stream_create(OPJ_SIZE_T p_buffer_size,OPJ_BOOL l
 	return (opj_stream_t *) l_stream;
 }
 
+/**
+ * Moves the current position of a stream created by opj_stream_create_memory_read_stream().
+ * @return OPJ_FALSE if the position is past the end of the data.
+ */
+static OPJ_BOOL opj_stream_memory_seek (opj_stream_private_t * p_stream, OPJ_OFF_T p_size)
+{
+	if ((OPJ_UINT64)p_size > (OPJ_UINT64)p_stream->m_buffer_size) {
+		p_stream->m_current_data = p_stream->m_stored_data + p_stream->m_buffer_size;
+		p_stream->m_bytes_in_buffer = 0;
+		p_stream->m_byte_offset = (OPJ_OFF_T)p_stream->m_buffer_size;
+		return OPJ_FALSE;
+	}
+
+	p_stream->m_current_data = p_stream->m_stored_data + p_size;
+	p_stream->m_bytes_in_buffer = p_stream->m_buffer_size - (OPJ_SIZE_T)p_size;
+	p_stream->m_byte_offset = p_size;
+
+	return OPJ_TRUE;
+}
+
+opj_stream_t* opj_stream_create_memory_read_stream (const OPJ_BYTE * p_data, OPJ_SIZE_T p_size)
+{
+	opj_stream_private_t * l_stream = 00;
+	l_stream = (opj_stream_private_t*) opj_calloc(1,sizeof(opj_stream_private_t));
+	if (! l_stream) {
+		return 00;
+	}
+
+	/* the data is the buffer, all read at once: the stream is at its end as */
+	/* soon as the buffer is exhausted, and never calls m_read_fn */
+	l_stream->m_stored_data = (OPJ_BYTE *) p_data;
+	l_stream->m_current_data = l_stream->m_stored_data;
+	l_stream->m_buffer_size = p_size;
+	l_stream->m_bytes_in_buffer = p_size;
+	l_stream->m_user_data_length = (OPJ_UINT64)p_size;
+
+	l_stream->m_status = opj_stream_e_input | opj_stream_e_end | opj_stream_e_memory;
+	l_stream->m_opj_skip = opj_stream_read_skip;
+	l_stream->m_opj_seek = opj_stream_read_seek;
+
+	l_stream->m_read_fn = opj_stream_default_read;
+	l_stream->m_write_fn = opj_stream_default_write;
+	l_stream->m_skip_fn = opj_stream_default_skip;
+	l_stream->m_seek_fn = opj_stream_default_seek;
+
+	return (opj_stream_t *) l_stream;
+}
+
+opj_stream_t* OPJ_CALLCONV opj_stream_create_memory_stream (const void * p_buffer, OPJ_SIZE_T p_size)
+{
+	return opj_stream_create_memory_read_stream((const OPJ_BYTE *) p_buffer, p_size);
+}
+
+opj_stream_t* OPJ_CALLCONV opj_stream_create_memory_output_stream (OPJ_SIZE_T p_initial_size)
+{
+	opj_stream_private_t * l_stream = 00;
+	l_stream = (opj_stream_private_t*) opj_calloc(1,sizeof(opj_stream_private_t));
+	if (! l_stream) {
+		return 00;
+	}
+
+	/* the buffer holds the whole output, m_user_data_length being the number of bytes */
+	/* written so far: writes, skips and seeks work directly on it */
+	if (p_initial_size == 0) {
+		p_initial_size = OPJ_J2K_STREAM_CHUNK_SIZE;
+	}
+	l_stream->m_buffer_size = p_initial_size;
+	l_stream->m_stored_data = (OPJ_BYTE *) opj_malloc(p_initial_size);
+	if (! l_stream->m_stored_data) {
+		opj_free(l_stream);
+		return 00;
+	}
+	l_stream->m_current_data = l_stream->m_stored_data;
+
+	l_stream->m_status = opj_stream_e_output | opj_stream_e_memory;
+	l_stream->m_opj_skip = opj_stream_write_skip;
+	l_stream->m_opj_seek = opj_stream_write_seek;
+
+	l_stream->m_read_fn = opj_stream_default_read;
+	l_stream->m_write_fn = opj_stream_default_write;
+	l_stream->m_skip_fn = opj_stream_default_skip;
+	l_stream->m_seek_fn = opj_stream_default_seek;
+
+	return (opj_stream_t *) l_stream;
+}
+
+const OPJ_BYTE * OPJ_CALLCONV opj_stream_get_memory_data (opj_stream_t* p_stream, OPJ_SIZE_T * p_size)
+{
+	opj_stream_private_t* l_stream = (opj_stream_private_t*) p_stream;
+
+	if ((! l_stream) || (! (l_stream->m_status & opj_stream_e_memory))) {
+		if (p_size) {
+			*p_size = 0;
+		}
+		return 00;
+	}
+
+	if (p_size) {
+		*p_size = (OPJ_SIZE_T)l_stream->m_user_data_length;
+	}
+	return l_stream->m_stored_data;
+}
+
+/**
+ * Makes the buffer of a memory output stream large enough for the given number of bytes,
+ * doubling its size so that a codestream written piecewise is moved only a few times.
+ */
+static OPJ_BOOL opj_stream_memory_reserve (opj_stream_private_t * p_stream, OPJ_SIZE_T p_size)
+{
+	OPJ_SIZE_T l_new_size = p_stream->m_buffer_size;
+	OPJ_BYTE * l_new_data = 00;
+
+	if (p_size <= p_stream->m_buffer_size) {
+		return OPJ_TRUE;
+	}
+
+	while (l_new_size < p_size) {
+		if (l_new_size > ((OPJ_SIZE_T)-1) / 2) {
+			l_new_size = p_size;
+			break;
+		}
+		l_new_size *= 2;
+	}
+
+	l_new_data = (OPJ_BYTE *) opj_realloc(p_stream->m_stored_data, l_new_size);
+	if (! l_new_data) {
+		return OPJ_FALSE;
+	}
+	p_stream->m_stored_data = l_new_data;
+	p_stream->m_buffer_size = l_new_size;
+
+	return OPJ_TRUE;
+}
+
+/**
+ * Writes some bytes at the current position of a memory output stream. The bytes skipped
+ * over since the end of the data written so far are set to zero.
+ */
+static OPJ_SIZE_T opj_stream_memory_write (opj_stream_private_t * p_stream, const OPJ_BYTE * p_buffer, OPJ_SIZE_T p_size, opj_event_mgr_t * p_event_mgr)
+{
+	OPJ_SIZE_T l_offset = (OPJ_SIZE_T)p_stream->m_byte_offset;
+	OPJ_SIZE_T l_length = (OPJ_SIZE_T)p_stream->m_user_data_length;
+
+	if ((p_size > ((OPJ_SIZE_T)-1) - l_offset) || ! opj_stream_memory_reserve(p_stream, l_offset + p_size)) {
+		p_stream->m_status |= opj_stream_e_error;
+		opj_event_msg(p_event_mgr, EVT_ERROR, "Not enough memory to write the stream\n");
+		return (OPJ_SIZE_T)-1;
+	}
+
+	if (l_offset > l_length) {
+		memset(p_stream->m_stored_data + l_length, 0, l_offset - l_length);
+	}
+	memcpy(p_stream->m_stored_data + l_offset, p_buffer, p_size);
+
+	p_stream->m_byte_offset += (OPJ_OFF_T)p_size;
+	if ((OPJ_UINT64)p_stream->m_byte_offset > p_stream->m_user_data_length) {
+		p_stream->m_user_data_length = (OPJ_UINT64)p_stream->m_byte_offset;
+	}
+
+	return p_size;
+}
+
 opj_stream_t* OPJ_CALLCONV opj_stream_default_create(OPJ_BOOL l_is_input)
 {
 	return opj_stream_create(OPJ_J2K_STREAM_CHUNK_SIZE,l_is_input);
@@ -197,7 +359,9 @@ void OPJ_CALLCONV opj_stream_destroy(opj_stream_t* p_stream)
 		if (l_stream->m_free_user_data_fn) {
 			l_stream->m_free_user_data_fn(l_stream->m_user_data);
 		}
-		opj_free(l_stream->m_stored_data);
+		if (! (l_stream->m_status & opj_stream_e_memory) || (l_stream->m_status & opj_stream_e_output)) {
+			opj_free(l_stream->m_stored_data);
+		}
 		l_stream->m_stored_data = 00;
 		opj_free(l_stream);
 	}
@@ -370,6 +534,25 @@ OPJ_SIZE_T opj_stream_read_data (opj_stream_private_t * p_stream,OPJ_BYTE * p_bu
 	}
 }
 
+OPJ_SIZE_T opj_stream_read_data_in_place (opj_stream_private_t * p_stream, const OPJ_BYTE ** p_buffer, OPJ_SIZE_T p_size)
+{
+	OPJ_SIZE_T l_read_nb_bytes;
+
+	if (! (p_stream->m_status & opj_stream_e_memory)) {
+		*p_buffer = 00;
+		return 0;
+	}
+
+	/* the buffer of a memory stream is the whole data: no refill can occur */
+	l_read_nb_bytes = (p_size < p_stream->m_bytes_in_buffer) ? p_size : p_stream->m_bytes_in_buffer;
+	*p_buffer = p_stream->m_current_data;
+	p_stream->m_current_data += l_read_nb_bytes;
+	p_stream->m_bytes_in_buffer -= l_read_nb_bytes;
+	p_stream->m_byte_offset += (OPJ_OFF_T)l_read_nb_bytes;
+
+	return l_read_nb_bytes;
+}
+
 OPJ_SIZE_T opj_stream_write_data (opj_stream_private_t * p_stream,
 								  const OPJ_BYTE * p_buffer,
 								  OPJ_SIZE_T p_size, 
@@ -382,6 +565,10 @@ OPJ_SIZE_T opj_stream_write_data (opj_stream_private_t * p_stream,
 		return (OPJ_SIZE_T)-1;
 	}
 
+	if (p_stream->m_status & opj_stream_e_memory) {
+		return opj_stream_memory_write(p_stream, p_buffer, p_size, p_event_mgr);
+	}
+
 	while(1) {
 		l_remaining_bytes = p_stream->m_buffer_size - p_stream->m_bytes_in_buffer;
 		
@@ -423,6 +610,11 @@ OPJ_BOOL opj_stream_flush (opj_stream_private_t * p_stream, opj_event_mgr_t * p_
 	/* the number of bytes written on the media. */
 	OPJ_SIZE_T l_current_write_nb_bytes = 0;
 
+	if (p_stream->m_status & opj_stream_e_memory) {
+		/* the data is written in place, there is nothing to flush */
+		return OPJ_TRUE;
+	}
+
 	p_stream->m_current_data = p_stream->m_stored_data;
 
 	while (p_stream->m_bytes_in_buffer) {
@@ -511,6 +703,12 @@ OPJ_OFF_T opj_stream_write_skip (opj_stream_private_t * p_stream, OPJ_OFF_T p_si
 		return (OPJ_OFF_T) -1;
 	}
 
+	if (p_stream->m_status & opj_stream_e_memory) {
+		/* the bytes skipped are set to zero if something is written after them */
+		p_stream->m_byte_offset += p_size;
+		return p_size;
+	}
+
 	/* we should flush data */
 	l_is_written = opj_stream_flush (p_stream, p_event_mgr);
 	if (! l_is_written) {
@@ -564,6 +762,10 @@ OPJ_OFF_T opj_stream_skip (opj_stream_private_t * p_stream, OPJ_OFF_T p_size, op
 OPJ_BOOL opj_stream_read_seek (opj_stream_private_t * p_stream, OPJ_OFF_T p_size, opj_event_mgr_t * p_event_mgr)
 {
 	OPJ_ARG_NOT_USED(p_event_mgr);
+	if (p_stream->m_status & opj_stream_e_memory) {
+		return opj_stream_memory_seek(p_stream, p_size);
+	}
+
 	p_stream->m_current_data = p_stream->m_stored_data;
 	p_stream->m_bytes_in_buffer = 0;
 
@@ -583,6 +785,11 @@ OPJ_BOOL opj_stream_read_seek (opj_stream_private_t * p_stream, OPJ_OFF_T p_size
 
 OPJ_BOOL opj_stream_write_seek (opj_stream_private_t * p_stream, OPJ_OFF_T p_size, opj_event_mgr_t * p_event_mgr)
 {
+	if (p_stream->m_status & opj_stream_e_memory) {
+		p_stream->m_byte_offset = p_size;
+		return OPJ_TRUE;
+	}
+
 	if (! opj_stream_flush(p_stream,p_event_mgr)) {
 		p_stream->m_status |= opj_stream_e_error;
 		return OPJ_FALSE;
@@ -610,7 +817,12 @@ OPJ_BOOL opj_stream_seek (opj_stream_private_t * p_stream, OPJ_OFF_T p_size, str
 
 OPJ_BOOL opj_stream_has_seek (const opj_stream_private_t * p_stream)
 {
-	return p_stream->m_seek_fn != opj_stream_default_seek;
+	return (p_stream->m_status & opj_stream_e_memory) || p_stream->m_seek_fn != opj_stream_default_seek;
+}
+
+OPJ_BOOL opj_stream_is_in_memory (const opj_stream_private_t * p_stream)
+{
+	return (p_stream->m_status & opj_stream_e_memory) != 0;
 }
 
 OPJ_SIZE_T opj_stream_default_read (void * p_buffer, OPJ_SIZE_T p_nb_bytes, void * p_user_data)
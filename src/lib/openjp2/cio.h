@@ -77,7 +77,8 @@ typedef enum
 	opj_stream_e_output		= 0x1,
 	opj_stream_e_input		= 0x2,
 	opj_stream_e_end		= 0x4,
-	opj_stream_e_error		= 0x8
+	opj_stream_e_error		= 0x8,
+	opj_stream_e_memory		= 0x10	/**< the whole data lies in memory, in m_stored_data, which the stream owns only for output */
 }
 opj_stream_flag ;
 
@@ -369,6 +370,31 @@ OPJ_BOOL opj_stream_seek (opj_stream_private_t * p_stream, OPJ_OFF_T p_size, str
  */
 OPJ_BOOL opj_stream_has_seek (const opj_stream_private_t * p_stream);
 
+/**
+ * Tells if the given stream was created by opj_stream_create_memory_read_stream().
+ */
+OPJ_BOOL opj_stream_is_in_memory (const opj_stream_private_t * p_stream);
+
+/**
+ * Creates a read stream over data lying in memory. The data is used as the buffer of the
+ * stream, which is never refilled: reads copy from it, skips and seeks only move the
+ * current position.
+ * @param		p_data		the data, which must outlive the stream and the tiles read from it.
+ * @param		p_size		the number of bytes of data.
+ * @return		the stream, or NULL if it could not be allocated.
+ */
+opj_stream_t* opj_stream_create_memory_read_stream (const OPJ_BYTE * p_data, OPJ_SIZE_T p_size);
+
+/**
+ * Reads some bytes from a stream created by opj_stream_create_memory_read_stream() without
+ * copying them: the current position is moved and a pointer into the data of the stream is given.
+ * @param		p_stream	the stream to read data from.
+ * @param		p_buffer	receives a pointer to the bytes read, valid as long as the data of the stream.
+ * @param		p_size		number of bytes to read.
+ * @return		the number of bytes read, 0 if the stream does not lie in memory.
+ */
+OPJ_SIZE_T opj_stream_read_data_in_place (opj_stream_private_t * p_stream, const OPJ_BYTE ** p_buffer, OPJ_SIZE_T p_size);
+
 /**
  * FIXME DOC.
  */
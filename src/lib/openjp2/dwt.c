@@ -37,10 +37,6 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
-#ifdef __SSE__
-#include <xmmintrin.h>
-#endif
-
 #include "opj_includes.h"
 
 /** @defgroup DWT DWT - Implementation of a discrete wavelet transform */
@@ -59,17 +55,31 @@ typedef struct dwt_local {
 	OPJ_INT32 cas;
 } opj_dwt_t;
 
-typedef union {
-	OPJ_FLOAT32	f[4];
-} opj_v4_t;
-
 typedef struct v4dwt_local {
-	opj_v4_t*	wavelet ;
+	/** interleaved samples, rows of kernels->dwt_real_lanes values */
+	OPJ_FLOAT32*	wavelet ;
 	OPJ_INT32		dn ;
 	OPJ_INT32		sn ;
 	OPJ_INT32		cas ;
+	const opj_kernels_t* kernels ;
 } opj_v4dwt_t ;
 
+/** Area of a resolution level, relative to its upper left corner */
+typedef struct dwt_window {
+	OPJ_UINT32 x0;
+	OPJ_UINT32 y0;
+	OPJ_UINT32 x1;
+	OPJ_UINT32 y1;
+} opj_dwt_window_t;
+
+/** Number of columns transformed at once by the vertical pass of the inverse 5-3 transform */
+#define OPJ_DWT_VCOLS	8
+
+/** Margin, in sub-band samples, added around the area of a sub-band read by the inverse 5-3 transform */
+#define OPJ_DWT_MARGIN_53	2
+/** Margin, in sub-band samples, added around the area of a sub-band read by the inverse 9-7 transform */
+#define OPJ_DWT_MARGIN_97	3
+
 static const OPJ_FLOAT32 opj_dwt_alpha =  1.586134342f; /*  12994 */
 static const OPJ_FLOAT32 opj_dwt_beta  =  0.052980118f; /*    434 */
 static const OPJ_FLOAT32 opj_dwt_gamma = -0.882911075f; /*  -7233 */
@@ -97,6 +107,10 @@ Forward lazy transform (vertical)
 */
 static void opj_dwt_deinterleave_v(OPJ_INT32 *a, OPJ_INT32 *b, OPJ_INT32 dn, OPJ_INT32 sn, OPJ_INT32 x, OPJ_INT32 cas);
 /**
+Forward lazy transform (vertical) of OPJ_DWT_VCOLS columns, from rows of OPJ_DWT_VCOLS samples
+*/
+static void opj_dwt_deinterleave_v_cols(OPJ_INT32 *a, OPJ_INT32 *b, OPJ_INT32 dn, OPJ_INT32 sn, OPJ_INT32 x, OPJ_INT32 cas);
+/**
 Inverse lazy transform (horizontal)
 */
 static void opj_dwt_interleave_h(opj_dwt_t* h, OPJ_INT32 *a);
@@ -114,6 +128,31 @@ Inverse 5-3 wavelet transform in 1-D
 static void opj_dwt_decode_1(opj_dwt_t *v);
 static void opj_dwt_decode_1_(OPJ_INT32 *a, OPJ_INT32 dn, OPJ_INT32 sn, OPJ_INT32 cas);
 /**
+Inverse lazy transform (vertical) of OPJ_DWT_VCOLS columns, into rows of OPJ_DWT_VCOLS samples
+*/
+static void opj_dwt_interleave_v_cols(opj_dwt_t* v, OPJ_INT32 *a, OPJ_INT32 x);
+/**
+Inverse 5-3 wavelet transform in 1-D of OPJ_DWT_VCOLS interleaved columns
+*/
+static void opj_dwt_decode_cols(OPJ_INT32* a, OPJ_INT32 dn, OPJ_INT32 sn, OPJ_INT32 cas);
+#ifdef OPJ_HAVE_X86_KERNELS
+static void opj_dwt_decode_cols_sse2(OPJ_INT32* a, OPJ_INT32 dn, OPJ_INT32 sn, OPJ_INT32 cas);
+static void opj_dwt_decode_cols_avx2(OPJ_INT32* a, OPJ_INT32 dn, OPJ_INT32 sn, OPJ_INT32 cas);
+#endif
+/**
+Forward 5-3 wavelet transform in 1-D of OPJ_DWT_VCOLS interleaved columns
+*/
+static void opj_dwt_encode_cols(OPJ_INT32* a, OPJ_INT32 dn, OPJ_INT32 sn, OPJ_INT32 cas);
+/**
+Forward 9-7 wavelet transform in 1-D of OPJ_DWT_VCOLS interleaved columns
+*/
+static void opj_dwt_encode_cols_real(OPJ_INT32* a, OPJ_INT32 dn, OPJ_INT32 sn, OPJ_INT32 cas);
+#ifdef OPJ_HAVE_X86_KERNELS
+static void opj_dwt_encode_cols_sse2(OPJ_INT32* a, OPJ_INT32 dn, OPJ_INT32 sn, OPJ_INT32 cas);
+static void opj_dwt_encode_cols_avx2(OPJ_INT32* a, OPJ_INT32 dn, OPJ_INT32 sn, OPJ_INT32 cas);
+static void opj_dwt_encode_cols_real_avx2(OPJ_INT32* a, OPJ_INT32 dn, OPJ_INT32 sn, OPJ_INT32 cas);
+#endif
+/**
 Forward 9-7 wavelet transform in 1-D
 */
 static void opj_dwt_encode_1_real(OPJ_INT32 *a, OPJ_INT32 dn, OPJ_INT32 sn, OPJ_INT32 cas);
@@ -124,10 +163,21 @@ static void opj_dwt_encode_stepsize(OPJ_INT32 stepsize, OPJ_INT32 numbps, opj_st
 /**
 Inverse wavelet transform in 2-D.
 */
-static OPJ_BOOL opj_dwt_decode_tile(opj_tcd_tilecomp_t* tilec, OPJ_UINT32 i, DWT1DFN fn);
+static OPJ_BOOL opj_dwt_decode_tile(const opj_kernels_t* kernels, opj_tcd_tilecomp_t* tilec, OPJ_UINT32 i, const opj_dwt_window_t* win, DWT1DFN fn);
+/**
+Area of a sub-band read by the inverse transform to compute the samples [p_x0, p_x1)
+of a resolution level
+*/
+static void opj_dwt_get_band_range(OPJ_UINT32 p_x0, OPJ_UINT32 p_x1, OPJ_UINT32 p_nb, OPJ_UINT32 p_margin, OPJ_UINT32* p_b0, OPJ_UINT32* p_b1);
+/**
+Computes, for each resolution level, the area to reconstruct so that the area win
+of resolution level numres-1 is exact. Returns OPJ_FALSE if win is empty.
+*/
+static OPJ_BOOL opj_dwt_get_windows(opj_tcd_resolution_t* restrict r, OPJ_UINT32 numres, const opj_dwt_window_t* win, OPJ_UINT32 margin, opj_dwt_window_t* wins);
 
 static OPJ_BOOL opj_dwt_encode_procedure(	opj_tcd_tilecomp_t * tilec,
-										    void (*p_function)(OPJ_INT32 *, OPJ_INT32,OPJ_INT32,OPJ_INT32) );
+										    void (*p_function)(OPJ_INT32 *, OPJ_INT32,OPJ_INT32,OPJ_INT32),
+										    void (*p_cols_function)(OPJ_INT32 *, OPJ_INT32,OPJ_INT32,OPJ_INT32) );
 
 static OPJ_UINT32 opj_dwt_max_resolution(opj_tcd_resolution_t* restrict r, OPJ_UINT32 i);
 
@@ -140,16 +190,27 @@ static void opj_v4dwt_interleave_h(opj_v4dwt_t* restrict w, OPJ_FLOAT32* restric
 
 static void opj_v4dwt_interleave_v(opj_v4dwt_t* restrict v , OPJ_FLOAT32* restrict a , OPJ_INT32 x, OPJ_INT32 nb_elts_read);
 
-#ifdef __SSE__
-static void opj_v4dwt_decode_step1_sse(opj_v4_t* w, OPJ_INT32 count, const __m128 c);
+/* <summary>                             */
+/* Inverse 9-7 horizontal transform of the rows [j0, j1) of a resolution level. */
+/* </summary>                            */
+static void opj_v4dwt_decode_h_rows(opj_v4dwt_t* restrict h, OPJ_FLOAT32* restrict a, OPJ_UINT32 w, OPJ_UINT32 size, OPJ_UINT32 rw, OPJ_UINT32 j0, OPJ_UINT32 j1);
 
-static void opj_v4dwt_decode_step2_sse(opj_v4_t* l, opj_v4_t* w, OPJ_INT32 k, OPJ_INT32 m, __m128 c);
+static void opj_v4dwt_decode_step1(OPJ_FLOAT32* w, OPJ_INT32 count, const OPJ_FLOAT32 c);
 
-#else
-static void opj_v4dwt_decode_step1(opj_v4_t* w, OPJ_INT32 count, const OPJ_FLOAT32 c);
+static void opj_v4dwt_decode_step2(OPJ_FLOAT32* l, OPJ_FLOAT32* w, OPJ_INT32 k, OPJ_INT32 m, OPJ_FLOAT32 c);
+
+#ifdef OPJ_HAVE_X86_KERNELS
+static void opj_v4dwt_decode_step1_sse(OPJ_FLOAT32* w, OPJ_INT32 count, const OPJ_FLOAT32 c);
+
+static void opj_v4dwt_decode_step2_sse(OPJ_FLOAT32* l, OPJ_FLOAT32* w, OPJ_INT32 k, OPJ_INT32 m, OPJ_FLOAT32 c);
 
-static void opj_v4dwt_decode_step2(opj_v4_t* l, opj_v4_t* w, OPJ_INT32 k, OPJ_INT32 m, OPJ_FLOAT32 c);
+static void opj_v8dwt_decode_step1_avx2(OPJ_FLOAT32* w, OPJ_INT32 count, const OPJ_FLOAT32 c);
 
+static void opj_v8dwt_decode_step2_avx2(OPJ_FLOAT32* l, OPJ_FLOAT32* w, OPJ_INT32 k, OPJ_INT32 m, OPJ_FLOAT32 c);
+
+static void opj_v16dwt_decode_step1_avx512(OPJ_FLOAT32* w, OPJ_INT32 count, const OPJ_FLOAT32 c);
+
+static void opj_v16dwt_decode_step2_avx512(OPJ_FLOAT32* l, OPJ_FLOAT32* w, OPJ_INT32 k, OPJ_INT32 m, OPJ_FLOAT32 c);
 #endif
 
 /*@}*/
@@ -212,6 +273,30 @@ void opj_dwt_deinterleave_h(OPJ_INT32 *a, OPJ_INT32 *b, OPJ_INT32 dn, OPJ_INT32
 	}
 }
 
+/* <summary>                                 */
+/* Forward lazy transform (vertical) of OPJ_DWT_VCOLS columns. */
+/* </summary>                                */
+void opj_dwt_deinterleave_v_cols(OPJ_INT32 *a, OPJ_INT32 *b, OPJ_INT32 dn, OPJ_INT32 sn, OPJ_INT32 x, OPJ_INT32 cas) {
+	OPJ_INT32 i;
+	OPJ_INT32 * l_dest = b;
+	OPJ_INT32 * l_src = a + cas * OPJ_DWT_VCOLS;
+
+	for (i = 0; i < sn; ++i) {
+		memcpy(l_dest, l_src, OPJ_DWT_VCOLS * sizeof(OPJ_INT32));
+		l_dest += x;
+		l_src += 2 * OPJ_DWT_VCOLS;
+	}
+
+	l_dest = b + sn * x;
+	l_src = a + (1 - cas) * OPJ_DWT_VCOLS;
+
+	for (i = 0; i < dn; ++i) {
+		memcpy(l_dest, l_src, OPJ_DWT_VCOLS * sizeof(OPJ_INT32));
+		l_dest += x;
+		l_src += 2 * OPJ_DWT_VCOLS;
+	}
+}
+
 /* <summary>                             */  
 /* Forward lazy transform (vertical).    */
 /* </summary>                            */ 
@@ -329,6 +414,319 @@ void opj_dwt_decode_1(opj_dwt_t *v) {
 	opj_dwt_decode_1_(v->mem, v->dn, v->sn, v->cas);
 }
 
+/* <summary>                                          */
+/* Inverse lazy transform (vertical) of several columns. */
+/* </summary>                                         */
+void opj_dwt_interleave_v_cols(opj_dwt_t* v, OPJ_INT32 *a, OPJ_INT32 x) {
+	OPJ_INT32 *ai = a;
+	OPJ_INT32 *bi = v->mem + v->cas * OPJ_DWT_VCOLS;
+	OPJ_INT32  i = v->sn;
+	while( i-- ) {
+		memcpy(bi, ai, OPJ_DWT_VCOLS * sizeof(OPJ_INT32));
+		bi += 2 * OPJ_DWT_VCOLS;
+		ai += x;
+	}
+	ai = a + (v->sn * x);
+	bi = v->mem + (1 - v->cas) * OPJ_DWT_VCOLS;
+	i = v->dn;
+	while( i-- ) {
+		memcpy(bi, ai, OPJ_DWT_VCOLS * sizeof(OPJ_INT32));
+		bi += 2 * OPJ_DWT_VCOLS;
+		ai += x;
+	}
+}
+
+/* <summary>                                           */
+/* Lifting steps of the inverse 5-3 transform on rows of OPJ_DWT_VCOLS samples: */
+/* a -= (b + c + 2) >> 2 and a += (b + c) >> 1.        */
+/* </summary>                                          */
+typedef void (*opj_dwt_lift_cols_fn)(OPJ_INT32* a, const OPJ_INT32* b, const OPJ_INT32* c);
+
+static INLINE void opj_dwt_lift_sub_cols(OPJ_INT32* a, const OPJ_INT32* b, const OPJ_INT32* c) {
+	OPJ_INT32 k;
+	for (k = 0; k < OPJ_DWT_VCOLS; ++k) {
+		a[k] -= (b[k] + c[k] + 2) >> 2;
+	}
+}
+static INLINE void opj_dwt_lift_add_cols(OPJ_INT32* a, const OPJ_INT32* b, const OPJ_INT32* c) {
+	OPJ_INT32 k;
+	for (k = 0; k < OPJ_DWT_VCOLS; ++k) {
+		a[k] += (b[k] + c[k]) >> 1;
+	}
+}
+
+#ifdef OPJ_HAVE_X86_KERNELS
+OPJ_TARGET_SSE2
+static INLINE void opj_dwt_lift_sub_cols_sse2(OPJ_INT32* a, const OPJ_INT32* b, const OPJ_INT32* c) {
+	const __m128i two = _mm_set1_epi32(2);
+	OPJ_INT32 k;
+	for (k = 0; k < OPJ_DWT_VCOLS; k += 4) {
+		__m128i s = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(b + k)), _mm_loadu_si128((const __m128i*)(c + k)));
+		s = _mm_srai_epi32(_mm_add_epi32(s, two), 2);
+		_mm_storeu_si128((__m128i*)(a + k), _mm_sub_epi32(_mm_loadu_si128((const __m128i*)(a + k)), s));
+	}
+}
+OPJ_TARGET_SSE2
+static INLINE void opj_dwt_lift_add_cols_sse2(OPJ_INT32* a, const OPJ_INT32* b, const OPJ_INT32* c) {
+	OPJ_INT32 k;
+	for (k = 0; k < OPJ_DWT_VCOLS; k += 4) {
+		__m128i s = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(b + k)), _mm_loadu_si128((const __m128i*)(c + k)));
+		s = _mm_srai_epi32(s, 1);
+		_mm_storeu_si128((__m128i*)(a + k), _mm_add_epi32(_mm_loadu_si128((const __m128i*)(a + k)), s));
+	}
+}
+
+OPJ_TARGET_AVX2
+static INLINE void opj_dwt_lift_sub_cols_avx2(OPJ_INT32* a, const OPJ_INT32* b, const OPJ_INT32* c) {
+	__m256i s = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)b), _mm256_loadu_si256((const __m256i*)c));
+	s = _mm256_srai_epi32(_mm256_add_epi32(s, _mm256_set1_epi32(2)), 2);
+	_mm256_storeu_si256((__m256i*)a, _mm256_sub_epi32(_mm256_loadu_si256((const __m256i*)a), s));
+}
+OPJ_TARGET_AVX2
+static INLINE void opj_dwt_lift_add_cols_avx2(OPJ_INT32* a, const OPJ_INT32* b, const OPJ_INT32* c) {
+	__m256i s = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)b), _mm256_loadu_si256((const __m256i*)c));
+	s = _mm256_srai_epi32(s, 1);
+	_mm256_storeu_si256((__m256i*)a, _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)a), s));
+}
+#endif
+
+/* Rows of the interleaved columns, with the same symmetric extension as OPJ_S_(), OPJ_D_(), ... */
+#define OPJ_SC(i) (a + (i) * 2 * OPJ_DWT_VCOLS)
+#define OPJ_DC(i) (a + (1 + (i) * 2) * OPJ_DWT_VCOLS)
+#define OPJ_SC_(i) ((i)<0?OPJ_SC(0):((i)>=sn?OPJ_SC(sn-1):OPJ_SC(i)))
+#define OPJ_DC_(i) ((i)<0?OPJ_DC(0):((i)>=dn?OPJ_DC(dn-1):OPJ_DC(i)))
+#define OPJ_SSC_(i) ((i)<0?OPJ_SC(0):((i)>=dn?OPJ_SC(dn-1):OPJ_SC(i)))
+#define OPJ_DDC_(i) ((i)<0?OPJ_DC(0):((i)>=sn?OPJ_DC(sn-1):OPJ_DC(i)))
+
+/* <summary>                                          */
+/* Inverse 5-3 wavelet transform in 1-D of several columns, with given lifting steps. */
+/* Inlined in each kernel, so that the lifting steps are inlined too. */
+/* </summary>                                         */
+static INLINE void opj_dwt_decode_cols_generic(OPJ_INT32* a, OPJ_INT32 dn, OPJ_INT32 sn, OPJ_INT32 cas,
+                                               opj_dwt_lift_cols_fn lift_sub, opj_dwt_lift_cols_fn lift_add) {
+	OPJ_INT32 i, k;
+
+	if (!cas) {
+		if ((dn > 0) || (sn > 1)) { /* NEW :  CASE ONE ELEMENT */
+			for (i = 0; i < sn; i++) lift_sub(OPJ_SC(i), OPJ_DC_(i - 1), OPJ_DC_(i));
+			for (i = 0; i < dn; i++) lift_add(OPJ_DC(i), OPJ_SC_(i), OPJ_SC_(i + 1));
+		}
+	} else {
+		if (!sn  && dn == 1) {        /* NEW :  CASE ONE ELEMENT */
+			for (k = 0; k < OPJ_DWT_VCOLS; k++) a[k] /= 2;
+		}
+		else {
+			for (i = 0; i < sn; i++) lift_sub(OPJ_DC(i), OPJ_SSC_(i), OPJ_SSC_(i + 1));
+			for (i = 0; i < dn; i++) lift_add(OPJ_SC(i), OPJ_DDC_(i), OPJ_DDC_(i - 1));
+		}
+	}
+}
+
+void opj_dwt_decode_cols(OPJ_INT32* a, OPJ_INT32 dn, OPJ_INT32 sn, OPJ_INT32 cas) {
+	opj_dwt_decode_cols_generic(a, dn, sn, cas, opj_dwt_lift_sub_cols, opj_dwt_lift_add_cols);
+}
+
+#ifdef OPJ_HAVE_X86_KERNELS
+OPJ_TARGET_SSE2
+void opj_dwt_decode_cols_sse2(OPJ_INT32* a, OPJ_INT32 dn, OPJ_INT32 sn, OPJ_INT32 cas) {
+	opj_dwt_decode_cols_generic(a, dn, sn, cas, opj_dwt_lift_sub_cols_sse2, opj_dwt_lift_add_cols_sse2);
+}
+
+OPJ_TARGET_AVX2
+void opj_dwt_decode_cols_avx2(OPJ_INT32* a, OPJ_INT32 dn, OPJ_INT32 sn, OPJ_INT32 cas) {
+	opj_dwt_decode_cols_generic(a, dn, sn, cas, opj_dwt_lift_sub_cols_avx2, opj_dwt_lift_add_cols_avx2);
+}
+#endif
+
+/* <summary>                                           */
+/* Lifting steps of the forward 5-3 transform on rows of OPJ_DWT_VCOLS samples: */
+/* a -= (b + c) >> 1 and a += (b + c + 2) >> 2.        */
+/* </summary>                                          */
+static INLINE void opj_dwt_lift_predict_cols(OPJ_INT32* a, const OPJ_INT32* b, const OPJ_INT32* c) {
+	OPJ_INT32 k;
+	for (k = 0; k < OPJ_DWT_VCOLS; ++k) {
+		a[k] -= (b[k] + c[k]) >> 1;
+	}
+}
+static INLINE void opj_dwt_lift_update_cols(OPJ_INT32* a, const OPJ_INT32* b, const OPJ_INT32* c) {
+	OPJ_INT32 k;
+	for (k = 0; k < OPJ_DWT_VCOLS; ++k) {
+		a[k] += (b[k] + c[k] + 2) >> 2;
+	}
+}
+
+#ifdef OPJ_HAVE_X86_KERNELS
+OPJ_TARGET_SSE2
+static INLINE void opj_dwt_lift_predict_cols_sse2(OPJ_INT32* a, const OPJ_INT32* b, const OPJ_INT32* c) {
+	OPJ_INT32 k;
+	for (k = 0; k < OPJ_DWT_VCOLS; k += 4) {
+		__m128i s = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(b + k)), _mm_loadu_si128((const __m128i*)(c + k)));
+		s = _mm_srai_epi32(s, 1);
+		_mm_storeu_si128((__m128i*)(a + k), _mm_sub_epi32(_mm_loadu_si128((const __m128i*)(a + k)), s));
+	}
+}
+OPJ_TARGET_SSE2
+static INLINE void opj_dwt_lift_update_cols_sse2(OPJ_INT32* a, const OPJ_INT32* b, const OPJ_INT32* c) {
+	const __m128i two = _mm_set1_epi32(2);
+	OPJ_INT32 k;
+	for (k = 0; k < OPJ_DWT_VCOLS; k += 4) {
+		__m128i s = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(b + k)), _mm_loadu_si128((const __m128i*)(c + k)));
+		s = _mm_srai_epi32(_mm_add_epi32(s, two), 2);
+		_mm_storeu_si128((__m128i*)(a + k), _mm_add_epi32(_mm_loadu_si128((const __m128i*)(a + k)), s));
+	}
+}
+
+OPJ_TARGET_AVX2
+static INLINE void opj_dwt_lift_predict_cols_avx2(OPJ_INT32* a, const OPJ_INT32* b, const OPJ_INT32* c) {
+	__m256i s = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)b), _mm256_loadu_si256((const __m256i*)c));
+	s = _mm256_srai_epi32(s, 1);
+	_mm256_storeu_si256((__m256i*)a, _mm256_sub_epi32(_mm256_loadu_si256((const __m256i*)a), s));
+}
+OPJ_TARGET_AVX2
+static INLINE void opj_dwt_lift_update_cols_avx2(OPJ_INT32* a, const OPJ_INT32* b, const OPJ_INT32* c) {
+	__m256i s = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)b), _mm256_loadu_si256((const __m256i*)c));
+	s = _mm256_srai_epi32(_mm256_add_epi32(s, _mm256_set1_epi32(2)), 2);
+	_mm256_storeu_si256((__m256i*)a, _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)a), s));
+}
+#endif
+
+/* <summary>                                          */
+/* Forward 5-3 wavelet transform in 1-D of several columns, with given lifting steps. */
+/* Inlined in each kernel, so that the lifting steps are inlined too. */
+/* </summary>                                         */
+static INLINE void opj_dwt_encode_cols_generic(OPJ_INT32* a, OPJ_INT32 dn, OPJ_INT32 sn, OPJ_INT32 cas,
+                                               opj_dwt_lift_cols_fn lift_predict, opj_dwt_lift_cols_fn lift_update) {
+	OPJ_INT32 i, k;
+
+	if (!cas) {
+		if ((dn > 0) || (sn > 1)) {	/* NEW :  CASE ONE ELEMENT */
+			for (i = 0; i < dn; i++) lift_predict(OPJ_DC(i), OPJ_SC_(i), OPJ_SC_(i + 1));
+			for (i = 0; i < sn; i++) lift_update(OPJ_SC(i), OPJ_DC_(i - 1), OPJ_DC_(i));
+		}
+	} else {
+		if (!sn && dn == 1) {		    /* NEW :  CASE ONE ELEMENT */
+			for (k = 0; k < OPJ_DWT_VCOLS; k++) a[k] *= 2;
+		}
+		else {
+			for (i = 0; i < dn; i++) lift_predict(OPJ_SC(i), OPJ_DDC_(i), OPJ_DDC_(i - 1));
+			for (i = 0; i < sn; i++) lift_update(OPJ_DC(i), OPJ_SSC_(i), OPJ_SSC_(i + 1));
+		}
+	}
+}
+
+void opj_dwt_encode_cols(OPJ_INT32* a, OPJ_INT32 dn, OPJ_INT32 sn, OPJ_INT32 cas) {
+	opj_dwt_encode_cols_generic(a, dn, sn, cas, opj_dwt_lift_predict_cols, opj_dwt_lift_update_cols);
+}
+
+#ifdef OPJ_HAVE_X86_KERNELS
+OPJ_TARGET_SSE2
+void opj_dwt_encode_cols_sse2(OPJ_INT32* a, OPJ_INT32 dn, OPJ_INT32 sn, OPJ_INT32 cas) {
+	opj_dwt_encode_cols_generic(a, dn, sn, cas, opj_dwt_lift_predict_cols_sse2, opj_dwt_lift_update_cols_sse2);
+}
+
+OPJ_TARGET_AVX2
+void opj_dwt_encode_cols_avx2(OPJ_INT32* a, OPJ_INT32 dn, OPJ_INT32 sn, OPJ_INT32 cas) {
+	opj_dwt_encode_cols_generic(a, dn, sn, cas, opj_dwt_lift_predict_cols_avx2, opj_dwt_lift_update_cols_avx2);
+}
+#endif
+
+/* <summary>                                           */
+/* Lifting steps of the forward 9-7 transform on rows of OPJ_DWT_VCOLS samples, */
+/* with the fixed point multiplication of opj_int_fix_mul(): */
+/* a -= (b + c) * k, a += (b + c) * k and a *= k.      */
+/* </summary>                                          */
+typedef void (*opj_dwt_lift_real_cols_fn)(OPJ_INT32* a, const OPJ_INT32* b, const OPJ_INT32* c, OPJ_INT32 k);
+typedef void (*opj_dwt_scale_real_cols_fn)(OPJ_INT32* a, OPJ_INT32 k);
+
+static INLINE void opj_dwt_lift_sub_real_cols(OPJ_INT32* a, const OPJ_INT32* b, const OPJ_INT32* c, OPJ_INT32 k) {
+	OPJ_INT32 i;
+	for (i = 0; i < OPJ_DWT_VCOLS; ++i) {
+		a[i] -= opj_int_fix_mul(b[i] + c[i], k);
+	}
+}
+static INLINE void opj_dwt_lift_add_real_cols(OPJ_INT32* a, const OPJ_INT32* b, const OPJ_INT32* c, OPJ_INT32 k) {
+	OPJ_INT32 i;
+	for (i = 0; i < OPJ_DWT_VCOLS; ++i) {
+		a[i] += opj_int_fix_mul(b[i] + c[i], k);
+	}
+}
+static INLINE void opj_dwt_scale_real_cols(OPJ_INT32* a, OPJ_INT32 k) {
+	OPJ_INT32 i;
+	for (i = 0; i < OPJ_DWT_VCOLS; ++i) {
+		a[i] = opj_int_fix_mul(a[i], k);
+	}
+}
+
+#ifdef OPJ_HAVE_X86_KERNELS
+/* opj_int_fix_mul() of 8 values: the 64 bits products of the even and odd */
+/* lanes are rounded and shifted, and their low 32 bits merged. A logical */
+/* shift gives the same low 32 bits as the arithmetic one of the C code. */
+OPJ_TARGET_AVX2
+static INLINE __m256i opj_dwt_fix_mul_avx2(__m256i a, __m256i k) {
+	const __m256i round = _mm256_set1_epi64x(4096);
+	__m256i lo = _mm256_mul_epi32(a, k);
+	__m256i hi = _mm256_mul_epi32(_mm256_srli_epi64(a, 32), k);
+	lo = _mm256_srli_epi64(_mm256_add_epi64(lo, round), 13);
+	hi = _mm256_slli_epi64(_mm256_add_epi64(hi, round), 32 - 13);
+	return _mm256_blend_epi32(lo, hi, 0xAA);
+}
+OPJ_TARGET_AVX2
+static INLINE void opj_dwt_lift_sub_real_cols_avx2(OPJ_INT32* a, const OPJ_INT32* b, const OPJ_INT32* c, OPJ_INT32 k) {
+	__m256i s = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)b), _mm256_loadu_si256((const __m256i*)c));
+	s = opj_dwt_fix_mul_avx2(s, _mm256_set1_epi32(k));
+	_mm256_storeu_si256((__m256i*)a, _mm256_sub_epi32(_mm256_loadu_si256((const __m256i*)a), s));
+}
+OPJ_TARGET_AVX2
+static INLINE void opj_dwt_lift_add_real_cols_avx2(OPJ_INT32* a, const OPJ_INT32* b, const OPJ_INT32* c, OPJ_INT32 k) {
+	__m256i s = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)b), _mm256_loadu_si256((const __m256i*)c));
+	s = opj_dwt_fix_mul_avx2(s, _mm256_set1_epi32(k));
+	_mm256_storeu_si256((__m256i*)a, _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)a), s));
+}
+OPJ_TARGET_AVX2
+static INLINE void opj_dwt_scale_real_cols_avx2(OPJ_INT32* a, OPJ_INT32 k) {
+	_mm256_storeu_si256((__m256i*)a, opj_dwt_fix_mul_avx2(_mm256_loadu_si256((const __m256i*)a), _mm256_set1_epi32(k)));
+}
+#endif
+
+/* <summary>                                          */
+/* Forward 9-7 wavelet transform in 1-D of several columns, with given lifting steps. */
+/* </summary>                                         */
+static INLINE void opj_dwt_encode_cols_real_generic(OPJ_INT32* a, OPJ_INT32 dn, OPJ_INT32 sn, OPJ_INT32 cas,
+                                                    opj_dwt_lift_real_cols_fn lift_sub, opj_dwt_lift_real_cols_fn lift_add,
+                                                    opj_dwt_scale_real_cols_fn scale) {
+	OPJ_INT32 i;
+	if (!cas) {
+		if ((dn > 0) || (sn > 1)) {	/* NEW :  CASE ONE ELEMENT */
+			for (i = 0; i < dn; i++) lift_sub(OPJ_DC(i), OPJ_SC_(i), OPJ_SC_(i + 1), 12993);
+			for (i = 0; i < sn; i++) lift_sub(OPJ_SC(i), OPJ_DC_(i - 1), OPJ_DC_(i), 434);
+			for (i = 0; i < dn; i++) lift_add(OPJ_DC(i), OPJ_SC_(i), OPJ_SC_(i + 1), 7233);
+			for (i = 0; i < sn; i++) lift_add(OPJ_SC(i), OPJ_DC_(i - 1), OPJ_DC_(i), 3633);
+			for (i = 0; i < dn; i++) scale(OPJ_DC(i), 5038);	/*5038 */
+			for (i = 0; i < sn; i++) scale(OPJ_SC(i), 6659);	/*6660 */
+		}
+	} else {
+		if ((sn > 0) || (dn > 1)) {	/* NEW :  CASE ONE ELEMENT */
+			for (i = 0; i < dn; i++) lift_sub(OPJ_SC(i), OPJ_DDC_(i), OPJ_DDC_(i - 1), 12993);
+			for (i = 0; i < sn; i++) lift_sub(OPJ_DC(i), OPJ_SSC_(i), OPJ_SSC_(i + 1), 434);
+			for (i = 0; i < dn; i++) lift_add(OPJ_SC(i), OPJ_DDC_(i), OPJ_DDC_(i - 1), 7233);
+			for (i = 0; i < sn; i++) lift_add(OPJ_DC(i), OPJ_SSC_(i), OPJ_SSC_(i + 1), 3633);
+			for (i = 0; i < dn; i++) scale(OPJ_SC(i), 5038);	/*5038 */
+			for (i = 0; i < sn; i++) scale(OPJ_DC(i), 6659);	/*6660 */
+		}
+	}
+}
+
+void opj_dwt_encode_cols_real(OPJ_INT32* a, OPJ_INT32 dn, OPJ_INT32 sn, OPJ_INT32 cas) {
+	opj_dwt_encode_cols_real_generic(a, dn, sn, cas, opj_dwt_lift_sub_real_cols, opj_dwt_lift_add_real_cols, opj_dwt_scale_real_cols);
+}
+
+#ifdef OPJ_HAVE_X86_KERNELS
+OPJ_TARGET_AVX2
+void opj_dwt_encode_cols_real_avx2(OPJ_INT32* a, OPJ_INT32 dn, OPJ_INT32 sn, OPJ_INT32 cas) {
+	opj_dwt_encode_cols_real_generic(a, dn, sn, cas, opj_dwt_lift_sub_real_cols_avx2, opj_dwt_lift_add_real_cols_avx2, opj_dwt_scale_real_cols_avx2);
+}
+#endif
+
 /* <summary>                             */
 /* Forward 9-7 wavelet transform in 1-D. */
 /* </summary>                            */
@@ -385,7 +783,9 @@ void opj_dwt_encode_stepsize(OPJ_INT32 stepsize, OPJ_INT32 numbps, opj_stepsize_
 /* <summary>                            */
 /* Forward 5-3 wavelet transform in 2-D. */
 /* </summary>                           */
-INLINE OPJ_BOOL opj_dwt_encode_procedure(opj_tcd_tilecomp_t * tilec,void (*p_function)(OPJ_INT32 *, OPJ_INT32,OPJ_INT32,OPJ_INT32) )
+INLINE OPJ_BOOL opj_dwt_encode_procedure(opj_tcd_tilecomp_t * tilec,
+                                         void (*p_function)(OPJ_INT32 *, OPJ_INT32,OPJ_INT32,OPJ_INT32),
+                                         void (*p_cols_function)(OPJ_INT32 *, OPJ_INT32,OPJ_INT32,OPJ_INT32) )
 {
 	OPJ_INT32 i, j, k;
 	OPJ_INT32 *a = 00;
@@ -407,7 +807,8 @@ INLINE OPJ_BOOL opj_dwt_encode_procedure(opj_tcd_tilecomp_t * tilec,void (*p_fun
 	l_cur_res = tilec->resolutions + l;
 	l_last_res = l_cur_res - 1;
 
-	l_data_size = opj_dwt_max_resolution( tilec->resolutions,tilec->numresolutions) * (OPJ_UINT32)sizeof(OPJ_INT32);
+	/* the buffer holds OPJ_DWT_VCOLS columns for the vertical pass */
+	l_data_size = opj_dwt_max_resolution( tilec->resolutions,tilec->numresolutions) * OPJ_DWT_VCOLS * (OPJ_UINT32)sizeof(OPJ_INT32);
 	bj = (OPJ_INT32*)opj_malloc((size_t)l_data_size);
 	if (! bj) {
 		return OPJ_FALSE;
@@ -431,7 +832,19 @@ INLINE OPJ_BOOL opj_dwt_encode_procedure(opj_tcd_tilecomp_t * tilec,void (*p_fun
 
 		sn = rh1;
 		dn = rh - rh1;
-		for (j = 0; j < rw; ++j) {
+		/* columns are transformed OPJ_DWT_VCOLS at a time, so that each row */
+		/* of the tile is read and written with contiguous accesses */
+		for (j = 0; j + OPJ_DWT_VCOLS <= rw; j += OPJ_DWT_VCOLS) {
+			aj = a + j;
+			for (k = 0; k < rh; ++k) {
+				memcpy(&bj[k * OPJ_DWT_VCOLS], &aj[k*w], OPJ_DWT_VCOLS * sizeof(OPJ_INT32));
+			}
+
+			(*p_cols_function) (bj, dn, sn, cas_col);
+
+			opj_dwt_deinterleave_v_cols(bj, aj, dn, sn, w, cas_col);
+		}
+		for (; j < rw; ++j) {
 			aj = a + j;
 			for (k = 0; k < rh; ++k) {
 				bj[k] = aj[k*w];
@@ -463,16 +876,25 @@ INLINE OPJ_BOOL opj_dwt_encode_procedure(opj_tcd_tilecomp_t * tilec,void (*p_fun
 
 /* Forward 5-3 wavelet transform in 2-D. */
 /* </summary>                           */
-OPJ_BOOL opj_dwt_encode(opj_tcd_tilecomp_t * tilec)
+OPJ_BOOL opj_dwt_encode(const opj_kernels_t* kernels, opj_tcd_tilecomp_t * tilec)
 {
-	return opj_dwt_encode_procedure(tilec,opj_dwt_encode_1);
+	return opj_dwt_encode_procedure(tilec,opj_dwt_encode_1,kernels->dwt_encode_cols);
 }
 
 /* <summary>                            */
 /* Inverse 5-3 wavelet transform in 2-D. */
 /* </summary>                           */
-OPJ_BOOL opj_dwt_decode(opj_tcd_tilecomp_t* tilec, OPJ_UINT32 numres) {
-	return opj_dwt_decode_tile(tilec, numres, &opj_dwt_decode_1);
+OPJ_BOOL opj_dwt_decode(const opj_kernels_t* kernels, opj_tcd_tilecomp_t* tilec, OPJ_UINT32 numres,
+                        OPJ_UINT32 win_x0, OPJ_UINT32 win_y0, OPJ_UINT32 win_x1, OPJ_UINT32 win_y1) {
+	opj_tcd_resolution_t* res = &tilec->resolutions[numres - 1];
+	opj_dwt_window_t win;
+
+	win.x0 = win_x0 - (OPJ_UINT32)res->x0;
+	win.y0 = win_y0 - (OPJ_UINT32)res->y0;
+	win.x1 = win_x1 - (OPJ_UINT32)res->x0;
+	win.y1 = win_y1 - (OPJ_UINT32)res->y0;
+
+	return opj_dwt_decode_tile(kernels, tilec, numres, &win, &opj_dwt_decode_1);
 }
 
 
@@ -497,9 +919,9 @@ OPJ_FLOAT64 opj_dwt_getnorm(OPJ_UINT32 level, OPJ_UINT32 orient) {
 /* <summary>                             */
 /* Forward 9-7 wavelet transform in 2-D. */
 /* </summary>                            */
-OPJ_BOOL opj_dwt_encode_real(opj_tcd_tilecomp_t * tilec)
+OPJ_BOOL opj_dwt_encode_real(const opj_kernels_t* kernels, opj_tcd_tilecomp_t * tilec)
 {
-	return opj_dwt_encode_procedure(tilec,opj_dwt_encode_1_real);
+	return opj_dwt_encode_procedure(tilec,opj_dwt_encode_1_real,kernels->dwt_encode_cols_real);
 }
 
 /* <summary>                          */
@@ -554,12 +976,50 @@ OPJ_UINT32 opj_dwt_max_resolution(opj_tcd_resolution_t* restrict r, OPJ_UINT32 i
 	return mr ;
 }
 
+/* <summary>                            */
+/* Area of a sub-band read by the inverse transform. */
+/* </summary>                           */
+void opj_dwt_get_band_range(OPJ_UINT32 p_x0, OPJ_UINT32 p_x1, OPJ_UINT32 p_nb, OPJ_UINT32 p_margin, OPJ_UINT32* p_b0, OPJ_UINT32* p_b1) {
+	/* sample p of the resolution level is sample p/2 of the low or high sub-band */
+	OPJ_UINT32 b0 = p_x0 >> 1;
+	OPJ_UINT32 b1 = (p_x1 + 1) >> 1;
+
+	b0 = (b0 < p_margin) ? 0 : b0 - p_margin;
+	b1 = opj_uint_min(b1 + p_margin, p_nb);
+	*p_b0 = opj_uint_min(b0, b1);
+	*p_b1 = b1;
+}
+
+/* <summary>                            */
+/* Areas to reconstruct at each resolution level. */
+/* </summary>                           */
+OPJ_BOOL opj_dwt_get_windows(opj_tcd_resolution_t* restrict r, OPJ_UINT32 numres, const opj_dwt_window_t* win, OPJ_UINT32 margin, opj_dwt_window_t* wins) {
+	OPJ_UINT32 resno = numres - 1;
+
+	wins[resno].x0 = win->x0;
+	wins[resno].y0 = win->y0;
+	wins[resno].x1 = opj_uint_min(win->x1, (OPJ_UINT32)(r[resno].x1 - r[resno].x0));
+	wins[resno].y1 = opj_uint_min(win->y1, (OPJ_UINT32)(r[resno].y1 - r[resno].y0));
+	if (wins[resno].x0 >= wins[resno].x1 || wins[resno].y0 >= wins[resno].y1) {
+		return OPJ_FALSE;
+	}
+
+	/* the lower resolution level is the low-pass sub-band of the next one */
+	for (; resno > 0; --resno) {
+		opj_dwt_get_band_range(wins[resno].x0, wins[resno].x1, (OPJ_UINT32)(r[resno - 1].x1 - r[resno - 1].x0), margin, &wins[resno - 1].x0, &wins[resno - 1].x1);
+		opj_dwt_get_band_range(wins[resno].y0, wins[resno].y1, (OPJ_UINT32)(r[resno - 1].y1 - r[resno - 1].y0), margin, &wins[resno - 1].y0, &wins[resno - 1].y1);
+	}
+	return OPJ_TRUE;
+}
+
 /* <summary>                            */
 /* Inverse wavelet transform in 2-D.     */
 /* </summary>                           */
-OPJ_BOOL opj_dwt_decode_tile(opj_tcd_tilecomp_t* tilec, OPJ_UINT32 numres, DWT1DFN dwt_1D) {
+OPJ_BOOL opj_dwt_decode_tile(const opj_kernels_t* kernels, opj_tcd_tilecomp_t* tilec, OPJ_UINT32 numres, const opj_dwt_window_t* win, DWT1DFN dwt_1D) {
 	opj_dwt_t h;
 	opj_dwt_t v;
+	opj_dwt_window_t wins[OPJ_J2K_MAXRLVLS];
+	OPJ_UINT32 resno = 0;
 
 	opj_tcd_resolution_t* tr = tilec->resolutions;
 
@@ -568,8 +1028,13 @@ OPJ_BOOL opj_dwt_decode_tile(opj_tcd_tilecomp_t* tilec, OPJ_UINT32 numres, DWT1D
 
 	OPJ_UINT32 w = (OPJ_UINT32)(tilec->x1 - tilec->x0);
 
+	if (! opj_dwt_get_windows(tr, numres, win, OPJ_DWT_MARGIN_53, wins)) {
+		/* nothing to reconstruct */
+		return OPJ_TRUE;
+	}
+
 	h.mem = (OPJ_INT32*)
-	opj_aligned_malloc(opj_dwt_max_resolution(tr, numres) * sizeof(OPJ_INT32));
+	opj_aligned_malloc(opj_dwt_max_resolution(tr, numres) * OPJ_DWT_VCOLS * sizeof(OPJ_INT32));
 	if (! h.mem){
 		/* FIXME event manager error callback */
 		return OPJ_FALSE;
@@ -579,7 +1044,9 @@ OPJ_BOOL opj_dwt_decode_tile(opj_tcd_tilecomp_t* tilec, OPJ_UINT32 numres, DWT1D
 
 	while( --numres) {
 		OPJ_INT32 * restrict tiledp = tilec->data;
-		OPJ_UINT32 j;
+		const opj_dwt_window_t* lwin = &wins[resno];
+		const opj_dwt_window_t* rwin = &wins[++resno];
+		OPJ_UINT32 j, j0, j1;
 
 		++tr;
 		h.sn = (OPJ_INT32)rw;
@@ -591,7 +1058,14 @@ OPJ_BOOL opj_dwt_decode_tile(opj_tcd_tilecomp_t* tilec, OPJ_UINT32 numres, DWT1D
 		h.dn = (OPJ_INT32)(rw - (OPJ_UINT32)h.sn);
 		h.cas = tr->x0 % 2;
 
-		for(j = 0; j < rh; ++j) {
+		/* only the rows of the low and high sub-bands read by the vertical pass */
+		for(j = lwin->y0; j < lwin->y1; ++j) {
+			opj_dwt_interleave_h(&h, &tiledp[j*w]);
+			(dwt_1D)(&h);
+			memcpy(&tiledp[j*w], h.mem, rw * sizeof(OPJ_INT32));
+		}
+		opj_dwt_get_band_range(rwin->y0, rwin->y1, rh - (OPJ_UINT32)v.sn, OPJ_DWT_MARGIN_53, &j0, &j1);
+		for(j = (OPJ_UINT32)v.sn + j0; j < (OPJ_UINT32)v.sn + j1; ++j) {
 			opj_dwt_interleave_h(&h, &tiledp[j*w]);
 			(dwt_1D)(&h);
 			memcpy(&tiledp[j*w], h.mem, rw * sizeof(OPJ_INT32));
@@ -600,7 +1074,17 @@ OPJ_BOOL opj_dwt_decode_tile(opj_tcd_tilecomp_t* tilec, OPJ_UINT32 numres, DWT1D
 		v.dn = (OPJ_INT32)(rh - (OPJ_UINT32)v.sn);
 		v.cas = tr->y0 % 2;
 
-		for(j = 0; j < rw; ++j){
+		/* columns are transformed OPJ_DWT_VCOLS at a time, so that each row */
+		/* of the tile is read and written with contiguous accesses */
+		for(j = rwin->x0; j + OPJ_DWT_VCOLS <= rwin->x1; j += OPJ_DWT_VCOLS){
+			OPJ_UINT32 k;
+			opj_dwt_interleave_v_cols(&v, &tiledp[j], (OPJ_INT32)w);
+			kernels->dwt_decode_cols(v.mem, v.dn, v.sn, v.cas);
+			for(k = 0; k < rh; ++k) {
+				memcpy(&tiledp[k * w + j], &v.mem[k * OPJ_DWT_VCOLS], OPJ_DWT_VCOLS * sizeof(OPJ_INT32));
+			}
+		}
+		for(; j < rwin->x1; ++j){
 			OPJ_UINT32 k;
 			opj_dwt_interleave_v(&v, &tiledp[j], (OPJ_INT32)w);
 			(dwt_1D)(&v);
@@ -613,43 +1097,64 @@ OPJ_BOOL opj_dwt_decode_tile(opj_tcd_tilecomp_t* tilec, OPJ_UINT32 numres, DWT1D
 	return OPJ_TRUE;
 }
 
+/* The copy loops below are inlined with a constant number of lanes, so that */
+/* the compiler unrolls them and turns the memcpy() into vector moves */
+
+/* Copies count samples of lanes rows (stride x) of a to interleaved rows of bi. */
+static INLINE void opj_v4dwt_gather_rows(OPJ_FLOAT32* restrict bi, const OPJ_FLOAT32* restrict a, OPJ_INT32 count, OPJ_INT32 x, const OPJ_INT32 lanes){
+	OPJ_INT32 i, r;
+	for(i = 0; i < count; ++i){
+		for(r = 0; r < lanes; ++r){
+			bi[i * 2 * lanes + r] = a[i + r * x];
+		}
+	}
+}
+
+/* Copies count interleaved rows of bi to the columns of lanes rows (stride x) of a. */
+static INLINE void opj_v4dwt_scatter_rows(OPJ_FLOAT32* restrict a, const OPJ_FLOAT32* restrict bi, OPJ_UINT32 count, OPJ_UINT32 x, const OPJ_INT32 lanes){
+	OPJ_UINT32 i;
+	OPJ_INT32 r;
+	for(i = 0; i < count; ++i){
+		for(r = 0; r < lanes; ++r){
+			a[i + (OPJ_UINT32)r * x] = bi[i * (OPJ_UINT32)lanes + (OPJ_UINT32)r];
+		}
+	}
+}
+
+/* Copies count rows of lanes samples, with strides dst_step and src_step. */
+static INLINE void opj_v4dwt_copy_rows(OPJ_FLOAT32* restrict dst, OPJ_SIZE_T dst_step, const OPJ_FLOAT32* restrict src, OPJ_SIZE_T src_step, OPJ_UINT32 count, const OPJ_INT32 lanes){
+	OPJ_UINT32 i;
+	for(i = 0; i < count; ++i){
+		memcpy(dst + i * dst_step, src + i * src_step, (size_t)lanes * sizeof(OPJ_FLOAT32));
+	}
+}
+
 void opj_v4dwt_interleave_h(opj_v4dwt_t* restrict w, OPJ_FLOAT32* restrict a, OPJ_INT32 x, OPJ_INT32 size){
-	OPJ_FLOAT32* restrict bi = (OPJ_FLOAT32*) (w->wavelet + w->cas);
+	const OPJ_INT32 lanes = w->kernels->dwt_real_lanes;
+	OPJ_FLOAT32* restrict bi = w->wavelet + w->cas * lanes;
 	OPJ_INT32 count = w->sn;
-	OPJ_INT32 i, k;
+	OPJ_INT32 i, k, r;
 
 	for(k = 0; k < 2; ++k){
-		if ( count + 3 * x < size && ((size_t) a & 0x0f) == 0 && ((size_t) bi & 0x0f) == 0 && (x & 0x0f) == 0 ) {
+		if (count + (lanes - 1) * x < size) {
 			/* Fast code path */
-			for(i = 0; i < count; ++i){
-				OPJ_INT32 j = i;
-				bi[i*8    ] = a[j];
-				j += x;
-				bi[i*8 + 1] = a[j];
-				j += x;
-				bi[i*8 + 2] = a[j];
-				j += x;
-				bi[i*8 + 3] = a[j];
+			switch (lanes) {
+				case 16: opj_v4dwt_gather_rows(bi, a, count, x, 16); break;
+				case 8: opj_v4dwt_gather_rows(bi, a, count, x, 8); break;
+				default: opj_v4dwt_gather_rows(bi, a, count, x, 4); break;
 			}
 		}
 		else {
-			/* Slow code path */
-			for(i = 0; i < count; ++i){
-				OPJ_INT32 j = i;
-				bi[i*8    ] = a[j];
-				j += x;
-				if(j >= size) continue;
-				bi[i*8 + 1] = a[j];
-				j += x;
-				if(j >= size) continue;
-				bi[i*8 + 2] = a[j];
-				j += x;
-				if(j >= size) continue;
-				bi[i*8 + 3] = a[j]; /* This one*/
+			/* Slow code path: do not read past the end of the buffer */
+			for(r = 0; r < lanes && r * x < size; ++r){
+				OPJ_INT32 n = opj_int_min(count, size - r * x);
+				for(i = 0; i < n; ++i){
+					bi[i * 2 * lanes + r] = a[i + r * x];
+				}
 			}
 		}
 
-		bi = (OPJ_FLOAT32*) (w->wavelet + 1 - w->cas);
+		bi = w->wavelet + (1 - w->cas) * lanes;
 		a += w->sn;
 		size -= w->sn;
 		count = w->dn;
@@ -657,75 +1162,33 @@ void opj_v4dwt_interleave_h(opj_v4dwt_t* restrict w, OPJ_FLOAT32* restrict a, OP
 }
 
 void opj_v4dwt_interleave_v(opj_v4dwt_t* restrict v , OPJ_FLOAT32* restrict a , OPJ_INT32 x, OPJ_INT32 nb_elts_read){
-	opj_v4_t* restrict bi = v->wavelet + v->cas;
-	OPJ_INT32 i;
-
-	for(i = 0; i < v->sn; ++i){
-		memcpy(&bi[i*2], &a[i*x], (size_t)nb_elts_read * sizeof(OPJ_FLOAT32));
-	}
-
-	a += v->sn * x;
-	bi = v->wavelet + 1 - v->cas;
-
-	for(i = 0; i < v->dn; ++i){
-		memcpy(&bi[i*2], &a[i*x], (size_t)nb_elts_read * sizeof(OPJ_FLOAT32));
-	}
-}
-
-#ifdef __SSE__
+	const OPJ_INT32 lanes = v->kernels->dwt_real_lanes;
+	OPJ_FLOAT32* restrict bi = v->wavelet + v->cas * lanes;
+	OPJ_INT32 i, k;
 
-void opj_v4dwt_decode_step1_sse(opj_v4_t* w, OPJ_INT32 count, const __m128 c){
-	__m128* restrict vw = (__m128*) w;
-	OPJ_INT32 i;
-	/* 4x unrolled loop */
-	for(i = 0; i < count >> 2; ++i){
-		*vw = _mm_mul_ps(*vw, c);
-		vw += 2;
-		*vw = _mm_mul_ps(*vw, c);
-		vw += 2;
-		*vw = _mm_mul_ps(*vw, c);
-		vw += 2;
-		*vw = _mm_mul_ps(*vw, c);
-		vw += 2;
-	}
-	count &= 3;
-	for(i = 0; i < count; ++i){
-		*vw = _mm_mul_ps(*vw, c);
-		vw += 2;
-	}
-}
+	for(k = 0; k < 2; ++k){
+		OPJ_INT32 count = k ? v->dn : v->sn;
+		if (nb_elts_read == lanes) {
+			switch (lanes) {
+				case 16: opj_v4dwt_copy_rows(bi, (OPJ_SIZE_T)(2 * lanes), a, (OPJ_SIZE_T)x, (OPJ_UINT32)count, 16); break;
+				case 8: opj_v4dwt_copy_rows(bi, (OPJ_SIZE_T)(2 * lanes), a, (OPJ_SIZE_T)x, (OPJ_UINT32)count, 8); break;
+				default: opj_v4dwt_copy_rows(bi, (OPJ_SIZE_T)(2 * lanes), a, (OPJ_SIZE_T)x, (OPJ_UINT32)count, 4); break;
+			}
+		}
+		else {
+			for(i = 0; i < count; ++i){
+				memcpy(&bi[i*2*lanes], &a[i*x], (size_t)nb_elts_read * sizeof(OPJ_FLOAT32));
+			}
+		}
 
-void opj_v4dwt_decode_step2_sse(opj_v4_t* l, opj_v4_t* w, OPJ_INT32 k, OPJ_INT32 m, __m128 c){
-	__m128* restrict vl = (__m128*) l;
-	__m128* restrict vw = (__m128*) w;
-	OPJ_INT32 i;
-	__m128 tmp1, tmp2, tmp3;
-	tmp1 = vl[0];
-	for(i = 0; i < m; ++i){
-		tmp2 = vw[-1];
-		tmp3 = vw[ 0];
-		vw[-1] = _mm_add_ps(tmp2, _mm_mul_ps(_mm_add_ps(tmp1, tmp3), c));
-		tmp1 = tmp3;
-		vw += 2;
-	}
-	vl = vw - 2;
-	if(m >= k){
-		return;
-	}
-	c = _mm_add_ps(c, c);
-	c = _mm_mul_ps(c, vl[0]);
-	for(; m < k; ++m){
-		__m128 tmp = vw[-1];
-		vw[-1] = _mm_add_ps(tmp, c);
-		vw += 2;
+		a += v->sn * x;
+		bi = v->wavelet + (1 - v->cas) * lanes;
 	}
 }
 
-#else
-
-void opj_v4dwt_decode_step1(opj_v4_t* w, OPJ_INT32 count, const OPJ_FLOAT32 c)
+void opj_v4dwt_decode_step1(OPJ_FLOAT32* w, OPJ_INT32 count, const OPJ_FLOAT32 c)
 {
-	OPJ_FLOAT32* restrict fw = (OPJ_FLOAT32*) w;
+	OPJ_FLOAT32* restrict fw = w;
 	OPJ_INT32 i;
 	for(i = 0; i < count; ++i){
 		OPJ_FLOAT32 tmp1 = fw[i*8    ];
@@ -739,10 +1202,10 @@ void opj_v4dwt_decode_step1(opj_v4_t* w, OPJ_INT32 count, const OPJ_FLOAT32 c)
 	}
 }
 
-void opj_v4dwt_decode_step2(opj_v4_t* l, opj_v4_t* w, OPJ_INT32 k, OPJ_INT32 m, OPJ_FLOAT32 c)
+void opj_v4dwt_decode_step2(OPJ_FLOAT32* l, OPJ_FLOAT32* w, OPJ_INT32 k, OPJ_INT32 m, OPJ_FLOAT32 c)
 {
-	OPJ_FLOAT32* restrict fl = (OPJ_FLOAT32*) l;
-	OPJ_FLOAT32* restrict fw = (OPJ_FLOAT32*) w;
+	OPJ_FLOAT32* restrict fl = l;
+	OPJ_FLOAT32* restrict fw = w;
 	OPJ_INT32 i;
 	for(i = 0; i < m; ++i){
 		OPJ_FLOAT32 tmp1_1 = fl[0];
@@ -788,14 +1251,178 @@ void opj_v4dwt_decode_step2(opj_v4_t* l, opj_v4_t* w, OPJ_INT32 k, OPJ_INT32 m,
 	}
 }
 
+#ifdef OPJ_HAVE_X86_KERNELS
+
+OPJ_TARGET_SSE2
+void opj_v4dwt_decode_step1_sse(OPJ_FLOAT32* w, OPJ_INT32 count, const OPJ_FLOAT32 cst){
+	__m128* restrict vw = (__m128*) w;
+	const __m128 c = _mm_set1_ps(cst);
+	OPJ_INT32 i;
+	/* 4x unrolled loop */
+	for(i = 0; i < count >> 2; ++i){
+		*vw = _mm_mul_ps(*vw, c);
+		vw += 2;
+		*vw = _mm_mul_ps(*vw, c);
+		vw += 2;
+		*vw = _mm_mul_ps(*vw, c);
+		vw += 2;
+		*vw = _mm_mul_ps(*vw, c);
+		vw += 2;
+	}
+	count &= 3;
+	for(i = 0; i < count; ++i){
+		*vw = _mm_mul_ps(*vw, c);
+		vw += 2;
+	}
+}
+
+OPJ_TARGET_SSE2
+void opj_v4dwt_decode_step2_sse(OPJ_FLOAT32* l, OPJ_FLOAT32* w, OPJ_INT32 k, OPJ_INT32 m, OPJ_FLOAT32 cst){
+	__m128* restrict vl = (__m128*) l;
+	__m128* restrict vw = (__m128*) w;
+	__m128 c = _mm_set1_ps(cst);
+	OPJ_INT32 i;
+	__m128 tmp1, tmp2, tmp3;
+	tmp1 = vl[0];
+	for(i = 0; i < m; ++i){
+		tmp2 = vw[-1];
+		tmp3 = vw[ 0];
+		vw[-1] = _mm_add_ps(tmp2, _mm_mul_ps(_mm_add_ps(tmp1, tmp3), c));
+		tmp1 = tmp3;
+		vw += 2;
+	}
+	vl = vw - 2;
+	if(m >= k){
+		return;
+	}
+	c = _mm_add_ps(c, c);
+	c = _mm_mul_ps(c, vl[0]);
+	for(; m < k; ++m){
+		__m128 tmp = vw[-1];
+		vw[-1] = _mm_add_ps(tmp, c);
+		vw += 2;
+	}
+}
+
+
+OPJ_TARGET_AVX2
+void opj_v8dwt_decode_step1_avx2(OPJ_FLOAT32* w, OPJ_INT32 count, const OPJ_FLOAT32 cst){
+	const __m256 c = _mm256_set1_ps(cst);
+	OPJ_INT32 i;
+	for(i = 0; i < count; ++i){
+		_mm256_storeu_ps(w, _mm256_mul_ps(_mm256_loadu_ps(w), c));
+		w += 16;
+	}
+}
+
+OPJ_TARGET_AVX2
+void opj_v8dwt_decode_step2_avx2(OPJ_FLOAT32* l, OPJ_FLOAT32* w, OPJ_INT32 k, OPJ_INT32 m, OPJ_FLOAT32 cst){
+	__m256 c = _mm256_set1_ps(cst);
+	__m256 tmp1, tmp2, tmp3;
+	OPJ_INT32 i;
+	tmp1 = _mm256_loadu_ps(l);
+	for(i = 0; i < m; ++i){
+		tmp2 = _mm256_loadu_ps(w - 8);
+		tmp3 = _mm256_loadu_ps(w);
+		_mm256_storeu_ps(w - 8, _mm256_add_ps(tmp2, _mm256_mul_ps(_mm256_add_ps(tmp1, tmp3), c)));
+		tmp1 = tmp3;
+		w += 16;
+	}
+	if(m >= k){
+		return;
+	}
+	c = _mm256_add_ps(c, c);
+	c = _mm256_mul_ps(c, _mm256_loadu_ps(w - 16));
+	for(; m < k; ++m){
+		_mm256_storeu_ps(w - 8, _mm256_add_ps(_mm256_loadu_ps(w - 8), c));
+		w += 16;
+	}
+}
+
+/* The multiplications use the explicit rounding form of the intrinsic, so */
+/* that they cannot be fused with the additions (AVX-512 provides FMA): the */
+/* results must stay bit-exact with the SSE and scalar kernels */
+
+OPJ_TARGET_AVX512
+void opj_v16dwt_decode_step1_avx512(OPJ_FLOAT32* w, OPJ_INT32 count, const OPJ_FLOAT32 cst){
+	const __m512 c = _mm512_set1_ps(cst);
+	OPJ_INT32 i;
+	for(i = 0; i < count; ++i){
+		_mm512_storeu_ps(w, _mm512_mul_round_ps(_mm512_loadu_ps(w), c, _MM_FROUND_CUR_DIRECTION));
+		w += 32;
+	}
+}
+
+OPJ_TARGET_AVX512
+void opj_v16dwt_decode_step2_avx512(OPJ_FLOAT32* l, OPJ_FLOAT32* w, OPJ_INT32 k, OPJ_INT32 m, OPJ_FLOAT32 cst){
+	__m512 c = _mm512_set1_ps(cst);
+	__m512 tmp1, tmp2, tmp3;
+	OPJ_INT32 i;
+	tmp1 = _mm512_loadu_ps(l);
+	for(i = 0; i < m; ++i){
+		tmp2 = _mm512_loadu_ps(w - 16);
+		tmp3 = _mm512_loadu_ps(w);
+		_mm512_storeu_ps(w - 16, _mm512_add_ps(tmp2, _mm512_mul_round_ps(_mm512_add_ps(tmp1, tmp3), c, _MM_FROUND_CUR_DIRECTION)));
+		tmp1 = tmp3;
+		w += 32;
+	}
+	if(m >= k){
+		return;
+	}
+	c = _mm512_add_ps(c, c);
+	c = _mm512_mul_round_ps(c, _mm512_loadu_ps(w - 32), _MM_FROUND_CUR_DIRECTION);
+	for(; m < k; ++m){
+		_mm512_storeu_ps(w - 16, _mm512_add_ps(_mm512_loadu_ps(w - 16), c));
+		w += 32;
+	}
+}
+
+#endif /* OPJ_HAVE_X86_KERNELS */
+
+/* <summary>                             */
+/* Kernels of the inverse transforms.    */
+/* </summary>                            */
+void opj_dwt_init_kernels(opj_kernels_t* p_kernels, OPJ_UINT32 p_level)
+{
+	p_kernels->dwt_encode_cols = opj_dwt_encode_cols;
+	p_kernels->dwt_encode_cols_real = opj_dwt_encode_cols_real;
+	p_kernels->dwt_decode_cols = opj_dwt_decode_cols;
+	p_kernels->dwt_real_lanes = 4;
+	p_kernels->dwt_real_step1 = opj_v4dwt_decode_step1;
+	p_kernels->dwt_real_step2 = opj_v4dwt_decode_step2;
+#ifdef OPJ_HAVE_X86_KERNELS
+	if (p_level >= OPJ_CPU_LEVEL_SSE2) {
+		p_kernels->dwt_encode_cols = opj_dwt_encode_cols_sse2;
+		p_kernels->dwt_decode_cols = opj_dwt_decode_cols_sse2;
+		p_kernels->dwt_real_step1 = opj_v4dwt_decode_step1_sse;
+		p_kernels->dwt_real_step2 = opj_v4dwt_decode_step2_sse;
+	}
+	if (p_level >= OPJ_CPU_LEVEL_AVX2) {
+		p_kernels->dwt_encode_cols = opj_dwt_encode_cols_avx2;
+		p_kernels->dwt_encode_cols_real = opj_dwt_encode_cols_real_avx2;
+		p_kernels->dwt_decode_cols = opj_dwt_decode_cols_avx2;
+		p_kernels->dwt_real_lanes = 8;
+		p_kernels->dwt_real_step1 = opj_v8dwt_decode_step1_avx2;
+		p_kernels->dwt_real_step2 = opj_v8dwt_decode_step2_avx2;
+	}
+	if (p_level >= OPJ_CPU_LEVEL_AVX512) {
+		p_kernels->dwt_real_lanes = 16;
+		p_kernels->dwt_real_step1 = opj_v16dwt_decode_step1_avx512;
+		p_kernels->dwt_real_step2 = opj_v16dwt_decode_step2_avx512;
+	}
+#else
+	(void)p_level;
 #endif
+}
 
 /* <summary>                             */
 /* Inverse 9-7 wavelet transform in 1-D. */
 /* </summary>                            */
 void opj_v4dwt_decode(opj_v4dwt_t* restrict dwt)
 {
-	OPJ_INT32 a, b;
+	OPJ_INT32 a, b, lanes;
+	void (*step1)(OPJ_FLOAT32* w, OPJ_INT32 count, OPJ_FLOAT32 c);
+	void (*step2)(OPJ_FLOAT32* l, OPJ_FLOAT32* w, OPJ_INT32 k, OPJ_INT32 m, OPJ_FLOAT32 c);
 	if(dwt->cas == 0) {
 		if(!((dwt->dn > 0) || (dwt->sn > 1))){
 			return;
@@ -809,31 +1436,67 @@ void opj_v4dwt_decode(opj_v4dwt_t* restrict dwt)
 		a = 1;
 		b = 0;
 	}
-#ifdef __SSE__
-	opj_v4dwt_decode_step1_sse(dwt->wavelet+a, dwt->sn, _mm_set1_ps(opj_K));
-	opj_v4dwt_decode_step1_sse(dwt->wavelet+b, dwt->dn, _mm_set1_ps(opj_c13318));
-	opj_v4dwt_decode_step2_sse(dwt->wavelet+b, dwt->wavelet+a+1, dwt->sn, opj_int_min(dwt->sn, dwt->dn-a), _mm_set1_ps(opj_dwt_delta));
-	opj_v4dwt_decode_step2_sse(dwt->wavelet+a, dwt->wavelet+b+1, dwt->dn, opj_int_min(dwt->dn, dwt->sn-b), _mm_set1_ps(opj_dwt_gamma));
-	opj_v4dwt_decode_step2_sse(dwt->wavelet+b, dwt->wavelet+a+1, dwt->sn, opj_int_min(dwt->sn, dwt->dn-a), _mm_set1_ps(opj_dwt_beta));
-	opj_v4dwt_decode_step2_sse(dwt->wavelet+a, dwt->wavelet+b+1, dwt->dn, opj_int_min(dwt->dn, dwt->sn-b), _mm_set1_ps(opj_dwt_alpha));
-#else
-	opj_v4dwt_decode_step1(dwt->wavelet+a, dwt->sn, opj_K);
-	opj_v4dwt_decode_step1(dwt->wavelet+b, dwt->dn, opj_c13318);
-	opj_v4dwt_decode_step2(dwt->wavelet+b, dwt->wavelet+a+1, dwt->sn, opj_int_min(dwt->sn, dwt->dn-a), opj_dwt_delta);
-	opj_v4dwt_decode_step2(dwt->wavelet+a, dwt->wavelet+b+1, dwt->dn, opj_int_min(dwt->dn, dwt->sn-b), opj_dwt_gamma);
-	opj_v4dwt_decode_step2(dwt->wavelet+b, dwt->wavelet+a+1, dwt->sn, opj_int_min(dwt->sn, dwt->dn-a), opj_dwt_beta);
-	opj_v4dwt_decode_step2(dwt->wavelet+a, dwt->wavelet+b+1, dwt->dn, opj_int_min(dwt->dn, dwt->sn-b), opj_dwt_alpha);
-#endif
+	lanes = dwt->kernels->dwt_real_lanes;
+	step1 = dwt->kernels->dwt_real_step1;
+	step2 = dwt->kernels->dwt_real_step2;
+	step1(dwt->wavelet+a*lanes, dwt->sn, opj_K);
+	step1(dwt->wavelet+b*lanes, dwt->dn, opj_c13318);
+	step2(dwt->wavelet+b*lanes, dwt->wavelet+(a+1)*lanes, dwt->sn, opj_int_min(dwt->sn, dwt->dn-a), opj_dwt_delta);
+	step2(dwt->wavelet+a*lanes, dwt->wavelet+(b+1)*lanes, dwt->dn, opj_int_min(dwt->dn, dwt->sn-b), opj_dwt_gamma);
+	step2(dwt->wavelet+b*lanes, dwt->wavelet+(a+1)*lanes, dwt->sn, opj_int_min(dwt->sn, dwt->dn-a), opj_dwt_beta);
+	step2(dwt->wavelet+a*lanes, dwt->wavelet+(b+1)*lanes, dwt->dn, opj_int_min(dwt->dn, dwt->sn-b), opj_dwt_alpha);
 }
 
 
+/* <summary>                             */
+/* Inverse 9-7 horizontal transform of the rows [j0, j1) of a resolution level. */
+/* </summary>                            */
+void opj_v4dwt_decode_h_rows(opj_v4dwt_t* restrict h, OPJ_FLOAT32* restrict a, OPJ_UINT32 w, OPJ_UINT32 size, OPJ_UINT32 rw, OPJ_UINT32 j0, OPJ_UINT32 j1)
+{
+	const OPJ_INT32 lanes = h->kernels->dwt_real_lanes;
+	OPJ_FLOAT32 * restrict aj = a + j0 * w;
+	OPJ_UINT32 bufsize = size - j0 * w;
+	OPJ_INT32 j;
+
+	for(j = (OPJ_INT32)(j1 - j0); j > 0; j -= lanes) {
+		OPJ_INT32 nb_rows = opj_int_min(j, lanes);
+		OPJ_INT32 k, r;
+		opj_v4dwt_interleave_h(h, aj, (OPJ_INT32)w, (OPJ_INT32)bufsize);
+		opj_v4dwt_decode(h);
+
+		if (nb_rows == 4 && lanes == 4) {
+			opj_v4dwt_scatter_rows(aj, h->wavelet, rw, w, 4);
+		}
+		else {
+			/* wider batches are written one row at a time, which is faster than */
+			/* interleaving the writes to 8 or 16 rows */
+			for(r = 0; r < nb_rows; ++r){
+				OPJ_FLOAT32 * restrict ar = aj + (OPJ_UINT32)r * w;
+				for(k = 0; k < (OPJ_INT32)rw; ++k){
+					ar[k] = h->wavelet[k * lanes + r];
+				}
+			}
+		}
+
+		if (j > lanes) {
+			aj += w * (OPJ_UINT32)lanes;
+			bufsize -= w * (OPJ_UINT32)lanes;
+		}
+	}
+}
+
 /* <summary>                             */
 /* Inverse 9-7 wavelet transform in 2-D. */
 /* </summary>                            */
-OPJ_BOOL opj_dwt_decode_real(opj_tcd_tilecomp_t* restrict tilec, OPJ_UINT32 numres)
+OPJ_BOOL opj_dwt_decode_real(const opj_kernels_t* kernels, opj_tcd_tilecomp_t* restrict tilec, OPJ_UINT32 numres,
+                             OPJ_UINT32 win_x0, OPJ_UINT32 win_y0, OPJ_UINT32 win_x1, OPJ_UINT32 win_y1)
 {
 	opj_v4dwt_t h;
 	opj_v4dwt_t v;
+	opj_dwt_window_t win;
+	opj_dwt_window_t wins[OPJ_J2K_MAXRLVLS];
+	OPJ_UINT32 resno = 0;
+	OPJ_INT32 lanes;
 
 	opj_tcd_resolution_t* res = tilec->resolutions;
 
@@ -842,16 +1505,31 @@ OPJ_BOOL opj_dwt_decode_real(opj_tcd_tilecomp_t* restrict tilec, OPJ_UINT32 numr
 
 	OPJ_UINT32 w = (OPJ_UINT32)(tilec->x1 - tilec->x0);
 
-	h.wavelet = (opj_v4_t*) opj_aligned_malloc((opj_dwt_max_resolution(res, numres)+5) * sizeof(opj_v4_t));
+	win.x0 = win_x0 - (OPJ_UINT32)res[numres - 1].x0;
+	win.y0 = win_y0 - (OPJ_UINT32)res[numres - 1].y0;
+	win.x1 = win_x1 - (OPJ_UINT32)res[numres - 1].x0;
+	win.y1 = win_y1 - (OPJ_UINT32)res[numres - 1].y0;
+	if (! opj_dwt_get_windows(res, numres, &win, OPJ_DWT_MARGIN_97, wins)) {
+		/* nothing to reconstruct */
+		return OPJ_TRUE;
+	}
+
+	h.kernels = kernels;
+	h.wavelet = (OPJ_FLOAT32*) opj_aligned_malloc((opj_dwt_max_resolution(res, numres)+5) * (OPJ_UINT32)kernels->dwt_real_lanes * sizeof(OPJ_FLOAT32));
 	if (!h.wavelet) {
 		/* FIXME event manager error callback */
 		return OPJ_FALSE;
 	}
 	v.wavelet = h.wavelet;
+	v.kernels = h.kernels;
+	lanes = kernels->dwt_real_lanes;
 
 	while( --numres) {
 		OPJ_FLOAT32 * restrict aj = (OPJ_FLOAT32*) tilec->data;
 		OPJ_UINT32 bufsize = (OPJ_UINT32)((tilec->x1 - tilec->x0) * (tilec->y1 - tilec->y0));
+		const opj_dwt_window_t* lwin = &wins[resno];
+		const opj_dwt_window_t* rwin = &wins[++resno];
+		OPJ_UINT32 j0, j1;
 		OPJ_INT32 j;
 
 		h.sn = (OPJ_INT32)rw;
@@ -865,63 +1543,35 @@ OPJ_BOOL opj_dwt_decode_real(opj_tcd_tilecomp_t* restrict tilec, OPJ_UINT32 numr
 		h.dn = (OPJ_INT32)(rw - (OPJ_UINT32)h.sn);
 		h.cas = res->x0 % 2;
 
-		for(j = (OPJ_INT32)rh; j > 3; j -= 4) {
-			OPJ_INT32 k;
-			opj_v4dwt_interleave_h(&h, aj, (OPJ_INT32)w, (OPJ_INT32)bufsize);
-			opj_v4dwt_decode(&h);
-
-			for(k = (OPJ_INT32)rw; --k >= 0;){
-				aj[k               ] = h.wavelet[k].f[0];
-				aj[k+(OPJ_INT32)w  ] = h.wavelet[k].f[1];
-				aj[k+(OPJ_INT32)w*2] = h.wavelet[k].f[2];
-				aj[k+(OPJ_INT32)w*3] = h.wavelet[k].f[3];
-			}
-
-			aj += w*4;
-			bufsize -= w*4;
-		}
-
-		if (rh & 0x03) {
-			OPJ_INT32 k;
-			j = rh & 0x03;
-			opj_v4dwt_interleave_h(&h, aj, (OPJ_INT32)w, (OPJ_INT32)bufsize);
-			opj_v4dwt_decode(&h);
-			for(k = (OPJ_INT32)rw; --k >= 0;){
-				switch(j) {
-					case 3: aj[k+(OPJ_INT32)w*2] = h.wavelet[k].f[2];
-					case 2: aj[k+(OPJ_INT32)w  ] = h.wavelet[k].f[1];
-					case 1: aj[k               ] = h.wavelet[k].f[0];
-				}
-			}
-		}
+		/* only the rows of the low and high sub-bands read by the vertical pass */
+		opj_v4dwt_decode_h_rows(&h, aj, w, bufsize, rw, lwin->y0, lwin->y1);
+		opj_dwt_get_band_range(rwin->y0, rwin->y1, rh - (OPJ_UINT32)v.sn, OPJ_DWT_MARGIN_97, &j0, &j1);
+		opj_v4dwt_decode_h_rows(&h, aj, w, bufsize, rw, (OPJ_UINT32)v.sn + j0, (OPJ_UINT32)v.sn + j1);
 
 		v.dn = (OPJ_INT32)(rh - (OPJ_UINT32)v.sn);
 		v.cas = res->y0 % 2;
 
-		aj = (OPJ_FLOAT32*) tilec->data;
-		for(j = (OPJ_INT32)rw; j > 3; j -= 4){
+		aj += rwin->x0;
+		for(j = (OPJ_INT32)(rwin->x1 - rwin->x0); j > 0; j -= lanes){
+			OPJ_INT32 nb_cols = opj_int_min(j, lanes);
 			OPJ_UINT32 k;
 
-			opj_v4dwt_interleave_v(&v, aj, (OPJ_INT32)w, 4);
+			opj_v4dwt_interleave_v(&v, aj, (OPJ_INT32)w, nb_cols);
 			opj_v4dwt_decode(&v);
 
-			for(k = 0; k < rh; ++k){
-				memcpy(&aj[k*w], &v.wavelet[k], 4 * sizeof(OPJ_FLOAT32));
+			if (nb_cols == lanes) {
+				switch (lanes) {
+					case 16: opj_v4dwt_copy_rows(aj, w, v.wavelet, 16, rh, 16); break;
+					case 8: opj_v4dwt_copy_rows(aj, w, v.wavelet, 8, rh, 8); break;
+					default: opj_v4dwt_copy_rows(aj, w, v.wavelet, 4, rh, 4); break;
+				}
 			}
-			aj += 4;
-		}
-
-		if (rw & 0x03){
-			OPJ_UINT32 k;
-
-			j = rw & 0x03;
-
-			opj_v4dwt_interleave_v(&v, aj, (OPJ_INT32)w, j);
-			opj_v4dwt_decode(&v);
-
-			for(k = 0; k < rh; ++k){
-				memcpy(&aj[k*w], &v.wavelet[k], (size_t)j * sizeof(OPJ_FLOAT32));
+			else {
+				for(k = 0; k < rh; ++k){
+					memcpy(&aj[k*w], &v.wavelet[k * (OPJ_UINT32)lanes], (size_t)nb_cols * sizeof(OPJ_FLOAT32));
+				}
 			}
+			aj += lanes;
 		}
 	}
 
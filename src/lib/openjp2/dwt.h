@@ -56,17 +56,26 @@ DWT.C are used by some function in TCD.C.
 /**
 Forward 5-3 wavelet tranform in 2-D. 
 Apply a reversible DWT transform to a component of an image.
+@param kernels Kernels selected for the CPU
 @param tilec Tile component information (current tile)
 */
-OPJ_BOOL opj_dwt_encode(opj_tcd_tilecomp_t * tilec);
+OPJ_BOOL opj_dwt_encode(const opj_kernels_t* kernels, opj_tcd_tilecomp_t * tilec);
 
 /**
 Inverse 5-3 wavelet tranform in 2-D.
 Apply a reversible inverse DWT transform to a component of an image.
+Only the rows and columns needed to reconstruct the area (win_x0, win_y0,
+win_x1, win_y1) are transformed; the other samples are left undefined.
+@param kernels Kernels selected for the CPU
 @param tilec Tile component information (current tile)
 @param numres Number of resolution levels to decode
+@param win_x0 Left of the area, in coordinates of resolution level numres-1 (within its bounds)
+@param win_y0 Top of the area
+@param win_x1 Right of the area
+@param win_y1 Bottom of the area
 */
-OPJ_BOOL opj_dwt_decode(opj_tcd_tilecomp_t* tilec, OPJ_UINT32 numres);
+OPJ_BOOL opj_dwt_decode(const opj_kernels_t* kernels, opj_tcd_tilecomp_t* tilec, OPJ_UINT32 numres,
+                        OPJ_UINT32 win_x0, OPJ_UINT32 win_y0, OPJ_UINT32 win_x1, OPJ_UINT32 win_y1);
 
 /**
 Get the gain of a subband for the reversible 5-3 DWT.
@@ -84,16 +93,25 @@ OPJ_FLOAT64 opj_dwt_getnorm(OPJ_UINT32 level, OPJ_UINT32 orient);
 /**
 Forward 9-7 wavelet transform in 2-D. 
 Apply an irreversible DWT transform to a component of an image.
+@param kernels Kernels selected for the CPU
 @param tilec Tile component information (current tile)
 */
-OPJ_BOOL opj_dwt_encode_real(opj_tcd_tilecomp_t * tilec);
+OPJ_BOOL opj_dwt_encode_real(const opj_kernels_t* kernels, opj_tcd_tilecomp_t * tilec);
 /**
 Inverse 9-7 wavelet transform in 2-D. 
 Apply an irreversible inverse DWT transform to a component of an image.
+Only the rows and columns needed to reconstruct the area (win_x0, win_y0,
+win_x1, win_y1) are transformed; the other samples are left undefined.
+@param kernels Kernels selected for the CPU
 @param tilec Tile component information (current tile)
 @param numres Number of resolution levels to decode
+@param win_x0 Left of the area, in coordinates of resolution level numres-1 (within its bounds)
+@param win_y0 Top of the area
+@param win_x1 Right of the area
+@param win_y1 Bottom of the area
 */
-OPJ_BOOL opj_dwt_decode_real(opj_tcd_tilecomp_t* restrict tilec, OPJ_UINT32 numres);
+OPJ_BOOL opj_dwt_decode_real(const opj_kernels_t* kernels, opj_tcd_tilecomp_t* restrict tilec, OPJ_UINT32 numres,
+                             OPJ_UINT32 win_x0, OPJ_UINT32 win_y0, OPJ_UINT32 win_x1, OPJ_UINT32 win_y1);
 
 /**
 Get the gain of a subband for the irreversible 9-7 DWT.
@@ -114,6 +132,12 @@ Explicit calculation of the Quantization Stepsizes
 @param prec Precint analyzed
 */
 void opj_dwt_calc_explicit_stepsizes(opj_tccp_t * tccp, OPJ_UINT32 prec);
+/**
+Fills the DWT entries of a kernel table.
+@param p_kernels Table to fill
+@param p_level Level of the kernels (OPJ_CPU_LEVEL_xxx)
+*/
+void opj_dwt_init_kernels(opj_kernels_t* p_kernels, OPJ_UINT32 p_level);
 /* ----------------------------------------------------------------------- */
 /*@}*/
 
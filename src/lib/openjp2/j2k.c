@@ -338,6 +338,70 @@ static OPJ_BOOL opj_j2k_pre_write_tile ( opj_j2k_t * p_j2k,
 
 static OPJ_BOOL opj_j2k_update_image_data (opj_tcd_t * p_tcd, OPJ_BYTE * p_data, opj_image_t* p_output_image);
 
+/**
+ * Gets the number of channels and the size of a sample of a pixel format.
+ *
+ * @return OPJ_FALSE if the format is unknown.
+ */
+static OPJ_BOOL opj_j2k_get_pixel_layout (OPJ_PIXEL_FORMAT p_format, OPJ_UINT32 * p_nb_channels, OPJ_UINT32 * p_sample_size);
+
+/**
+ * Writes the samples of a decoded tile in the caller buffer of the decoder (see opj_j2k_decode_into_buffer()).
+ * Tiles write disjoint areas of the buffer, so this may run concurrently for several tiles.
+ */
+static void opj_j2k_update_buffer_data (opj_tcd_t * p_tcd, const opj_j2k_dec_t * p_dec, const opj_image_t* p_output_image);
+
+/**
+ * Copies the number of decoded resolutions of each component from a decoded tile image to the output image.
+ */
+static void opj_j2k_update_image_resno_decoded (const opj_image_t* p_tile_image, opj_image_t* p_output_image);
+
+/**
+ * Reads the marker that follows the data of the tile-part just read (SOT or EOC).
+ */
+static OPJ_BOOL opj_j2k_read_next_tile_marker ( opj_j2k_t * p_j2k,
+                                                opj_stream_private_t *p_stream,
+                                                opj_event_mgr_t * p_manager );
+
+/**
+ * Reads the tile-parts until all the tile-parts of a tile are read.
+ *
+ * @param       p_j2k           the jpeg2000 codec.
+ * @param       p_go_on         set to OPJ_FALSE if there is no more tile to decode.
+ * @param       p_stream        the stream to read data from.
+ * @param       p_manager       the user event manager.
+ */
+static OPJ_BOOL opj_j2k_read_tile_parts(      opj_j2k_t * p_j2k,
+                                                OPJ_BOOL * p_go_on,
+                                                opj_stream_private_t *p_stream,
+                                                opj_event_mgr_t * p_manager );
+
+/**
+ * Reads and decodes the tiles concurrently, each tile being decoded by a worker thread.
+ */
+static OPJ_BOOL opj_j2k_decode_tiles_parallel ( opj_j2k_t *p_j2k,
+                                                opj_stream_private_t *p_stream,
+                                                opj_event_mgr_t * p_manager);
+
+/**
+ * Checks that the decoding of an image fits in the memory budget of the decoder, and computes
+ * how many tiles can be decoded at once within it (m_max_tiles_in_flight).
+ *
+ * The usage is estimated from the main header: the samples of the output image, and for each tile
+ * being decoded, the samples of its components, the buffer of its decoded samples, its code-blocks
+ * and its compressed data (the tiles being assumed to have similar compressed sizes).
+ *
+ * @param       p_j2k           the jpeg2000 codec.
+ * @param       p_image         the image to decode, with the decoded area and resolution.
+ * @param       p_stream        the stream to read data from.
+ * @param       p_manager       the user event manager.
+ * @return OPJ_FALSE if the decoding of a single tile does not fit in the budget.
+ */
+static OPJ_BOOL opj_j2k_check_memory_budget (   opj_j2k_t *p_j2k,
+                                                opj_image_t * p_image,
+                                                opj_stream_private_t *p_stream,
+                                                opj_event_mgr_t * p_manager);
+
 static void opj_get_tile_dimensions(opj_image_t * l_image,
 																		opj_tcd_tilecomp_t * l_tilec,
 																		opj_image_comp_t * l_img_comp,
@@ -356,6 +420,40 @@ static OPJ_BOOL opj_j2k_post_write_tile (opj_j2k_t * p_j2k,
                                                                              opj_stream_private_t *p_stream,
                                                                              opj_event_mgr_t * p_manager );
 
+/**
+ * Allocates the components of the current tile of the tile coder and copies the tile samples from the image.
+ *
+ * @param       p_tcd           the tile coder, initialized for the tile.
+ * @param       p_buffer        scratch buffer, reallocated if too small.
+ * @param       p_buffer_size   size of the scratch buffer.
+ * @param       p_manager       the user event manager.
+ */
+static OPJ_BOOL opj_j2k_copy_image_to_tile(     opj_tcd_t * p_tcd,
+                                                OPJ_BYTE ** p_buffer,
+                                                OPJ_UINT32 * p_buffer_size,
+                                                opj_event_mgr_t * p_manager );
+
+/**
+ * Encodes the current tile and writes all its tile-parts in m_encoded_tile_data.
+ *
+ * @param       p_j2k           the jpeg2000 codec.
+ * @param       p_data_written  number of bytes written in m_encoded_tile_data.
+ * @param       p_stream        the stream (not written to).
+ * @param       p_manager       the user event manager.
+ */
+static OPJ_BOOL opj_j2k_write_tile_parts(       opj_j2k_t * p_j2k,
+                                                OPJ_UINT32 * p_data_written,
+                                                opj_stream_private_t *p_stream,
+                                                opj_event_mgr_t * p_manager );
+
+/**
+ * Encodes the tiles concurrently, each tile being encoded by a worker thread.
+ * The tile-parts are written to the stream in the tile order.
+ */
+static OPJ_BOOL opj_j2k_encode_tiles_parallel ( opj_j2k_t *p_j2k,
+                                                opj_stream_private_t *p_stream,
+                                                opj_event_mgr_t * p_manager );
+
 /**
  * Sets up the procedures to do on writing header.
  * Developers wanting to extend the library can add their own writing procedures.
@@ -389,6 +487,44 @@ static OPJ_BOOL opj_j2k_get_end_header( opj_j2k_t *p_j2k,
 
 static OPJ_BOOL opj_j2k_allocate_tile_element_cstr_index(opj_j2k_t *p_j2k);
 
+/**
+ * Fills the tile-part positions of the codestream index from the lengths read in the TLM markers,
+ * so that the tile-parts of a tile are reached without reading the SOT markers before them.
+ *
+ * @param       p_j2k                   J2K codec.
+ * @param       p_stream                the stream, just after the first SOT marker.
+ * @param       p_manager               the user event manager.
+*/
+static OPJ_BOOL opj_j2k_build_tile_index_from_tlm(     opj_j2k_t *p_j2k,
+                                                        opj_stream_private_t *p_stream,
+                                                        opj_event_mgr_t * p_manager );
+
+/**
+ * Moves the stream just after the SOT marker of a tile-part located by the codestream index.
+ *
+ * @param       p_stream                the stream.
+ * @param       p_start_pos             position of the SOT marker.
+ * @param       p_manager               the user event manager.
+ * @return      OPJ_FALSE if the stream could not be moved or if there is no SOT marker there.
+*/
+static OPJ_BOOL opj_j2k_seek_tile_part( opj_stream_private_t *p_stream,
+                                        OPJ_OFF_T p_start_pos,
+                                        opj_event_mgr_t * p_manager );
+
+/**
+ * When a single tile is decoded, moves the stream just after the SOT marker of its next tile-part
+ * if the codestream index locates it, skipping the tile-parts of the other tiles in between.
+ *
+ * @param       p_j2k                   J2K codec.
+ * @param       p_stream                the stream, just after a tile-part of the tile.
+ * @param       p_moved                 set to OPJ_TRUE if the stream was moved.
+ * @param       p_manager               the user event manager.
+*/
+static OPJ_BOOL opj_j2k_seek_next_tile_part(   opj_j2k_t *p_j2k,
+                                                opj_stream_private_t *p_stream,
+                                                OPJ_BOOL * p_moved,
+                                                opj_event_mgr_t * p_manager );
+
 /*
  * -----------------------------------------------------------------------
  * -----------------------------------------------------------------------
@@ -718,6 +854,39 @@ static OPJ_BOOL opj_j2k_read_plt (  opj_j2k_t *p_j2k,
                                     OPJ_UINT32 p_header_size,
                                     opj_event_mgr_t * p_manager );
 
+/**
+ * Grows an array of lengths so that it holds at least p_size of them.
+ *
+ * @param       p_lengths               the array of lengths, reallocated.
+ * @param       p_max_lengths           the size of the array, updated.
+ * @param       p_size                  the number of lengths needed.
+*/
+static OPJ_BOOL opj_j2k_reserve_lengths(OPJ_UINT32 ** p_lengths,
+                                        OPJ_UINT32 * p_max_lengths,
+                                        OPJ_UINT32 p_size );
+
+/**
+ * Notes where the packet lengths of a tile-part start, when its SOT marker is read.
+ *
+ * @param       p_j2k                   the jpeg2000 codec.
+ * @param       p_sot_pos               position of the SOT marker.
+*/
+static void opj_j2k_begin_tile_part_packet_lengths(     opj_j2k_t *p_j2k,
+                                                        OPJ_OFF_T p_sot_pos );
+
+/**
+ * Checks the packet lengths of a tile-part against its data. The lengths of the PLM markers are
+ * taken when the tile-part has no PLT marker. Lengths that do not match are not used, nor the
+ * lengths of the later tile-parts of the tile.
+ *
+ * @param       p_j2k                   the jpeg2000 codec.
+ * @param       p_data_size             size of the data of the tile-part.
+ * @param       p_manager               the user event manager.
+*/
+static OPJ_BOOL opj_j2k_end_tile_part_packet_lengths(   opj_j2k_t *p_j2k,
+                                                        OPJ_UINT32 p_data_size,
+                                                        opj_event_mgr_t * p_manager );
+
 #if 0
 /**
  * Reads a PPM marker (Packed packet headers, main header)
@@ -821,6 +990,47 @@ static OPJ_BOOL opj_j2k_read_sod(   opj_j2k_t *p_j2k,
                                     opj_stream_private_t *p_stream,
                                     opj_event_mgr_t * p_manager );
 
+/**
+ * Tells if the data of the current tile-part may leave out packets that the decoding of its tile
+ * does not need, with a reduced resolution or a smaller number of layers. The packets needed by
+ * the tile are listed in its tcp (m_needed_packets) the first time.
+ *
+ * @param       p_j2k                   the jpeg2000 codec.
+ * @param       p_stream                the stream the tile-part is read from.
+ */
+static OPJ_BOOL opj_j2k_may_skip_packets(   opj_j2k_t *p_j2k,
+                                            opj_stream_private_t *p_stream );
+
+/**
+ * Reads the data of the current tile-part without the packets its tile does not need: their bodies
+ * are skipped in the stream, and so is the rest of the tile-part after the last packet needed.
+ * The lengths of the packets come from the PLT/PLM markers, or else from their headers, read
+ * ahead of their bodies. In the packet lengths of the tile, a packet left out gets the length of
+ * its header when it is kept for the state of its precinct, 0 otherwise.
+ *
+ * @param       p_j2k                   the jpeg2000 codec.
+ * @param       p_stream                the stream to read the tile-part from.
+ * @param       p_read_size             set to the number of bytes of the tile-part read or skipped.
+ * @param       p_manager               the user event manager.
+ */
+static OPJ_BOOL opj_j2k_read_needed_packets(    opj_j2k_t *p_j2k,
+                                                opj_stream_private_t *p_stream,
+                                                OPJ_SIZE_T * p_read_size,
+                                                opj_event_mgr_t * p_manager );
+
+/**
+ * Grows the data of a tile to hold at least p_size bytes, doubling its size up to p_max_size.
+ */
+static OPJ_BOOL opj_j2k_reserve_tile_data(  opj_tcp_t * p_tcp,
+                                            OPJ_SIZE_T * p_capacity,
+                                            OPJ_SIZE_T p_size,
+                                            OPJ_SIZE_T p_max_size );
+
+/**
+ * Tells if the tiles are decoded concurrently by opj_j2k_decode_tiles_parallel().
+ */
+static OPJ_BOOL opj_j2k_use_tile_parallel_decoding(opj_j2k_t *p_j2k);
+
 void opj_j2k_update_tlm (opj_j2k_t * p_j2k, OPJ_UINT32 p_tile_part_size )
 {
         opj_write_bytes(p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_current,p_j2k->m_current_tile_number,1);            /* PSOT */
@@ -3283,6 +3493,8 @@ static OPJ_BOOL opj_j2k_read_tlm (  opj_j2k_t *p_j2k,
                                     )
 {
         OPJ_UINT32 l_Ztlm, l_Stlm, l_ST, l_SP, l_tot_num_tp_remaining, l_quotient, l_Ptlm_size;
+        OPJ_UINT32 l_tot_num_tp, l_Ttlm_i, l_Ptlm_i, l_nb_tiles, i;
+        opj_cp_t *l_cp = 00;
         /* preconditions */
         assert(p_header_data != 00);
         assert(p_j2k != 00);
@@ -3311,16 +3523,55 @@ static OPJ_BOOL opj_j2k_read_tlm (  opj_j2k_t *p_j2k,
                 opj_event_msg(p_manager, EVT_ERROR, "Error reading TLM marker\n");
                 return OPJ_FALSE;
         }
-        /* FIXME Do not care of this at the moment since only local variables are set here */
-        /*
-        for
-                (i = 0; i < l_tot_num_tp; ++i)
-        {
-                opj_read_bytes(p_header_data,&l_Ttlm_i,l_ST);                           // Ttlm_i
-                p_header_data += l_ST;
-                opj_read_bytes(p_header_data,&l_Ptlm_i,l_Ptlm_size);            // Ptlm_i
+
+        /* the tile-part lengths are kept to locate the tile-parts of a tile without */
+        /* reading the SOT markers before them, which needs all the markers in order */
+        l_cp = &(p_j2k->m_cp);
+        l_nb_tiles = l_cp->tw * l_cp->th;
+        if (l_cp->tlm_ignored || l_ST == 3 || l_Ztlm != l_cp->tlm_nb_markers) {
+                l_cp->tlm_ignored = 1;
+                return OPJ_TRUE;
+        }
+        ++l_cp->tlm_nb_markers;
+
+        l_tot_num_tp = p_header_size / l_quotient;
+        if (l_tot_num_tp > l_cp->tlm_max_entries - l_cp->tlm_nb_entries) {
+                opj_j2k_tlm_entry_t *l_new_entries = 00;
+                OPJ_UINT32 l_max_entries = l_cp->tlm_nb_entries + l_tot_num_tp;
+                if (l_max_entries < l_cp->tlm_nb_entries) {
+                        l_cp->tlm_ignored = 1;
+                        return OPJ_TRUE;
+                }
+                l_new_entries = (opj_j2k_tlm_entry_t *) opj_realloc(l_cp->tlm_entries, l_max_entries * sizeof(opj_j2k_tlm_entry_t));
+                if (! l_new_entries) {
+                        opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to read TLM marker\n");
+                        return OPJ_FALSE;
+                }
+                l_cp->tlm_entries = l_new_entries;
+                l_cp->tlm_max_entries = l_max_entries;
+        }
+
+        for (i = 0; i < l_tot_num_tp; ++i) {
+                if (l_ST) {
+                        opj_read_bytes(p_header_data,&l_Ttlm_i,l_ST);                   /* Ttlm_i */
+                        p_header_data += l_ST;
+                }
+                else {
+                        /* one tile-part per tile, in the order of the tiles */
+                        l_Ttlm_i = l_cp->tlm_nb_entries;
+                }
+                opj_read_bytes(p_header_data,&l_Ptlm_i,l_Ptlm_size);                    /* Ptlm_i */
                 p_header_data += l_Ptlm_size;
-        }*/
+
+                if (l_Ttlm_i >= l_nb_tiles || l_Ptlm_i < 14) {
+                        opj_event_msg(p_manager, EVT_WARNING, "Inconsistent TLM marker, tile-parts are located through their SOT markers\n");
+                        l_cp->tlm_ignored = 1;
+                        return OPJ_TRUE;
+                }
+                l_cp->tlm_entries[l_cp->tlm_nb_entries].m_tile_no = l_Ttlm_i;
+                l_cp->tlm_entries[l_cp->tlm_nb_entries].m_length = l_Ptlm_i;
+                ++l_cp->tlm_nb_entries;
+        }
         return OPJ_TRUE;
 }
 
@@ -3338,6 +3589,9 @@ static OPJ_BOOL opj_j2k_read_plm (  opj_j2k_t *p_j2k,
                                     opj_event_mgr_t * p_manager
                                     )
 {
+        OPJ_UINT32 l_Zplm, l_Nplm, l_tmp, l_packet_len = 0, i;
+        opj_cp_t *l_cp = 00;
+
         /* preconditions */
         assert(p_header_data != 00);
         assert(p_j2k != 00);
@@ -3347,61 +3601,67 @@ static OPJ_BOOL opj_j2k_read_plm (  opj_j2k_t *p_j2k,
                 opj_event_msg(p_manager, EVT_ERROR, "Error reading PLM marker\n");
                 return OPJ_FALSE;
         }
-        /* Do not care of this at the moment since only local variables are set here */
-        /*
-        opj_read_bytes(p_header_data,&l_Zplm,1);                                        // Zplm
+
+        opj_read_bytes(p_header_data,&l_Zplm,1);                /* Zplm */
         ++p_header_data;
         --p_header_size;
 
-        while
-                (p_header_size > 0)
-        {
-                opj_read_bytes(p_header_data,&l_Nplm,1);                                // Nplm
+        /* the packet lengths are assigned to the tile-parts in order, which needs all the markers in order */
+        l_cp = &(p_j2k->m_cp);
+        if (l_cp->plm_ignored || l_Zplm != l_cp->plm_nb_markers) {
+                l_cp->plm_ignored = 1;
+                return OPJ_TRUE;
+        }
+        ++l_cp->plm_nb_markers;
+
+        while (p_header_size > 0) {
+                opj_read_bytes(p_header_data,&l_Nplm,1);        /* Nplm */
                 ++p_header_data;
-                p_header_size -= (1+l_Nplm);
-                if
-                        (p_header_size < 0)
-                {
+                --p_header_size;
+                if (l_Nplm > p_header_size) {
                         opj_event_msg(p_manager, EVT_ERROR, "Error reading PLM marker\n");
-                        return false;
+                        return OPJ_FALSE;
                 }
-                for
-                        (i = 0; i < l_Nplm; ++i)
-                {
-                        opj_read_bytes(p_header_data,&l_tmp,1);                         // Iplm_ij
+
+                /* a new tile-part */
+                if (l_cp->plm_nb_tile_parts == l_cp->plm_max_tile_parts) {
+                        if (! opj_j2k_reserve_lengths(&(l_cp->plm_tile_parts), &(l_cp->plm_max_tile_parts), l_cp->plm_nb_tile_parts + 1)) {
+                                opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to read PLM marker\n");
+                                return OPJ_FALSE;
+                        }
+                }
+                l_cp->plm_tile_parts[l_cp->plm_nb_tile_parts++] = l_cp->plm_nb_lengths;
+
+                for (i = 0; i < l_Nplm; ++i) {
+                        opj_read_bytes(p_header_data,&l_tmp,1); /* Iplm_ij */
                         ++p_header_data;
-                        // take only the last seven bytes
+                        /* take only the last seven bytes */
                         l_packet_len |= (l_tmp & 0x7f);
-                        if
-                                (l_tmp & 0x80)
-                        {
+                        if (l_tmp & 0x80) {
                                 l_packet_len <<= 7;
                         }
-                        else
-                        {
-                // store packet length and proceed to next packet
+                        else {
+                                /* store packet length and proceed to next packet */
+                                if (l_cp->plm_nb_lengths == l_cp->plm_max_lengths) {
+                                        if (! opj_j2k_reserve_lengths(&(l_cp->plm_lengths), &(l_cp->plm_max_lengths), l_cp->plm_nb_lengths + 1)) {
+                                                opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to read PLM marker\n");
+                                                return OPJ_FALSE;
+                                        }
+                                }
+                                l_cp->plm_lengths[l_cp->plm_nb_lengths++] = l_packet_len;
                                 l_packet_len = 0;
                         }
                 }
-                if
-                        (l_packet_len != 0)
-                {
+                p_header_size -= l_Nplm;
+
+                if (l_packet_len != 0) {
                         opj_event_msg(p_manager, EVT_ERROR, "Error reading PLM marker\n");
-                        return false;
+                        return OPJ_FALSE;
                 }
         }
-        */
+
         return OPJ_TRUE;
 }
-
-/**
- * Reads a PLT marker (Packet length, tile-part header)
- *
- * @param       p_header_data   the data contained in the PLT box.
- * @param       p_j2k                   the jpeg2000 codec.
- * @param       p_header_size   the size of the data contained in the PLT marker.
- * @param       p_manager               the user event manager.
-*/
 static OPJ_BOOL opj_j2k_read_plt (  opj_j2k_t *p_j2k,
                                     OPJ_BYTE * p_header_data,
                                     OPJ_UINT32 p_header_size,
@@ -3409,6 +3669,7 @@ static OPJ_BOOL opj_j2k_read_plt (  opj_j2k_t *p_j2k,
                                     )
 {
         OPJ_UINT32 l_Zplt, l_tmp, l_packet_len = 0, i;
+        opj_tcp_t *l_tcp = 00;
 
         /* preconditions */
         assert(p_header_data != 00);
@@ -3424,6 +3685,8 @@ static OPJ_BOOL opj_j2k_read_plt (  opj_j2k_t *p_j2k,
         ++p_header_data;
         --p_header_size;
 
+        l_tcp = &(p_j2k->m_cp.tcps[p_j2k->m_current_tile_number]);
+
         for (i = 0; i < p_header_size; ++i) {
                 opj_read_bytes(p_header_data,&l_tmp,1);         /* Iplt_ij */
                 ++p_header_data;
@@ -3433,7 +3696,14 @@ static OPJ_BOOL opj_j2k_read_plt (  opj_j2k_t *p_j2k,
                         l_packet_len <<= 7;
                 }
                 else {
-            /* store packet length and proceed to next packet */
+                        /* store packet length and proceed to next packet */
+                        if (l_tcp->m_nb_packet_lengths == l_tcp->m_max_packet_lengths) {
+                                if (! opj_j2k_reserve_lengths(&(l_tcp->m_packet_lengths), &(l_tcp->m_max_packet_lengths), l_tcp->m_nb_packet_lengths + 1)) {
+                                        opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to read PLT marker\n");
+                                        return OPJ_FALSE;
+                                }
+                        }
+                        l_tcp->m_packet_lengths[l_tcp->m_nb_packet_lengths++] = l_packet_len;
                         l_packet_len = 0;
                 }
         }
@@ -3446,6 +3716,103 @@ static OPJ_BOOL opj_j2k_read_plt (  opj_j2k_t *p_j2k,
         return OPJ_TRUE;
 }
 
+static OPJ_BOOL opj_j2k_reserve_lengths(OPJ_UINT32 ** p_lengths,
+                                        OPJ_UINT32 * p_max_lengths,
+                                        OPJ_UINT32 p_size )
+{
+        OPJ_UINT32 * l_new_lengths = 00;
+        OPJ_UINT32 l_max_lengths = *p_max_lengths ? *p_max_lengths : 64;
+
+        if (p_size <= *p_max_lengths) {
+                return OPJ_TRUE;
+        }
+        while (l_max_lengths < p_size) {
+                /* the size in bytes has to fit on 32 bits */
+                if (l_max_lengths > ((OPJ_UINT32)-1) / (2 * (OPJ_UINT32)sizeof(OPJ_UINT32))) {
+                        return OPJ_FALSE;
+                }
+                l_max_lengths *= 2;
+        }
+
+        l_new_lengths = (OPJ_UINT32 *) opj_realloc(*p_lengths, l_max_lengths * sizeof(OPJ_UINT32));
+        if (! l_new_lengths) {
+                return OPJ_FALSE;
+        }
+        *p_lengths = l_new_lengths;
+        *p_max_lengths = l_max_lengths;
+
+        return OPJ_TRUE;
+}
+
+static void opj_j2k_begin_tile_part_packet_lengths(     opj_j2k_t *p_j2k,
+                                                        OPJ_OFF_T p_sot_pos )
+{
+        opj_cp_t * l_cp = &(p_j2k->m_cp);
+        opj_j2k_dec_t * l_dec = &(p_j2k->m_specific_param.m_decoder);
+
+        l_dec->m_tp_first_packet_length = l_cp->tcps[p_j2k->m_current_tile_number].m_nb_packet_lengths;
+
+        /* the PLM markers list the tile-parts in the order of the codestream: a tile-part */
+        /* is known to be the next one only when the tile-parts are read one after the other */
+        l_dec->m_plm_tile_part = -1;
+        if (l_cp->plm_ignored || p_sot_pos != l_cp->plm_next_sot_pos
+            || l_cp->plm_nb_tile_parts_read >= l_cp->plm_nb_tile_parts) {
+                return;
+        }
+        l_dec->m_plm_tile_part = (OPJ_INT32)l_cp->plm_nb_tile_parts_read++;
+        l_cp->plm_next_sot_pos = p_sot_pos + l_dec->m_sot_length + 12;
+}
+
+static OPJ_BOOL opj_j2k_end_tile_part_packet_lengths(   opj_j2k_t *p_j2k,
+                                                        OPJ_UINT32 p_data_size,
+                                                        opj_event_mgr_t * p_manager )
+{
+        opj_cp_t * l_cp = &(p_j2k->m_cp);
+        opj_j2k_dec_t * l_dec = &(p_j2k->m_specific_param.m_decoder);
+        opj_tcp_t * l_tcp = &(l_cp->tcps[p_j2k->m_current_tile_number]);
+        OPJ_UINT32 l_total = 0, i;
+
+        if (l_tcp->m_packet_lengths_invalid || l_dec->m_tp_first_packet_length > l_tcp->m_nb_packet_lengths) {
+                l_tcp->m_packet_lengths_invalid = 1;
+                l_tcp->m_nb_packet_lengths = opj_uint_min(l_tcp->m_nb_packet_lengths, l_dec->m_tp_first_packet_length);
+                return OPJ_TRUE;
+        }
+
+        if (l_tcp->m_nb_packet_lengths == l_dec->m_tp_first_packet_length && l_dec->m_plm_tile_part >= 0) {
+                OPJ_UINT32 l_tile_part = (OPJ_UINT32)l_dec->m_plm_tile_part;
+                OPJ_UINT32 l_first = l_cp->plm_tile_parts[l_tile_part];
+                OPJ_UINT32 l_last = (l_tile_part + 1 < l_cp->plm_nb_tile_parts) ? l_cp->plm_tile_parts[l_tile_part + 1] : l_cp->plm_nb_lengths;
+
+                if (! opj_j2k_reserve_lengths(&(l_tcp->m_packet_lengths), &(l_tcp->m_max_packet_lengths), l_tcp->m_nb_packet_lengths + (l_last - l_first))) {
+                        opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to read the packet lengths\n");
+                        return OPJ_FALSE;
+                }
+                for (i = l_first; i < l_last; ++i) {
+                        l_tcp->m_packet_lengths[l_tcp->m_nb_packet_lengths++] = l_cp->plm_lengths[i];
+                }
+        }
+
+        /* packets do not span tile-parts: their lengths add up to the data of the tile-part */
+        for (i = l_dec->m_tp_first_packet_length; i < l_tcp->m_nb_packet_lengths; ++i) {
+                OPJ_UINT32 l_length = l_tcp->m_packet_lengths[i];
+                if (l_length == 0 || l_length > p_data_size - l_total) {
+                        break;
+                }
+                l_total += l_length;
+        }
+        if (i != l_tcp->m_nb_packet_lengths || l_total != p_data_size) {
+                if (l_tcp->m_nb_packet_lengths != l_dec->m_tp_first_packet_length) {
+                        opj_event_msg(p_manager, EVT_WARNING, "Packet lengths of tile %d do not match its data, the headers of its next packets are all read\n",
+                                      p_j2k->m_current_tile_number + 1);
+                }
+                /* the lengths of the tile-parts before stay valid */
+                l_tcp->m_packet_lengths_invalid = 1;
+                l_tcp->m_nb_packet_lengths = l_dec->m_tp_first_packet_length;
+        }
+
+        return OPJ_TRUE;
+}
+
 #if 0
 OPJ_BOOL j2k_read_ppm_v2 (
                                                 opj_j2k_t *p_j2k,
@@ -4348,33 +4715,315 @@ OPJ_BOOL opj_j2k_write_sod(     opj_j2k_t *p_j2k,
         return OPJ_TRUE;
 }
 
-OPJ_BOOL opj_j2k_read_sod (opj_j2k_t *p_j2k,
-                           opj_stream_private_t *p_stream,
-                                                   opj_event_mgr_t * p_manager
-                           )
+static OPJ_BOOL opj_j2k_may_skip_packets(   opj_j2k_t *p_j2k,
+                                            opj_stream_private_t *p_stream )
 {
-        OPJ_SIZE_T l_current_read_size;
-        opj_codestream_index_t * l_cstr_index = 00;
-        OPJ_BYTE ** l_current_data = 00;
-        opj_tcp_t * l_tcp = 00;
-        OPJ_UINT32 * l_tile_len = 00;
-        OPJ_BOOL l_sot_length_pb_detected = OPJ_FALSE;
+        opj_cp_t * l_cp = &(p_j2k->m_cp);
+        opj_tcp_t * l_tcp = &(l_cp->tcps[p_j2k->m_current_tile_number]);
+        OPJ_UINT32 i;
 
-        /* preconditions */
-        assert(p_j2k != 00);
-        assert(p_manager != 00);
-        assert(p_stream != 00);
+        /* the data of a memory stream is not read (see opj_stream_read_data_in_place()), and */
+        /* with packed packet headers (PPM/PPT), the headers of the packets left out are needed */
+        if ((! l_cp->m_specific_param.m_dec.m_reduce && ! l_cp->m_specific_param.m_dec.m_layer)
+            || opj_stream_is_in_memory(p_stream) || l_tcp->m_data_borrowed
+            || l_cp->ppm || l_tcp->ppt) {
+                return OPJ_FALSE;
+        }
 
-        l_tcp = &(p_j2k->m_cp.tcps[p_j2k->m_current_tile_number]);
+        if (! l_tcp->m_needed_packets) {
+                opj_t2_t * l_t2 = opj_t2_create(p_j2k->m_private_image, l_cp);
+                OPJ_BOOL l_ok;
 
-        if (p_j2k->m_specific_param.m_decoder.m_last_tile_part) {
-                /* opj_stream_get_number_byte_left returns OPJ_OFF_T
-                // but we are in the last tile part,
-                // so its result will fit on OPJ_UINT32 unless we find
-                // a file with a single tile part of more than 4 GB...*/
-                p_j2k->m_specific_param.m_decoder.m_sot_length = (OPJ_UINT32)(opj_stream_get_number_byte_left(p_stream) - 2);
-        }
-        else {
+                if (! l_t2) {
+                        return OPJ_FALSE;
+                }
+                l_ok = opj_t2_get_needed_packets(l_t2, p_j2k->m_current_tile_number, &(l_tcp->m_needed_packets), &(l_tcp->m_nb_packets));
+                opj_t2_destroy(l_t2);
+                if (! l_ok || ! l_tcp->m_needed_packets) {
+                        return OPJ_FALSE;
+                }
+
+                l_tcp->m_end_needed_packets = 0;
+                for (i = 0; i < l_tcp->m_nb_packets; ++i) {
+                        if (l_tcp->m_needed_packets[i]) {
+                                l_tcp->m_end_needed_packets = i + 1;
+                        }
+                }
+        }
+
+        for (i = 0; i < l_tcp->m_nb_packets; ++i) {
+                if (! l_tcp->m_needed_packets[i]) {
+                        return OPJ_TRUE;
+                }
+        }
+        return OPJ_FALSE;
+}
+
+static OPJ_BOOL opj_j2k_reserve_tile_data(  opj_tcp_t * p_tcp,
+                                            OPJ_SIZE_T * p_capacity,
+                                            OPJ_SIZE_T p_size,
+                                            OPJ_SIZE_T p_max_size )
+{
+        OPJ_BYTE * l_new_data = 00;
+        OPJ_SIZE_T l_capacity = *p_capacity;
+
+        if (p_size <= l_capacity) {
+                return OPJ_TRUE;
+        }
+        l_capacity = (l_capacity > p_max_size / 2) ? p_max_size : 2 * l_capacity;
+        if (l_capacity < p_size) {
+                l_capacity = p_size;
+        }
+
+        l_new_data = (OPJ_BYTE *) opj_realloc(p_tcp->m_data, l_capacity);
+        if (! l_new_data) {
+                return OPJ_FALSE;
+        }
+        p_tcp->m_data = l_new_data;
+        *p_capacity = l_capacity;
+
+        return OPJ_TRUE;
+}
+
+static OPJ_BOOL opj_j2k_read_needed_packets(    opj_j2k_t *p_j2k,
+                                                opj_stream_private_t *p_stream,
+                                                OPJ_SIZE_T * p_read_size,
+                                                opj_event_mgr_t * p_manager )
+{
+        opj_j2k_dec_t * l_dec = &(p_j2k->m_specific_param.m_decoder);
+        OPJ_UINT32 l_tile_no = p_j2k->m_current_tile_number;
+        opj_tcp_t * l_tcp = &(p_j2k->m_cp.tcps[l_tile_no]);
+        OPJ_UINT32 l_first = l_dec->m_tp_first_packet_length;
+        OPJ_UINT32 l_packet_no = l_first;
+        /* bytes of the tile-part not read nor skipped yet */
+        OPJ_UINT32 l_left = l_dec->m_sot_length;
+        /* bytes read ahead of the packets, at l_window in the data of the tile */
+        OPJ_UINT32 l_ahead = 0;
+        OPJ_UINT32 l_window = l_tcp->m_data_size;
+        OPJ_SIZE_T l_capacity = l_tcp->m_data_size;
+        OPJ_SIZE_T l_max_size = (OPJ_SIZE_T)l_tcp->m_data_size + l_dec->m_sot_length;
+        OPJ_BOOL l_had_lengths = (l_tcp->m_nb_packet_lengths > l_first) || (l_dec->m_plm_tile_part >= 0);
+        OPJ_BOOL l_was_invalid = l_tcp->m_packet_lengths_invalid;
+        OPJ_BOOL l_was_scanned = (l_dec->m_scanned_tile_number == (OPJ_INT32)l_tile_no);
+        OPJ_BOOL l_read_all = OPJ_FALSE;
+        OPJ_BOOL l_truncated = OPJ_FALSE;
+        opj_t2_t * l_t2 = 00;
+        opj_t2_scan_t * l_scan = 00;
+        OPJ_SIZE_T l_nb_bytes;
+        OPJ_OFF_T l_nb_skipped;
+        OPJ_UINT32 l_size;
+        OPJ_UINT32 i;
+
+        *p_read_size = 0;
+
+        /* the tile coder keeps the state of the headers read only if this tile-part goes on with them */
+        if (l_was_scanned) {
+                l_dec->m_scanned_tile_number = -1;
+        }
+
+        if (! opj_j2k_end_tile_part_packet_lengths(p_j2k, l_left, p_manager)) {
+                return OPJ_FALSE;
+        }
+
+        if (l_first < l_tcp->m_end_needed_packets && l_tcp->m_nb_packet_lengths == l_first) {
+                /* without packet lengths, the headers are read with the tile coder, which keeps */
+                /* their state from a tile-part to the next unless another tile is read in between */
+                if (! l_had_lengths && ! l_was_invalid && ! opj_j2k_use_tile_parallel_decoding(p_j2k)
+                    && (l_first == 0 || l_was_scanned)) {
+                        if (l_first != 0 || opj_tcd_init_decode_tile(p_j2k->m_tcd, l_tile_no)) {
+                                l_t2 = opj_t2_create(p_j2k->m_private_image, &(p_j2k->m_cp));
+                        }
+                        if (l_t2) {
+                                l_scan = opj_t2_create_scan(l_t2, l_tile_no, p_j2k->m_tcd->tcd_image->tiles);
+                        }
+                        for (i = 0; l_scan && i < l_first; ++i) {
+                                if (! opj_t2_scan_next(l_scan)) {
+                                        opj_t2_destroy_scan(l_scan);
+                                        l_scan = 00;
+                                }
+                        }
+                        if (l_scan) {
+                                l_dec->m_scanned_tile_number = (OPJ_INT32)l_tile_no;
+                                l_tcp->m_packet_lengths_invalid = 0;
+                        }
+                }
+                /* else the packets cannot be told apart, the whole tile-part is read */
+                l_read_all = (l_scan == 00);
+
+                /* the headers after the lengths known are read with the state of their */
+                /* precinct, which the packets left out with no header do not give */
+                for (i = 0; l_read_all && i < l_tcp->m_nb_packet_lengths; ++i) {
+                        if (l_tcp->m_packet_lengths[i] == 0) {
+                                opj_event_msg(p_manager, EVT_WARNING, "Packet lengths of tile %d are missing after packets left out, the tile may not be decoded correctly\n",
+                                              l_tile_no + 1);
+                                break;
+                        }
+                }
+        }
+
+        while (! l_read_all && l_packet_no < l_tcp->m_end_needed_packets && l_left + l_ahead > 0) {
+                OPJ_BOOL l_needed = l_packet_no < l_tcp->m_nb_packets && l_tcp->m_needed_packets[l_packet_no];
+                OPJ_UINT32 l_header_length;
+                OPJ_UINT32 l_length;
+                /* bytes of the packet kept in the data of the tile */
+                OPJ_UINT32 l_keep;
+
+                if (l_scan) {
+                        /* enough bytes are read ahead for the header of the packet */
+                        if (l_ahead < OPJ_J2K_PACKET_SCAN_WINDOW / 2 && l_left > 0) {
+                                l_size = opj_uint_min(l_left, OPJ_J2K_PACKET_SCAN_WINDOW - l_ahead);
+                                if (l_window != l_tcp->m_data_size) {
+                                        memmove(l_tcp->m_data + l_tcp->m_data_size, l_tcp->m_data + l_window, l_ahead);
+                                        l_window = l_tcp->m_data_size;
+                                }
+                                if (! opj_j2k_reserve_tile_data(l_tcp, &l_capacity, (OPJ_SIZE_T)l_window + l_ahead + l_size, l_max_size)) {
+                                        opj_t2_destroy_scan(l_scan);
+                                        opj_t2_destroy(l_t2);
+                                        opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to decode tile\n");
+                                        return OPJ_FALSE;
+                                }
+                                l_nb_bytes = opj_stream_read_data(p_stream, l_tcp->m_data + l_window + l_ahead, l_size, p_manager);
+                                l_ahead += (OPJ_UINT32)l_nb_bytes;
+                                *p_read_size += l_nb_bytes;
+                                /* at the end of the stream, the packets read ahead are still used */
+                                l_left = (l_nb_bytes == l_size) ? l_left - l_size : 0;
+                        }
+
+                        if (! opj_t2_scan_next(l_scan)
+                            || ! opj_t2_scan_packet(l_scan, l_tcp->m_data + l_window, l_ahead, l_ahead + l_left, &l_header_length, &l_length)
+                            || ! opj_j2k_reserve_lengths(&(l_tcp->m_packet_lengths), &(l_tcp->m_max_packet_lengths), l_tcp->m_nb_packet_lengths + 1)) {
+                                /* the packets cannot be followed anymore: the rest of the tile-part is read */
+                                l_dec->m_scanned_tile_number = -1;
+                                l_tcp->m_packet_lengths_invalid = 1;
+                                l_read_all = OPJ_TRUE;
+                                break;
+                        }
+                        /* the header of a packet left out is kept for the state of its precinct, */
+                        /* in case the headers of the next packets are read again by T2 */
+                        l_keep = l_needed ? l_length : l_header_length;
+                        l_tcp->m_packet_lengths[l_tcp->m_nb_packet_lengths++] = l_keep;
+                }
+                else {
+                        l_length = l_tcp->m_packet_lengths[l_packet_no];
+                        l_keep = l_needed ? l_length : 0;
+                        l_tcp->m_packet_lengths[l_packet_no] = l_keep;
+                }
+
+                /* the bytes kept go at the end of the data of the tile */
+                l_size = opj_uint_min(l_keep, l_ahead);
+                if (l_size > 0 && l_window != l_tcp->m_data_size) {
+                        memmove(l_tcp->m_data + l_tcp->m_data_size, l_tcp->m_data + l_window, l_size);
+                }
+                l_tcp->m_data_size += l_size;
+                l_window += l_size;
+                l_ahead -= l_size;
+
+                if (l_size < l_keep) {
+                        l_size = l_keep - l_size;
+                        if (! opj_j2k_reserve_tile_data(l_tcp, &l_capacity, (OPJ_SIZE_T)l_tcp->m_data_size + opj_uint_min(l_size, l_left), l_max_size)) {
+                                opj_t2_destroy_scan(l_scan);
+                                opj_t2_destroy(l_t2);
+                                opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to decode tile\n");
+                                return OPJ_FALSE;
+                        }
+                        l_nb_bytes = opj_stream_read_data(p_stream, l_tcp->m_data + l_tcp->m_data_size, opj_uint_min(l_size, l_left), p_manager);
+                        l_tcp->m_data_size += (OPJ_UINT32)l_nb_bytes;
+                        l_window = l_tcp->m_data_size;
+                        l_left -= (OPJ_UINT32)l_nb_bytes;
+                        *p_read_size += l_nb_bytes;
+                        if (l_nb_bytes != l_size) {
+                                /* the packet is kept as it is, and decoded as far as possible */
+                                l_truncated = OPJ_TRUE;
+                                break;
+                        }
+                }
+
+                /* the rest of the packet is dropped */
+                l_length -= l_keep;
+                if (l_length <= l_ahead) {
+                        l_window += l_length;
+                        l_ahead -= l_length;
+                }
+                else {
+                        /* from the stream, past the bytes read ahead */
+                        l_size = l_length - l_ahead;
+                        l_window = l_tcp->m_data_size;
+                        l_ahead = 0;
+                        l_nb_skipped = (l_size <= l_left) ? opj_stream_skip(p_stream, (OPJ_OFF_T)l_size, p_manager) : -1;
+                        if (l_nb_skipped != (OPJ_OFF_T)l_size) {
+                                l_truncated = OPJ_TRUE;
+                                break;
+                        }
+                        l_left -= l_size;
+                        *p_read_size += l_size;
+                }
+                ++l_packet_no;
+        }
+
+        opj_t2_destroy_scan(l_scan);
+        opj_t2_destroy(l_t2);
+
+        if (l_truncated) {
+                /* the packets from the one cut on are not known */
+                l_tcp->m_packet_lengths_invalid = 1;
+                l_tcp->m_nb_packet_lengths = opj_uint_min(l_tcp->m_nb_packet_lengths, l_packet_no);
+                return OPJ_TRUE;
+        }
+
+        if (l_read_all) {
+                /* the bytes read ahead and the rest of the tile-part are kept */
+                if (l_window != l_tcp->m_data_size) {
+                        memmove(l_tcp->m_data + l_tcp->m_data_size, l_tcp->m_data + l_window, l_ahead);
+                }
+                l_tcp->m_data_size += l_ahead;
+                if (! opj_j2k_reserve_tile_data(l_tcp, &l_capacity, (OPJ_SIZE_T)l_tcp->m_data_size + l_left, l_max_size)) {
+                        opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to decode tile\n");
+                        return OPJ_FALSE;
+                }
+                l_nb_bytes = opj_stream_read_data(p_stream, l_tcp->m_data + l_tcp->m_data_size, l_left, p_manager);
+                l_tcp->m_data_size += (OPJ_UINT32)l_nb_bytes;
+                *p_read_size += l_nb_bytes;
+        }
+        else if (l_left > 0) {
+                /* the tile has the packets it needs: the rest of the tile-part is skipped */
+                l_nb_skipped = opj_stream_skip(p_stream, (OPJ_OFF_T)l_left, p_manager);
+                if (l_nb_skipped > 0) {
+                        *p_read_size += (OPJ_SIZE_T)l_nb_skipped;
+                }
+        }
+
+        return OPJ_TRUE;
+}
+
+OPJ_BOOL opj_j2k_read_sod (opj_j2k_t *p_j2k,
+                           opj_stream_private_t *p_stream,
+                                                   opj_event_mgr_t * p_manager
+                           )
+{
+        OPJ_SIZE_T l_current_read_size;
+        opj_codestream_index_t * l_cstr_index = 00;
+        OPJ_BYTE ** l_current_data = 00;
+        opj_tcp_t * l_tcp = 00;
+        OPJ_UINT32 * l_tile_len = 00;
+        OPJ_BOOL l_sot_length_pb_detected = OPJ_FALSE;
+        OPJ_BOOL l_in_place = OPJ_FALSE;
+        OPJ_BOOL l_skip_packets = OPJ_FALSE;
+
+        /* preconditions */
+        assert(p_j2k != 00);
+        assert(p_manager != 00);
+        assert(p_stream != 00);
+
+        l_tcp = &(p_j2k->m_cp.tcps[p_j2k->m_current_tile_number]);
+
+        if (p_j2k->m_specific_param.m_decoder.m_last_tile_part) {
+                /* opj_stream_get_number_byte_left returns OPJ_OFF_T
+                // but we are in the last tile part,
+                // so its result will fit on OPJ_UINT32 unless we find
+                // a file with a single tile part of more than 4 GB...*/
+                p_j2k->m_specific_param.m_decoder.m_sot_length = (OPJ_UINT32)(opj_stream_get_number_byte_left(p_stream) - 2);
+        }
+        else {
             /* Check to avoid pass the limit of OPJ_UINT32 */
             if (p_j2k->m_specific_param.m_decoder.m_sot_length >= 2 )
                 p_j2k->m_specific_param.m_decoder.m_sot_length -= 2;
@@ -4394,12 +5043,30 @@ OPJ_BOOL opj_j2k_read_sod (opj_j2k_t *p_j2k,
                 opj_event_msg(p_manager, EVT_ERROR, "Tile part length size inconsistent with stream length\n");
                 return OPJ_FALSE;
             }
-            if (! *l_current_data) {
+            if (opj_j2k_may_skip_packets(p_j2k, p_stream)) {
+                /* the data is read packet by packet, see opj_j2k_read_needed_packets() */
+                l_skip_packets = OPJ_TRUE;
+            }
+            else if (! *l_current_data && opj_stream_is_in_memory(p_stream)) {
+                /* the first tile-part is referenced where it lies, in the data of the stream */
+                l_in_place = OPJ_TRUE;
+            }
+            else if (! *l_current_data) {
                 /* LH: oddly enough, in this path, l_tile_len!=0.
                  * TODO: If this was consistant, we could simplify the code to only use realloc(), as realloc(0,...) default to malloc(0,...).
                  */
                 *l_current_data = (OPJ_BYTE*) opj_malloc(p_j2k->m_specific_param.m_decoder.m_sot_length);
             }
+            else if (l_tcp->m_data_borrowed) {
+                /* tile-parts are separated by their headers: from the second one on, */
+                /* the tile data is gathered in a buffer of its own */
+                OPJ_BYTE *l_new_current_data = (OPJ_BYTE *) opj_malloc(*l_tile_len + p_j2k->m_specific_param.m_decoder.m_sot_length);
+                if (l_new_current_data) {
+                        memcpy(l_new_current_data, *l_current_data, *l_tile_len);
+                }
+                l_tcp->m_data_borrowed = 0;
+                *l_current_data = l_new_current_data;
+            }
             else {
                 OPJ_BYTE *l_new_current_data = (OPJ_BYTE *) opj_realloc(*l_current_data, *l_tile_len + p_j2k->m_specific_param.m_decoder.m_sot_length);
                 if (! l_new_current_data) {
@@ -4412,7 +5079,7 @@ OPJ_BOOL opj_j2k_read_sod (opj_j2k_t *p_j2k,
                 *l_current_data = l_new_current_data;
             }
             
-            if (*l_current_data == 00) {
+            if (*l_current_data == 00 && ! l_in_place && ! l_skip_packets) {
                 opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to decode tile\n");
                 return OPJ_FALSE;
             }
@@ -4445,7 +5112,21 @@ OPJ_BOOL opj_j2k_read_sod (opj_j2k_t *p_j2k,
         }
 
         /* Patch to support new PHR data */
-        if (!l_sot_length_pb_detected) {
+        if (l_in_place) {
+            const OPJ_BYTE * l_tile_part_data = 00;
+            l_current_read_size = opj_stream_read_data_in_place(
+                        p_stream,
+                        &l_tile_part_data,
+                        p_j2k->m_specific_param.m_decoder.m_sot_length);
+            *l_current_data = (OPJ_BYTE *) l_tile_part_data;
+            l_tcp->m_data_borrowed = 1;
+        }
+        else if (l_skip_packets) {
+            if (! opj_j2k_read_needed_packets(p_j2k, p_stream, &l_current_read_size, p_manager)) {
+                return OPJ_FALSE;
+            }
+        }
+        else if (!l_sot_length_pb_detected) {
             l_current_read_size = opj_stream_read_data(
                         p_stream,
                         *l_current_data + *l_tile_len,
@@ -4464,9 +5145,14 @@ OPJ_BOOL opj_j2k_read_sod (opj_j2k_t *p_j2k,
                 p_j2k->m_specific_param.m_decoder.m_state = J2K_STATE_TPHSOT;
         }
 
+        if (l_skip_packets) {
+                /* the data and the packet lengths of the tile are up to date */
+                return OPJ_TRUE;
+        }
+
         *l_tile_len += (OPJ_UINT32)l_current_read_size;
 
-        return OPJ_TRUE;
+        return opj_j2k_end_tile_part_packet_lengths(p_j2k, (OPJ_UINT32)l_current_read_size, p_manager);
 }
 
  OPJ_BOOL opj_j2k_write_rgn(opj_j2k_t *p_j2k,
@@ -4842,7 +5528,14 @@ OPJ_BOOL opj_j2k_read_eoc (     opj_j2k_t *p_j2k,
                                 return OPJ_FALSE;
                         }
 
-                        l_success = opj_tcd_decode_tile(l_tcd, l_tcp->m_data, l_tcp->m_data_size, i, p_j2k->cstr_index);
+                        l_success = opj_tcd_decode_tile(l_tcd,
+                                                        p_j2k->m_private_image->x0,
+                                                        p_j2k->m_private_image->y0,
+                                                        p_j2k->m_private_image->x1,
+                                                        p_j2k->m_private_image->y1,
+                                                        l_tcp->m_data, l_tcp->m_data_size,
+                                                        l_tcp->m_packet_lengths, l_tcp->m_nb_packet_lengths,
+                                                        i, p_j2k->cstr_index);
                         /* cleanup */
 
                         if (! l_success) {
@@ -5916,6 +6609,7 @@ void opj_j2k_setup_decoder(opj_j2k_t *j2k, opj_dparameters_t *parameters)
         if(j2k && parameters) {
                 j2k->m_cp.m_specific_param.m_dec.m_layer = parameters->cp_layer;
                 j2k->m_cp.m_specific_param.m_dec.m_reduce = parameters->cp_reduce;
+                j2k->m_cp.m_specific_param.m_dec.m_max_memory = parameters->max_memory;
 
 #ifdef USE_JPWL
                 j2k->m_cp.correct = parameters->jpwl_correct;
@@ -5962,6 +6656,15 @@ opj_j2k_t* opj_j2k_create_compress(void)
                 return NULL;
         }
 
+        /* code-blocks are processed in the calling thread by default */
+        l_j2k->m_tp = opj_thread_pool_create(0);
+        if (! l_j2k->m_tp) {
+                opj_j2k_destroy(l_j2k);
+                return NULL;
+        }
+
+        opj_kernels_init(&l_j2k->m_kernels, opj_cpu_get_level());
+
         return l_j2k;
 }
 
@@ -6816,6 +7519,11 @@ OPJ_BOOL opj_j2k_read_header(   opj_stream_private_t *p_stream,
         if (!opj_j2k_allocate_tile_element_cstr_index(p_j2k)){
                 return OPJ_FALSE;
         }
+        if (! opj_j2k_build_tile_index_from_tlm(p_j2k, p_stream, p_manager)) {
+                return OPJ_FALSE;
+        }
+        /* the packet lengths of the PLM markers start with the first tile-part */
+        p_j2k->m_cp.plm_next_sot_pos = (OPJ_OFF_T)p_j2k->cstr_index->main_head_end;
 
         return OPJ_TRUE;
 }
@@ -7426,13 +8134,15 @@ static OPJ_BOOL opj_j2k_copy_default_tcp_and_create_tcd (       opj_j2k_t * p_j2
                 ++l_tcp;
         }
 
-        /* Create the current tile decoder*/
-        p_j2k->m_tcd = (opj_tcd_t*)opj_tcd_create(OPJ_TRUE); /* FIXME why a cast ? */
-        if (! p_j2k->m_tcd ) {
-                return OPJ_FALSE;
+        /* Create the current tile decoder, or recycle the one of the previous image */
+        if (! p_j2k->m_tcd) {
+                p_j2k->m_tcd = (opj_tcd_t*)opj_tcd_create(OPJ_TRUE); /* FIXME why a cast ? */
+                if (! p_j2k->m_tcd ) {
+                        return OPJ_FALSE;
+                }
         }
 
-        if ( !opj_tcd_init(p_j2k->m_tcd, l_image, &(p_j2k->m_cp)) ) {
+        if ( !opj_tcd_init(p_j2k->m_tcd, l_image, &(p_j2k->m_cp), p_j2k->m_tp, &p_j2k->m_kernels) ) {
                 opj_tcd_destroy(p_j2k->m_tcd);
                 p_j2k->m_tcd = 00;
                 opj_event_msg(p_manager, EVT_ERROR, "Cannot decode tile, memory error\n");
@@ -7472,6 +8182,10 @@ void opj_j2k_destroy (opj_j2k_t *p_j2k)
                         p_j2k->m_specific_param.m_decoder.m_header_data = 00;
                         p_j2k->m_specific_param.m_decoder.m_header_data_size = 0;
                 }
+
+                opj_free(p_j2k->m_specific_param.m_decoder.m_tile_data);
+                p_j2k->m_specific_param.m_decoder.m_tile_data = 00;
+                p_j2k->m_specific_param.m_decoder.m_tile_data_size = 0;
         }
         else {
 
@@ -7513,9 +8227,107 @@ void opj_j2k_destroy (opj_j2k_t *p_j2k)
         opj_image_destroy(p_j2k->m_output_image);
         p_j2k->m_output_image = NULL;
 
+        opj_thread_pool_destroy(p_j2k->m_tp);
+        p_j2k->m_tp = 00;
+
         opj_free(p_j2k);
 }
 
+OPJ_BOOL opj_j2k_set_threads(opj_j2k_t *p_j2k, OPJ_UINT32 num_threads)
+{
+        opj_thread_pool_t * l_tp;
+
+        if (num_threads > 1 && ! opj_has_thread_support()) {
+                return OPJ_FALSE;
+        }
+        if (num_threads > 1024) {
+                return OPJ_FALSE;
+        }
+
+        l_tp = opj_thread_pool_create((int)num_threads);
+        if (! l_tp) {
+                return OPJ_FALSE;
+        }
+
+        opj_thread_pool_destroy(p_j2k->m_tp);
+        p_j2k->m_tp = l_tp;
+        if (p_j2k->m_tcd) {
+                p_j2k->m_tcd->thread_pool = l_tp;
+        }
+
+        return OPJ_TRUE;
+}
+
+OPJ_BOOL opj_j2k_decoder_reset(opj_j2k_t *p_j2k)
+{
+        opj_j2k_dec_t * l_dec = &(p_j2k->m_specific_param.m_decoder);
+        opj_decoding_param_t l_dec_param = p_j2k->m_cp.m_specific_param.m_dec;
+#ifdef USE_JPWL
+        OPJ_BOOL l_correct = p_j2k->m_cp.correct;
+        OPJ_INT32 l_exp_comps = p_j2k->m_cp.exp_comps;
+        OPJ_INT32 l_max_tiles = p_j2k->m_cp.max_tiles;
+#endif /* USE_JPWL */
+
+        if (! p_j2k->m_is_decoder) {
+                return OPJ_FALSE;
+        }
+
+        /* coding parameters of the previous codestream, but the user decoding parameters */
+        opj_j2k_cp_destroy(&(p_j2k->m_cp));
+        memset(&(p_j2k->m_cp),0,sizeof(opj_cp_t));
+        p_j2k->m_cp.m_is_decoder = 1;
+        p_j2k->m_cp.m_specific_param.m_dec = l_dec_param;
+#ifdef USE_JPWL
+        p_j2k->m_cp.correct = l_correct;
+        p_j2k->m_cp.exp_comps = l_exp_comps;
+        p_j2k->m_cp.max_tiles = l_max_tiles;
+#endif /* USE_JPWL */
+
+        opj_j2k_tcp_destroy(l_dec->m_default_tcp);
+        memset(l_dec->m_default_tcp, 0, sizeof(opj_tcp_t));
+
+        j2k_destroy_cstr_index(p_j2k->cstr_index);
+        p_j2k->cstr_index = opj_j2k_create_cstr_index();
+        if (! p_j2k->cstr_index) {
+                return OPJ_FALSE;
+        }
+
+        opj_image_destroy(p_j2k->m_private_image);
+        p_j2k->m_private_image = NULL;
+        opj_image_destroy(p_j2k->m_output_image);
+        p_j2k->m_output_image = NULL;
+
+        opj_procedure_list_clear(p_j2k->m_procedure_list);
+        opj_procedure_list_clear(p_j2k->m_validation_list);
+
+        /* decoder state, keeping the header and tile buffers (m_tcd is rebound by the next header) */
+        l_dec->m_state = J2K_STATE_NONE;
+        l_dec->m_sot_length = 0;
+        l_dec->m_start_tile_x = 0;
+        l_dec->m_start_tile_y = 0;
+        l_dec->m_end_tile_x = 0;
+        l_dec->m_end_tile_y = 0;
+        l_dec->m_DA_x0 = 0;
+        l_dec->m_DA_y0 = 0;
+        l_dec->m_DA_x1 = 0;
+        l_dec->m_DA_y1 = 0;
+        l_dec->m_tile_ind_to_dec = -1;
+        l_dec->m_last_sot_read_pos = 0;
+        l_dec->m_tp_first_packet_length = 0;
+        l_dec->m_plm_tile_part = -1;
+        l_dec->m_scanned_tile_number = -1;
+        l_dec->m_last_tile_part = 0;
+        l_dec->m_dest_buffer = 00;
+        l_dec->m_dest_stride = 0;
+        l_dec->m_can_decode = 0;
+        l_dec->m_discard_tiles = 0;
+        l_dec->m_skip_data = 0;
+
+        p_j2k->m_current_tile_number = 0;
+
+        return OPJ_TRUE;
+}
+
 void j2k_destroy_cstr_index (opj_codestream_index_t *p_cstr_ind)
 {
         if (p_cstr_ind) {
@@ -7566,6 +8378,10 @@ void opj_j2k_tcp_destroy (opj_tcp_t *p_tcp)
                 p_tcp->ppt_buffer = 00;
         }
 
+        opj_free(p_tcp->m_packet_lengths);
+        p_tcp->m_packet_lengths = 00;
+        p_tcp->m_max_packet_lengths = 0;
+
         if (p_tcp->tccps != 00) {
                 opj_free(p_tcp->tccps);
                 p_tcp->tccps = 00;
@@ -7617,10 +8433,20 @@ void opj_j2k_tcp_destroy (opj_tcp_t *p_tcp)
 void opj_j2k_tcp_data_destroy (opj_tcp_t *p_tcp)
 {
         if (p_tcp->m_data) {
-                opj_free(p_tcp->m_data);
+                if (! p_tcp->m_data_borrowed) {
+                        opj_free(p_tcp->m_data);
+                }
                 p_tcp->m_data = NULL;
                 p_tcp->m_data_size = 0;
+                p_tcp->m_data_borrowed = 0;
         }
+        /* the packet lengths go with the data, the buffer is kept */
+        p_tcp->m_nb_packet_lengths = 0;
+        p_tcp->m_packet_lengths_invalid = 0;
+        opj_free(p_tcp->m_needed_packets);
+        p_tcp->m_needed_packets = 00;
+        p_tcp->m_nb_packets = 0;
+        p_tcp->m_end_needed_packets = 0;
 }
 
 void opj_j2k_cp_destroy (opj_cp_t *p_cp)
@@ -7651,6 +8477,12 @@ void opj_j2k_cp_destroy (opj_cp_t *p_cp)
         p_cp->ppm_data = NULL; /* ppm_data belongs to the allocated buffer pointed by ppm_buffer */
         opj_free(p_cp->comment);
         p_cp->comment = 00;
+        opj_free(p_cp->tlm_entries);
+        p_cp->tlm_entries = 00;
+        opj_free(p_cp->plm_lengths);
+        p_cp->plm_lengths = 00;
+        opj_free(p_cp->plm_tile_parts);
+        p_cp->plm_tile_parts = 00;
         if (! p_cp->m_is_decoder)
         {
                 opj_free(p_cp->m_specific_param.m_enc.m_matrice);
@@ -7658,15 +8490,10 @@ void opj_j2k_cp_destroy (opj_cp_t *p_cp)
         }
 }
 
-OPJ_BOOL opj_j2k_read_tile_header(      opj_j2k_t * p_j2k,
-                                                                    OPJ_UINT32 * p_tile_index,
-                                                                    OPJ_UINT32 * p_data_size,
-                                                                    OPJ_INT32 * p_tile_x0, OPJ_INT32 * p_tile_y0,
-                                                                    OPJ_INT32 * p_tile_x1, OPJ_INT32 * p_tile_y1,
-                                                                    OPJ_UINT32 * p_nb_comps,
-                                                                    OPJ_BOOL * p_go_on,
-                                                                    opj_stream_private_t *p_stream,
-                                                                    opj_event_mgr_t * p_manager )
+static OPJ_BOOL opj_j2k_read_tile_parts(      opj_j2k_t * p_j2k,
+                                                OPJ_BOOL * p_go_on,
+                                                opj_stream_private_t *p_stream,
+                                                opj_event_mgr_t * p_manager )
 {
         OPJ_UINT32 l_current_marker = J2K_MS_SOT;
         OPJ_UINT32 l_marker_size;
@@ -7792,6 +8619,7 @@ OPJ_BOOL opj_j2k_read_tile_header(      opj_j2k_t * p_j2k,
                                 {
                                         p_j2k->m_specific_param.m_decoder.m_last_sot_read_pos = sot_pos;
                                 }
+                                opj_j2k_begin_tile_part_packet_lengths(p_j2k, opj_stream_tell(p_stream) - l_marker_size - 4);
                         }
 
                         if (p_j2k->m_specific_param.m_decoder.m_skip_data) {
@@ -7824,14 +8652,24 @@ OPJ_BOOL opj_j2k_read_tile_header(      opj_j2k_t * p_j2k,
                         }
 
                         if (! p_j2k->m_specific_param.m_decoder.m_can_decode){
+                                OPJ_BOOL l_moved = OPJ_FALSE;
+
+                                /* Go straight to the next tile-part of the tile if it is located */
+                                if (! opj_j2k_seek_next_tile_part(p_j2k, p_stream, &l_moved, p_manager)) {
+                                        return OPJ_FALSE;
+                                }
+                                if (l_moved) {
+                                        l_current_marker = J2K_MS_SOT;
+                                }
                                 /* Try to read 2 bytes (the next marker ID) from stream and copy them into the buffer */
-                                if (opj_stream_read_data(p_stream,p_j2k->m_specific_param.m_decoder.m_header_data,2,p_manager) != 2) {
+                                else if (opj_stream_read_data(p_stream,p_j2k->m_specific_param.m_decoder.m_header_data,2,p_manager) != 2) {
                                         opj_event_msg(p_manager, EVT_ERROR, "Stream too short\n");
                                         return OPJ_FALSE;
                                 }
-
-                                /* Read 2 bytes from buffer as the new marker ID */
-                                opj_read_bytes(p_j2k->m_specific_param.m_decoder.m_header_data,&l_current_marker,2);
+                                else {
+                                        /* Read 2 bytes from buffer as the new marker ID */
+                                        opj_read_bytes(p_j2k->m_specific_param.m_decoder.m_header_data,&l_current_marker,2);
+                                }
                         }
                 }
                 else {
@@ -7875,11 +8713,34 @@ OPJ_BOOL opj_j2k_read_tile_header(      opj_j2k_t * p_j2k,
                 }
         }
 
+        *p_go_on = OPJ_TRUE;
+        return OPJ_TRUE;
+}
+
+OPJ_BOOL opj_j2k_read_tile_header(      opj_j2k_t * p_j2k,
+                                                                    OPJ_UINT32 * p_tile_index,
+                                                                    OPJ_UINT32 * p_data_size,
+                                                                    OPJ_INT32 * p_tile_x0, OPJ_INT32 * p_tile_y0,
+                                                                    OPJ_INT32 * p_tile_x1, OPJ_INT32 * p_tile_y1,
+                                                                    OPJ_UINT32 * p_nb_comps,
+                                                                    OPJ_BOOL * p_go_on,
+                                                                    opj_stream_private_t *p_stream,
+                                                                    opj_event_mgr_t * p_manager )
+{
+        if (! opj_j2k_read_tile_parts(p_j2k, p_go_on, p_stream, p_manager)) {
+                return OPJ_FALSE;
+        }
+        if (! *p_go_on) {
+                return OPJ_TRUE;
+        }
+
         /*FIXME ???*/
         if (! opj_tcd_init_decode_tile(p_j2k->m_tcd, p_j2k->m_current_tile_number)) {
                 opj_event_msg(p_manager, EVT_ERROR, "Cannot decode tile, memory error\n");
                 return OPJ_FALSE;
         }
+        /* the tile coder holds the tile to decode from now on, not the packet headers read */
+        p_j2k->m_specific_param.m_decoder.m_scanned_tile_number = -1;
 
         opj_event_msg(p_manager, EVT_INFO, "Header of tile %d / %d has been read.\n",
                         p_j2k->m_current_tile_number+1, (p_j2k->m_cp.th * p_j2k->m_cp.tw));
@@ -7905,9 +8766,8 @@ OPJ_BOOL opj_j2k_decode_tile (  opj_j2k_t * p_j2k,
                                                         opj_stream_private_t *p_stream,
                                                         opj_event_mgr_t * p_manager )
 {
-        OPJ_UINT32 l_current_marker;
-        OPJ_BYTE l_data [2];
         opj_tcp_t * l_tcp;
+        opj_image_t * l_area;
 
         /* preconditions */
         assert(p_stream != 00);
@@ -7925,9 +8785,19 @@ OPJ_BOOL opj_j2k_decode_tile (  opj_j2k_t * p_j2k,
                 return OPJ_FALSE;
         }
 
+        /* only the code-blocks needed by the area of the output image are decoded */
+        /* (the whole image when tiles are decoded through opj_decode_tile_data()) */
+        l_area = p_j2k->m_output_image ? p_j2k->m_output_image : p_j2k->m_private_image;
+
         if (! opj_tcd_decode_tile(      p_j2k->m_tcd,
+                                                                l_area->x0,
+                                                                l_area->y0,
+                                                                l_area->x1,
+                                                                l_area->y1,
                                                                 l_tcp->m_data,
                                                                 l_tcp->m_data_size,
+                                                                l_tcp->m_packet_lengths,
+                                                                l_tcp->m_nb_packet_lengths,
                                                                 p_tile_index,
                                                                 p_j2k->cstr_index) ) {
                 opj_j2k_tcp_destroy(l_tcp);
@@ -7936,7 +8806,8 @@ OPJ_BOOL opj_j2k_decode_tile (  opj_j2k_t * p_j2k,
                 return OPJ_FALSE;
         }
 
-        if (! opj_tcd_update_tile_data(p_j2k->m_tcd,p_data,p_data_size)) {
+        /* without p_data, the caller reads the samples from the tile components */
+        if (p_data && ! opj_tcd_update_tile_data(p_j2k->m_tcd,p_data,p_data_size)) {
                 return OPJ_FALSE;
         }
 
@@ -7946,6 +8817,16 @@ OPJ_BOOL opj_j2k_decode_tile (  opj_j2k_t * p_j2k,
         p_j2k->m_tcd->tcp = 0;*/
         opj_j2k_tcp_data_destroy(l_tcp);
 
+        return opj_j2k_read_next_tile_marker(p_j2k, p_stream, p_manager);
+}
+
+static OPJ_BOOL opj_j2k_read_next_tile_marker ( opj_j2k_t * p_j2k,
+                                                opj_stream_private_t *p_stream,
+                                                opj_event_mgr_t * p_manager )
+{
+        OPJ_UINT32 l_current_marker;
+        OPJ_BYTE l_data [2];
+
         p_j2k->m_specific_param.m_decoder.m_can_decode = 0;
         p_j2k->m_specific_param.m_decoder.m_state &= (~ (0x0080u));/* FIXME J2K_DEC_STATE_DATA);*/
 
@@ -7981,25 +8862,108 @@ OPJ_BOOL opj_j2k_decode_tile (  opj_j2k_t * p_j2k,
         return OPJ_TRUE;
 }
 
-OPJ_BOOL opj_j2k_update_image_data (opj_tcd_t * p_tcd, OPJ_BYTE * p_data, opj_image_t* p_output_image)
+void opj_j2k_update_image_resno_decoded (const opj_image_t* p_tile_image, opj_image_t* p_output_image)
 {
-        OPJ_UINT32 i,j,k = 0;
-        OPJ_UINT32 l_width_src,l_height_src;
-        OPJ_UINT32 l_width_dest,l_height_dest;
-        OPJ_INT32 l_offset_x0_src, l_offset_y0_src, l_offset_x1_src, l_offset_y1_src;
-        OPJ_INT32 l_start_offset_src, l_line_offset_src, l_end_offset_src ;
-        OPJ_UINT32 l_start_x_dest , l_start_y_dest;
-        OPJ_UINT32 l_x0_dest, l_y0_dest, l_x1_dest, l_y1_dest;
-        OPJ_INT32 l_start_offset_dest, l_line_offset_dest;
+        OPJ_UINT32 i;
 
-        opj_image_comp_t * l_img_comp_src = 00;
-        opj_image_comp_t * l_img_comp_dest = 00;
+        for (i = 0; i < p_tile_image->numcomps; ++i) {
+                p_output_image->comps[i].resno_decoded = p_tile_image->comps[i].resno_decoded;
+        }
+}
 
-        opj_tcd_tilecomp_t * l_tilec = 00;
-        opj_image_t * l_image_src = 00;
-        OPJ_UINT32 l_size_comp, l_remaining;
-        OPJ_INT32 * l_dest_ptr;
-        opj_tcd_resolution_t* l_res= 00;
+OPJ_BOOL opj_j2k_get_pixel_layout (OPJ_PIXEL_FORMAT p_format, OPJ_UINT32 * p_nb_channels, OPJ_UINT32 * p_sample_size)
+{
+        switch (p_format) {
+                case OPJ_PIXEL_GRAY8:  *p_nb_channels = 1; *p_sample_size = 1; break;
+                case OPJ_PIXEL_RGB8:   *p_nb_channels = 3; *p_sample_size = 1; break;
+                case OPJ_PIXEL_RGBA8:  *p_nb_channels = 4; *p_sample_size = 1; break;
+                case OPJ_PIXEL_GRAY16: *p_nb_channels = 1; *p_sample_size = 2; break;
+                case OPJ_PIXEL_RGB16:  *p_nb_channels = 3; *p_sample_size = 2; break;
+                case OPJ_PIXEL_RGBA16: *p_nb_channels = 4; *p_sample_size = 2; break;
+                default:
+                        return OPJ_FALSE;
+        }
+        return OPJ_TRUE;
+}
+
+void opj_j2k_update_buffer_data (opj_tcd_t * p_tcd, const opj_j2k_dec_t * p_dec, const opj_image_t* p_output_image)
+{
+        OPJ_UINT32 l_nb_channels = 0, l_sample_size = 0;
+        OPJ_UINT32 l_pixel_size, l_nb_comps, compno, i, j;
+
+        opj_j2k_get_pixel_layout(p_dec->m_dest_format, &l_nb_channels, &l_sample_size);
+        l_pixel_size = l_nb_channels * l_sample_size;
+        l_nb_comps = opj_uint_min(l_nb_channels, p_output_image->numcomps);
+
+        for (compno = 0; compno < l_nb_comps; ++compno) {
+                const opj_image_comp_t * l_img_comp_src = &(p_tcd->image->comps[compno]);
+                const opj_image_comp_t * l_img_comp_dest = &(p_output_image->comps[compno]);
+                const opj_tcd_tilecomp_t * l_tilec = &(p_tcd->tcd_image->tiles->comps[compno]);
+                const opj_tcd_resolution_t * l_res = l_tilec->resolutions + l_img_comp_src->resno_decoded;
+                OPJ_UINT32 l_tile_w = (OPJ_UINT32)(l_tilec->x1 - l_tilec->x0);
+                OPJ_UINT32 l_bits = l_sample_size * 8;
+                OPJ_UINT32 l_offset = l_img_comp_src->sgnd ? 1U << (l_img_comp_src->prec - 1) : 0;
+                OPJ_UINT32 l_shr = (l_img_comp_src->prec > l_bits) ? l_img_comp_src->prec - l_bits : 0;
+                OPJ_UINT32 l_shl = (l_img_comp_src->prec < l_bits) ? l_bits - l_img_comp_src->prec : 0;
+                OPJ_UINT32 l_x0_dest, l_y0_dest, l_x0, l_y0, l_x1, l_y1;
+                const OPJ_INT32 * l_src_ptr;
+                OPJ_BYTE * l_dest_ptr;
+
+                /* area of the tile component in the output component, both in reduced coordinates */
+                l_x0_dest = (OPJ_UINT32)opj_int_ceildivpow2((OPJ_INT32)l_img_comp_dest->x0, (OPJ_INT32)l_img_comp_dest->factor);
+                l_y0_dest = (OPJ_UINT32)opj_int_ceildivpow2((OPJ_INT32)l_img_comp_dest->y0, (OPJ_INT32)l_img_comp_dest->factor);
+                l_x0 = opj_uint_max((OPJ_UINT32)l_res->x0, l_x0_dest);
+                l_y0 = opj_uint_max((OPJ_UINT32)l_res->y0, l_y0_dest);
+                l_x1 = opj_uint_min((OPJ_UINT32)l_res->x1, l_x0_dest + l_img_comp_dest->w);
+                l_y1 = opj_uint_min((OPJ_UINT32)l_res->y1, l_y0_dest + l_img_comp_dest->h);
+                if (l_x0 >= l_x1 || l_y0 >= l_y1) {
+                        continue;
+                }
+
+                l_src_ptr = l_tilec->data + (OPJ_SIZE_T)(l_y0 - (OPJ_UINT32)l_res->y0) * l_tile_w + (l_x0 - (OPJ_UINT32)l_res->x0);
+                l_dest_ptr = p_dec->m_dest_buffer + (OPJ_SIZE_T)(l_y0 - l_y0_dest) * p_dec->m_dest_stride
+                                + (OPJ_SIZE_T)(l_x0 - l_x0_dest) * l_pixel_size + compno * l_sample_size;
+
+                for (j = 0; j < l_y1 - l_y0; ++j) {
+                        if (l_sample_size == 1) {
+                                OPJ_BYTE * l_dest = l_dest_ptr;
+                                for (i = 0; i < l_x1 - l_x0; ++i) {
+                                        *l_dest = (OPJ_BYTE)((((OPJ_UINT32)l_src_ptr[i] + l_offset) >> l_shr) << l_shl);
+                                        l_dest += l_pixel_size;
+                                }
+                        }
+                        else {
+                                OPJ_UINT16 * l_dest = (OPJ_UINT16 *) l_dest_ptr;
+                                for (i = 0; i < l_x1 - l_x0; ++i) {
+                                        *l_dest = (OPJ_UINT16)((((OPJ_UINT32)l_src_ptr[i] + l_offset) >> l_shr) << l_shl);
+                                        l_dest += l_nb_channels;
+                                }
+                        }
+                        l_src_ptr += l_tile_w;
+                        l_dest_ptr += p_dec->m_dest_stride;
+                }
+        }
+}
+
+OPJ_BOOL opj_j2k_update_image_data (opj_tcd_t * p_tcd, OPJ_BYTE * p_data, opj_image_t* p_output_image)
+{
+        OPJ_UINT32 i,j,k = 0;
+        OPJ_UINT32 l_width_src,l_height_src;
+        OPJ_UINT32 l_width_dest,l_height_dest;
+        OPJ_INT32 l_offset_x0_src, l_offset_y0_src, l_offset_x1_src, l_offset_y1_src;
+        OPJ_INT32 l_start_offset_src, l_line_offset_src, l_end_offset_src ;
+        OPJ_UINT32 l_start_x_dest , l_start_y_dest;
+        OPJ_UINT32 l_x0_dest, l_y0_dest, l_x1_dest, l_y1_dest;
+        OPJ_INT32 l_start_offset_dest, l_line_offset_dest;
+
+        opj_image_comp_t * l_img_comp_src = 00;
+        opj_image_comp_t * l_img_comp_dest = 00;
+
+        opj_tcd_tilecomp_t * l_tilec = 00;
+        opj_image_t * l_image_src = 00;
+        OPJ_UINT32 l_size_comp, l_remaining;
+        OPJ_INT32 * l_dest_ptr;
+        opj_tcd_resolution_t* l_res= 00;
 
         l_tilec = p_tcd->tcd_image->tiles->comps;
         l_image_src = p_tcd->image;
@@ -8018,9 +8982,6 @@ OPJ_BOOL opj_j2k_update_image_data (opj_tcd_t * p_tcd, OPJ_BYTE * p_data, opj_im
                         }
                 }
 
-                /* Copy info from decoded comp image to output image */
-                l_img_comp_dest->resno_decoded = l_img_comp_src->resno_decoded;
-
                 /*-----*/
                 /* Compute the precision of the output buffer */
                 l_size_comp = l_img_comp_src->prec >> 3; /*(/ 8)*/
@@ -8426,6 +9387,8 @@ opj_j2k_t* opj_j2k_create_decompress(void)
         l_j2k->m_specific_param.m_decoder.m_tile_ind_to_dec = -1 ;
 
         l_j2k->m_specific_param.m_decoder.m_last_sot_read_pos = 0 ;
+        l_j2k->m_specific_param.m_decoder.m_plm_tile_part = -1;
+        l_j2k->m_specific_param.m_decoder.m_scanned_tile_number = -1;
 
         /* codestream index creation */
         l_j2k->cstr_index = opj_j2k_create_cstr_index();
@@ -8448,6 +9411,15 @@ opj_j2k_t* opj_j2k_create_decompress(void)
                 return 00;
         }
 
+        /* code-blocks are processed in the calling thread by default */
+        l_j2k->m_tp = opj_thread_pool_create(0);
+        if (! l_j2k->m_tp) {
+                opj_j2k_destroy(l_j2k);
+                return 00;
+        }
+
+        opj_kernels_init(&l_j2k->m_kernels, opj_cpu_get_level());
+
         return l_j2k;
 }
 
@@ -9391,6 +10363,559 @@ OPJ_BOOL opj_j2k_allocate_tile_element_cstr_index(opj_j2k_t *p_j2k)
         return OPJ_TRUE;
 }
 
+static OPJ_BOOL opj_j2k_build_tile_index_from_tlm(     opj_j2k_t *p_j2k,
+                                                        opj_stream_private_t *p_stream,
+                                                        opj_event_mgr_t * p_manager )
+{
+        opj_cp_t * l_cp = &(p_j2k->m_cp);
+        opj_codestream_index_t * l_cstr_index = p_j2k->cstr_index;
+        opj_tile_index_t * l_tile_index = 00;
+        OPJ_OFF_T l_pos, l_bytes_left;
+        OPJ_UINT32 i;
+
+        if (l_cp->tlm_ignored || ! l_cp->tlm_nb_entries || ! l_cstr_index->tile_index) {
+                return OPJ_TRUE;
+        }
+
+        /* the tile-parts follow each other from the first SOT marker on */
+        l_pos = (OPJ_OFF_T)l_cstr_index->main_head_end;
+        for (i = 0; i < l_cp->tlm_nb_entries; ++i) {
+                l_pos += l_cp->tlm_entries[i].m_length;
+        }
+        l_bytes_left = opj_stream_get_number_byte_left(p_stream);
+        if (l_bytes_left && l_pos > opj_stream_tell(p_stream) + l_bytes_left) {
+                opj_event_msg(p_manager, EVT_WARNING, "TLM marker lengths exceed the codestream, tile-parts are located through their SOT markers\n");
+                l_cp->tlm_ignored = 1;
+                return OPJ_TRUE;
+        }
+
+        for (i = 0; i < l_cp->tlm_nb_entries; ++i) {
+                ++l_cstr_index->tile_index[l_cp->tlm_entries[i].m_tile_no].nb_tps;
+        }
+        for (i = 0; i < l_cstr_index->nb_of_tiles; ++i) {
+                l_tile_index = &(l_cstr_index->tile_index[i]);
+                if (l_tile_index->nb_tps) {
+                        l_tile_index->tp_index = (opj_tp_index_t *) opj_calloc(l_tile_index->nb_tps, sizeof(opj_tp_index_t));
+                        if (! l_tile_index->tp_index) {
+                                opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to build the tile index\n");
+                                return OPJ_FALSE;
+                        }
+                        l_tile_index->current_nb_tps = l_tile_index->nb_tps;
+                }
+        }
+
+        /* current_tpsno counts the tile-parts of each tile, it is set again by the SOT markers */
+        l_pos = (OPJ_OFF_T)l_cstr_index->main_head_end;
+        for (i = 0; i < l_cp->tlm_nb_entries; ++i) {
+                opj_tp_index_t * l_tp_index;
+                l_tile_index = &(l_cstr_index->tile_index[l_cp->tlm_entries[i].m_tile_no]);
+                l_tile_index->tileno = l_cp->tlm_entries[i].m_tile_no;
+                l_tp_index = &(l_tile_index->tp_index[l_tile_index->current_tpsno++]);
+                l_tp_index->start_pos = l_pos;
+                l_tp_index->end_pos = l_pos + l_cp->tlm_entries[i].m_length;
+                l_pos = l_tp_index->end_pos;
+        }
+        for (i = 0; i < l_cstr_index->nb_of_tiles; ++i) {
+                l_cstr_index->tile_index[i].current_tpsno = 0;
+        }
+
+        return OPJ_TRUE;
+}
+
+static OPJ_BOOL opj_j2k_seek_tile_part( opj_stream_private_t *p_stream,
+                                        OPJ_OFF_T p_start_pos,
+                                        opj_event_mgr_t * p_manager )
+{
+        OPJ_BYTE l_data[2];
+        OPJ_UINT32 l_marker;
+
+        if (! opj_stream_read_seek(p_stream, p_start_pos, p_manager)
+            || opj_stream_read_data(p_stream, l_data, 2, p_manager) != 2) {
+                opj_event_msg(p_manager, EVT_WARNING, "Cannot reach the tile-part located by the codestream index\n");
+                return OPJ_FALSE;
+        }
+        opj_read_bytes(l_data, &l_marker, 2);
+        if (l_marker != J2K_MS_SOT) {
+                opj_event_msg(p_manager, EVT_WARNING, "No SOT marker where the codestream index locates a tile-part\n");
+                return OPJ_FALSE;
+        }
+
+        return OPJ_TRUE;
+}
+
+static OPJ_BOOL opj_j2k_seek_next_tile_part(   opj_j2k_t *p_j2k,
+                                                opj_stream_private_t *p_stream,
+                                                OPJ_BOOL * p_moved,
+                                                opj_event_mgr_t * p_manager )
+{
+        opj_j2k_dec_t * l_dec = &(p_j2k->m_specific_param.m_decoder);
+        opj_tile_index_t * l_tile_index = 00;
+        opj_tcp_t * l_tcp = 00;
+        OPJ_UINT32 l_next_part;
+        OPJ_OFF_T l_current_pos;
+
+        *p_moved = OPJ_FALSE;
+        if (l_dec->m_tile_ind_to_dec < 0
+            || (OPJ_UINT32)l_dec->m_tile_ind_to_dec != p_j2k->m_current_tile_number
+            || l_dec->m_state != J2K_STATE_TPHSOT
+            || ! p_j2k->cstr_index->tile_index) {
+                return OPJ_TRUE;
+        }
+
+        l_tcp = &(p_j2k->m_cp.tcps[p_j2k->m_current_tile_number]);
+        l_tile_index = &(p_j2k->cstr_index->tile_index[p_j2k->m_current_tile_number]);
+        l_next_part = l_tile_index->current_tpsno + 1;
+        if (l_next_part >= l_tcp->m_nb_tile_parts || l_next_part >= l_tile_index->nb_tps
+            || ! l_tile_index->tp_index
+            || l_tile_index->tp_index[l_next_part].start_pos <= opj_stream_tell(p_stream)) {
+                /* the next tile-part is not known, or it is the next one in the codestream */
+                return OPJ_TRUE;
+        }
+
+        l_current_pos = opj_stream_tell(p_stream);
+        if (! opj_j2k_seek_tile_part(p_stream, l_tile_index->tp_index[l_next_part].start_pos, p_manager)) {
+                /* a wrong index (from inconsistent TLM markers): go on with the next marker */
+                if (! opj_stream_read_seek(p_stream, l_current_pos, p_manager)) {
+                        opj_event_msg(p_manager, EVT_ERROR, "Problem with seek function\n");
+                        return OPJ_FALSE;
+                }
+                return OPJ_TRUE;
+        }
+        *p_moved = OPJ_TRUE;
+
+        return OPJ_TRUE;
+}
+
+/**
+ * State shared by the tile decoding jobs of opj_j2k_decode_tiles_parallel()
+ */
+typedef struct opj_j2k_tile_decoding_state
+{
+        /** coding parameters (read only while jobs are running) */
+        opj_cp_t * m_cp;
+        /** header of the image being decoded */
+        opj_image_t * m_private_image;
+        /** output image, each job writes a disjoint area of it */
+        opj_image_t * m_output_image;
+        /** codestream index */
+        opj_codestream_index_t * m_cstr_index;
+        /** kernels of the codec */
+        const opj_kernels_t * m_kernels;
+        /** decoder parameters, holding the caller buffer of opj_j2k_decode_into_buffer() */
+        const opj_j2k_dec_t * m_dec;
+        /** event manager, only used while holding m_mutex */
+        opj_event_mgr_t * m_manager;
+        /** protects m_manager and m_last_seq */
+        opj_mutex_t * m_mutex;
+        /** sequence number of the last tile that updated m_output_image->comps[].resno_decoded */
+        OPJ_UINT32 m_last_seq;
+        /** set to OPJ_FALSE by a job that failed */
+        volatile OPJ_BOOL m_ret;
+} opj_j2k_tile_decoding_state_t;
+
+/**
+ * A tile to decode by a worker thread
+ */
+typedef struct opj_j2k_tile_decoding_job
+{
+        opj_j2k_tile_decoding_state_t * m_state;
+        /** index of the tile */
+        OPJ_UINT32 m_tile_no;
+        /** rank of the tile in the codestream (1 for the first one) */
+        OPJ_UINT32 m_seq;
+        /** tile data (all tile-parts), owned by the job unless borrowed from a memory stream */
+        OPJ_BYTE * m_data;
+        OPJ_UINT32 m_data_size;
+        OPJ_BOOL m_data_borrowed;
+        /** packet lengths of the tile (from PLT/PLM markers), owned by the job */
+        OPJ_UINT32 * m_packet_lengths;
+        OPJ_UINT32 m_nb_packet_lengths;
+} opj_j2k_tile_decoding_job_t;
+
+static void opj_j2k_tile_decoding_job_free_data(opj_j2k_tile_decoding_job_t * p_job)
+{
+        if (! p_job->m_data_borrowed) {
+                opj_free(p_job->m_data);
+        }
+        p_job->m_data = 00;
+        opj_free(p_job->m_packet_lengths);
+        p_job->m_packet_lengths = 00;
+}
+
+static void opj_j2k_thread_pool_destroy_wrapper(void * p_tp)
+{
+        opj_thread_pool_destroy((opj_thread_pool_t *) p_tp);
+}
+
+/**
+ * Gets the thread pool (without thread) used by the tile jobs run by a worker.
+ * The code-blocks of a tile are processed by the worker itself, the pool only
+ * caches its T1 handles.
+ */
+static opj_thread_pool_t * opj_j2k_get_tile_thread_pool(opj_tls_t * p_tls)
+{
+        opj_thread_pool_t * l_tp = (opj_thread_pool_t *) opj_tls_get(p_tls, OPJ_TLS_KEY_TILE_TP);
+        if (! l_tp) {
+                l_tp = opj_thread_pool_create(0);
+                if (! l_tp || ! opj_tls_set(p_tls, OPJ_TLS_KEY_TILE_TP, l_tp, opj_j2k_thread_pool_destroy_wrapper)) {
+                        opj_thread_pool_destroy(l_tp);
+                        return 00;
+                }
+        }
+        return l_tp;
+}
+
+static void opj_j2k_tcd_destroy_wrapper(void * p_tcd)
+{
+        opj_tcd_destroy((opj_tcd_t *) p_tcd);
+}
+
+/**
+ * Gets the tile coder recycled by the tile jobs run by a worker. Its precincts,
+ * code-blocks, tag trees and samples are kept from one tile to the next, and
+ * from one image to the next, and are only reallocated when they must grow.
+ */
+static opj_tcd_t * opj_j2k_get_tile_coder(opj_tls_t * p_tls, OPJ_BOOL p_is_decoder)
+{
+        int l_key = p_is_decoder ? OPJ_TLS_KEY_TILE_TCD_DEC : OPJ_TLS_KEY_TILE_TCD_ENC;
+        opj_tcd_t * l_tcd = (opj_tcd_t *) opj_tls_get(p_tls, l_key);
+        if (! l_tcd) {
+                l_tcd = opj_tcd_create(p_is_decoder);
+                if (! l_tcd || ! opj_tls_set(p_tls, l_key, l_tcd, opj_j2k_tcd_destroy_wrapper)) {
+                        opj_tcd_destroy(l_tcd);
+                        return 00;
+                }
+        }
+        return l_tcd;
+}
+
+static void opj_j2k_tile_decoding_msg(opj_j2k_tile_decoding_state_t * p_state, OPJ_INT32 p_event_type, const char * p_fmt, OPJ_UINT32 p_tile_no)
+{
+        opj_mutex_lock(p_state->m_mutex);
+        opj_event_msg(p_state->m_manager, p_event_type, p_fmt, p_tile_no + 1, p_state->m_cp->th * p_state->m_cp->tw);
+        opj_mutex_unlock(p_state->m_mutex);
+}
+
+/**
+ * Decodes one tile with a private tile decoder and copies it in the output image.
+ */
+static void opj_j2k_tile_decoding_processor(void * p_user_data, opj_tls_t * p_tls)
+{
+        opj_j2k_tile_decoding_job_t * l_job = (opj_j2k_tile_decoding_job_t *) p_user_data;
+        opj_j2k_tile_decoding_state_t * l_state = l_job->m_state;
+        opj_thread_pool_t * l_tp;
+        opj_image_t * l_image = 00;
+        opj_tcd_t * l_tcd = 00;
+        OPJ_BYTE * l_tile_data = 00;
+        OPJ_UINT32 l_tile_data_size;
+        OPJ_BOOL l_success = OPJ_FALSE;
+
+        if (! l_state->m_ret) {
+                goto end;
+        }
+
+        l_tp = opj_j2k_get_tile_thread_pool(p_tls);
+        if (! l_tp) {
+                goto end;
+        }
+
+        /* resno_decoded is updated while decoding a tile, so each tile needs its own image header */
+        l_image = opj_image_create0();
+        if (! l_image) {
+                goto end;
+        }
+        opj_copy_image_header(l_state->m_private_image, l_image);
+        if (! l_image->comps) {
+                goto end;
+        }
+
+        l_tcd = opj_j2k_get_tile_coder(p_tls, OPJ_TRUE);
+        if (! l_tcd || ! opj_tcd_init(l_tcd, l_image, l_state->m_cp, l_tp, l_state->m_kernels)) {
+                goto end;
+        }
+
+        if (! opj_tcd_init_decode_tile(l_tcd, l_job->m_tile_no)) {
+                goto end;
+        }
+
+        if (! opj_tcd_decode_tile(l_tcd,
+                                  l_state->m_output_image->x0,
+                                  l_state->m_output_image->y0,
+                                  l_state->m_output_image->x1,
+                                  l_state->m_output_image->y1,
+                                  l_job->m_data, l_job->m_data_size,
+                                  l_job->m_packet_lengths, l_job->m_nb_packet_lengths,
+                                  l_job->m_tile_no, l_state->m_cstr_index)) {
+                goto end;
+        }
+        opj_j2k_tile_decoding_job_free_data(l_job);
+
+        if (l_state->m_dec->m_dest_buffer) {
+                opj_j2k_update_buffer_data(l_tcd, l_state->m_dec, l_state->m_output_image);
+        }
+        else {
+                l_tile_data_size = opj_tcd_get_decoded_tile_size(l_tcd);
+                l_tile_data = (OPJ_BYTE *) opj_malloc(l_tile_data_size);
+                if (! l_tile_data) {
+                        goto end;
+                }
+                if (! opj_tcd_update_tile_data(l_tcd, l_tile_data, l_tile_data_size)) {
+                        goto end;
+                }
+                if (! opj_j2k_update_image_data(l_tcd, l_tile_data, l_state->m_output_image)) {
+                        goto end;
+                }
+        }
+
+        if (l_state->m_cp->m_specific_param.m_dec.m_max_memory) {
+                /* within a memory budget, a worker does not keep its tile for the next one */
+                opj_tcd_release_tile(l_tcd);
+        }
+
+        opj_mutex_lock(l_state->m_mutex);
+        /* keep the values of the last tile of the codestream, as the serial decoder does */
+        if (l_job->m_seq > l_state->m_last_seq) {
+                l_state->m_last_seq = l_job->m_seq;
+                opj_j2k_update_image_resno_decoded(l_image, l_state->m_output_image);
+        }
+        opj_event_msg(l_state->m_manager, EVT_INFO, "Tile %d/%d has been decoded.\n", l_job->m_tile_no + 1, l_state->m_cp->th * l_state->m_cp->tw);
+        opj_mutex_unlock(l_state->m_mutex);
+
+        l_success = OPJ_TRUE;
+
+end:
+        if (! l_success && l_state->m_ret) {
+                l_state->m_ret = OPJ_FALSE;
+                opj_j2k_tile_decoding_msg(l_state, EVT_ERROR, "Failed to decode tile %d/%d\n", l_job->m_tile_no);
+        }
+        opj_free(l_tile_data);
+        opj_image_destroy(l_image);
+        opj_j2k_tile_decoding_job_free_data(l_job);
+        opj_free(l_job);
+}
+
+/**
+ * Tells whether the tiles can be decoded concurrently.
+ */
+static OPJ_BOOL opj_j2k_check_memory_budget (   opj_j2k_t *p_j2k,
+                                                opj_image_t * p_image,
+                                                opj_stream_private_t *p_stream,
+                                                opj_event_mgr_t * p_manager)
+{
+        opj_j2k_dec_t * l_dec = &(p_j2k->m_specific_param.m_decoder);
+        opj_cp_t * l_cp = &(p_j2k->m_cp);
+        opj_tccp_t * l_tccp = l_dec->m_default_tcp->tccps;
+        OPJ_UINT64 l_max_memory = (OPJ_UINT64)l_cp->m_specific_param.m_dec.m_max_memory;
+        OPJ_UINT64 l_image_size = 0;
+        OPJ_UINT64 l_tile_size = 0;
+        OPJ_UINT64 l_nb_tiles_in_budget;
+        OPJ_UINT32 l_tile_w, l_tile_h, compno, resno;
+
+        l_dec->m_max_tiles_in_flight = 0;
+        if (l_max_memory == 0) {
+                return OPJ_TRUE;
+        }
+
+        /* largest tile of the image */
+        l_tile_w = opj_uint_min(l_cp->tdx, p_j2k->m_private_image->x1 - p_j2k->m_private_image->x0);
+        l_tile_h = opj_uint_min(l_cp->tdy, p_j2k->m_private_image->y1 - p_j2k->m_private_image->y0);
+
+        for (compno = 0; compno < p_image->numcomps; ++compno, ++l_tccp) {
+                opj_image_comp_t * l_img_comp = p_image->comps + compno;
+                OPJ_UINT32 l_tilec_w = opj_uint_ceildiv(l_tile_w, l_img_comp->dx);
+                OPJ_UINT32 l_tilec_h = opj_uint_ceildiv(l_tile_h, l_img_comp->dy);
+                OPJ_UINT64 l_nb_cblks = 0;
+
+                if (! l_dec->m_dest_buffer) {
+                        /* samples of the output image, and decoded samples of the tile before they are copied there */
+                        l_image_size += (OPJ_UINT64)l_img_comp->w * l_img_comp->h * sizeof(OPJ_INT32);
+                        l_tile_size += (OPJ_UINT64)opj_uint_ceildivpow2(l_tilec_w, l_img_comp->factor)
+                                       * opj_uint_ceildivpow2(l_tilec_h, l_img_comp->factor) * sizeof(OPJ_INT32);
+                }
+
+                /* samples of the tile-component, at full resolution */
+                l_tile_size += (OPJ_UINT64)l_tilec_w * l_tilec_h * sizeof(OPJ_INT32);
+
+                /* code-blocks of the sub-bands, bounded by the precincts as in opj_tcd_init_tile() */
+                for (resno = 0; resno < l_tccp->numresolutions; ++resno) {
+                        OPJ_UINT32 l_level = l_tccp->numresolutions - 1 - resno + (resno ? 1U : 0U);
+                        OPJ_UINT32 l_cbgw = resno ? (l_tccp->prcw[resno] ? l_tccp->prcw[resno] - 1 : 0) : l_tccp->prcw[resno];
+                        OPJ_UINT32 l_cbgh = resno ? (l_tccp->prch[resno] ? l_tccp->prch[resno] - 1 : 0) : l_tccp->prch[resno];
+                        OPJ_UINT32 l_band_w = opj_uint_ceildivpow2(l_tilec_w, l_level);
+                        OPJ_UINT32 l_band_h = opj_uint_ceildivpow2(l_tilec_h, l_level);
+
+                        l_nb_cblks += (resno ? 3U : 1U)
+                                      * (OPJ_UINT64)opj_uint_ceildivpow2(l_band_w, opj_uint_min(l_tccp->cblkw, l_cbgw))
+                                      * opj_uint_ceildivpow2(l_band_h, opj_uint_min(l_tccp->cblkh, l_cbgh));
+                }
+                l_tile_size += l_nb_cblks * (sizeof(opj_tcd_cblk_dec_t) + OPJ_J2K_DEFAULT_CBLK_DATA_SIZE
+                                             + OPJ_J2K_DEFAULT_NB_SEGS * sizeof(opj_tcd_seg_t));
+        }
+
+        /* compressed data of the tile */
+        l_tile_size += (OPJ_UINT64)opj_stream_get_number_byte_left(p_stream) / (l_cp->tw * l_cp->th);
+
+        if (l_image_size + l_tile_size > l_max_memory) {
+                opj_event_msg(p_manager, EVT_ERROR,
+                              "Decoding the image needs about %u MB, more than the memory budget of %u MB\n",
+                              (OPJ_UINT32)((l_image_size + l_tile_size + 0xFFFFFU) >> 20),
+                              (OPJ_UINT32)(l_max_memory >> 20));
+                return OPJ_FALSE;
+        }
+
+        l_nb_tiles_in_budget = (l_max_memory - l_image_size) / l_tile_size;
+        l_dec->m_max_tiles_in_flight = l_nb_tiles_in_budget > 0xFFFFU ? 0xFFFFU : (OPJ_UINT32)l_nb_tiles_in_budget;
+
+        return OPJ_TRUE;
+}
+
+static OPJ_BOOL opj_j2k_use_tile_parallel_decoding(opj_j2k_t *p_j2k)
+{
+        OPJ_UINT32 l_nb_tiles_to_decode =
+                (p_j2k->m_specific_param.m_decoder.m_end_tile_x - p_j2k->m_specific_param.m_decoder.m_start_tile_x) *
+                (p_j2k->m_specific_param.m_decoder.m_end_tile_y - p_j2k->m_specific_param.m_decoder.m_start_tile_y);
+
+        /* with a single tile, the code-blocks are decoded concurrently instead, as they */
+        /* are when the memory budget only allows one tile at a time */
+        return opj_thread_pool_get_thread_count(p_j2k->m_tp) > 1 && l_nb_tiles_to_decode > 1
+                && p_j2k->m_specific_param.m_decoder.m_max_tiles_in_flight != 1;
+}
+
+OPJ_BOOL opj_j2k_decode_tiles_parallel ( opj_j2k_t *p_j2k,
+                                         opj_stream_private_t *p_stream,
+                                         opj_event_mgr_t * p_manager)
+{
+        OPJ_BOOL l_go_on = OPJ_TRUE;
+        OPJ_UINT32 nr_tiles = 0;
+        OPJ_UINT32 i;
+        OPJ_BOOL l_ret = OPJ_TRUE;
+        opj_j2k_tile_decoding_state_t l_state;
+        opj_image_t * l_output_image = p_j2k->m_output_image;
+        /* Tiles queued or being decoded, each one holding its compressed data */
+        /* and its decoded samples: bounding them bounds the memory used */
+        int l_max_tiles_in_flight = OPJ_J2K_MAX_TILES_IN_FLIGHT_PER_THREAD * opj_thread_pool_get_thread_count(p_j2k->m_tp);
+
+        if (p_j2k->m_specific_param.m_decoder.m_max_tiles_in_flight != 0
+            && (OPJ_UINT32)l_max_tiles_in_flight > p_j2k->m_specific_param.m_decoder.m_max_tiles_in_flight) {
+                /* no more tiles than the memory budget allows */
+                l_max_tiles_in_flight = (int)p_j2k->m_specific_param.m_decoder.m_max_tiles_in_flight;
+        }
+
+        memset(&l_state, 0, sizeof(l_state));
+        l_state.m_cp = &(p_j2k->m_cp);
+        l_state.m_private_image = p_j2k->m_private_image;
+        l_state.m_output_image = l_output_image;
+        l_state.m_cstr_index = p_j2k->cstr_index;
+        l_state.m_kernels = &p_j2k->m_kernels;
+        l_state.m_dec = &(p_j2k->m_specific_param.m_decoder);
+        l_state.m_manager = p_manager;
+        l_state.m_ret = OPJ_TRUE;
+        l_state.m_mutex = opj_mutex_create();
+        if (! l_state.m_mutex) {
+                opj_event_msg(p_manager, EVT_ERROR, "Cannot create mutex\n");
+                return OPJ_FALSE;
+        }
+
+        /* The output buffers are shared by the jobs, allocate them before */
+        /* (unless the tiles are written to the caller buffer) */
+        for (i = 0; i < l_output_image->numcomps && ! l_state.m_dec->m_dest_buffer; ++i) {
+                opj_image_comp_t * l_img_comp = &(l_output_image->comps[i]);
+                if (! l_img_comp->data) {
+                        l_img_comp->data = (OPJ_INT32*) opj_calloc((OPJ_SIZE_T)l_img_comp->w * l_img_comp->h, sizeof(OPJ_INT32));
+                        if (! l_img_comp->data) {
+                                opj_mutex_destroy(l_state.m_mutex);
+                                opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to decode tiles\n");
+                                return OPJ_FALSE;
+                        }
+                }
+        }
+
+        while (OPJ_TRUE) {
+                opj_j2k_tile_decoding_job_t * l_job;
+                opj_tcp_t * l_tcp;
+                OPJ_UINT32 l_tile_no;
+
+                opj_mutex_lock(l_state.m_mutex);
+                if (! opj_j2k_read_tile_parts(p_j2k, &l_go_on, p_stream, p_manager)) {
+                        opj_mutex_unlock(l_state.m_mutex);
+                        l_ret = OPJ_FALSE;
+                        break;
+                }
+                opj_mutex_unlock(l_state.m_mutex);
+
+                if (! l_go_on) {
+                        break;
+                }
+
+                l_tile_no = p_j2k->m_current_tile_number;
+                l_tcp = &(p_j2k->m_cp.tcps[l_tile_no]);
+                if (! l_tcp->m_data) {
+                        opj_j2k_tcp_destroy(l_tcp);
+                        l_ret = OPJ_FALSE;
+                        break;
+                }
+
+                l_job = (opj_j2k_tile_decoding_job_t *) opj_malloc(sizeof(opj_j2k_tile_decoding_job_t));
+                if (! l_job) {
+                        opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to decode tile %d/%d\n", l_tile_no + 1, p_j2k->m_cp.th * p_j2k->m_cp.tw);
+                        l_ret = OPJ_FALSE;
+                        break;
+                }
+                l_job->m_state = &l_state;
+                l_job->m_tile_no = l_tile_no;
+                l_job->m_seq = ++nr_tiles;
+                /* the job takes ownership of the tile data */
+                l_job->m_data = l_tcp->m_data;
+                l_job->m_data_size = l_tcp->m_data_size;
+                l_job->m_data_borrowed = l_tcp->m_data_borrowed;
+                l_job->m_packet_lengths = l_tcp->m_packet_lengths;
+                l_job->m_nb_packet_lengths = l_tcp->m_nb_packet_lengths;
+                l_tcp->m_data = 00;
+                l_tcp->m_data_size = 0;
+                l_tcp->m_data_borrowed = 0;
+                l_tcp->m_packet_lengths = 00;
+                l_tcp->m_max_packet_lengths = 0;
+                opj_j2k_tcp_data_destroy(l_tcp);
+
+                opj_thread_pool_wait_completion(p_j2k->m_tp, l_max_tiles_in_flight - 1);
+                if (! l_state.m_ret) {
+                        opj_j2k_tile_decoding_job_free_data(l_job);
+                        opj_free(l_job);
+                        l_ret = OPJ_FALSE;
+                        break;
+                }
+                if (! opj_thread_pool_submit_job(p_j2k->m_tp, opj_j2k_tile_decoding_processor, l_job)) {
+                        opj_j2k_tile_decoding_job_free_data(l_job);
+                        opj_free(l_job);
+                        l_ret = OPJ_FALSE;
+                        break;
+                }
+
+                opj_mutex_lock(l_state.m_mutex);
+                l_ret = opj_j2k_read_next_tile_marker(p_j2k, p_stream, p_manager);
+                opj_mutex_unlock(l_state.m_mutex);
+                if (! l_ret) {
+                        break;
+                }
+
+                if(opj_stream_get_number_byte_left(p_stream) == 0
+                    && p_j2k->m_specific_param.m_decoder.m_state == J2K_STATE_NEOC)
+                    break;
+                if(nr_tiles ==  p_j2k->m_cp.th * p_j2k->m_cp.tw)
+                    break;
+        }
+
+        opj_thread_pool_wait_completion(p_j2k->m_tp, 0);
+        opj_mutex_destroy(l_state.m_mutex);
+
+        if (! l_state.m_ret) {
+                p_j2k->m_specific_param.m_decoder.m_state |= 0x8000;/*FIXME J2K_DEC_STATE_ERR;*/
+                l_ret = OPJ_FALSE;
+        }
+
+        return l_ret;
+}
+
 OPJ_BOOL opj_j2k_decode_tiles ( opj_j2k_t *p_j2k,
                                                             opj_stream_private_t *p_stream,
                                                             opj_event_mgr_t * p_manager)
@@ -9401,14 +10926,25 @@ OPJ_BOOL opj_j2k_decode_tiles ( opj_j2k_t *p_j2k,
         OPJ_INT32 l_tile_x0,l_tile_y0,l_tile_x1,l_tile_y1;
         OPJ_UINT32 l_nb_comps;
         OPJ_BYTE * l_current_data;
+        OPJ_BYTE * l_dest_buffer;
+        opj_j2k_dec_t * l_dec = &(p_j2k->m_specific_param.m_decoder);
         OPJ_UINT32 nr_tiles = 0;
 
-        l_current_data = (OPJ_BYTE*)opj_malloc(1000);
-        if (! l_current_data) {
-                opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to decode tiles\n");
-                return OPJ_FALSE;
+        if (opj_j2k_use_tile_parallel_decoding(p_j2k)) {
+                return opj_j2k_decode_tiles_parallel(p_j2k, p_stream, p_manager);
         }
-        l_max_data_size = 1000;
+
+        /* the buffer of the decoded samples of a tile is kept by the codec, from one image to the next */
+        if (! l_dec->m_tile_data) {
+                l_dec->m_tile_data = (OPJ_BYTE*)opj_malloc(1000);
+                if (! l_dec->m_tile_data) {
+                        opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to decode tiles\n");
+                        return OPJ_FALSE;
+                }
+                l_dec->m_tile_data_size = 1000;
+        }
+        l_current_data = l_dec->m_tile_data;
+        l_max_data_size = l_dec->m_tile_data_size;
 
         while (OPJ_TRUE) {
                 if (! opj_j2k_read_tile_header( p_j2k,
@@ -9420,7 +10956,6 @@ OPJ_BOOL opj_j2k_decode_tiles ( opj_j2k_t *p_j2k,
                                         &l_go_on,
                                         p_stream,
                                         p_manager)) {
-                        opj_free(l_current_data);
                         return OPJ_FALSE;
                 }
 
@@ -9428,28 +10963,40 @@ OPJ_BOOL opj_j2k_decode_tiles ( opj_j2k_t *p_j2k,
                         break;
                 }
 
-                if (l_data_size > l_max_data_size) {
+                /* with a caller buffer, the samples are written from the tile components */
+                l_dest_buffer = p_j2k->m_specific_param.m_decoder.m_dest_buffer;
+
+                if (! l_dest_buffer && l_data_size > l_max_data_size) {
                         OPJ_BYTE *l_new_current_data = (OPJ_BYTE *) opj_realloc(l_current_data, l_data_size);
                         if (! l_new_current_data) {
                                 opj_free(l_current_data);
+                                l_dec->m_tile_data = 00;
+                                l_dec->m_tile_data_size = 0;
                                 opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to decode tile %d/%d\n", l_current_tile_no +1, p_j2k->m_cp.th * p_j2k->m_cp.tw);
                                 return OPJ_FALSE;
                         }
                         l_current_data = l_new_current_data;
                         l_max_data_size = l_data_size;
+                        l_dec->m_tile_data = l_current_data;
+                        l_dec->m_tile_data_size = l_max_data_size;
                 }
 
-                if (! opj_j2k_decode_tile(p_j2k,l_current_tile_no,l_current_data,l_data_size,p_stream,p_manager)) {
-                        opj_free(l_current_data);
+                if (! opj_j2k_decode_tile(p_j2k,l_current_tile_no,l_dest_buffer ? 00 : l_current_data,l_data_size,p_stream,p_manager)) {
                         opj_event_msg(p_manager, EVT_ERROR, "Failed to decode tile %d/%d\n", l_current_tile_no +1, p_j2k->m_cp.th * p_j2k->m_cp.tw);
                         return OPJ_FALSE;
                 }
                 opj_event_msg(p_manager, EVT_INFO, "Tile %d/%d has been decoded.\n", l_current_tile_no +1, p_j2k->m_cp.th * p_j2k->m_cp.tw);
 
-                if (! opj_j2k_update_image_data(p_j2k->m_tcd,l_current_data, p_j2k->m_output_image)) {
-                        opj_free(l_current_data);
+                if (l_dest_buffer) {
+                        opj_j2k_update_buffer_data(p_j2k->m_tcd, &(p_j2k->m_specific_param.m_decoder), p_j2k->m_output_image);
+                }
+                else if (! opj_j2k_update_image_data(p_j2k->m_tcd,l_current_data, p_j2k->m_output_image)) {
                         return OPJ_FALSE;
                 }
+                opj_j2k_update_image_resno_decoded(p_j2k->m_tcd->image, p_j2k->m_output_image);
+                if (p_j2k->m_cp.m_specific_param.m_dec.m_max_memory) {
+                        opj_tcd_release_tile(p_j2k->m_tcd);
+                }
                 opj_event_msg(p_manager, EVT_INFO, "Image data has been updated with tile %d.\n\n", l_current_tile_no + 1);
                 
                 if(opj_stream_get_number_byte_left(p_stream) == 0  
@@ -9459,7 +11006,12 @@ OPJ_BOOL opj_j2k_decode_tiles ( opj_j2k_t *p_j2k,
                     break;
         }
 
-        opj_free(l_current_data);
+        if (p_j2k->m_cp.m_specific_param.m_dec.m_max_memory) {
+                /* within a memory budget, the codec does not keep tile buffers between images */
+                opj_free(l_dec->m_tile_data);
+                l_dec->m_tile_data = 00;
+                l_dec->m_tile_data_size = 0;
+        }
 
         return OPJ_TRUE;
 }
@@ -9522,10 +11074,14 @@ static OPJ_BOOL opj_j2k_decode_one_tile (       opj_j2k_t *p_j2k,
                                 }
                         }
                         else{
-                                if ( !(opj_stream_read_seek(p_stream, p_j2k->cstr_index->tile_index[l_tile_no_to_dec].tp_index[0].start_pos+2, p_manager)) ) {
-                                        opj_event_msg(p_manager, EVT_ERROR, "Problem with seek function\n");
+                                /* the first tile-part of the tile is located, by its SOT marker or by TLM */
+                                if ( !(opj_j2k_seek_tile_part(p_stream, p_j2k->cstr_index->tile_index[l_tile_no_to_dec].tp_index[0].start_pos, p_manager)) ) {
+                                        /* a wrong index (from inconsistent TLM markers): read all the SOT markers */
+                                        if ( !(opj_stream_read_seek(p_stream, p_j2k->cstr_index->main_head_end + 2, p_manager)) ) {
+                                                opj_event_msg(p_manager, EVT_ERROR, "Problem with seek function\n");
                         opj_free(l_current_data);
-                                        return OPJ_FALSE;
+                                                return OPJ_FALSE;
+                                        }
                                 }
                         }
                         /* Special case if we have previously read the EOC marker (if the previous tile getted is the last ) */
@@ -9575,6 +11131,10 @@ static OPJ_BOOL opj_j2k_decode_one_tile (       opj_j2k_t *p_j2k,
                         opj_free(l_current_data);
                         return OPJ_FALSE;
                 }
+                opj_j2k_update_image_resno_decoded(p_j2k->m_tcd->image, p_j2k->m_output_image);
+                if (p_j2k->m_cp.m_specific_param.m_dec.m_max_memory) {
+                        opj_tcd_release_tile(p_j2k->m_tcd);
+                }
                 opj_event_msg(p_manager, EVT_INFO, "Image data has been updated with tile %d.\n\n", l_current_tile_no);
 
                 if(l_current_tile_no == l_tile_no_to_dec)
@@ -9620,6 +11180,10 @@ OPJ_BOOL opj_j2k_decode(opj_j2k_t * p_j2k,
         if (!p_image)
                 return OPJ_FALSE;
 
+        if (! opj_j2k_check_memory_budget(p_j2k, p_image, p_stream, p_manager)) {
+                return OPJ_FALSE;
+        }
+
         p_j2k->m_output_image = opj_image_create0();
         if (! (p_j2k->m_output_image)) {
                 return OPJ_FALSE;
@@ -9653,6 +11217,68 @@ OPJ_BOOL opj_j2k_decode(opj_j2k_t * p_j2k,
         return OPJ_TRUE;
 }
 
+OPJ_BOOL opj_j2k_decode_into_buffer(opj_j2k_t * p_j2k,
+                                    opj_stream_private_t * p_stream,
+                                    opj_image_t * p_image,
+                                    OPJ_BYTE * p_buffer,
+                                    OPJ_SIZE_T p_stride,
+                                    OPJ_PIXEL_FORMAT p_format,
+                                    opj_event_mgr_t * p_manager)
+{
+        OPJ_UINT32 l_nb_channels, l_sample_size, l_nb_comps, compno, i, j;
+        OPJ_BOOL l_ret;
+
+        if (!p_image || !p_buffer)
+                return OPJ_FALSE;
+
+        if (! opj_j2k_get_pixel_layout(p_format, &l_nb_channels, &l_sample_size)) {
+                opj_event_msg(p_manager, EVT_ERROR, "Unknown pixel format %d\n", (int)p_format);
+                return OPJ_FALSE;
+        }
+
+        /* the alpha channel is optional */
+        l_nb_comps = opj_uint_min(l_nb_channels, p_image->numcomps);
+        if (l_nb_comps < (l_nb_channels == 4 ? 3 : l_nb_channels)) {
+                opj_event_msg(p_manager, EVT_ERROR, "The image has %d components, not enough for the pixel format\n", p_image->numcomps);
+                return OPJ_FALSE;
+        }
+        for (compno = 1; compno < l_nb_comps; ++compno) {
+                if (p_image->comps[compno].dx != p_image->comps[0].dx || p_image->comps[compno].dy != p_image->comps[0].dy) {
+                        opj_event_msg(p_manager, EVT_ERROR, "Components with different subsamplings cannot be decoded into a buffer\n");
+                        return OPJ_FALSE;
+                }
+        }
+        if (p_stride / (l_nb_channels * l_sample_size) < p_image->comps[0].w) {
+                opj_event_msg(p_manager, EVT_ERROR, "The stride of the buffer is smaller than a row of pixels\n");
+                return OPJ_FALSE;
+        }
+
+        /* opaque pixels when the image has no alpha component */
+        if (l_nb_comps < l_nb_channels) {
+                for (j = 0; j < p_image->comps[0].h; ++j) {
+                        OPJ_BYTE * l_row = p_buffer + (OPJ_SIZE_T)j * p_stride;
+                        for (i = 0; i < p_image->comps[0].w; ++i) {
+                                if (l_sample_size == 1) {
+                                        l_row[i * 4 + 3] = 0xff;
+                                }
+                                else {
+                                        ((OPJ_UINT16 *) l_row)[i * 4 + 3] = 0xffff;
+                                }
+                        }
+                }
+        }
+
+        p_j2k->m_specific_param.m_decoder.m_dest_buffer = p_buffer;
+        p_j2k->m_specific_param.m_decoder.m_dest_stride = p_stride;
+        p_j2k->m_specific_param.m_decoder.m_dest_format = p_format;
+
+        l_ret = opj_j2k_decode(p_j2k, p_stream, p_image, p_manager);
+
+        p_j2k->m_specific_param.m_decoder.m_dest_buffer = 00;
+
+        return l_ret;
+}
+
 OPJ_BOOL opj_j2k_get_tile(      opj_j2k_t *p_j2k,
                                                     opj_stream_private_t *p_stream,
                                                     opj_image_t* p_image,
@@ -9709,6 +11335,10 @@ OPJ_BOOL opj_j2k_get_tile(      opj_j2k_t *p_j2k,
                 l_img_comp++;
         }
 
+        if (! opj_j2k_check_memory_budget(p_j2k, p_image, p_stream, p_manager)) {
+                return OPJ_FALSE;
+        }
+
         /* Destroy the previous output image*/
         if (p_j2k->m_output_image)
                 opj_image_destroy(p_j2k->m_output_image);
@@ -9776,13 +11406,324 @@ OPJ_BOOL opj_j2k_set_decoded_resolution_factor(opj_j2k_t *p_j2k,
         return OPJ_FALSE;
 }
 
+OPJ_BOOL opj_j2k_copy_image_to_tile(  opj_tcd_t * p_tcd,
+                                        OPJ_BYTE ** p_buffer,
+                                        OPJ_UINT32 * p_buffer_size,
+                                        opj_event_mgr_t * p_manager )
+{
+        OPJ_UINT32 j;
+        OPJ_UINT32 l_current_tile_size;
+
+        for (j=0;j<p_tcd->image->numcomps;++j) {
+                opj_tcd_tilecomp_t* l_tilec = p_tcd->tcd_image->tiles->comps + j;
+                if(! opj_alloc_tile_component_data(l_tilec)) {
+                        opj_event_msg(p_manager, EVT_ERROR, "Error allocating tile component data." );
+                        return OPJ_FALSE;
+                }
+        }
+
+        l_current_tile_size = opj_tcd_get_encoded_tile_size(p_tcd);
+        if (l_current_tile_size > *p_buffer_size) {
+                OPJ_BYTE *l_new_current_data = (OPJ_BYTE *) opj_realloc(*p_buffer, l_current_tile_size);
+                if (! l_new_current_data) {
+                        opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to encode all tiles\n");
+                        return OPJ_FALSE;
+                }
+                *p_buffer = l_new_current_data;
+                *p_buffer_size = l_current_tile_size;
+        }
+
+        /* copy image data (32 bit) to l_current_data as contiguous, all-component, zero offset buffer */
+        /* 32 bit components @ 8 bit precision get converted to 8 bit */
+        /* 32 bit components @ 16 bit precision get converted to 16 bit */
+        opj_j2k_get_tile_data(p_tcd,*p_buffer);
+
+        /* now copy this data into the tile component */
+        if (! opj_tcd_copy_tile_data(p_tcd,*p_buffer,l_current_tile_size)) {
+                opj_event_msg(p_manager, EVT_ERROR, "Size mismatch between tile data and sent data." );
+                return OPJ_FALSE;
+        }
+
+        return OPJ_TRUE;
+}
+
+/**
+ * State shared by the tile encoding jobs of opj_j2k_encode_tiles_parallel()
+ */
+typedef struct opj_j2k_tile_encoding_state
+{
+        /** the codec (read only while jobs are running) */
+        opj_j2k_t * m_j2k;
+        /** the output stream, only given to the tile-part writers */
+        opj_stream_private_t * m_stream;
+        /** event manager, only used while holding m_mutex */
+        opj_event_mgr_t * m_manager;
+        /** protects m_manager and the m_done flag of the jobs */
+        opj_mutex_t * m_mutex;
+        /** set to OPJ_FALSE by a job that failed */
+        volatile OPJ_BOOL m_ret;
+} opj_j2k_tile_encoding_state_t;
+
+/**
+ * A tile to encode by a worker thread
+ */
+typedef struct opj_j2k_tile_encoding_job
+{
+        opj_j2k_tile_encoding_state_t * m_state;
+        /** index of the tile */
+        OPJ_UINT32 m_tile_no;
+        /** encoded tile-parts (m_encoded_tile_size bytes) */
+        OPJ_BYTE * m_data;
+        OPJ_UINT32 m_data_size;
+        /** TLM entries of the tile-parts (cinema profiles only) */
+        OPJ_BYTE * m_tlm_data;
+        OPJ_UINT32 m_tlm_size;
+        /** set (under m_mutex) when the job is over */
+        OPJ_BOOL m_done;
+} opj_j2k_tile_encoding_job_t;
+
+static void opj_j2k_tile_encoding_job_destroy(opj_j2k_tile_encoding_job_t * p_job)
+{
+        if (p_job) {
+                opj_free(p_job->m_data);
+                opj_free(p_job->m_tlm_data);
+                opj_free(p_job);
+        }
+}
+
+/**
+ * Encodes one tile with a private tile coder, in the buffers of the job.
+ */
+static void opj_j2k_tile_encoding_processor(void * p_user_data, opj_tls_t * p_tls)
+{
+        opj_j2k_tile_encoding_job_t * l_job = (opj_j2k_tile_encoding_job_t *) p_user_data;
+        opj_j2k_tile_encoding_state_t * l_state = l_job->m_state;
+        opj_j2k_t * l_shared_j2k = l_state->m_j2k;
+        opj_j2k_t l_j2k;
+        opj_event_mgr_t l_manager;
+        opj_thread_pool_t * l_tp;
+        opj_image_t * l_image = 00;
+        opj_tcd_t * l_tcd = 00;
+        OPJ_BYTE * l_tile_data = 00;
+        OPJ_UINT32 l_tile_data_size = 0;
+        OPJ_UINT32 i;
+        OPJ_BOOL l_success = OPJ_FALSE;
+
+        /* the messages of the tile-part writers are not thread-safe, they are dropped */
+        /* and a single error is reported below */
+        memset(&l_manager, 0, sizeof(l_manager));
+
+        if (! l_state->m_ret) {
+                goto end;
+        }
+
+        l_tp = opj_j2k_get_tile_thread_pool(p_tls);
+        if (! l_tp) {
+                goto end;
+        }
+
+        /* opj_tcd_init_tile() writes in the image header, so each tile needs its own */
+        /* one. The samples are borrowed from the private image of the codec. */
+        l_image = opj_image_create0();
+        if (! l_image) {
+                goto end;
+        }
+        opj_copy_image_header(l_shared_j2k->m_private_image, l_image);
+        if (! l_image->comps) {
+                goto end;
+        }
+        for (i = 0; i < l_image->numcomps; ++i) {
+                l_image->comps[i].data = l_shared_j2k->m_private_image->comps[i].data;
+        }
+
+        l_tcd = opj_j2k_get_tile_coder(p_tls, OPJ_FALSE);
+        if (! l_tcd || ! opj_tcd_init(l_tcd, l_image, &(l_shared_j2k->m_cp), l_tp, &l_shared_j2k->m_kernels)) {
+                goto end;
+        }
+
+        /* private view of the codec: the tile-part writers only update the current */
+        /* tile number, the tile coder and the tile-part counters of the encoder */
+        l_j2k = *l_shared_j2k;
+        l_j2k.m_current_tile_number = l_job->m_tile_no;
+        l_j2k.m_tcd = l_tcd;
+        l_j2k.m_specific_param.m_encoder.m_encoded_tile_data = l_job->m_data;
+        l_j2k.m_specific_param.m_encoder.m_tlm_sot_offsets_buffer = l_job->m_tlm_data;
+        l_j2k.m_specific_param.m_encoder.m_tlm_sot_offsets_current = l_job->m_tlm_data;
+
+        if (! opj_j2k_pre_write_tile(&l_j2k, l_job->m_tile_no, l_state->m_stream, &l_manager)) {
+                goto end;
+        }
+        if (! opj_j2k_copy_image_to_tile(l_tcd, &l_tile_data, &l_tile_data_size, &l_manager)) {
+                goto end;
+        }
+        if (! opj_j2k_write_tile_parts(&l_j2k, &(l_job->m_data_size), l_state->m_stream, &l_manager)) {
+                goto end;
+        }
+        if (l_job->m_tlm_data) {
+                l_job->m_tlm_size = (OPJ_UINT32)(l_j2k.m_specific_param.m_encoder.m_tlm_sot_offsets_current - l_job->m_tlm_data);
+        }
+
+        l_success = OPJ_TRUE;
+
+end:
+        opj_mutex_lock(l_state->m_mutex);
+        if (! l_success && l_state->m_ret) {
+                l_state->m_ret = OPJ_FALSE;
+                opj_event_msg(l_state->m_manager, EVT_ERROR, "Failed to encode tile %d/%d\n", l_job->m_tile_no + 1, l_shared_j2k->m_cp.th * l_shared_j2k->m_cp.tw);
+        }
+        l_job->m_done = OPJ_TRUE;
+        opj_mutex_unlock(l_state->m_mutex);
+
+        opj_free(l_tile_data);
+        if (l_image) {
+                if (l_image->comps) {
+                        for (i = 0; i < l_image->numcomps; ++i) {
+                                l_image->comps[i].data = 00;
+                        }
+                }
+                opj_image_destroy(l_image);
+        }
+}
+
+OPJ_BOOL opj_j2k_encode_tiles_parallel ( opj_j2k_t *p_j2k,
+                                         opj_stream_private_t *p_stream,
+                                         opj_event_mgr_t * p_manager )
+{
+        OPJ_UINT32 l_nb_tiles = p_j2k->m_cp.th * p_j2k->m_cp.tw;
+        OPJ_UINT32 l_nb_submitted = 0;
+        OPJ_UINT32 l_nb_written = 0;
+        OPJ_UINT32 i;
+        OPJ_BOOL l_ret = OPJ_TRUE;
+        opj_j2k_tile_encoding_state_t l_state;
+        opj_j2k_tile_encoding_job_t ** l_jobs;
+        OPJ_BYTE * l_tlm_current = p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_current;
+        /* Tiles queued, being encoded or waiting to be written, each one holding */
+        /* its encoded data: bounding them bounds the memory used */
+        OPJ_UINT32 l_max_tiles_in_flight = (OPJ_UINT32)(OPJ_J2K_MAX_TILES_IN_FLIGHT_PER_THREAD * opj_thread_pool_get_thread_count(p_j2k->m_tp));
+
+        memset(&l_state, 0, sizeof(l_state));
+        l_state.m_j2k = p_j2k;
+        l_state.m_stream = p_stream;
+        l_state.m_manager = p_manager;
+        l_state.m_ret = OPJ_TRUE;
+        l_state.m_mutex = opj_mutex_create();
+        if (! l_state.m_mutex) {
+                opj_event_msg(p_manager, EVT_ERROR, "Cannot create mutex\n");
+                return OPJ_FALSE;
+        }
+
+        /* jobs in flight, the one of tile i being stored at i % l_max_tiles_in_flight */
+        l_jobs = (opj_j2k_tile_encoding_job_t **) opj_calloc(l_max_tiles_in_flight, sizeof(opj_j2k_tile_encoding_job_t *));
+        if (! l_jobs) {
+                opj_mutex_destroy(l_state.m_mutex);
+                opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to encode all tiles\n");
+                return OPJ_FALSE;
+        }
+
+        while (l_nb_written < l_nb_tiles) {
+                opj_j2k_tile_encoding_job_t * l_job;
+                OPJ_UINT32 l_nb_in_flight = l_nb_submitted - l_nb_written;
+                OPJ_UINT32 l_nb_done = 0;
+                OPJ_BOOL l_oldest_done;
+
+                if (! l_state.m_ret) {
+                        l_ret = OPJ_FALSE;
+                        break;
+                }
+
+                /* keep the workers busy */
+                if (l_nb_submitted < l_nb_tiles && l_nb_in_flight < l_max_tiles_in_flight) {
+                        opj_tcp_t * l_tcp = p_j2k->m_cp.tcps + l_nb_submitted;
+
+                        l_job = (opj_j2k_tile_encoding_job_t *) opj_calloc(1, sizeof(opj_j2k_tile_encoding_job_t));
+                        if (l_job) {
+                                l_job->m_state = &l_state;
+                                l_job->m_tile_no = l_nb_submitted;
+                                l_job->m_data = (OPJ_BYTE *) opj_malloc(p_j2k->m_specific_param.m_encoder.m_encoded_tile_size);
+                                if (p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_buffer) {
+                                        l_job->m_tlm_data = (OPJ_BYTE *) opj_malloc(5 * l_tcp->m_nb_tile_parts);
+                                }
+                        }
+                        if (! l_job || ! l_job->m_data
+                            || (p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_buffer && ! l_job->m_tlm_data)) {
+                                opj_j2k_tile_encoding_job_destroy(l_job);
+                                opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to encode all tiles\n");
+                                l_ret = OPJ_FALSE;
+                                break;
+                        }
+
+                        opj_mutex_lock(l_state.m_mutex);
+                        opj_event_msg(p_manager, EVT_INFO, "tile number %d / %d\n", l_nb_submitted + 1, l_nb_tiles);
+                        opj_mutex_unlock(l_state.m_mutex);
+
+                        l_jobs[l_nb_submitted % l_max_tiles_in_flight] = l_job;
+                        ++l_nb_submitted;
+                        if (! opj_thread_pool_submit_job(p_j2k->m_tp, opj_j2k_tile_encoding_processor, l_job)) {
+                                l_ret = OPJ_FALSE;
+                                break;
+                        }
+                        continue;
+                }
+
+                /* write the tiles in order: wait for the oldest one */
+                l_job = l_jobs[l_nb_written % l_max_tiles_in_flight];
+                opj_mutex_lock(l_state.m_mutex);
+                l_oldest_done = l_job->m_done;
+                for (i = l_nb_written; i < l_nb_submitted; ++i) {
+                        if (l_jobs[i % l_max_tiles_in_flight]->m_done) {
+                                ++l_nb_done;
+                        }
+                }
+                opj_mutex_unlock(l_state.m_mutex);
+
+                if (! l_oldest_done) {
+                        /* at least one of the jobs not done yet must complete */
+                        opj_thread_pool_wait_completion(p_j2k->m_tp, (int)(l_nb_in_flight - l_nb_done - 1));
+                        continue;
+                }
+                if (! l_state.m_ret) {
+                        l_ret = OPJ_FALSE;
+                        break;
+                }
+
+                if (opj_stream_write_data(p_stream, l_job->m_data, l_job->m_data_size, p_manager) != l_job->m_data_size) {
+                        l_ret = OPJ_FALSE;
+                        break;
+                }
+                if (l_job->m_tlm_data) {
+                        memcpy(l_tlm_current, l_job->m_tlm_data, l_job->m_tlm_size);
+                        l_tlm_current += l_job->m_tlm_size;
+                }
+
+                opj_j2k_tile_encoding_job_destroy(l_job);
+                l_jobs[l_nb_written % l_max_tiles_in_flight] = 00;
+                ++l_nb_written;
+        }
+
+        if (! l_ret) {
+                /* tell the jobs not started yet to give up */
+                l_state.m_ret = OPJ_FALSE;
+        }
+        opj_thread_pool_wait_completion(p_j2k->m_tp, 0);
+        for (i = 0; i < l_max_tiles_in_flight; ++i) {
+                opj_j2k_tile_encoding_job_destroy(l_jobs[i]);
+        }
+        /* the jobs read the codec: it is only updated once they are over */
+        p_j2k->m_current_tile_number += l_nb_written;
+        p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_current = l_tlm_current;
+        opj_free(l_jobs);
+        opj_mutex_destroy(l_state.m_mutex);
+
+        return l_ret;
+}
+
 OPJ_BOOL opj_j2k_encode(opj_j2k_t * p_j2k,
                         opj_stream_private_t *p_stream,
                         opj_event_mgr_t * p_manager )
 {
         OPJ_UINT32 i, j;
         OPJ_UINT32 l_nb_tiles;
-        OPJ_UINT32 l_max_tile_size = 0, l_current_tile_size;
+        OPJ_UINT32 l_max_tile_size = 0;
         OPJ_BYTE * l_current_data = 00;
         opj_tcd_t* p_tcd = 00;
 
@@ -9794,6 +11735,10 @@ OPJ_BOOL opj_j2k_encode(opj_j2k_t * p_j2k,
         p_tcd = p_j2k->m_tcd;
 
         l_nb_tiles = p_j2k->m_cp.th * p_j2k->m_cp.tw;
+        if (l_nb_tiles > 1 && opj_thread_pool_get_thread_count(p_j2k->m_tp) > 1) {
+                return opj_j2k_encode_tiles_parallel(p_j2k, p_stream, p_manager);
+        }
+
         for (i=0;i<l_nb_tiles;++i) {
                 if (! opj_j2k_pre_write_tile(p_j2k,i,p_stream,p_manager)) {
                         if (l_current_data) {
@@ -9803,52 +11748,26 @@ OPJ_BOOL opj_j2k_encode(opj_j2k_t * p_j2k,
                 }
 
                 /* if we only have one tile, then simply set tile component data equal to image component data */
-                /* otherwise, allocate the data */
-                for (j=0;j<p_j2k->m_tcd->image->numcomps;++j) {
-                        opj_tcd_tilecomp_t* l_tilec = p_tcd->tcd_image->tiles->comps + j;
-                        if (l_nb_tiles == 1) {
-												        opj_image_comp_t * l_img_comp = p_tcd->image->comps + j;
-												        l_tilec->data  =  l_img_comp->data;
-												        l_tilec->ownsData = OPJ_FALSE;
-                        } else {
-												        if(! opj_alloc_tile_component_data(l_tilec)) {
-												                opj_event_msg(p_manager, EVT_ERROR, "Error allocating tile component data." );
-												                if (l_current_data) {
-												                        opj_free(l_current_data);
-												                }
-												                return OPJ_FALSE;
-												        }
-												        opj_alloc_tile_component_data(l_tilec);
-                        }
-                }
-                l_current_tile_size = opj_tcd_get_encoded_tile_size(p_j2k->m_tcd);
-                if (l_nb_tiles > 1) {
-                        if (l_current_tile_size > l_max_tile_size) {
-												        OPJ_BYTE *l_new_current_data = (OPJ_BYTE *) opj_realloc(l_current_data, l_current_tile_size);
-												        if (! l_new_current_data) {
-												                if (l_current_data) {
-												                        opj_free(l_current_data);
-												                }
-												                opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to encode all tiles\n");
-												                return OPJ_FALSE;
-																}
-																l_current_data = l_new_current_data;
-																l_max_tile_size = l_current_tile_size;
-                        }
-
-                        /* copy image data (32 bit) to l_current_data as contiguous, all-component, zero offset buffer */
-                        /* 32 bit components @ 8 bit precision get converted to 8 bit */
-                        /* 32 bit components @ 16 bit precision get converted to 16 bit */
-                        opj_j2k_get_tile_data(p_j2k->m_tcd,l_current_data);
-
-                        /* now copy this data into the tile component */
-                        if (! opj_tcd_copy_tile_data(p_j2k->m_tcd,l_current_data,l_current_tile_size)) {
-																opj_event_msg(p_manager, EVT_ERROR, "Size mismatch between tile data and sent data." );
-																return OPJ_FALSE;
+                /* otherwise, allocate the data and copy the tile samples from the image */
+                if (l_nb_tiles == 1) {
+                        for (j=0;j<p_j2k->m_tcd->image->numcomps;++j) {
+                                opj_tcd_tilecomp_t* l_tilec = p_tcd->tcd_image->tiles->comps + j;
+                                opj_image_comp_t * l_img_comp = p_tcd->image->comps + j;
+                                l_tilec->data  =  l_img_comp->data;
+                                l_tilec->ownsData = OPJ_FALSE;
+                        }
+                }
+                else if (! opj_j2k_copy_image_to_tile(p_tcd, &l_current_data, &l_max_tile_size, p_manager)) {
+                        if (l_current_data) {
+                                opj_free(l_current_data);
                         }
+                        return OPJ_FALSE;
                 }
 
                 if (! opj_j2k_post_write_tile (p_j2k,p_stream,p_manager)) {
+                        if (l_current_data) {
+                                opj_free(l_current_data);
+                        }
                         return OPJ_FALSE;
                 }
         }
@@ -10071,18 +11990,16 @@ void opj_j2k_get_tile_data (opj_tcd_t * p_tcd, OPJ_BYTE * p_data)
         }
 }
 
-OPJ_BOOL opj_j2k_post_write_tile (      opj_j2k_t * p_j2k,
-                                                                opj_stream_private_t *p_stream,
-                                                                opj_event_mgr_t * p_manager )
+OPJ_BOOL opj_j2k_write_tile_parts(     opj_j2k_t * p_j2k,
+                                        OPJ_UINT32 * p_data_written,
+                                        opj_stream_private_t *p_stream,
+                                        opj_event_mgr_t * p_manager )
 {
         OPJ_UINT32 l_nb_bytes_written;
         OPJ_BYTE * l_current_data = 00;
         OPJ_UINT32 l_tile_size = 0;
         OPJ_UINT32 l_available_data;
 
-        /* preconditions */
-        assert(p_j2k->m_specific_param.m_encoder.m_encoded_tile_data);
-
         l_tile_size = p_j2k->m_specific_param.m_encoder.m_encoded_tile_size;
         l_available_data = l_tile_size;
         l_current_data = p_j2k->m_specific_param.m_encoder.m_encoded_tile_data;
@@ -10100,7 +12017,23 @@ OPJ_BOOL opj_j2k_post_write_tile (      opj_j2k_t * p_j2k,
         }
 
         l_available_data -= l_nb_bytes_written;
-        l_nb_bytes_written = l_tile_size - l_available_data;
+        *p_data_written = l_tile_size - l_available_data;
+
+        return OPJ_TRUE;
+}
+
+OPJ_BOOL opj_j2k_post_write_tile (      opj_j2k_t * p_j2k,
+                                                                opj_stream_private_t *p_stream,
+                                                                opj_event_mgr_t * p_manager )
+{
+        OPJ_UINT32 l_nb_bytes_written;
+
+        /* preconditions */
+        assert(p_j2k->m_specific_param.m_encoder.m_encoded_tile_data);
+
+        if (! opj_j2k_write_tile_parts(p_j2k,&l_nb_bytes_written,p_stream,p_manager)) {
+                return OPJ_FALSE;
+        }
 
         if ( opj_stream_write_data(     p_stream,
                                                                 p_j2k->m_specific_param.m_encoder.m_encoded_tile_data,
@@ -10536,7 +12469,7 @@ static OPJ_BOOL opj_j2k_create_tcd(     opj_j2k_t *p_j2k,
                 return OPJ_FALSE;
         }
 
-        if (!opj_tcd_init(p_j2k->m_tcd,p_j2k->m_private_image,&p_j2k->m_cp)) {
+        if (!opj_tcd_init(p_j2k->m_tcd,p_j2k->m_private_image,&p_j2k->m_cp,p_j2k->m_tp,&p_j2k->m_kernels)) {
                 opj_tcd_destroy(p_j2k->m_tcd);
                 p_j2k->m_tcd = 00;
                 return OPJ_FALSE;
@@ -66,6 +66,8 @@ The functions in J2K.C have for goal to read/write the several parts of the code
 #define J2K_CCP_QNTSTY_SEQNT 2
 
 #define OPJ_J2K_DEFAULT_CBLK_DATA_SIZE 8192
+#define OPJ_J2K_MAX_TILES_IN_FLIGHT_PER_THREAD 2 /**< Tiles queued or being coded at the same time, per worker thread */
+#define OPJ_J2K_PACKET_SCAN_WINDOW (64 * 1024) /**< Bytes read ahead of a packet to read its header, when its body may be skipped */
 
 /* ----------------------------------------------------------------------- */
 
@@ -272,6 +274,24 @@ typedef struct opj_tcp
 	OPJ_BYTE *		m_data;
 	/** size of data */
 	OPJ_UINT32		m_data_size;
+	/** set when m_data points into the data of a memory stream, which the tcp does not own */
+	OPJ_UINT32		m_data_borrowed : 1;
+	/** lengths of the packets of the tile in the order of the codestream, from the PLT or PLM markers */
+	OPJ_UINT32 *	m_packet_lengths;
+	/** number of lengths in m_packet_lengths */
+	OPJ_UINT32		m_nb_packet_lengths;
+	/** size of m_packet_lengths */
+	OPJ_UINT32		m_max_packet_lengths;
+	/** set when the packet lengths do not match the data of a tile-part: only the lengths */
+	/** of the tile-parts before it are used, m_nb_packet_lengths does not grow anymore */
+	OPJ_UINT32		m_packet_lengths_invalid : 1;
+	/** for each packet of the tile in the order of the codestream, 1 if the decoding needs it, */
+	/** when packets may be left out of m_data (see opj_j2k_read_sod()), NULL otherwise */
+	OPJ_BYTE *		m_needed_packets;
+	/** number of packets in m_needed_packets */
+	OPJ_UINT32		m_nb_packets;
+	/** index after the last packet needed */
+	OPJ_UINT32		m_end_needed_packets;
 	/** encoding norms */
 	OPJ_FLOAT64 *	mct_norms;
 	/** the mct decoding matrix */
@@ -329,10 +349,23 @@ typedef struct opj_decoding_param
 	OPJ_UINT32 m_reduce;
 	/** if != 0, then only the first "layer" layers are decoded; if == 0 or not used, all the quality layers are decoded */
 	OPJ_UINT32 m_layer;
+	/** if != 0, maximum number of bytes the decoding of an image may need; if == 0, the memory is not limited */
+	OPJ_SIZE_T m_max_memory;
 }
 opj_decoding_param_t;
 
 
+/**
+ * Length of a tile-part, as given by a TLM marker
+ */
+typedef struct opj_j2k_tlm_entry
+{
+	/** index of the tile the tile-part belongs to */
+	OPJ_UINT32 m_tile_no;
+	/** length of the tile-part, from its SOT marker on */
+	OPJ_UINT32 m_length;
+} opj_j2k_tlm_entry_t;
+
 /**
  * Coding parameters
  */
@@ -377,6 +410,34 @@ typedef struct opj_cp
 	/** use in case of multiple marker PPM (case on non-finished previous info) */
 	OPJ_INT32 ppm_previous;
 
+	/** tile-part lengths read from the TLM markers, in the order of the tile-parts */
+	opj_j2k_tlm_entry_t *tlm_entries;
+	/** number of entries in tlm_entries */
+	OPJ_UINT32 tlm_nb_entries;
+	/** size of tlm_entries */
+	OPJ_UINT32 tlm_max_entries;
+	/** number of TLM markers read */
+	OPJ_UINT32 tlm_nb_markers;
+
+	/** packet lengths read from the PLM markers, for all the tile-parts */
+	OPJ_UINT32 *plm_lengths;
+	/** number of lengths in plm_lengths */
+	OPJ_UINT32 plm_nb_lengths;
+	/** size of plm_lengths */
+	OPJ_UINT32 plm_max_lengths;
+	/** index in plm_lengths of the first packet length of each tile-part, in the order of the tile-parts */
+	OPJ_UINT32 *plm_tile_parts;
+	/** number of tile-parts in plm_tile_parts */
+	OPJ_UINT32 plm_nb_tile_parts;
+	/** size of plm_tile_parts */
+	OPJ_UINT32 plm_max_tile_parts;
+	/** number of PLM markers read */
+	OPJ_UINT32 plm_nb_markers;
+	/** number of tile-parts read one after the other from the first one, whose PLM packet lengths are known */
+	OPJ_UINT32 plm_nb_tile_parts_read;
+	/** position of the SOT marker of the tile-part following them */
+	OPJ_OFF_T plm_next_sot_pos;
+
 	/** tile coding parameters */
 	opj_tcp_t *tcps;
 
@@ -435,6 +496,10 @@ typedef struct opj_cp
 	/******** FLAGS *********/
 	/** if ppm == 1 --> there was a PPM marker*/
 	OPJ_UINT32 ppm : 1;
+	/** if tlm_ignored == 1 --> the TLM markers cannot be used to locate the tile-parts */
+	OPJ_UINT32 tlm_ignored : 1;
+	/** if plm_ignored == 1 --> the PLM markers cannot be used to skip packets */
+	OPJ_UINT32 plm_ignored : 1;
 	/** tells if the parameter is a coding or decoding one */
 	OPJ_UINT32 m_is_decoder : 1;
 /* <<UniPG */
@@ -451,6 +516,9 @@ typedef struct opj_j2k_dec
 	opj_tcp_t *m_default_tcp;
 	OPJ_BYTE  *m_header_data;
 	OPJ_UINT32 m_header_data_size;
+	/** decoded samples of the current tile, kept from one image to the next */
+	OPJ_BYTE  *m_tile_data;
+	OPJ_UINT32 m_tile_data_size;
 	/** to tell the tile part length */
 	OPJ_UINT32 m_sot_length;
 	/** Only tiles index in the correct range will be decoded.*/
@@ -470,6 +538,12 @@ typedef struct opj_j2k_dec
 	OPJ_INT32 m_tile_ind_to_dec;
 	/** Position of the last SOT marker read */
 	OPJ_OFF_T m_last_sot_read_pos;
+	/** index in the packet lengths of the current tile of the first packet of the current tile-part */
+	OPJ_UINT32 m_tp_first_packet_length;
+	/** index of the current tile-part in the PLM markers, -1 if unknown */
+	OPJ_INT32 m_plm_tile_part;
+	/** tile whose packet headers the tile coder has read so far while reading its data, -1 if none */
+	OPJ_INT32 m_scanned_tile_number;
 
 	/**
 	 * Indicate that the current tile-part is assume as the last tile part of the codestream.
@@ -477,6 +551,17 @@ typedef struct opj_j2k_dec
 	 * SOD reader function. FIXME NOT USED for the moment
 	 */
 	OPJ_BOOL   m_last_tile_part;
+	/**
+	 * Caller buffer the tiles are written to by opj_j2k_decode_into_buffer(),
+	 * NULL when they are written to the components of the output image
+	 */
+	OPJ_BYTE * m_dest_buffer;
+	/** number of bytes between two rows of m_dest_buffer */
+	OPJ_SIZE_T m_dest_stride;
+	/** pixel format of m_dest_buffer */
+	OPJ_PIXEL_FORMAT m_dest_format;
+	/** number of tiles that can be decoded at once within m_max_memory, 0 if not limited */
+	OPJ_UINT32 m_max_tiles_in_flight;
 	/** to tell that a tile can be decoded. */
 	OPJ_UINT32 m_can_decode			: 1;
 	OPJ_UINT32 m_discard_tiles		: 1;
@@ -568,6 +653,12 @@ typedef struct opj_j2k
 	/** the current tile coder/decoder **/
 	struct opj_tcd *	m_tcd;
 
+	/** thread pool used to process the code-blocks */
+	opj_thread_pool_t* m_tp;
+
+	/** kernels selected for the CPU */
+	opj_kernels_t m_kernels;
+
 }
 opj_j2k_t;
 
@@ -778,6 +869,27 @@ OPJ_BOOL opj_j2k_decode(opj_j2k_t *j2k,
                         opj_image_t *p_image,
                         opj_event_mgr_t *p_manager);
 
+/**
+ * Decode an image from a JPEG-2000 codestream into a buffer of interleaved
+ * pixels, see opj_decode_into_buffer().
+ *
+ * @param p_j2k     J2K decompressor handle
+ * @param p_stream  the stream to read the codestream from
+ * @param p_image   the image header read by opj_j2k_read_header()
+ * @param p_buffer  the buffer to fill
+ * @param p_stride  number of bytes between two rows of the buffer
+ * @param p_format  format of the pixels of the buffer
+ * @param p_manager the user event manager
+ * @return OPJ_TRUE if the image was decoded
+*/
+OPJ_BOOL opj_j2k_decode_into_buffer(opj_j2k_t *p_j2k,
+                                    opj_stream_private_t *p_stream,
+                                    opj_image_t *p_image,
+                                    OPJ_BYTE *p_buffer,
+                                    OPJ_SIZE_T p_stride,
+                                    OPJ_PIXEL_FORMAT p_format,
+                                    opj_event_mgr_t *p_manager);
+
 
 OPJ_BOOL opj_j2k_get_tile(	opj_j2k_t *p_j2k,
 			    			opj_stream_private_t *p_stream,
@@ -785,6 +897,28 @@ OPJ_BOOL opj_j2k_get_tile(	opj_j2k_t *p_j2k,
 					    	opj_event_mgr_t * p_manager,
 						    OPJ_UINT32 tile_index );
 
+/**
+ * Sets the number of threads used to decode/encode the code-blocks.
+ *
+ * @param p_j2k         the jpeg2000 codec.
+ * @param num_threads   number of threads (0 or 1 to process in the calling thread).
+ *
+ * @return OPJ_TRUE if the thread pool could be (re)created.
+ */
+OPJ_BOOL opj_j2k_set_threads(opj_j2k_t *p_j2k, OPJ_UINT32 num_threads);
+
+/**
+ * Resets a jpeg2000 decoder so that it can read the header of another codestream.
+ * The decoding parameters, the thread pool (with the T1 handles of its threads),
+ * the tile decoder and the header buffer are kept, everything read from the
+ * previous codestream is released.
+ *
+ * @param p_j2k         the jpeg2000 codec.
+ *
+ * @return OPJ_TRUE in case of success.
+ */
+OPJ_BOOL opj_j2k_decoder_reset(opj_j2k_t *p_j2k);
+
 OPJ_BOOL opj_j2k_set_decoded_resolution_factor(opj_j2k_t *p_j2k, 
                                                OPJ_UINT32 res_factor,
                                                opj_event_mgr_t * p_manager);
@@ -108,6 +108,11 @@ static OPJ_BOOL opj_jp2_read_cdef(	opj_jp2_t * jp2,
 
 static void opj_jp2_apply_cdef(opj_image_t *image, opj_jp2_color_t *color);
 
+/**
+Sets the color space of a decoded image from the enumerated colour space of the colr box
+*/
+static void opj_jp2_set_color_space(opj_jp2_t *jp2, opj_image_t *p_image);
+
 /**
  * Writes the Channel Definition box.
  *
@@ -1394,6 +1399,20 @@ OPJ_BOOL opj_jp2_read_colr( opj_jp2_t *jp2,
     return OPJ_TRUE;
 }
 
+static void opj_jp2_set_color_space(opj_jp2_t *jp2, opj_image_t* p_image)
+{
+	if (jp2->enumcs == 16)
+		p_image->color_space = OPJ_CLRSPC_SRGB;
+	else if (jp2->enumcs == 17)
+		p_image->color_space = OPJ_CLRSPC_GRAY;
+	else if (jp2->enumcs == 18)
+		p_image->color_space = OPJ_CLRSPC_SYCC;
+	else if (jp2->enumcs == 24)
+		p_image->color_space = OPJ_CLRSPC_EYCC;
+	else
+		p_image->color_space = OPJ_CLRSPC_UNKNOWN;
+}
+
 OPJ_BOOL opj_jp2_decode(opj_jp2_t *jp2,
                         opj_stream_private_t *p_stream,
                         opj_image_t* p_image,
@@ -1414,16 +1433,7 @@ OPJ_BOOL opj_jp2_decode(opj_jp2_t *jp2,
 	    }
 
 	    /* Set Image Color Space */
-	    if (jp2->enumcs == 16)
-		    p_image->color_space = OPJ_CLRSPC_SRGB;
-	    else if (jp2->enumcs == 17)
-		    p_image->color_space = OPJ_CLRSPC_GRAY;
-	    else if (jp2->enumcs == 18)
-		    p_image->color_space = OPJ_CLRSPC_SYCC;
-            else if (jp2->enumcs == 24)
-                    p_image->color_space = OPJ_CLRSPC_EYCC;
-	    else
-		    p_image->color_space = OPJ_CLRSPC_UNKNOWN;
+	    opj_jp2_set_color_space(jp2, p_image);
 
 	    if(jp2->color.jp2_pclr) {
 		    /* Part 1, I.5.3.4: Either both or none : */
@@ -1448,6 +1458,42 @@ OPJ_BOOL opj_jp2_decode(opj_jp2_t *jp2,
 	return OPJ_TRUE;
 }
 
+OPJ_BOOL opj_jp2_decode_into_buffer(opj_jp2_t *jp2,
+                                    opj_stream_private_t *p_stream,
+                                    opj_image_t* p_image,
+                                    OPJ_BYTE *p_buffer,
+                                    OPJ_SIZE_T p_stride,
+                                    OPJ_PIXEL_FORMAT p_format,
+                                    opj_event_mgr_t * p_manager)
+{
+	if (!p_image)
+		return OPJ_FALSE;
+
+	/* a palette changes the number of components, it cannot be applied to the pixels */
+	if (!jp2->ignore_pclr_cmap_cdef && jp2->color.jp2_pclr) {
+		opj_event_msg(p_manager, EVT_ERROR, "Images with a palette cannot be decoded into a buffer\n");
+		return OPJ_FALSE;
+	}
+
+	/* J2K decoding */
+	if( ! opj_j2k_decode_into_buffer(jp2->j2k, p_stream, p_image, p_buffer, p_stride, p_format, p_manager) ) {
+		opj_event_msg(p_manager, EVT_ERROR, "Failed to decode the codestream in the JP2 file\n");
+		return OPJ_FALSE;
+	}
+
+	if (!jp2->ignore_pclr_cmap_cdef) {
+		opj_jp2_set_color_space(jp2, p_image);
+
+		if(jp2->color.icc_profile_buf) {
+			p_image->icc_profile_buf = jp2->color.icc_profile_buf;
+			p_image->icc_profile_len = jp2->color.icc_profile_len;
+			jp2->color.icc_profile_buf = NULL;
+		}
+	}
+
+	return OPJ_TRUE;
+}
+
 OPJ_BOOL opj_jp2_write_jp2h(opj_jp2_t *jp2,
                             opj_stream_private_t *stream,
                             opj_event_mgr_t * p_manager
@@ -2613,59 +2659,67 @@ OPJ_BOOL opj_jp2_decode_tile (  opj_jp2_t * p_jp2,
 	return opj_j2k_decode_tile (p_jp2->j2k,p_tile_index,p_data,p_data_size,p_stream,p_manager);
 }
 
-void opj_jp2_destroy(opj_jp2_t *jp2)
+/**
+ * Frees the boxes read from a JP2 file.
+ */
+static void opj_jp2_free_boxes(opj_jp2_t *jp2)
 {
-	if (jp2) {
-		/* destroy the J2K codec */
-		opj_j2k_destroy(jp2->j2k);
-		jp2->j2k = 00;
+	if (jp2->comps) {
+		opj_free(jp2->comps);
+		jp2->comps = 00;
+	}
 
-		if (jp2->comps) {
-			opj_free(jp2->comps);
-			jp2->comps = 00;
-		}
+	if (jp2->cl) {
+		opj_free(jp2->cl);
+		jp2->cl = 00;
+	}
 
-		if (jp2->cl) {
-			opj_free(jp2->cl);
-			jp2->cl = 00;
-		}
+	if (jp2->color.icc_profile_buf) {
+		opj_free(jp2->color.icc_profile_buf);
+		jp2->color.icc_profile_buf = 00;
+	}
 
-		if (jp2->color.icc_profile_buf) {
-			opj_free(jp2->color.icc_profile_buf);
-			jp2->color.icc_profile_buf = 00;
+	if (jp2->color.jp2_cdef) {
+		if (jp2->color.jp2_cdef->info) {
+			opj_free(jp2->color.jp2_cdef->info);
+			jp2->color.jp2_cdef->info = NULL;
 		}
 
-		if (jp2->color.jp2_cdef) {
-			if (jp2->color.jp2_cdef->info) {
-				opj_free(jp2->color.jp2_cdef->info);
-				jp2->color.jp2_cdef->info = NULL;
-			}
+		opj_free(jp2->color.jp2_cdef);
+		jp2->color.jp2_cdef = 00;
+	}
 
-			opj_free(jp2->color.jp2_cdef);
-			jp2->color.jp2_cdef = 00;
+	if (jp2->color.jp2_pclr) {
+		if (jp2->color.jp2_pclr->cmap) {
+			opj_free(jp2->color.jp2_pclr->cmap);
+			jp2->color.jp2_pclr->cmap = NULL;
+		}
+		if (jp2->color.jp2_pclr->channel_sign) {
+			opj_free(jp2->color.jp2_pclr->channel_sign);
+			jp2->color.jp2_pclr->channel_sign = NULL;
+		}
+		if (jp2->color.jp2_pclr->channel_size) {
+			opj_free(jp2->color.jp2_pclr->channel_size);
+			jp2->color.jp2_pclr->channel_size = NULL;
+		}
+		if (jp2->color.jp2_pclr->entries) {
+			opj_free(jp2->color.jp2_pclr->entries);
+			jp2->color.jp2_pclr->entries = NULL;
 		}
 
-		if (jp2->color.jp2_pclr) {
-			if (jp2->color.jp2_pclr->cmap) {
-				opj_free(jp2->color.jp2_pclr->cmap);
-				jp2->color.jp2_pclr->cmap = NULL;
-			}
-			if (jp2->color.jp2_pclr->channel_sign) {
-				opj_free(jp2->color.jp2_pclr->channel_sign);
-				jp2->color.jp2_pclr->channel_sign = NULL;
-			}
-			if (jp2->color.jp2_pclr->channel_size) {
-				opj_free(jp2->color.jp2_pclr->channel_size);
-				jp2->color.jp2_pclr->channel_size = NULL;
-			}
-			if (jp2->color.jp2_pclr->entries) {
-				opj_free(jp2->color.jp2_pclr->entries);
-				jp2->color.jp2_pclr->entries = NULL;
-			}
+		opj_free(jp2->color.jp2_pclr);
+		jp2->color.jp2_pclr = 00;
+	}
+}
 
-			opj_free(jp2->color.jp2_pclr);
-			jp2->color.jp2_pclr = 00;
-		}
+void opj_jp2_destroy(opj_jp2_t *jp2)
+{
+	if (jp2) {
+		/* destroy the J2K codec */
+		opj_j2k_destroy(jp2->j2k);
+		jp2->j2k = 00;
+
+		opj_jp2_free_boxes(jp2);
 
 		if (jp2->m_validation_list) {
 			opj_procedure_list_destroy(jp2->m_validation_list);
@@ -2818,6 +2872,44 @@ OPJ_BOOL opj_jp2_set_decoded_resolution_factor(opj_jp2_t *p_jp2,
 	return opj_j2k_set_decoded_resolution_factor(p_jp2->j2k, res_factor, p_manager);
 }
 
+OPJ_BOOL opj_jp2_decoder_reset(opj_jp2_t *p_jp2)
+{
+	if (! opj_j2k_decoder_reset(p_jp2->j2k)) {
+		return OPJ_FALSE;
+	}
+
+	opj_jp2_free_boxes(p_jp2);
+	p_jp2->w = 0;
+	p_jp2->h = 0;
+	p_jp2->numcomps = 0;
+	p_jp2->bpc = 0;
+	p_jp2->C = 0;
+	p_jp2->UnkC = 0;
+	p_jp2->IPR = 0;
+	p_jp2->meth = 0;
+	p_jp2->approx = 0;
+	p_jp2->enumcs = 0;
+	p_jp2->precedence = 0;
+	p_jp2->brand = 0;
+	p_jp2->minversion = 0;
+	p_jp2->numcl = 0;
+	p_jp2->j2k_codestream_offset = 0;
+	p_jp2->jp2_state = JP2_STATE_NONE;
+	p_jp2->jp2_img_state = JP2_IMG_STATE_NONE;
+	p_jp2->color.icc_profile_len = 0;
+	p_jp2->color.jp2_has_colr = 0;
+
+	opj_procedure_list_clear(p_jp2->m_procedure_list);
+	opj_procedure_list_clear(p_jp2->m_validation_list);
+
+	return OPJ_TRUE;
+}
+
+OPJ_BOOL opj_jp2_set_threads(opj_jp2_t *p_jp2, OPJ_UINT32 num_threads)
+{
+	return opj_j2k_set_threads(p_jp2->j2k, num_threads);
+}
+
 /* JPIP specific */
 
 #ifdef USE_JPIP
@@ -270,6 +270,28 @@ OPJ_BOOL opj_jp2_decode(opj_jp2_t *jp2,
             opj_image_t* p_image,
             opj_event_mgr_t * p_manager);
 
+/**
+ * Decode an image from a JPEG-2000 file stream into a buffer of interleaved
+ * pixels, see opj_decode_into_buffer(). Palettes are not supported and
+ * channel definitions are not applied.
+ * @param jp2 JP2 decompressor handle
+ * @param p_stream  the stream to read the file from
+ * @param p_image   the image header read by opj_jp2_read_header()
+ * @param p_buffer  the buffer to fill
+ * @param p_stride  number of bytes between two rows of the buffer
+ * @param p_format  format of the pixels of the buffer
+ * @param p_manager the user event manager
+ *
+ * @return OPJ_TRUE if the image was decoded
+*/
+OPJ_BOOL opj_jp2_decode_into_buffer(opj_jp2_t *jp2,
+                                    opj_stream_private_t *p_stream,
+                                    opj_image_t* p_image,
+                                    OPJ_BYTE *p_buffer,
+                                    OPJ_SIZE_T p_stride,
+                                    OPJ_PIXEL_FORMAT p_format,
+                                    opj_event_mgr_t * p_manager);
+
 /**
  * Setup the encoder parameters using the current image and using user parameters. 
  * Coding parameters are returned in jp2->j2k->cp. 
@@ -450,6 +472,26 @@ OPJ_BOOL opj_jp2_get_tile(  opj_jp2_t *p_jp2,
                             OPJ_UINT32 tile_index );
 
 
+/**
+ * Sets the number of threads used to decode/encode the code-blocks.
+ *
+ * @param p_jp2         the jpeg2000 codec.
+ * @param num_threads   number of threads.
+ *
+ * @return OPJ_TRUE if the thread pool could be (re)created.
+ */
+OPJ_BOOL opj_jp2_set_threads(opj_jp2_t *p_jp2, OPJ_UINT32 num_threads);
+
+/**
+ * Resets a JP2 decoder so that it can read another file, keeping the
+ * decoding parameters and the scratch memory of its J2K codec.
+ *
+ * @param p_jp2         the jpeg2000 file codec.
+ *
+ * @return OPJ_TRUE in case of success.
+ */
+OPJ_BOOL opj_jp2_decoder_reset(opj_jp2_t *p_jp2);
+
 /**
  * 
  */
@@ -37,16 +37,6 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
-#ifdef __SSE__
-#include <xmmintrin.h>
-#endif
-#ifdef __SSE2__
-#include <emmintrin.h>
-#endif
-#ifdef __SSE4_1__
-#include <smmintrin.h>
-#endif
-
 #include "opj_includes.h"
 
 /* <summary> */
@@ -72,7 +62,6 @@ const OPJ_FLOAT64 * opj_mct_get_mct_norms_real ()
 /* <summary> */
 /* Foward reversible MCT. */
 /* </summary> */
-#ifdef __SSE2__
 void opj_mct_encode(
 		OPJ_INT32* restrict c0,
 		OPJ_INT32* restrict c1,
@@ -82,23 +71,7 @@ void opj_mct_encode(
 	OPJ_SIZE_T i;
 	const OPJ_SIZE_T len = n;
 	
-	for(i = 0; i < (len & ~3U); i += 4) {
-		__m128i y, u, v;
-		__m128i r = _mm_load_si128((const __m128i *)&(c0[i]));
-		__m128i g = _mm_load_si128((const __m128i *)&(c1[i]));
-		__m128i b = _mm_load_si128((const __m128i *)&(c2[i]));
-		y = _mm_add_epi32(g, g);
-		y = _mm_add_epi32(y, b);
-		y = _mm_add_epi32(y, r);
-		y = _mm_srai_epi32(y, 2);
-		u = _mm_sub_epi32(b, g);
-		v = _mm_sub_epi32(r, g);
-		_mm_store_si128((__m128i *)&(c0[i]), y);
-		_mm_store_si128((__m128i *)&(c1[i]), u);
-		_mm_store_si128((__m128i *)&(c2[i]), v);
-	}
-	
-	for(; i < len; ++i) {
+	for(i = 0; i < len; ++i) {
 		OPJ_INT32 r = c0[i];
 		OPJ_INT32 g = c1[i];
 		OPJ_INT32 b = c2[i];
@@ -110,8 +83,10 @@ void opj_mct_encode(
 		c2[i] = v;
 	}
 }
-#else
-void opj_mct_encode(
+
+#ifdef OPJ_HAVE_X86_KERNELS
+OPJ_TARGET_SSE2
+static void opj_mct_encode_sse2(
 		OPJ_INT32* restrict c0,
 		OPJ_INT32* restrict c1,
 		OPJ_INT32* restrict c2,
@@ -120,7 +95,23 @@ void opj_mct_encode(
 	OPJ_SIZE_T i;
 	const OPJ_SIZE_T len = n;
 	
-	for(i = 0; i < len; ++i) {
+	for(i = 0; i < (len & ~3U); i += 4) {
+		__m128i y, u, v;
+		__m128i r = _mm_load_si128((const __m128i *)&(c0[i]));
+		__m128i g = _mm_load_si128((const __m128i *)&(c1[i]));
+		__m128i b = _mm_load_si128((const __m128i *)&(c2[i]));
+		y = _mm_add_epi32(g, g);
+		y = _mm_add_epi32(y, b);
+		y = _mm_add_epi32(y, r);
+		y = _mm_srai_epi32(y, 2);
+		u = _mm_sub_epi32(b, g);
+		v = _mm_sub_epi32(r, g);
+		_mm_store_si128((__m128i *)&(c0[i]), y);
+		_mm_store_si128((__m128i *)&(c1[i]), u);
+		_mm_store_si128((__m128i *)&(c2[i]), v);
+	}
+	
+	for(; i < len; ++i) {
 		OPJ_INT32 r = c0[i];
 		OPJ_INT32 g = c1[i];
 		OPJ_INT32 b = c2[i];
@@ -137,8 +128,29 @@ void opj_mct_encode(
 /* <summary> */
 /* Inverse reversible MCT. */
 /* </summary> */
-#ifdef __SSE2__
 void opj_mct_decode(
+		OPJ_INT32* restrict c0,
+		OPJ_INT32* restrict c1, 
+		OPJ_INT32* restrict c2, 
+		OPJ_UINT32 n)
+{
+	OPJ_UINT32 i;
+	for (i = 0; i < n; ++i) {
+		OPJ_INT32 y = c0[i];
+		OPJ_INT32 u = c1[i];
+		OPJ_INT32 v = c2[i];
+		OPJ_INT32 g = y - ((u + v) >> 2);
+		OPJ_INT32 r = v + g;
+		OPJ_INT32 b = u + g;
+		c0[i] = r;
+		c1[i] = g;
+		c2[i] = b;
+	}
+}
+
+#ifdef OPJ_HAVE_X86_KERNELS
+OPJ_TARGET_SSE2
+static void opj_mct_decode_sse2(
 		OPJ_INT32* restrict c0,
 		OPJ_INT32* restrict c1,
 		OPJ_INT32* restrict c2,
@@ -172,15 +184,31 @@ void opj_mct_decode(
 		c2[i] = b;
 	}
 }
-#else
-void opj_mct_decode(
+
+OPJ_TARGET_AVX2
+static void opj_mct_decode_avx2(
 		OPJ_INT32* restrict c0,
-		OPJ_INT32* restrict c1, 
-		OPJ_INT32* restrict c2, 
+		OPJ_INT32* restrict c1,
+		OPJ_INT32* restrict c2,
 		OPJ_UINT32 n)
 {
-	OPJ_UINT32 i;
-	for (i = 0; i < n; ++i) {
+	OPJ_SIZE_T i;
+	const OPJ_SIZE_T len = n;
+	
+	for(i = 0; i < (len & ~7U); i += 8) {
+		__m256i r, g, b;
+		__m256i y = _mm256_loadu_si256((const __m256i *)&(c0[i]));
+		__m256i u = _mm256_loadu_si256((const __m256i *)&(c1[i]));
+		__m256i v = _mm256_loadu_si256((const __m256i *)&(c2[i]));
+		g = y;
+		g = _mm256_sub_epi32(g, _mm256_srai_epi32(_mm256_add_epi32(u, v), 2));
+		r = _mm256_add_epi32(v, g);
+		b = _mm256_add_epi32(u, g);
+		_mm256_storeu_si256((__m256i *)&(c0[i]), r);
+		_mm256_storeu_si256((__m256i *)&(c1[i]), g);
+		_mm256_storeu_si256((__m256i *)&(c2[i]), b);
+	}
+	for (; i < len; ++i) {
 		OPJ_INT32 y = c0[i];
 		OPJ_INT32 u = c1[i];
 		OPJ_INT32 v = c2[i];
@@ -204,8 +232,29 @@ OPJ_FLOAT64 opj_mct_getnorm(OPJ_UINT32 compno) {
 /* <summary> */
 /* Foward irreversible MCT. */
 /* </summary> */
-#ifdef __SSE4_1__
 void opj_mct_encode_real(
+		OPJ_INT32* restrict c0,
+		OPJ_INT32* restrict c1,
+		OPJ_INT32* restrict c2,
+		OPJ_UINT32 n)
+{
+	OPJ_UINT32 i;
+	for(i = 0; i < n; ++i) {
+		OPJ_INT32 r = c0[i];
+		OPJ_INT32 g = c1[i];
+		OPJ_INT32 b = c2[i];
+		OPJ_INT32 y =  opj_int_fix_mul(r, 2449) + opj_int_fix_mul(g, 4809) + opj_int_fix_mul(b, 934);
+		OPJ_INT32 u = -opj_int_fix_mul(r, 1382) - opj_int_fix_mul(g, 2714) + opj_int_fix_mul(b, 4096);
+		OPJ_INT32 v =  opj_int_fix_mul(r, 4096) - opj_int_fix_mul(g, 3430) - opj_int_fix_mul(b, 666);
+		c0[i] = y;
+		c1[i] = u;
+		c2[i] = v;
+	}
+}
+
+#ifdef OPJ_HAVE_X86_KERNELS
+OPJ_TARGET_SSE41
+static void opj_mct_encode_real_sse41(
 												 OPJ_INT32* restrict c0,
 												 OPJ_INT32* restrict c1,
 												 OPJ_INT32* restrict c2,
@@ -345,39 +394,40 @@ void opj_mct_encode_real(
 		c2[i] = v;
 	}
 }
-#else
-void opj_mct_encode_real(
-		OPJ_INT32* restrict c0,
-		OPJ_INT32* restrict c1,
-		OPJ_INT32* restrict c2,
+#endif
+
+/* <summary> */
+/* Inverse irreversible MCT. */
+/* </summary> */
+void opj_mct_decode_real(
+		OPJ_FLOAT32* restrict c0,
+		OPJ_FLOAT32* restrict c1,
+		OPJ_FLOAT32* restrict c2,
 		OPJ_UINT32 n)
 {
 	OPJ_UINT32 i;
 	for(i = 0; i < n; ++i) {
-		OPJ_INT32 r = c0[i];
-		OPJ_INT32 g = c1[i];
-		OPJ_INT32 b = c2[i];
-		OPJ_INT32 y =  opj_int_fix_mul(r, 2449) + opj_int_fix_mul(g, 4809) + opj_int_fix_mul(b, 934);
-		OPJ_INT32 u = -opj_int_fix_mul(r, 1382) - opj_int_fix_mul(g, 2714) + opj_int_fix_mul(b, 4096);
-		OPJ_INT32 v =  opj_int_fix_mul(r, 4096) - opj_int_fix_mul(g, 3430) - opj_int_fix_mul(b, 666);
-		c0[i] = y;
-		c1[i] = u;
-		c2[i] = v;
+		OPJ_FLOAT32 y = c0[i];
+		OPJ_FLOAT32 u = c1[i];
+		OPJ_FLOAT32 v = c2[i];
+		OPJ_FLOAT32 r = y + (v * 1.402f);
+		OPJ_FLOAT32 g = y - (u * 0.34413f) - (v * (0.71414f));
+		OPJ_FLOAT32 b = y + (u * 1.772f);
+		c0[i] = r;
+		c1[i] = g;
+		c2[i] = b;
 	}
 }
-#endif
 
-/* <summary> */
-/* Inverse irreversible MCT. */
-/* </summary> */
-void opj_mct_decode_real(
+#ifdef OPJ_HAVE_X86_KERNELS
+OPJ_TARGET_SSE2
+static void opj_mct_decode_real_sse(
 		OPJ_FLOAT32* restrict c0,
 		OPJ_FLOAT32* restrict c1,
 		OPJ_FLOAT32* restrict c2,
 		OPJ_UINT32 n)
 {
 	OPJ_UINT32 i;
-#ifdef __SSE__
 	__m128 vrv, vgu, vgv, vbu;
 	vrv = _mm_set1_ps(1.402f);
 	vgu = _mm_set1_ps(0.34413f);
@@ -413,19 +463,360 @@ void opj_mct_decode_real(
 		c1 += 4;
 		c2 += 4;
 	}
-	n &= 7;
+	opj_mct_decode_real(c0, c1, c2, n & 7);
+}
+
+/* the multiplications and additions are not fused (the target does not */
+/* include FMA), so that the results are the same as the other kernels */
+OPJ_TARGET_AVX2
+static void opj_mct_decode_real_avx2(
+		OPJ_FLOAT32* restrict c0,
+		OPJ_FLOAT32* restrict c1,
+		OPJ_FLOAT32* restrict c2,
+		OPJ_UINT32 n)
+{
+	OPJ_UINT32 i;
+	const __m256 vrv = _mm256_set1_ps(1.402f);
+	const __m256 vgu = _mm256_set1_ps(0.34413f);
+	const __m256 vgv = _mm256_set1_ps(0.71414f);
+	const __m256 vbu = _mm256_set1_ps(1.772f);
+	for (i = 0; i < (n >> 3); ++i) {
+		__m256 vy, vu, vv;
+		__m256 vr, vg, vb;
+
+		vy = _mm256_loadu_ps(c0);
+		vu = _mm256_loadu_ps(c1);
+		vv = _mm256_loadu_ps(c2);
+		vr = _mm256_add_ps(vy, _mm256_mul_ps(vv, vrv));
+		vg = _mm256_sub_ps(_mm256_sub_ps(vy, _mm256_mul_ps(vu, vgu)), _mm256_mul_ps(vv, vgv));
+		vb = _mm256_add_ps(vy, _mm256_mul_ps(vu, vbu));
+		_mm256_storeu_ps(c0, vr);
+		_mm256_storeu_ps(c1, vg);
+		_mm256_storeu_ps(c2, vb);
+		c0 += 8;
+		c1 += 8;
+		c2 += 8;
+	}
+	opj_mct_decode_real(c0, c1, c2, n & 7);
+}
 #endif
-	for(i = 0; i < n; ++i) {
-		OPJ_FLOAT32 y = c0[i];
-		OPJ_FLOAT32 u = c1[i];
-		OPJ_FLOAT32 v = c2[i];
+
+/* <summary> */
+/* Inverse reversible MCT, DC level shift and clamp, in one pass. */
+/* </summary> */
+void opj_mct_decode_shift(
+		OPJ_INT32* restrict c0,
+		OPJ_INT32* restrict c1,
+		OPJ_INT32* restrict c2,
+		OPJ_UINT32 n,
+		const OPJ_INT32* p_shift,
+		const OPJ_INT32* p_min,
+		const OPJ_INT32* p_max)
+{
+	OPJ_UINT32 i;
+	for (i = 0; i < n; ++i) {
+		OPJ_INT32 y = c0[i];
+		OPJ_INT32 u = c1[i];
+		OPJ_INT32 v = c2[i];
+		OPJ_INT32 g = y - ((u + v) >> 2);
+		OPJ_INT32 r = v + g;
+		OPJ_INT32 b = u + g;
+		c0[i] = opj_int_clamp(r + p_shift[0], p_min[0], p_max[0]);
+		c1[i] = opj_int_clamp(g + p_shift[1], p_min[1], p_max[1]);
+		c2[i] = opj_int_clamp(b + p_shift[2], p_min[2], p_max[2]);
+	}
+}
+
+/* <summary> */
+/* Inverse irreversible MCT, rounding, DC level shift and clamp, in one pass. */
+/* </summary> */
+void opj_mct_decode_real_shift(
+		OPJ_INT32* restrict c0,
+		OPJ_INT32* restrict c1,
+		OPJ_INT32* restrict c2,
+		OPJ_UINT32 n,
+		const OPJ_INT32* p_shift,
+		const OPJ_INT32* p_min,
+		const OPJ_INT32* p_max)
+{
+	OPJ_UINT32 i;
+	for (i = 0; i < n; ++i) {
+		OPJ_FLOAT32 y = ((OPJ_FLOAT32*)c0)[i];
+		OPJ_FLOAT32 u = ((OPJ_FLOAT32*)c1)[i];
+		OPJ_FLOAT32 v = ((OPJ_FLOAT32*)c2)[i];
 		OPJ_FLOAT32 r = y + (v * 1.402f);
 		OPJ_FLOAT32 g = y - (u * 0.34413f) - (v * (0.71414f));
 		OPJ_FLOAT32 b = y + (u * 1.772f);
-		c0[i] = r;
-		c1[i] = g;
-		c2[i] = b;
+		c0[i] = opj_int_clamp((OPJ_INT32)lrintf(r) + p_shift[0], p_min[0], p_max[0]);
+		c1[i] = opj_int_clamp((OPJ_INT32)lrintf(g) + p_shift[1], p_min[1], p_max[1]);
+		c2[i] = opj_int_clamp((OPJ_INT32)lrintf(b) + p_shift[2], p_min[2], p_max[2]);
+	}
+}
+
+/* <summary> */
+/* DC level shift and clamp of a component without MCT. */
+/* </summary> */
+void opj_mct_dc_shift(OPJ_INT32* restrict c, OPJ_UINT32 n, OPJ_INT32 p_shift, OPJ_INT32 p_min, OPJ_INT32 p_max)
+{
+	OPJ_UINT32 i;
+	for (i = 0; i < n; ++i) {
+		c[i] = opj_int_clamp(c[i] + p_shift, p_min, p_max);
+	}
+}
+
+/* <summary> */
+/* Rounding, DC level shift and clamp of an irreversible component without MCT. */
+/* </summary> */
+void opj_mct_dc_shift_real(OPJ_INT32* restrict c, OPJ_UINT32 n, OPJ_INT32 p_shift, OPJ_INT32 p_min, OPJ_INT32 p_max)
+{
+	OPJ_UINT32 i;
+	for (i = 0; i < n; ++i) {
+		OPJ_FLOAT32 l_value = ((OPJ_FLOAT32*)c)[i];
+		c[i] = opj_int_clamp((OPJ_INT32)lrintf(l_value) + p_shift, p_min, p_max);
+	}
+}
+
+#ifdef OPJ_HAVE_X86_KERNELS
+/* SSE2 has no 32 bits min and max: clamp with comparisons. The conversions */
+/* of the irreversible kernels round to nearest even as lrintf(). */
+OPJ_TARGET_SSE2
+static INLINE __m128i opj_mct_clamp_sse2(__m128i v, __m128i vmin, __m128i vmax)
+{
+	__m128i m = _mm_cmpgt_epi32(v, vmax);
+	v = _mm_or_si128(_mm_and_si128(m, vmax), _mm_andnot_si128(m, v));
+	m = _mm_cmplt_epi32(v, vmin);
+	return _mm_or_si128(_mm_and_si128(m, vmin), _mm_andnot_si128(m, v));
+}
+
+OPJ_TARGET_SSE2
+static void opj_mct_decode_shift_sse2(
+		OPJ_INT32* restrict c0,
+		OPJ_INT32* restrict c1,
+		OPJ_INT32* restrict c2,
+		OPJ_UINT32 n,
+		const OPJ_INT32* p_shift,
+		const OPJ_INT32* p_min,
+		const OPJ_INT32* p_max)
+{
+	OPJ_UINT32 i;
+	const __m128i s0 = _mm_set1_epi32(p_shift[0]), s1 = _mm_set1_epi32(p_shift[1]), s2 = _mm_set1_epi32(p_shift[2]);
+	const __m128i min0 = _mm_set1_epi32(p_min[0]), min1 = _mm_set1_epi32(p_min[1]), min2 = _mm_set1_epi32(p_min[2]);
+	const __m128i max0 = _mm_set1_epi32(p_max[0]), max1 = _mm_set1_epi32(p_max[1]), max2 = _mm_set1_epi32(p_max[2]);
+
+	for (i = 0; i < (n & ~3U); i += 4) {
+		__m128i r, g, b;
+		__m128i y = _mm_loadu_si128((const __m128i *)&(c0[i]));
+		__m128i u = _mm_loadu_si128((const __m128i *)&(c1[i]));
+		__m128i v = _mm_loadu_si128((const __m128i *)&(c2[i]));
+		g = _mm_sub_epi32(y, _mm_srai_epi32(_mm_add_epi32(u, v), 2));
+		r = _mm_add_epi32(v, g);
+		b = _mm_add_epi32(u, g);
+		_mm_storeu_si128((__m128i *)&(c0[i]), opj_mct_clamp_sse2(_mm_add_epi32(r, s0), min0, max0));
+		_mm_storeu_si128((__m128i *)&(c1[i]), opj_mct_clamp_sse2(_mm_add_epi32(g, s1), min1, max1));
+		_mm_storeu_si128((__m128i *)&(c2[i]), opj_mct_clamp_sse2(_mm_add_epi32(b, s2), min2, max2));
+	}
+	opj_mct_decode_shift(c0 + i, c1 + i, c2 + i, n - i, p_shift, p_min, p_max);
+}
+
+OPJ_TARGET_SSE2
+static void opj_mct_decode_real_shift_sse2(
+		OPJ_INT32* restrict c0,
+		OPJ_INT32* restrict c1,
+		OPJ_INT32* restrict c2,
+		OPJ_UINT32 n,
+		const OPJ_INT32* p_shift,
+		const OPJ_INT32* p_min,
+		const OPJ_INT32* p_max)
+{
+	OPJ_UINT32 i;
+	const __m128 vrv = _mm_set1_ps(1.402f);
+	const __m128 vgu = _mm_set1_ps(0.34413f);
+	const __m128 vgv = _mm_set1_ps(0.71414f);
+	const __m128 vbu = _mm_set1_ps(1.772f);
+	const __m128i s0 = _mm_set1_epi32(p_shift[0]), s1 = _mm_set1_epi32(p_shift[1]), s2 = _mm_set1_epi32(p_shift[2]);
+	const __m128i min0 = _mm_set1_epi32(p_min[0]), min1 = _mm_set1_epi32(p_min[1]), min2 = _mm_set1_epi32(p_min[2]);
+	const __m128i max0 = _mm_set1_epi32(p_max[0]), max1 = _mm_set1_epi32(p_max[1]), max2 = _mm_set1_epi32(p_max[2]);
+
+	for (i = 0; i < (n & ~3U); i += 4) {
+		__m128 vr, vg, vb;
+		__m128 vy = _mm_loadu_ps((const OPJ_FLOAT32*)&(c0[i]));
+		__m128 vu = _mm_loadu_ps((const OPJ_FLOAT32*)&(c1[i]));
+		__m128 vv = _mm_loadu_ps((const OPJ_FLOAT32*)&(c2[i]));
+		vr = _mm_add_ps(vy, _mm_mul_ps(vv, vrv));
+		vg = _mm_sub_ps(_mm_sub_ps(vy, _mm_mul_ps(vu, vgu)), _mm_mul_ps(vv, vgv));
+		vb = _mm_add_ps(vy, _mm_mul_ps(vu, vbu));
+		_mm_storeu_si128((__m128i *)&(c0[i]), opj_mct_clamp_sse2(_mm_add_epi32(_mm_cvtps_epi32(vr), s0), min0, max0));
+		_mm_storeu_si128((__m128i *)&(c1[i]), opj_mct_clamp_sse2(_mm_add_epi32(_mm_cvtps_epi32(vg), s1), min1, max1));
+		_mm_storeu_si128((__m128i *)&(c2[i]), opj_mct_clamp_sse2(_mm_add_epi32(_mm_cvtps_epi32(vb), s2), min2, max2));
 	}
+	opj_mct_decode_real_shift(c0 + i, c1 + i, c2 + i, n - i, p_shift, p_min, p_max);
+}
+
+OPJ_TARGET_SSE2
+static void opj_mct_dc_shift_sse2(OPJ_INT32* restrict c, OPJ_UINT32 n, OPJ_INT32 p_shift, OPJ_INT32 p_min, OPJ_INT32 p_max)
+{
+	OPJ_UINT32 i;
+	const __m128i s = _mm_set1_epi32(p_shift);
+	const __m128i vmin = _mm_set1_epi32(p_min);
+	const __m128i vmax = _mm_set1_epi32(p_max);
+
+	for (i = 0; i < (n & ~3U); i += 4) {
+		__m128i v = _mm_add_epi32(_mm_loadu_si128((const __m128i *)&(c[i])), s);
+		_mm_storeu_si128((__m128i *)&(c[i]), opj_mct_clamp_sse2(v, vmin, vmax));
+	}
+	opj_mct_dc_shift(c + i, n - i, p_shift, p_min, p_max);
+}
+
+OPJ_TARGET_SSE2
+static void opj_mct_dc_shift_real_sse2(OPJ_INT32* restrict c, OPJ_UINT32 n, OPJ_INT32 p_shift, OPJ_INT32 p_min, OPJ_INT32 p_max)
+{
+	OPJ_UINT32 i;
+	const __m128i s = _mm_set1_epi32(p_shift);
+	const __m128i vmin = _mm_set1_epi32(p_min);
+	const __m128i vmax = _mm_set1_epi32(p_max);
+
+	for (i = 0; i < (n & ~3U); i += 4) {
+		__m128i v = _mm_cvtps_epi32(_mm_loadu_ps((const OPJ_FLOAT32*)&(c[i])));
+		_mm_storeu_si128((__m128i *)&(c[i]), opj_mct_clamp_sse2(_mm_add_epi32(v, s), vmin, vmax));
+	}
+	opj_mct_dc_shift_real(c + i, n - i, p_shift, p_min, p_max);
+}
+
+OPJ_TARGET_AVX2
+static void opj_mct_decode_shift_avx2(
+		OPJ_INT32* restrict c0,
+		OPJ_INT32* restrict c1,
+		OPJ_INT32* restrict c2,
+		OPJ_UINT32 n,
+		const OPJ_INT32* p_shift,
+		const OPJ_INT32* p_min,
+		const OPJ_INT32* p_max)
+{
+	OPJ_UINT32 i;
+	const __m256i s0 = _mm256_set1_epi32(p_shift[0]), s1 = _mm256_set1_epi32(p_shift[1]), s2 = _mm256_set1_epi32(p_shift[2]);
+	const __m256i min0 = _mm256_set1_epi32(p_min[0]), min1 = _mm256_set1_epi32(p_min[1]), min2 = _mm256_set1_epi32(p_min[2]);
+	const __m256i max0 = _mm256_set1_epi32(p_max[0]), max1 = _mm256_set1_epi32(p_max[1]), max2 = _mm256_set1_epi32(p_max[2]);
+
+	for (i = 0; i < (n & ~7U); i += 8) {
+		__m256i r, g, b;
+		__m256i y = _mm256_loadu_si256((const __m256i *)&(c0[i]));
+		__m256i u = _mm256_loadu_si256((const __m256i *)&(c1[i]));
+		__m256i v = _mm256_loadu_si256((const __m256i *)&(c2[i]));
+		g = _mm256_sub_epi32(y, _mm256_srai_epi32(_mm256_add_epi32(u, v), 2));
+		r = _mm256_add_epi32(v, g);
+		b = _mm256_add_epi32(u, g);
+		_mm256_storeu_si256((__m256i *)&(c0[i]), _mm256_min_epi32(_mm256_max_epi32(_mm256_add_epi32(r, s0), min0), max0));
+		_mm256_storeu_si256((__m256i *)&(c1[i]), _mm256_min_epi32(_mm256_max_epi32(_mm256_add_epi32(g, s1), min1), max1));
+		_mm256_storeu_si256((__m256i *)&(c2[i]), _mm256_min_epi32(_mm256_max_epi32(_mm256_add_epi32(b, s2), min2), max2));
+	}
+	opj_mct_decode_shift(c0 + i, c1 + i, c2 + i, n - i, p_shift, p_min, p_max);
+}
+
+OPJ_TARGET_AVX2
+static void opj_mct_decode_real_shift_avx2(
+		OPJ_INT32* restrict c0,
+		OPJ_INT32* restrict c1,
+		OPJ_INT32* restrict c2,
+		OPJ_UINT32 n,
+		const OPJ_INT32* p_shift,
+		const OPJ_INT32* p_min,
+		const OPJ_INT32* p_max)
+{
+	OPJ_UINT32 i;
+	const __m256 vrv = _mm256_set1_ps(1.402f);
+	const __m256 vgu = _mm256_set1_ps(0.34413f);
+	const __m256 vgv = _mm256_set1_ps(0.71414f);
+	const __m256 vbu = _mm256_set1_ps(1.772f);
+	const __m256i s0 = _mm256_set1_epi32(p_shift[0]), s1 = _mm256_set1_epi32(p_shift[1]), s2 = _mm256_set1_epi32(p_shift[2]);
+	const __m256i min0 = _mm256_set1_epi32(p_min[0]), min1 = _mm256_set1_epi32(p_min[1]), min2 = _mm256_set1_epi32(p_min[2]);
+	const __m256i max0 = _mm256_set1_epi32(p_max[0]), max1 = _mm256_set1_epi32(p_max[1]), max2 = _mm256_set1_epi32(p_max[2]);
+
+	for (i = 0; i < (n & ~7U); i += 8) {
+		__m256 vr, vg, vb;
+		__m256 vy = _mm256_loadu_ps((const OPJ_FLOAT32*)&(c0[i]));
+		__m256 vu = _mm256_loadu_ps((const OPJ_FLOAT32*)&(c1[i]));
+		__m256 vv = _mm256_loadu_ps((const OPJ_FLOAT32*)&(c2[i]));
+		__m256i ir, ig, ib;
+		vr = _mm256_add_ps(vy, _mm256_mul_ps(vv, vrv));
+		vg = _mm256_sub_ps(_mm256_sub_ps(vy, _mm256_mul_ps(vu, vgu)), _mm256_mul_ps(vv, vgv));
+		vb = _mm256_add_ps(vy, _mm256_mul_ps(vu, vbu));
+		ir = _mm256_add_epi32(_mm256_cvtps_epi32(vr), s0);
+		ig = _mm256_add_epi32(_mm256_cvtps_epi32(vg), s1);
+		ib = _mm256_add_epi32(_mm256_cvtps_epi32(vb), s2);
+		_mm256_storeu_si256((__m256i *)&(c0[i]), _mm256_min_epi32(_mm256_max_epi32(ir, min0), max0));
+		_mm256_storeu_si256((__m256i *)&(c1[i]), _mm256_min_epi32(_mm256_max_epi32(ig, min1), max1));
+		_mm256_storeu_si256((__m256i *)&(c2[i]), _mm256_min_epi32(_mm256_max_epi32(ib, min2), max2));
+	}
+	opj_mct_decode_real_shift(c0 + i, c1 + i, c2 + i, n - i, p_shift, p_min, p_max);
+}
+
+OPJ_TARGET_AVX2
+static void opj_mct_dc_shift_avx2(OPJ_INT32* restrict c, OPJ_UINT32 n, OPJ_INT32 p_shift, OPJ_INT32 p_min, OPJ_INT32 p_max)
+{
+	OPJ_UINT32 i;
+	const __m256i s = _mm256_set1_epi32(p_shift);
+	const __m256i vmin = _mm256_set1_epi32(p_min);
+	const __m256i vmax = _mm256_set1_epi32(p_max);
+
+	for (i = 0; i < (n & ~7U); i += 8) {
+		__m256i v = _mm256_add_epi32(_mm256_loadu_si256((const __m256i *)&(c[i])), s);
+		_mm256_storeu_si256((__m256i *)&(c[i]), _mm256_min_epi32(_mm256_max_epi32(v, vmin), vmax));
+	}
+	opj_mct_dc_shift(c + i, n - i, p_shift, p_min, p_max);
+}
+
+OPJ_TARGET_AVX2
+static void opj_mct_dc_shift_real_avx2(OPJ_INT32* restrict c, OPJ_UINT32 n, OPJ_INT32 p_shift, OPJ_INT32 p_min, OPJ_INT32 p_max)
+{
+	OPJ_UINT32 i;
+	const __m256i s = _mm256_set1_epi32(p_shift);
+	const __m256i vmin = _mm256_set1_epi32(p_min);
+	const __m256i vmax = _mm256_set1_epi32(p_max);
+
+	for (i = 0; i < (n & ~7U); i += 8) {
+		__m256i v = _mm256_cvtps_epi32(_mm256_loadu_ps((const OPJ_FLOAT32*)&(c[i])));
+		v = _mm256_add_epi32(v, s);
+		_mm256_storeu_si256((__m256i *)&(c[i]), _mm256_min_epi32(_mm256_max_epi32(v, vmin), vmax));
+	}
+	opj_mct_dc_shift_real(c + i, n - i, p_shift, p_min, p_max);
+}
+#endif
+
+/* <summary> */
+/* Kernels of the MCT. */
+/* </summary> */
+void opj_mct_init_kernels(opj_kernels_t* p_kernels, OPJ_UINT32 p_level)
+{
+	p_kernels->mct_encode = opj_mct_encode;
+	p_kernels->mct_decode = opj_mct_decode;
+	p_kernels->mct_encode_real = opj_mct_encode_real;
+	p_kernels->mct_decode_real = opj_mct_decode_real;
+	p_kernels->mct_decode_shift = opj_mct_decode_shift;
+	p_kernels->mct_decode_real_shift = opj_mct_decode_real_shift;
+	p_kernels->dc_shift = opj_mct_dc_shift;
+	p_kernels->dc_shift_real = opj_mct_dc_shift_real;
+#ifdef OPJ_HAVE_X86_KERNELS
+	if (p_level >= OPJ_CPU_LEVEL_SSE2) {
+		p_kernels->mct_encode = opj_mct_encode_sse2;
+		p_kernels->mct_decode = opj_mct_decode_sse2;
+		p_kernels->mct_decode_real = opj_mct_decode_real_sse;
+		p_kernels->mct_decode_shift = opj_mct_decode_shift_sse2;
+		p_kernels->mct_decode_real_shift = opj_mct_decode_real_shift_sse2;
+		p_kernels->dc_shift = opj_mct_dc_shift_sse2;
+		p_kernels->dc_shift_real = opj_mct_dc_shift_real_sse2;
+	}
+	if (p_level >= OPJ_CPU_LEVEL_AVX2) {
+		p_kernels->mct_decode = opj_mct_decode_avx2;
+		p_kernels->mct_encode_real = opj_mct_encode_real_sse41;
+		p_kernels->mct_decode_real = opj_mct_decode_real_avx2;
+		p_kernels->mct_decode_shift = opj_mct_decode_shift_avx2;
+		p_kernels->mct_decode_real_shift = opj_mct_decode_real_shift_avx2;
+		p_kernels->dc_shift = opj_mct_dc_shift_avx2;
+		p_kernels->dc_shift_real = opj_mct_dc_shift_real_avx2;
+	}
+#else
+	(void)p_level;
+#endif
 }
 
 /* <summary> */
@@ -45,6 +45,8 @@
 
 The functions in MCT.C have for goal to realize reversible and irreversible multicomponent
 transform. The functions in MCT.C are used by some function in TCD.C.
+The functions below are the portable versions of the transforms; TCD.C uses the
+ones selected for the CPU by opj_mct_init_kernels().
 */
 
 /** @defgroup MCT MCT - Implementation of a multi-component transform */
@@ -93,11 +95,61 @@ Apply an irreversible multi-component inverse transform to an image
 */
 void opj_mct_decode_real(OPJ_FLOAT32* c0, OPJ_FLOAT32* c1, OPJ_FLOAT32* c2, OPJ_UINT32 n);
 /**
+Apply a reversible multi-component inverse transform, then the DC level shift
+of each component, clamped to the range of the component
+@param c0 Samples for luminance component
+@param c1 Samples for red chrominance component
+@param c2 Samples for blue chrominance component
+@param n Number of samples for each component
+@param p_shift DC level shift of each component
+@param p_min Minimum value of each component
+@param p_max Maximum value of each component
+*/
+void opj_mct_decode_shift(OPJ_INT32* c0, OPJ_INT32* c1, OPJ_INT32* c2, OPJ_UINT32 n,
+                          const OPJ_INT32* p_shift, const OPJ_INT32* p_min, const OPJ_INT32* p_max);
+/**
+Apply an irreversible multi-component inverse transform to float samples, then
+round them and apply the clamped DC level shift of each component
+@param c0 Samples for luminance component (float on input)
+@param c1 Samples for red chrominance component (float on input)
+@param c2 Samples for blue chrominance component (float on input)
+@param n Number of samples for each component
+@param p_shift DC level shift of each component
+@param p_min Minimum value of each component
+@param p_max Maximum value of each component
+*/
+void opj_mct_decode_real_shift(OPJ_INT32* c0, OPJ_INT32* c1, OPJ_INT32* c2, OPJ_UINT32 n,
+                               const OPJ_INT32* p_shift, const OPJ_INT32* p_min, const OPJ_INT32* p_max);
+/**
+Apply the DC level shift of a component, clamped to its range
+@param c Samples of the component
+@param n Number of samples
+@param p_shift DC level shift
+@param p_min Minimum value of the component
+@param p_max Maximum value of the component
+*/
+void opj_mct_dc_shift(OPJ_INT32* c, OPJ_UINT32 n, OPJ_INT32 p_shift, OPJ_INT32 p_min, OPJ_INT32 p_max);
+/**
+Round the float samples of a component and apply its DC level shift, clamped to its range
+@param c Samples of the component (float on input)
+@param n Number of samples
+@param p_shift DC level shift
+@param p_min Minimum value of the component
+@param p_max Maximum value of the component
+*/
+void opj_mct_dc_shift_real(OPJ_INT32* c, OPJ_UINT32 n, OPJ_INT32 p_shift, OPJ_INT32 p_min, OPJ_INT32 p_max);
+/**
 Get norm of the basis function used for the irreversible multi-component transform
 @param compno Number of the component (0->Y, 1->U, 2->V)
 @return 
 */
 OPJ_FLOAT64 opj_mct_getnorm_real(OPJ_UINT32 compno);
+/**
+Fills the MCT entries of a kernel table.
+@param p_kernels Table to fill
+@param p_level Level of the kernels (OPJ_CPU_LEVEL_xxx)
+*/
+void opj_mct_init_kernels(opj_kernels_t* p_kernels, OPJ_UINT32 p_level);
 
 /**
 FIXME DOC
@@ -77,11 +77,15 @@ typedef struct opj_mqc {
 	OPJ_BYTE *end;
 	opj_mqc_state_t *ctxs[MQC_NUMCTXS];
 	opj_mqc_state_t **curctx;
-#ifdef MQC_PERF_OPT
-	unsigned char *buffer;
-#endif
 } opj_mqc_t;
 
+/**
+Number of bytes the decoder reads past the end of its input.
+They must hold 0xFF 0xFF, which the decoder sees as an end of stream marker,
+so that no bounds check is needed when a byte is input.
+*/
+#define MQC_DEC_PADDING 2
+
 /** @name Exported functions */
 /*@{*/
 /* ----------------------------------------------------------------------- */
@@ -189,7 +193,8 @@ void opj_mqc_segmark_enc(opj_mqc_t *mqc);
 /**
 Initialize the decoder
 @param mqc MQC handle
-@param bp Pointer to the start of the buffer from which the bytes will be read
+@param bp Pointer to the start of the buffer from which the bytes will be read.
+The len bytes must be followed by MQC_DEC_PADDING bytes set to 0xFF.
 @param len Length of the input buffer
 */
 OPJ_BOOL opj_mqc_init_dec(opj_mqc_t *mqc, OPJ_BYTE *bp, OPJ_UINT32 len);
@@ -199,6 +204,99 @@ Decode a symbol
 @return Returns the decoded symbol (0 or 1)
 */
 OPJ_INT32 opj_mqc_decode(opj_mqc_t * const mqc);
+
+/**
+Copy the decoder registers into local variables, so that a whole coding pass
+can run on them with opj_mqc_decode_macro()
+*/
+#define opj_mqc_load_dec(mqc, curctx, a, c, ct, bp) \
+	{ \
+		curctx = (mqc)->curctx; \
+		a = (mqc)->a; \
+		c = (mqc)->c; \
+		ct = (mqc)->ct; \
+		bp = (mqc)->bp; \
+	}
+/**
+Write back the local variables loaded by opj_mqc_load_dec()
+*/
+#define opj_mqc_store_dec(mqc, curctx, a, c, ct, bp) \
+	{ \
+		(mqc)->curctx = curctx; \
+		(mqc)->a = a; \
+		(mqc)->c = c; \
+		(mqc)->ct = ct; \
+		(mqc)->bp = bp; \
+	}
+/**
+Input a byte. The input must be padded, see MQC_DEC_PADDING:
+a 0xFF followed by a byte above 0x8F is a marker and is never passed.
+*/
+#define opj_mqc_bytein_macro(c, ct, bp) \
+	{ \
+		OPJ_UINT32 l_next = *((bp) + 1); \
+		if (*(bp) == 0xff) { \
+			if (l_next > 0x8f) { \
+				c += 0xff00; \
+				ct = 8; \
+			} else { \
+				(bp)++; \
+				c += l_next << 9; \
+				ct = 7; \
+			} \
+		} else { \
+			(bp)++; \
+			c += l_next << 8; \
+			ct = 8; \
+		} \
+	}
+/**
+Renormalize the A and C registers while decoding
+*/
+#define opj_mqc_renormd_macro(a, c, ct, bp) \
+	{ \
+		do { \
+			if (ct == 0) { \
+				opj_mqc_bytein_macro(c, ct, bp); \
+			} \
+			a <<= 1; \
+			c <<= 1; \
+			ct--; \
+		} while (a < 0x8000); \
+	}
+/**
+Decode a symbol into d, with the decoder registers held in local variables
+*/
+#define opj_mqc_decode_macro(d, curctx, a, c, ct, bp) \
+	{ \
+		const opj_mqc_state_t *l_state = *(curctx); \
+		a -= l_state->qeval; \
+		if ((c >> 16) < l_state->qeval) { \
+			if (a < l_state->qeval) { \
+				d = (OPJ_INT32)l_state->mps; \
+				*(curctx) = l_state->nmps; \
+			} else { \
+				d = (OPJ_INT32)(1 - l_state->mps); \
+				*(curctx) = l_state->nlps; \
+			} \
+			a = l_state->qeval; \
+			opj_mqc_renormd_macro(a, c, ct, bp); \
+		} else { \
+			c -= l_state->qeval << 16; \
+			if ((a & 0x8000) == 0) { \
+				if (a < l_state->qeval) { \
+					d = (OPJ_INT32)(1 - l_state->mps); \
+					*(curctx) = l_state->nlps; \
+				} else { \
+					d = (OPJ_INT32)l_state->mps; \
+					*(curctx) = l_state->nmps; \
+				} \
+				opj_mqc_renormd_macro(a, c, ct, bp); \
+			} else { \
+				d = (OPJ_INT32)l_state->mps; \
+			} \
+		} \
+	}
 /* ----------------------------------------------------------------------- */
 /*@}*/
 
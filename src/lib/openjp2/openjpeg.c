@@ -37,6 +37,14 @@
 
 #include "opj_includes.h"
 
+#if !defined(_WIN32) && defined(OPJ_HAVE_SYS_MMAN_H)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define OPJ_HAVE_MMAP
+#endif
+
 
 /* ---------------------------------------------------------------------- */
 /* Functions to set the message handlers */
@@ -185,6 +193,12 @@ opj_codec_t* OPJ_CALLCONV opj_create_decompress(OPJ_CODEC_FORMAT p_format)
 									struct opj_stream_private *,
 									opj_image_t*, struct opj_event_mgr * )) opj_j2k_decode;
 
+			l_codec->m_codec_data.m_decompression.opj_decode_into_buffer =
+					(OPJ_BOOL (*) (	void *,
+									struct opj_stream_private *,
+									opj_image_t*, OPJ_BYTE*, OPJ_SIZE_T, OPJ_PIXEL_FORMAT,
+									struct opj_event_mgr * )) opj_j2k_decode_into_buffer;
+
 			l_codec->m_codec_data.m_decompression.opj_end_decompress =
 					(OPJ_BOOL (*) (	void *,
 									struct opj_stream_private *,
@@ -239,6 +253,13 @@ opj_codec_t* OPJ_CALLCONV opj_create_decompress(OPJ_CODEC_FORMAT p_format)
 									OPJ_UINT32 res_factor,
 									struct opj_event_mgr * p_manager)) opj_j2k_set_decoded_resolution_factor;
 
+			l_codec->opj_set_threads =
+					(OPJ_BOOL (*) ( void * p_codec,
+									OPJ_UINT32 num_threads )) opj_j2k_set_threads;
+
+			l_codec->m_codec_data.m_decompression.opj_reset =
+					(OPJ_BOOL (*) ( void * p_codec)) opj_j2k_decoder_reset;
+
 			l_codec->m_codec = opj_j2k_create_decompress();
 
 			if (! l_codec->m_codec) {
@@ -262,6 +283,12 @@ opj_codec_t* OPJ_CALLCONV opj_create_decompress(OPJ_CODEC_FORMAT p_format)
 									opj_image_t*,
 									struct opj_event_mgr * )) opj_jp2_decode;
 
+			l_codec->m_codec_data.m_decompression.opj_decode_into_buffer =
+					(OPJ_BOOL (*) (	void *,
+									struct opj_stream_private *,
+									opj_image_t*, OPJ_BYTE*, OPJ_SIZE_T, OPJ_PIXEL_FORMAT,
+									struct opj_event_mgr * )) opj_jp2_decode_into_buffer;
+
 			l_codec->m_codec_data.m_decompression.opj_end_decompress =  
                     (OPJ_BOOL (*) ( void *,
                                     struct opj_stream_private *,
@@ -315,6 +342,13 @@ opj_codec_t* OPJ_CALLCONV opj_create_decompress(OPJ_CODEC_FORMAT p_format)
 						    		OPJ_UINT32 res_factor,
 							    	opj_event_mgr_t * p_manager)) opj_jp2_set_decoded_resolution_factor;
 
+			l_codec->opj_set_threads =
+					(OPJ_BOOL (*) ( void * p_codec,
+									OPJ_UINT32 num_threads )) opj_jp2_set_threads;
+
+			l_codec->m_codec_data.m_decompression.opj_reset =
+					(OPJ_BOOL (*) ( void * p_codec)) opj_jp2_decoder_reset;
+
 			l_codec->m_codec = opj_jp2_create(OPJ_TRUE);
 
 			if (! l_codec->m_codec) {
@@ -374,6 +408,37 @@ OPJ_BOOL OPJ_CALLCONV opj_setup_decoder(opj_codec_t *p_codec,
 	return OPJ_FALSE;
 }
 
+OPJ_BOOL OPJ_CALLCONV opj_codec_set_threads(opj_codec_t *p_codec,
+                                            int num_threads)
+{
+	if (p_codec && num_threads >= 0) {
+		opj_codec_private_t * l_codec = (opj_codec_private_t *) p_codec;
+
+		return l_codec->opj_set_threads(l_codec->m_codec, (OPJ_UINT32)num_threads);
+	}
+	return OPJ_FALSE;
+}
+
+OPJ_BOOL OPJ_CALLCONV opj_codec_reset(opj_codec_t *p_codec)
+{
+	if (p_codec) {
+		opj_codec_private_t * l_codec = (opj_codec_private_t *) p_codec;
+
+		if (! l_codec->is_decompressor) {
+			opj_event_msg(&(l_codec->m_event_mgr), EVT_ERROR,
+                "Codec provided to the opj_codec_reset function is not a decompressor handler.\n");
+			return OPJ_FALSE;
+		}
+
+		if (! l_codec->m_codec_data.m_decompression.opj_reset(l_codec->m_codec)) {
+			opj_event_msg(&(l_codec->m_event_mgr), EVT_ERROR, "Failed to reset the codec\n");
+			return OPJ_FALSE;
+		}
+		return OPJ_TRUE;
+	}
+	return OPJ_FALSE;
+}
+
 OPJ_BOOL OPJ_CALLCONV opj_read_header (	opj_stream_t *p_stream,
 										opj_codec_t *p_codec,
 										opj_image_t **p_image )
@@ -418,6 +483,33 @@ OPJ_BOOL OPJ_CALLCONV opj_decode(   opj_codec_t *p_codec,
 	return OPJ_FALSE;
 }
 
+OPJ_BOOL OPJ_CALLCONV opj_decode_into_buffer(   opj_codec_t *p_codec,
+                                                opj_stream_t *p_stream,
+                                                opj_image_t* p_image,
+                                                OPJ_BYTE *p_buffer,
+                                                OPJ_SIZE_T p_stride,
+                                                OPJ_PIXEL_FORMAT p_format)
+{
+	if (p_codec && p_stream) {
+		opj_codec_private_t * l_codec = (opj_codec_private_t *) p_codec;
+		opj_stream_private_t * l_stream = (opj_stream_private_t *) p_stream;
+
+		if (! l_codec->is_decompressor) {
+			return OPJ_FALSE;
+		}
+
+		return l_codec->m_codec_data.m_decompression.opj_decode_into_buffer(l_codec->m_codec,
+																			l_stream,
+																			p_image,
+																			p_buffer,
+																			p_stride,
+																			p_format,
+																			&(l_codec->m_event_mgr) );
+	}
+
+	return OPJ_FALSE;
+}
+
 OPJ_BOOL OPJ_CALLCONV opj_set_decode_area(	opj_codec_t *p_codec,
 											opj_image_t* p_image,
 											OPJ_INT32 p_start_x, OPJ_INT32 p_start_y,
@@ -577,6 +669,8 @@ opj_codec_t* OPJ_CALLCONV opj_create_compress(OPJ_CODEC_FORMAT p_format)
 																				struct opj_image *,
 																				struct opj_event_mgr * )) opj_j2k_setup_encoder;
 
+			l_codec->opj_set_threads = (OPJ_BOOL (*) (void *, OPJ_UINT32)) opj_j2k_set_threads;
+
 			l_codec->m_codec = opj_j2k_create_compress();
 			if (! l_codec->m_codec) {
 				opj_free(l_codec);
@@ -614,6 +708,8 @@ opj_codec_t* OPJ_CALLCONV opj_create_compress(OPJ_CODEC_FORMAT p_format)
 																				struct opj_image *,
 																				struct opj_event_mgr * )) opj_jp2_setup_encoder;
 
+			l_codec->opj_set_threads = (OPJ_BOOL (*) (void *, OPJ_UINT32)) opj_jp2_set_threads;
+
 			l_codec->m_codec = opj_jp2_create(OPJ_FALSE);
 			if (! l_codec->m_codec) {
 				opj_free(l_codec);
@@ -960,3 +1056,131 @@ opj_stream_t* OPJ_CALLCONV opj_stream_create_file_stream (
 
     return l_stream;
 }
+
+#if defined(_WIN32) || defined(OPJ_HAVE_MMAP)
+/**
+ * A file mapped in memory, the user data of the stream reading it
+ */
+typedef struct opj_mapped_file
+{
+    /** first byte of the mapping */
+    void * m_data;
+    /** length of the file */
+    OPJ_SIZE_T m_size;
+} opj_mapped_file_t;
+
+/** Data of the stream of an empty file, which cannot be mapped */
+static const OPJ_BYTE opj_empty_file_data[1] = { 0 };
+
+static void opj_unmap_file (opj_mapped_file_t * p_file)
+{
+    if (p_file->m_size) {
+#ifdef _WIN32
+        UnmapViewOfFile(p_file->m_data);
+#else
+        munmap(p_file->m_data, p_file->m_size);
+#endif
+    }
+    opj_free(p_file);
+}
+
+/**
+ * Maps a whole file in memory, read only.
+ * @return the mapping, or NULL if the file could not be opened or mapped.
+ */
+static opj_mapped_file_t * opj_map_file (const char *fname)
+{
+    opj_mapped_file_t * l_file = (opj_mapped_file_t *) opj_calloc(1, sizeof(opj_mapped_file_t));
+#ifdef _WIN32
+    HANDLE l_handle, l_mapping;
+    LARGE_INTEGER l_size;
+
+    if (! l_file) {
+        return NULL;
+    }
+    l_handle = CreateFileA(fname, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (l_handle == INVALID_HANDLE_VALUE) {
+        opj_free(l_file);
+        return NULL;
+    }
+    if (! GetFileSizeEx(l_handle, &l_size) || (OPJ_UINT64)l_size.QuadPart > (OPJ_UINT64)(OPJ_SIZE_T)-1) {
+        CloseHandle(l_handle);
+        opj_free(l_file);
+        return NULL;
+    }
+    l_file->m_size = (OPJ_SIZE_T)l_size.QuadPart;
+    if (l_file->m_size) {
+        l_mapping = CreateFileMappingA(l_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+        l_file->m_data = l_mapping ? MapViewOfFile(l_mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+        if (l_mapping) {
+            /* the view keeps the mapping alive */
+            CloseHandle(l_mapping);
+        }
+    }
+    CloseHandle(l_handle);
+#else
+    int l_fd;
+    struct stat l_stat;
+
+    if (! l_file) {
+        return NULL;
+    }
+    l_fd = open(fname, O_RDONLY);
+    if (l_fd < 0) {
+        opj_free(l_file);
+        return NULL;
+    }
+    if (fstat(l_fd, &l_stat) != 0 || (OPJ_UINT64)l_stat.st_size > (OPJ_UINT64)(OPJ_SIZE_T)-1) {
+        close(l_fd);
+        opj_free(l_file);
+        return NULL;
+    }
+    l_file->m_size = (OPJ_SIZE_T)l_stat.st_size;
+    if (l_file->m_size) {
+        l_file->m_data = mmap(NULL, l_file->m_size, PROT_READ, MAP_PRIVATE, l_fd, 0);
+        if (l_file->m_data == MAP_FAILED) {
+            l_file->m_data = NULL;
+        }
+    }
+    /* the mapping keeps the file open */
+    close(l_fd);
+#endif
+
+    if (! l_file->m_size) {
+        l_file->m_data = (void *) opj_empty_file_data;
+    }
+    else if (! l_file->m_data) {
+        opj_free(l_file);
+        return NULL;
+    }
+    return l_file;
+}
+#endif /* _WIN32 || OPJ_HAVE_MMAP */
+
+opj_stream_t* OPJ_CALLCONV opj_stream_create_mmap_file_stream (const char *fname)
+{
+#if defined(_WIN32) || defined(OPJ_HAVE_MMAP)
+    opj_stream_t* l_stream = 00;
+    opj_mapped_file_t * l_file;
+
+    if (! fname) {
+        return NULL;
+    }
+
+    l_file = opj_map_file(fname);
+    if (! l_file) {
+        return NULL;
+    }
+
+    l_stream = opj_stream_create_memory_read_stream((const OPJ_BYTE *) l_file->m_data, l_file->m_size);
+    if (! l_stream) {
+        opj_unmap_file(l_file);
+        return NULL;
+    }
+    opj_stream_set_user_data(l_stream, l_file, (opj_stream_free_user_data_fn) opj_unmap_file);
+
+    return l_stream;
+#else
+    return opj_stream_create_default_file_stream(fname, OPJ_TRUE);
+#endif
+}
@@ -298,6 +298,19 @@ typedef enum CODEC_FORMAT {
     OPJ_CODEC_JPX  = 4		/**< JPX file format (JPEG 2000 Part-2) : to be coded */
 } OPJ_CODEC_FORMAT;
 
+/**
+ * Pixel formats of the buffers filled by opj_decode_into_buffer().
+ * Channels are interleaved, 16 bits samples are in the byte order of the CPU.
+*/
+typedef enum PIXEL_FORMAT {
+	OPJ_PIXEL_GRAY8  = 0,	/**< component 0, 8 bits */
+	OPJ_PIXEL_RGB8   = 1,	/**< components 0, 1, 2, 8 bits each */
+	OPJ_PIXEL_RGBA8  = 2,	/**< components 0, 1, 2, 3 (opaque if missing), 8 bits each */
+	OPJ_PIXEL_GRAY16 = 3,	/**< component 0, 16 bits */
+	OPJ_PIXEL_RGB16  = 4,	/**< components 0, 1, 2, 16 bits each */
+	OPJ_PIXEL_RGBA16 = 5	/**< components 0, 1, 2, 3 (opaque if missing), 16 bits each */
+} OPJ_PIXEL_FORMAT;
+
 
 /* 
 ==========================================================
@@ -312,6 +325,61 @@ typedef enum CODEC_FORMAT {
  * */
 typedef void (*opj_msg_callback) (const char *msg, void *client_data);
 
+/* 
+==========================================================
+   memory management typedef definitions
+==========================================================
+*/
+
+/**
+ * Callback function prototype for the allocation of an uninitialized memory block
+ * @param p_size            Bytes to allocate
+ * @param p_user_data       User data given to opj_set_memory_functions()
+ * @return the allocated block, or NULL if there is insufficient memory available
+ * */
+typedef void * (* opj_malloc_fn) (OPJ_SIZE_T p_size, void * p_user_data);
+
+/**
+ * Callback function prototype for the allocation of a memory block initialized to 0
+ * @param p_num             Blocks to allocate
+ * @param p_size            Bytes per block to allocate
+ * @param p_user_data       User data given to opj_set_memory_functions()
+ * @return the allocated block, or NULL if there is insufficient memory available
+ * */
+typedef void * (* opj_calloc_fn) (OPJ_SIZE_T p_num, OPJ_SIZE_T p_size, void * p_user_data);
+
+/**
+ * Callback function prototype for the reallocation of a memory block
+ * @param p_ptr             Block to reallocate (may be NULL)
+ * @param p_size            New size in bytes
+ * @param p_user_data       User data given to opj_set_memory_functions()
+ * @return the reallocated block, or NULL (leaving p_ptr untouched) if there is insufficient memory available
+ * */
+typedef void * (* opj_realloc_fn) (void * p_ptr, OPJ_SIZE_T p_size, void * p_user_data);
+
+/**
+ * Callback function prototype for the release of a memory block
+ * @param p_ptr             Block to release (never NULL)
+ * @param p_user_data       User data given to opj_set_memory_functions()
+ * */
+typedef void (* opj_free_fn) (void * p_ptr, void * p_user_data);
+
+/**
+ * Callback function prototype for the allocation of an aligned memory block
+ * @param p_size            Bytes to allocate
+ * @param p_alignment       Alignment in bytes, a power of 2
+ * @param p_user_data       User data given to opj_set_memory_functions()
+ * @return the allocated block, or NULL if there is insufficient memory available
+ * */
+typedef void * (* opj_aligned_malloc_fn) (OPJ_SIZE_T p_size, OPJ_SIZE_T p_alignment, void * p_user_data);
+
+/**
+ * Callback function prototype for the release of an aligned memory block
+ * @param p_ptr             Block to release (never NULL)
+ * @param p_user_data       User data given to opj_set_memory_functions()
+ * */
+typedef void (* opj_aligned_free_fn) (void * p_ptr, void * p_user_data);
+
 /* 
 ==========================================================
    codec typedef definitions
@@ -521,6 +589,16 @@ typedef struct opj_dparameters {
 	if == 0 or not used, all the quality layers are decoded 
 	*/
 	OPJ_UINT32 cp_layer;
+	/**
+	Set the maximum number of bytes the decoder may allocate for an image: the
+	samples of the output image, and those, the code-blocks and the compressed
+	data of the tiles being decoded. The usage is estimated when the decoding
+	starts, which fails if it is over the budget; otherwise tiles are decoded
+	concurrently only as far as the budget allows, and the memory of a tile is
+	released as soon as its samples are copied into the image.
+	if == 0 or not used, the memory is not limited
+	*/
+	OPJ_SIZE_T max_memory;
 
 	/**@name command line decoder parameters (not used inside the library) */
 	/*@{*/
@@ -1054,6 +1132,45 @@ extern "C" {
 /* Get the version of the openjpeg library*/
 OPJ_API const char * OPJ_CALLCONV opj_version(void);
 
+/* 
+==========================================================
+   memory management functions definitions
+==========================================================
+*/
+
+/**
+ * Installs the functions through which the library allocates and releases
+ * all of its memory: codecs, streams, images and their samples, and the
+ * scratch buffers of the coders.
+ *
+ * It must be called before any other function of the library, or at least
+ * while no codec, stream or image exists, since every block must be released
+ * by the functions that allocated it. This also holds for the blocks that the
+ * caller hands to the library (e.g. component samples or an ICC profile of an
+ * image released by opj_image_destroy()). The functions may be called from
+ * several threads at once when the codecs are multithreaded.
+ *
+ * @param p_malloc          Allocation of an uninitialized block
+ * @param p_calloc          Allocation of a zeroed block, or NULL to use p_malloc and clear the block
+ * @param p_realloc         Reallocation of a block
+ * @param p_free            Release of a block
+ * @param p_aligned_malloc  Allocation of an aligned block, or NULL to carve it out of a p_malloc block
+ * @param p_aligned_free    Release of an aligned block, NULL if and only if p_aligned_malloc is NULL
+ * @param p_user_data       Passed unchanged to every function
+ *
+ * Passing NULL for all the functions restores the C library allocator.
+ *
+ * @return OPJ_TRUE on success, OPJ_FALSE if p_malloc, p_realloc and p_free are not
+ * all given, or if only one of p_aligned_malloc and p_aligned_free is.
+ */
+OPJ_API OPJ_BOOL OPJ_CALLCONV opj_set_memory_functions(opj_malloc_fn p_malloc,
+                                                       opj_calloc_fn p_calloc,
+                                                       opj_realloc_fn p_realloc,
+                                                       opj_free_fn p_free,
+                                                       opj_aligned_malloc_fn p_aligned_malloc,
+                                                       opj_aligned_free_fn p_aligned_free,
+                                                       void * p_user_data);
+
 /* 
 ==========================================================
    image functions definitions
@@ -1180,6 +1297,44 @@ OPJ_API opj_stream_t* OPJ_CALLCONV opj_stream_create_default_file_stream (const
 OPJ_API opj_stream_t* OPJ_CALLCONV opj_stream_create_file_stream (const char *fname,
                                                                      OPJ_SIZE_T p_buffer_size,
                                                                      OPJ_BOOL p_is_read_stream);
+
+/**
+ * Create a read stream from a file identified with its filename, by mapping the file in memory.
+ * Reads copy straight from the mapping, and skips and seeks only move the current position,
+ * so that the parts of the file that are not decoded are never read from the disk.
+ * Where memory mapping is not available, this is a default file stream.
+ * @param fname             the filename of the file to stream
+ * @return the stream, or NULL if the file could not be opened or mapped
+*/
+OPJ_API opj_stream_t* OPJ_CALLCONV opj_stream_create_mmap_file_stream (const char *fname);
+
+/**
+ * Create a read stream over a buffer lying in memory. Reads copy straight from the buffer,
+ * skips and seeks only move the current position, and tiles made of a single tile-part are
+ * decoded from the buffer itself.
+ * @param p_buffer          the buffer, which must stay valid until the decoding is over
+ * @param p_size            the number of bytes in the buffer
+ * @return the stream, or NULL if it could not be allocated
+*/
+OPJ_API opj_stream_t* OPJ_CALLCONV opj_stream_create_memory_stream (const void *p_buffer, OPJ_SIZE_T p_size);
+
+/**
+ * Create a write stream into a buffer of the library, which grows as needed.
+ * The data written is given by opj_stream_get_memory_data().
+ * @param p_initial_size    the initial size of the buffer, 0 for a default size
+ * @return the stream, or NULL if it could not be allocated
+*/
+OPJ_API opj_stream_t* OPJ_CALLCONV opj_stream_create_memory_output_stream (OPJ_SIZE_T p_initial_size);
+
+/**
+ * Get the data of a stream created by opj_stream_create_memory_stream() or
+ * opj_stream_create_memory_output_stream(). For a write stream, the data is valid
+ * until the next write or the destruction of the stream.
+ * @param p_stream          the stream
+ * @param p_size            if not NULL, receives the number of bytes of data
+ * @return the data, or NULL if the stream does not lie in memory
+*/
+OPJ_API const OPJ_BYTE * OPJ_CALLCONV opj_stream_get_memory_data (opj_stream_t* p_stream, OPJ_SIZE_T * p_size);
  
 /* 
 ==========================================================
@@ -1262,6 +1417,36 @@ OPJ_API void OPJ_CALLCONV opj_set_default_decoder_parameters(opj_dparameters_t *
 OPJ_API OPJ_BOOL OPJ_CALLCONV opj_setup_decoder(opj_codec_t *p_codec,
 												opj_dparameters_t *parameters );
 
+/**
+ * Sets the number of threads used to decode or encode the code-blocks of
+ * each tile. The output is identical whatever the number of threads.
+ * This function should be called before opj_read_header() (decoder) or
+ * opj_start_compress() (encoder).
+ *
+ * @param p_codec       decompressor or compressor handler
+ * @param num_threads   number of threads. 0 or 1 processes the code-blocks
+ *                      in the calling thread (default).
+ *
+ * @return OPJ_TRUE if the function is successful, OPJ_FALSE if the library
+ *         has no thread support and num_threads > 1, or on failure.
+ */
+OPJ_API OPJ_BOOL OPJ_CALLCONV opj_codec_set_threads(opj_codec_t *p_codec,
+                                                    int num_threads);
+
+/**
+ * Resets a decompressor so that it can decode another image, after the
+ * previous one was decoded (or given up). It is cheaper than destroying the
+ * codec and creating a new one: the decoding parameters, the number of threads
+ * and the scratch memory (code-block decoders, tile buffers, header buffer)
+ * are kept. The next call must be opj_read_header() with the new stream.
+ *
+ * @param p_codec       decompressor handler
+ *
+ * @return OPJ_TRUE if the codec was reset, OPJ_FALSE if it is not a
+ *         decompressor or on failure.
+ */
+OPJ_API OPJ_BOOL OPJ_CALLCONV opj_codec_reset(opj_codec_t *p_codec);
+
 /**
  * Decodes an image header.
  *
@@ -1304,6 +1489,33 @@ OPJ_API OPJ_BOOL OPJ_CALLCONV opj_decode(   opj_codec_t *p_decompressor,
                                             opj_stream_t *p_stream,
                                             opj_image_t *p_image);
 
+/**
+ * Decode an image from a JPEG-2000 codestream into a buffer of interleaved
+ * pixels owned by the caller. The samples are written as the tiles are
+ * decoded and the components of p_image are not allocated.
+ *
+ * The buffer holds p_image->comps[0].h rows of p_image->comps[0].w pixels,
+ * as set by opj_read_header(), opj_set_decode_area() and the resolution
+ * factor. The components written must have the subsampling of component 0.
+ * Signed samples are offset by half their range, and all the samples are
+ * shifted to the number of bits of the format. Palettes and channel
+ * definitions of JP2 files are not applied.
+ *
+ * @param p_decompressor 	decompressor handle
+ * @param p_stream			Input buffer stream
+ * @param p_image 			the image header read by opj_read_header()
+ * @param p_buffer			the buffer to fill
+ * @param p_stride			number of bytes between two rows of the buffer
+ * @param p_format			format of the pixels of the buffer
+ * @return 					true if success, otherwise false
+ * */
+OPJ_API OPJ_BOOL OPJ_CALLCONV opj_decode_into_buffer(   opj_codec_t *p_decompressor,
+                                                        opj_stream_t *p_stream,
+                                                        opj_image_t *p_image,
+                                                        OPJ_BYTE *p_buffer,
+                                                        OPJ_SIZE_T p_stride,
+                                                        OPJ_PIXEL_FORMAT p_format);
+
 /**
  * Get the decoded tile from the codec
  *
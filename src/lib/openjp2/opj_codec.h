@@ -61,6 +61,15 @@ typedef struct opj_codec_private
                                      opj_image_t * p_image,
                                      struct opj_event_mgr * p_manager);
 
+            /** Decoding function writing to a caller buffer */
+            OPJ_BOOL (*opj_decode_into_buffer) ( void * p_codec,
+                                                 struct opj_stream_private * p_cio,
+                                                 opj_image_t * p_image,
+                                                 OPJ_BYTE * p_buffer,
+                                                 OPJ_SIZE_T p_stride,
+                                                 OPJ_PIXEL_FORMAT p_format,
+                                                 struct opj_event_mgr * p_manager);
+
             /** FIXME DOC */
             OPJ_BOOL (*opj_read_tile_header)( void * p_codec,
                                               OPJ_UINT32 * p_tile_index,
@@ -113,6 +122,9 @@ typedef struct opj_codec_private
             OPJ_BOOL (*opj_set_decoded_resolution_factor) ( void * p_codec,
                                                             OPJ_UINT32 res_factor,
                                                             opj_event_mgr_t * p_manager);
+
+            /** Reset function handler, to decode another image with the same codec */
+            OPJ_BOOL (*opj_reset) ( void * p_codec);
         } m_decompression;
 
         /**
@@ -157,6 +169,8 @@ typedef struct opj_codec_private
     void (*opj_dump_codec) (void * p_codec, OPJ_INT32 info_flag, FILE* output_stream);
     opj_codestream_info_v2_t* (*opj_get_codec_info)(void* p_codec);
     opj_codestream_index_t* (*opj_get_codec_index)(void* p_codec);
+    /** Set number of threads function handler */
+    OPJ_BOOL (*opj_set_threads)(void * p_codec, OPJ_UINT32 num_threads);
 }
 opj_codec_private_t;
 
@@ -0,0 +1,110 @@
+/*
+ * The copyright in this software is being made available under the 2-clauses
+ * BSD License, included below. This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such rights
+ * are granted under this license.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "opj_includes.h"
+
+/** Names of the levels, as given in the OPJ_CPU_LEVEL environment variable */
+static const char * const opj_cpu_level_names[] = { "generic", "sse2", "avx2", "avx512" };
+
+/**
+ * Detects the highest kernel level supported by the CPU (and the OS, for the
+ * state of the AVX registers).
+ */
+static OPJ_UINT32 opj_cpu_detect_level(void)
+{
+#if defined(OPJ_HAVE_X86_KERNELS) && defined(__GNUC__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f")) {
+		return OPJ_CPU_LEVEL_AVX512;
+	}
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("sse4.1")) {
+		return OPJ_CPU_LEVEL_AVX2;
+	}
+	if (__builtin_cpu_supports("sse2")) {
+		return OPJ_CPU_LEVEL_SSE2;
+	}
+	return OPJ_CPU_LEVEL_GENERIC;
+#elif defined(OPJ_HAVE_X86_KERNELS)
+	int regs[4];
+	OPJ_UINT32 l_level = OPJ_CPU_LEVEL_SSE2; /* always available on x64 */
+	__cpuid(regs, 0);
+	if (regs[0] >= 7) {
+		OPJ_BOOL l_osxsave;
+		OPJ_BOOL l_sse41;
+		unsigned long long l_xcr0 = 0;
+		__cpuid(regs, 1);
+		l_osxsave = (regs[2] & (1 << 27)) != 0;
+		l_sse41 = (regs[2] & (1 << 19)) != 0;
+		if (l_osxsave) {
+			l_xcr0 = _xgetbv(0);
+		}
+		__cpuidex(regs, 7, 0);
+		/* the OS must save the YMM (and ZMM) registers */
+		if ((regs[1] & (1 << 16)) && (l_xcr0 & 0xE6) == 0xE6) {
+			l_level = OPJ_CPU_LEVEL_AVX512;
+		}
+		else if ((regs[1] & (1 << 5)) && l_sse41 && (l_xcr0 & 0x06) == 0x06) {
+			l_level = OPJ_CPU_LEVEL_AVX2;
+		}
+	}
+	return l_level;
+#else
+	return OPJ_CPU_LEVEL_GENERIC;
+#endif
+}
+
+OPJ_UINT32 opj_cpu_get_level(void)
+{
+	OPJ_UINT32 l_level = opj_cpu_detect_level();
+	const char * l_env = getenv("OPJ_CPU_LEVEL");
+	OPJ_UINT32 i;
+
+	if (l_env) {
+		for (i = 0; i < sizeof(opj_cpu_level_names) / sizeof(opj_cpu_level_names[0]); ++i) {
+			if (strcmp(l_env, opj_cpu_level_names[i]) == 0) {
+				/* a level can only be lowered, the CPU could not run a higher one */
+				if (i < l_level) {
+					l_level = i;
+				}
+				break;
+			}
+		}
+	}
+	return l_level;
+}
+
+void opj_kernels_init(opj_kernels_t* p_kernels, OPJ_UINT32 p_level)
+{
+	memset(p_kernels, 0, sizeof(opj_kernels_t));
+	p_kernels->level = p_level;
+	opj_dwt_init_kernels(p_kernels, p_level);
+	opj_mct_init_kernels(p_kernels, p_level);
+	opj_t1_init_kernels(p_kernels, p_level);
+}
@@ -0,0 +1,146 @@
+/*
+ * The copyright in this software is being made available under the 2-clauses
+ * BSD License, included below. This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such rights
+ * are granted under this license.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __OPJ_CPU_H
+#define __OPJ_CPU_H
+
+/**
+@file opj_cpu.h
+@brief Runtime selection of the SIMD kernels
+
+The functions in opj_cpu.c detect the instruction sets supported by the CPU
+running the library, and fill the table of kernels (DWT, MCT, dequantization)
+used by a codec with the fastest ones it can run. The SIMD kernels are built
+whatever the target architecture of the library, so that a build for the
+baseline instruction set still uses them. The OPJ_CPU_LEVEL environment
+variable (generic, sse2, avx2 or avx512) caps the level of the kernels, to
+benchmark or debug each of them.
+*/
+
+/** @defgroup CPU CPU - Runtime selection of the SIMD kernels */
+/*@{*/
+
+/*
+ * x86 SIMD kernels are compiled for their own instruction set with a target
+ * attribute (GCC >= 4.9, clang), or with no attribute at all (MSVC x64).
+ * The intrinsics headers must be included before opj_malloc.h, which poisons
+ * malloc().
+ */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#include <immintrin.h>
+#define OPJ_HAVE_X86_KERNELS
+#define OPJ_TARGET_SSE2		__attribute__((target("sse2")))
+#define OPJ_TARGET_SSE41	__attribute__((target("sse4.1")))
+#define OPJ_TARGET_AVX2		__attribute__((target("avx2")))
+#define OPJ_TARGET_AVX512	__attribute__((target("avx512f")))
+#elif defined(_MSC_VER) && (_MSC_VER >= 1910) && defined(_M_X64)
+#include <intrin.h>
+#include <immintrin.h>
+#define OPJ_HAVE_X86_KERNELS
+#define OPJ_TARGET_SSE2
+#define OPJ_TARGET_SSE41
+#define OPJ_TARGET_AVX2
+#define OPJ_TARGET_AVX512
+#endif
+
+/** Portable C kernels */
+#define OPJ_CPU_LEVEL_GENERIC	0
+/** SSE2 kernels */
+#define OPJ_CPU_LEVEL_SSE2		1
+/** AVX2 (and SSE4.1) kernels */
+#define OPJ_CPU_LEVEL_AVX2		2
+/** AVX-512F kernels */
+#define OPJ_CPU_LEVEL_AVX512	3
+
+/**
+ * Kernels used by a codec. Each level may use the kernels of the lower ones
+ * for the functions it does not specialize.
+ */
+typedef struct opj_kernels
+{
+	/** level of the kernels (OPJ_CPU_LEVEL_xxx) */
+	OPJ_UINT32 level;
+
+	/** forward 5-3 transform of interleaved columns, see opj_dwt_encode() */
+	void (*dwt_encode_cols)(OPJ_INT32* a, OPJ_INT32 dn, OPJ_INT32 sn, OPJ_INT32 cas);
+	/** forward 9-7 transform of interleaved columns, see opj_dwt_encode_real() */
+	void (*dwt_encode_cols_real)(OPJ_INT32* a, OPJ_INT32 dn, OPJ_INT32 sn, OPJ_INT32 cas);
+	/** inverse 5-3 transform of interleaved columns, see opj_dwt_decode() */
+	void (*dwt_decode_cols)(OPJ_INT32* mem, OPJ_INT32 dn, OPJ_INT32 sn, OPJ_INT32 cas);
+	/** number of rows (or columns) transformed at once by dwt_real_step1/2 */
+	OPJ_INT32 dwt_real_lanes;
+	/** scaling step of the inverse 9-7 transform: w[2i] *= c, for i < count */
+	void (*dwt_real_step1)(OPJ_FLOAT32* w, OPJ_INT32 count, OPJ_FLOAT32 c);
+	/** lifting step of the inverse 9-7 transform: w[2i-1] += (w[2i-2] + w[2i]) * c, with w[-2] = l[0] */
+	void (*dwt_real_step2)(OPJ_FLOAT32* l, OPJ_FLOAT32* w, OPJ_INT32 k, OPJ_INT32 m, OPJ_FLOAT32 c);
+
+	/** forward reversible MCT, see opj_mct_init_kernels() */
+	void (*mct_encode)(OPJ_INT32* c0, OPJ_INT32* c1, OPJ_INT32* c2, OPJ_UINT32 n);
+	/** inverse reversible MCT */
+	void (*mct_decode)(OPJ_INT32* c0, OPJ_INT32* c1, OPJ_INT32* c2, OPJ_UINT32 n);
+	/** forward irreversible MCT */
+	void (*mct_encode_real)(OPJ_INT32* c0, OPJ_INT32* c1, OPJ_INT32* c2, OPJ_UINT32 n);
+	/** inverse irreversible MCT */
+	void (*mct_decode_real)(OPJ_FLOAT32* c0, OPJ_FLOAT32* c1, OPJ_FLOAT32* c2, OPJ_UINT32 n);
+	/** inverse reversible MCT followed by the DC level shift and clamp of each component */
+	void (*mct_decode_shift)(OPJ_INT32* c0, OPJ_INT32* c1, OPJ_INT32* c2, OPJ_UINT32 n, const OPJ_INT32* p_shift, const OPJ_INT32* p_min, const OPJ_INT32* p_max);
+	/** inverse irreversible MCT of float samples followed by the rounding, DC level shift and clamp of each component */
+	void (*mct_decode_real_shift)(OPJ_INT32* c0, OPJ_INT32* c1, OPJ_INT32* c2, OPJ_UINT32 n, const OPJ_INT32* p_shift, const OPJ_INT32* p_min, const OPJ_INT32* p_max);
+	/** DC level shift and clamp of a component */
+	void (*dc_shift)(OPJ_INT32* c, OPJ_UINT32 n, OPJ_INT32 p_shift, OPJ_INT32 p_min, OPJ_INT32 p_max);
+	/** rounding, DC level shift and clamp of a component of float samples */
+	void (*dc_shift_real)(OPJ_INT32* c, OPJ_UINT32 n, OPJ_INT32 p_shift, OPJ_INT32 p_min, OPJ_INT32 p_max);
+
+	/** copy of decoded code-block samples to a 5-3 tile component: tiledp = datap / 2 */
+	void (*t1_dequant)(OPJ_INT32* tiledp, OPJ_UINT32 tile_w, const OPJ_INT32* datap, OPJ_UINT32 cblk_w, OPJ_UINT32 cblk_h);
+	/** copy of decoded code-block samples to a 9-7 tile component: tiledp = datap * stepsize */
+	void (*t1_dequant_real)(OPJ_FLOAT32* tiledp, OPJ_UINT32 tile_w, const OPJ_INT32* datap, OPJ_UINT32 cblk_w, OPJ_UINT32 cblk_h, OPJ_FLOAT32 stepsize);
+} opj_kernels_t;
+
+/**
+ * Gets the level of the kernels to use: the highest one supported by the CPU,
+ * capped by the OPJ_CPU_LEVEL environment variable if it is set.
+ *
+ * @return the level (OPJ_CPU_LEVEL_xxx).
+ */
+OPJ_UINT32 opj_cpu_get_level(void);
+
+/**
+ * Fills a table with the kernels of a given level.
+ *
+ * @param p_kernels the table to fill.
+ * @param p_level   level of the kernels (OPJ_CPU_LEVEL_xxx), as given by opj_cpu_get_level().
+ */
+void opj_kernels_init(opj_kernels_t* p_kernels, OPJ_UINT32 p_level);
+
+/*@}*/
+
+#endif /* __OPJ_CPU_H */
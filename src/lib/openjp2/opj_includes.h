@@ -142,8 +142,10 @@ static INLINE long lrintf(float f){
 
 #include "opj_inttypes.h"
 #include "opj_clock.h"
+#include "opj_cpu.h" /* before opj_malloc.h, includes the intrinsics headers */
 #include "opj_malloc.h"
 #include "function_list.h"
+#include "thread.h"
 #include "event.h"
 #include "bio.h"
 #include "cio.h"
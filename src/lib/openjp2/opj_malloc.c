@@ -0,0 +1,255 @@
+/*
+ * The copyright in this software is being made available under the 2-clauses 
+ * BSD License, included below. This software may be subject to other third 
+ * party and contributor rights, including patent rights, and no such rights
+ * are granted under this license.
+ *
+ * Copyright (c) 2005, Herve Drolon, FreeImage Team
+ * Copyright (c) 2007, Callum Lerwick <seg@haxxed.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define OPJ_SKIP_POISON
+#include "opj_includes.h"
+
+/* FIXME: These should be set with cmake tests, but we're currently not requiring use of cmake */
+#ifdef _WIN32
+	/* Someone should tell the mingw people that their malloc.h ought to provide _mm_malloc() */
+	#ifdef __GNUC__
+		#include <mm_malloc.h>
+		#define HAVE_MM_MALLOC
+	#else /* MSVC, Intel C++ */
+		#include <malloc.h>
+		#ifdef _mm_malloc
+			#define HAVE_MM_MALLOC
+		#endif
+	#endif
+#else /* Not _WIN32 */
+	#if defined(__sun)
+		#define HAVE_MEMALIGN
+		extern void* memalign(size_t, size_t);
+	#else
+		/* malloc() only aligns allocations to 16 bytes (Linux x86_64, OSX) or less */
+		#define HAVE_POSIX_MEMALIGN
+		extern int posix_memalign(void**, size_t, size_t);
+	#endif
+#endif
+
+/* ----------------------------------------------------------------------- */
+/* C library allocator, used until opj_set_memory_functions() is called */
+
+static void * opj_default_malloc(OPJ_SIZE_T p_size, void * p_user_data)
+{
+	OPJ_ARG_NOT_USED(p_user_data);
+#ifdef _MSC_VER
+	/* prevent assertion on overflow for MSVC */
+	if (p_size >= (OPJ_SIZE_T)-0x100) {
+		return NULL;
+	}
+#endif
+	return malloc(p_size);
+}
+
+static void * opj_default_calloc(OPJ_SIZE_T p_num, OPJ_SIZE_T p_size, void * p_user_data)
+{
+	OPJ_ARG_NOT_USED(p_user_data);
+#ifdef _MSC_VER
+	/* prevent assertion on overflow for MSVC */
+	if (p_num != 0 && p_num >= (OPJ_SIZE_T)-0x100 / p_size) {
+		return NULL;
+	}
+#endif
+	return calloc(p_num, p_size);
+}
+
+static void * opj_default_realloc(void * p_ptr, OPJ_SIZE_T p_size, void * p_user_data)
+{
+	OPJ_ARG_NOT_USED(p_user_data);
+#ifdef _MSC_VER
+	/* prevent assertion on overflow for MSVC */
+	if (p_size >= (OPJ_SIZE_T)-0x100) {
+		return NULL;
+	}
+#endif
+	return realloc(p_ptr, p_size);
+}
+
+static void opj_default_free(void * p_ptr, void * p_user_data)
+{
+	OPJ_ARG_NOT_USED(p_user_data);
+	free(p_ptr);
+}
+
+static void * opj_default_aligned_malloc(OPJ_SIZE_T p_size, OPJ_SIZE_T p_alignment, void * p_user_data)
+{
+	OPJ_ARG_NOT_USED(p_user_data);
+#if defined(HAVE_MM_MALLOC)
+	return _mm_malloc(p_size, p_alignment);
+#elif defined(HAVE_MEMALIGN)
+	return memalign(p_alignment, p_size);
+#elif defined(HAVE_POSIX_MEMALIGN)
+	{
+		void* l_mem = NULL;
+		if (posix_memalign(&l_mem, p_alignment, p_size)) {
+			return NULL;
+		}
+		return l_mem;
+	}
+#else
+	OPJ_ARG_NOT_USED(p_alignment);
+	return malloc(p_size);
+#endif
+}
+
+static void opj_default_aligned_free(void * p_ptr, void * p_user_data)
+{
+	OPJ_ARG_NOT_USED(p_user_data);
+#if defined(HAVE_MM_MALLOC)
+	_mm_free(p_ptr);
+#else
+	free(p_ptr);
+#endif
+}
+
+/* ----------------------------------------------------------------------- */
+
+static opj_malloc_fn opj_malloc_func = opj_default_malloc;
+static opj_calloc_fn opj_calloc_func = opj_default_calloc;
+static opj_realloc_fn opj_realloc_func = opj_default_realloc;
+static opj_free_fn opj_free_func = opj_default_free;
+static opj_aligned_malloc_fn opj_aligned_malloc_func = opj_default_aligned_malloc;
+static opj_aligned_free_fn opj_aligned_free_func = opj_default_aligned_free;
+static void * opj_memory_user_data = NULL;
+
+/**
+ * Zeroed allocation for the callers that did not give a calloc function.
+ */
+static void * opj_calloc_from_malloc(OPJ_SIZE_T p_num, OPJ_SIZE_T p_size, void * p_user_data)
+{
+	void * l_mem;
+	if (p_size != 0 && p_num > (OPJ_SIZE_T)-1 / p_size) {
+		return NULL;
+	}
+	l_mem = opj_malloc_func(p_num * p_size, p_user_data);
+	if (l_mem) {
+		memset(l_mem, 0, p_num * p_size);
+	}
+	return l_mem;
+}
+
+/**
+ * Aligned allocation for the callers that did not give aligned functions:
+ * the block is carved out of a larger one, whose address is stored just
+ * before the aligned address.
+ */
+static void * opj_aligned_malloc_from_malloc(OPJ_SIZE_T p_size, OPJ_SIZE_T p_alignment, void * p_user_data)
+{
+	OPJ_SIZE_T l_extra = p_alignment - 1U + sizeof(void *);
+	void * l_mem;
+	void ** l_aligned;
+
+	if (p_size > (OPJ_SIZE_T)-1 - l_extra) {
+		return NULL;
+	}
+	l_mem = opj_malloc_func(p_size + l_extra, p_user_data);
+	if (! l_mem) {
+		return NULL;
+	}
+	l_aligned = (void **)(((OPJ_SIZE_T)l_mem + l_extra) & ~(p_alignment - 1U));
+	l_aligned[-1] = l_mem;
+	return l_aligned;
+}
+
+static void opj_aligned_free_from_malloc(void * p_ptr, void * p_user_data)
+{
+	opj_free_func(((void **)p_ptr)[-1], p_user_data);
+}
+
+OPJ_BOOL OPJ_CALLCONV opj_set_memory_functions(opj_malloc_fn p_malloc,
+                                               opj_calloc_fn p_calloc,
+                                               opj_realloc_fn p_realloc,
+                                               opj_free_fn p_free,
+                                               opj_aligned_malloc_fn p_aligned_malloc,
+                                               opj_aligned_free_fn p_aligned_free,
+                                               void * p_user_data)
+{
+	if (! p_malloc && ! p_calloc && ! p_realloc && ! p_free && ! p_aligned_malloc && ! p_aligned_free) {
+		opj_malloc_func = opj_default_malloc;
+		opj_calloc_func = opj_default_calloc;
+		opj_realloc_func = opj_default_realloc;
+		opj_free_func = opj_default_free;
+		opj_aligned_malloc_func = opj_default_aligned_malloc;
+		opj_aligned_free_func = opj_default_aligned_free;
+		opj_memory_user_data = NULL;
+		return OPJ_TRUE;
+	}
+	if (! p_malloc || ! p_realloc || ! p_free || (! p_aligned_malloc != ! p_aligned_free)) {
+		return OPJ_FALSE;
+	}
+
+	opj_malloc_func = p_malloc;
+	opj_calloc_func = p_calloc ? p_calloc : opj_calloc_from_malloc;
+	opj_realloc_func = p_realloc;
+	opj_free_func = p_free;
+	opj_aligned_malloc_func = p_aligned_malloc ? p_aligned_malloc : opj_aligned_malloc_from_malloc;
+	opj_aligned_free_func = p_aligned_free ? p_aligned_free : opj_aligned_free_from_malloc;
+	opj_memory_user_data = p_user_data;
+	return OPJ_TRUE;
+}
+
+/* ----------------------------------------------------------------------- */
+
+void * opj_malloc(size_t size)
+{
+	return opj_malloc_func(size, opj_memory_user_data);
+}
+
+void * opj_calloc(size_t num, size_t size)
+{
+	return opj_calloc_func(num, size, opj_memory_user_data);
+}
+
+void * opj_aligned_malloc(size_t size)
+{
+	return opj_aligned_malloc_func(size, OPJ_ALIGNMENT, opj_memory_user_data);
+}
+
+void opj_aligned_free(void * m)
+{
+	if (m) {
+		opj_aligned_free_func(m, opj_memory_user_data);
+	}
+}
+
+void * opj_realloc(void * m, size_t s)
+{
+	return opj_realloc_func(m, s, opj_memory_user_data);
+}
+
+void opj_free(void * m)
+{
+	if (m) {
+		opj_free_func(m, opj_memory_user_data);
+	}
+}
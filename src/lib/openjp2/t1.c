@@ -49,7 +49,53 @@ static INLINE OPJ_BYTE opj_t1_getctxno_zc(OPJ_UINT32 f, OPJ_UINT32 orient);
 static OPJ_BYTE opj_t1_getctxno_sc(OPJ_UINT32 f);
 static INLINE OPJ_UINT32 opj_t1_getctxno_mag(OPJ_UINT32 f);
 static OPJ_BYTE opj_t1_getspb(OPJ_UINT32 f);
-static OPJ_INT16 opj_t1_getnmsedec_sig(OPJ_UINT32 x, OPJ_UINT32 bitpos);
+/**
+Zero coding context of the row 0 of a decoder flags word, see opj_dec_flag_t
+@param f Flags word of the column, shifted right by 3 bits per row
+@param orient Band orientation
+*/
+static INLINE OPJ_UINT32 opj_t1_dec_getctxno_zc(OPJ_UINT32 f, OPJ_UINT32 orient);
+/**
+Magnitude refinement context of the row 0 of a decoder flags word
+@param f Flags word of the column, shifted right by 3 bits per row
+*/
+static INLINE OPJ_UINT32 opj_t1_dec_getctxno_mag(OPJ_UINT32 f);
+/**
+Index in lut_ctxno_sc_dec and lut_spb_dec of a sample of a stripe column
+@param f Flags word of the column
+@param pf Flags word of the previous column
+@param nf Flags word of the next column
+@param ci Row of the sample in the stripe
+*/
+static INLINE OPJ_UINT32 opj_t1_dec_getsc_lut_index(OPJ_UINT32 f, OPJ_UINT32 pf, OPJ_UINT32 nf, OPJ_UINT32 ci);
+static OPJ_UINT32 opj_t1_dec_getctxno_zc(OPJ_UINT32 f, OPJ_UINT32 orient) {
+	return lut_ctxno_zc_dec[(orient << 9) | (f & T1_SIGMA_NEIGHBOURS)];
+}
+
+OPJ_UINT32 opj_t1_dec_getctxno_mag(OPJ_UINT32 f) {
+	OPJ_UINT32 tmp1 = (f & T1_SIGMA_NEIGHBOURS) ? T1_CTXNO_MAG + 1 : T1_CTXNO_MAG;
+	OPJ_UINT32 tmp2 = (f & T1_MU_0) ? T1_CTXNO_MAG + 2 : tmp1;
+	return (tmp2);
+}
+
+OPJ_UINT32 opj_t1_dec_getsc_lut_index(OPJ_UINT32 f, OPJ_UINT32 pf, OPJ_UINT32 nf, OPJ_UINT32 ci) {
+	/* significance of the north, west, east and south neighbours */
+	OPJ_UINT32 lu = (f >> (3U * ci)) & (T1_SIGMA_N | T1_SIGMA_W | T1_SIGMA_E | T1_SIGMA_S);
+
+	/* signs of the west and east neighbours, in the previous and next columns */
+	lu |= (pf >> (T1_CHI_THIS_I + 3U * ci)) & T1_LUT_SGN_W;
+	lu |= (nf >> (T1_CHI_THIS_I - 2U + 3U * ci)) & T1_LUT_SGN_E;
+	/* signs of the north and south neighbours */
+	if (ci == 0U) {
+		lu |= (f >> (T1_CHI_0_I - 4U)) & T1_LUT_SGN_N;
+	} else {
+		lu |= (f >> (T1_CHI_1_I - 4U + 3U * (ci - 1U))) & T1_LUT_SGN_N;
+	}
+	lu |= (f >> (T1_CHI_2_I - 6U + 3U * ci)) & T1_LUT_SGN_S;
+	return lu;
+}
+
+OPJ_INT16 opj_t1_getnmsedec_sig(OPJ_UINT32 x, OPJ_UINT32 bitpos);
 static OPJ_INT16 opj_t1_getnmsedec_ref(OPJ_UINT32 x, OPJ_UINT32 bitpos);
 static void opj_t1_updateflags(opj_flag_t *flagsp, OPJ_UINT32 s, OPJ_UINT32 stride);
 /**
@@ -78,26 +124,6 @@ static void opj_t1_dec_sigpass_step(opj_t1_t *t1,
                                     OPJ_UINT32 vsc);
 #endif
 
-static INLINE void opj_t1_dec_sigpass_step_raw(
-                opj_t1_t *t1,
-                opj_flag_t *flagsp,
-                OPJ_INT32 *datap,
-                OPJ_INT32 orient,
-                OPJ_INT32 oneplushalf,
-                OPJ_INT32 vsc);
-static INLINE void opj_t1_dec_sigpass_step_mqc(
-                opj_t1_t *t1,
-                opj_flag_t *flagsp,
-                OPJ_INT32 *datap,
-                OPJ_INT32 orient,
-                OPJ_INT32 oneplushalf);
-static INLINE void opj_t1_dec_sigpass_step_mqc_vsc(
-                opj_t1_t *t1,
-                opj_flag_t *flagsp,
-                OPJ_INT32 *datap,
-                OPJ_INT32 orient,
-                OPJ_INT32 oneplushalf,
-                OPJ_INT32 vsc);
 
 
 /**
@@ -116,16 +142,12 @@ Decode significant pass
 static void opj_t1_dec_sigpass_raw(
                 opj_t1_t *t1,
                 OPJ_INT32 bpno,
-                OPJ_INT32 orient,
                 OPJ_INT32 cblksty);
 static void opj_t1_dec_sigpass_mqc(
                 opj_t1_t *t1,
                 OPJ_INT32 bpno,
-                OPJ_INT32 orient);
-static void opj_t1_dec_sigpass_mqc_vsc(
-                opj_t1_t *t1,
-                OPJ_INT32 bpno,
-                OPJ_INT32 orient);
+                OPJ_INT32 orient,
+                OPJ_UINT32 vsc);
 
 
 
@@ -155,13 +177,9 @@ static void opj_t1_enc_refpass( opj_t1_t *t1,
 Decode refinement pass
 */
 static void opj_t1_dec_refpass_raw(
-                opj_t1_t *t1,
-                OPJ_INT32 bpno,
-                OPJ_INT32 cblksty);
-static void opj_t1_dec_refpass_mqc(
                 opj_t1_t *t1,
                 OPJ_INT32 bpno);
-static void opj_t1_dec_refpass_mqc_vsc(
+static void opj_t1_dec_refpass_mqc(
                 opj_t1_t *t1,
                 OPJ_INT32 bpno);
 
@@ -179,26 +197,6 @@ static void opj_t1_dec_refpass_step(opj_t1_t *t1,
                                     OPJ_UINT32 vsc);
 #endif
 
-static INLINE void  opj_t1_dec_refpass_step_raw(
-                opj_t1_t *t1,
-                opj_flag_t *flagsp,
-                OPJ_INT32 *datap,
-                OPJ_INT32 poshalf,
-                OPJ_INT32 neghalf,
-                OPJ_INT32 vsc);
-static INLINE void opj_t1_dec_refpass_step_mqc(
-                opj_t1_t *t1,
-                opj_flag_t *flagsp,
-                OPJ_INT32 *datap,
-                OPJ_INT32 poshalf,
-                OPJ_INT32 neghalf);
-static INLINE void opj_t1_dec_refpass_step_mqc_vsc(
-                opj_t1_t *t1,
-                opj_flag_t *flagsp,
-                OPJ_INT32 *datap,
-                OPJ_INT32 poshalf,
-                OPJ_INT32 neghalf,
-                OPJ_INT32 vsc);
 
 
 
@@ -216,29 +214,6 @@ static void opj_t1_enc_clnpass_step(
 		OPJ_UINT32 partial,
 		OPJ_UINT32 vsc);
 /**
-Decode clean-up pass
-*/
-static void opj_t1_dec_clnpass_step_partial(
-		opj_t1_t *t1,
-		opj_flag_t *flagsp,
-		OPJ_INT32 *datap,
-		OPJ_INT32 orient,
-		OPJ_INT32 oneplushalf);
-static void opj_t1_dec_clnpass_step(
-		opj_t1_t *t1,
-		opj_flag_t *flagsp,
-		OPJ_INT32 *datap,
-		OPJ_INT32 orient,
-		OPJ_INT32 oneplushalf);
-static void opj_t1_dec_clnpass_step_vsc(
-		opj_t1_t *t1,
-		opj_flag_t *flagsp,
-		OPJ_INT32 *datap,
-		OPJ_INT32 orient,
-		OPJ_INT32 oneplushalf,
-		OPJ_INT32 partial,
-		OPJ_INT32 vsc);
-/**
 Encode clean-up pass
 */
 static void opj_t1_enc_clnpass(
@@ -277,7 +252,6 @@ static void opj_t1_encode_cblk( opj_t1_t *t1,
                                 OPJ_FLOAT64 stepsize,
                                 OPJ_UINT32 cblksty,
                                 OPJ_UINT32 numcomps,
-                                opj_tcd_tile_t * tile,
                                 const OPJ_FLOAT64 * mct_norms,
                                 OPJ_UINT32 mct_numcomps);
 
@@ -299,12 +273,136 @@ OPJ_BOOL opj_t1_allocate_buffers(   opj_t1_t *t1,
                                     OPJ_UINT32 w,
                                     OPJ_UINT32 h);
 
+/**
+Copies the decoded samples of a code-block to a 5-3 tile component, dividing them by 2
+@param tiledp First sample of the code-block in the tile component
+@param tile_w Width of the tile component
+@param datap Decoded samples
+@param cblk_w Width of the code-block
+@param cblk_h Height of the code-block
+*/
+static void opj_t1_dequant(OPJ_INT32* restrict tiledp, OPJ_UINT32 tile_w, const OPJ_INT32* restrict datap, OPJ_UINT32 cblk_w, OPJ_UINT32 cblk_h);
+/**
+Copies the decoded samples of a code-block to a 9-7 tile component, multiplying them by the quantization step size
+@param tiledp First sample of the code-block in the tile component
+@param tile_w Width of the tile component
+@param datap Decoded samples
+@param cblk_w Width of the code-block
+@param cblk_h Height of the code-block
+@param stepsize Quantization step size of the band
+*/
+static void opj_t1_dequant_real(OPJ_FLOAT32* restrict tiledp, OPJ_UINT32 tile_w, const OPJ_INT32* restrict datap, OPJ_UINT32 cblk_w, OPJ_UINT32 cblk_h, OPJ_FLOAT32 stepsize);
+#ifdef OPJ_HAVE_X86_KERNELS
+static void opj_t1_dequant_sse2(OPJ_INT32* restrict tiledp, OPJ_UINT32 tile_w, const OPJ_INT32* restrict datap, OPJ_UINT32 cblk_w, OPJ_UINT32 cblk_h);
+static void opj_t1_dequant_real_sse2(OPJ_FLOAT32* restrict tiledp, OPJ_UINT32 tile_w, const OPJ_INT32* restrict datap, OPJ_UINT32 cblk_w, OPJ_UINT32 cblk_h, OPJ_FLOAT32 stepsize);
+static void opj_t1_dequant_avx2(OPJ_INT32* restrict tiledp, OPJ_UINT32 tile_w, const OPJ_INT32* restrict datap, OPJ_UINT32 cblk_w, OPJ_UINT32 cblk_h);
+static void opj_t1_dequant_real_avx2(OPJ_FLOAT32* restrict tiledp, OPJ_UINT32 tile_w, const OPJ_INT32* restrict datap, OPJ_UINT32 cblk_w, OPJ_UINT32 cblk_h, OPJ_FLOAT32 stepsize);
+#endif
+
 /*@}*/
 
 /*@}*/
 
 /* ----------------------------------------------------------------------- */
 
+/*
+The MQ decoding passes keep the decoder registers in local variables
+(curctx, a, c, ct, bp, see opj_mqc_load_dec()), and decode their samples
+with the macros below, which work on these variables. The flags word of
+the current stripe column is also held by the caller, in the flags argument,
+and ci is the row of the sample in the stripe.
+*/
+
+/** Set the current context of the MQ decoder registers held in locals */
+#define opj_t1_setcurctx(curctx, ctxno) curctx = &(mqc)->ctxs[(OPJ_UINT32)(ctxno)]
+
+/**
+Mark the sample of row ci as significant with sign s, and update the flags of its neighbours.
+In vertically causal mode, the stripe above is not updated.
+*/
+#define opj_t1_dec_update_flags_macro(flags, flagsp, ci, s, flags_stride, vsc) \
+	{ \
+		(flagsp)[-1] |= T1_SIGMA_5 << (3U * (ci)); \
+		(flagsp)[1] |= T1_SIGMA_3 << (3U * (ci)); \
+		flags |= (((OPJ_UINT32)(s) << T1_CHI_1_I) | T1_SIGMA_4) << (3U * (ci)); \
+		if ((ci) == 0U && !(vsc)) { \
+			opj_dec_flag_t *l_north = (flagsp) - (flags_stride); \
+			*l_north |= ((OPJ_UINT32)(s) << T1_CHI_5_I) | T1_SIGMA_16; \
+			l_north[-1] |= T1_SIGMA_17; \
+			l_north[1] |= T1_SIGMA_15; \
+		} \
+		if ((ci) == 3U) { \
+			opj_dec_flag_t *l_south = (flagsp) + (flags_stride); \
+			*l_south |= ((OPJ_UINT32)(s) << T1_CHI_0_I) | T1_SIGMA_1; \
+			l_south[-1] |= T1_SIGMA_2; \
+			l_south[1] |= T1_SIGMA_0; \
+		} \
+	}
+
+/**
+Decode one sample of the significance propagation pass
+*/
+#define opj_t1_dec_sigpass_step_mqc_macro(flags, flagsp, flags_stride, datap, ci, orient, oneplushalf, vsc, curctx, a, c, ct, bp) \
+	{ \
+		if ((flags & ((T1_SIGMA_THIS | T1_PI_THIS) << (3U * (ci)))) == 0U && \
+				(flags & (T1_SIGMA_NEIGHBOURS << (3U * (ci)))) != 0U) { \
+			OPJ_INT32 l_v; \
+			opj_t1_setcurctx(curctx, opj_t1_dec_getctxno_zc(flags >> (3U * (ci)), (OPJ_UINT32)(orient))); \
+			opj_mqc_decode_macro(l_v, curctx, a, c, ct, bp); \
+			if (l_v) { \
+				OPJ_UINT32 l_lu = opj_t1_dec_getsc_lut_index(flags, (flagsp)[-1], (flagsp)[1], ci); \
+				opj_t1_setcurctx(curctx, lut_ctxno_sc_dec[l_lu]); \
+				opj_mqc_decode_macro(l_v, curctx, a, c, ct, bp); \
+				l_v ^= lut_spb_dec[l_lu]; \
+				*(datap) = l_v ? -(oneplushalf) : (oneplushalf); \
+				opj_t1_dec_update_flags_macro(flags, flagsp, ci, l_v, flags_stride, vsc); \
+			} \
+			flags |= T1_PI_THIS << (3U * (ci)); \
+		} \
+	}
+
+/**
+Decode one sample of the magnitude refinement pass
+*/
+#define opj_t1_dec_refpass_step_mqc_macro(flags, datap, ci, poshalf, neghalf, curctx, a, c, ct, bp) \
+	{ \
+		if ((flags & ((T1_SIGMA_THIS | T1_PI_THIS) << (3U * (ci)))) == (T1_SIGMA_THIS << (3U * (ci)))) { \
+			OPJ_INT32 l_v, l_t; \
+			opj_t1_setcurctx(curctx, opj_t1_dec_getctxno_mag(flags >> (3U * (ci)))); \
+			opj_mqc_decode_macro(l_v, curctx, a, c, ct, bp); \
+			l_t = l_v ? (poshalf) : (neghalf); \
+			*(datap) += *(datap) < 0 ? -l_t : l_t; \
+			flags |= T1_MU_THIS << (3U * (ci)); \
+		} \
+	}
+
+/**
+Decode one sample of the clean-up pass. The visited flags are reset by the caller.
+@param partial Set for the first sample after a run-length, whose significance is already known
+*/
+#define opj_t1_dec_clnpass_step_mqc_macro(partial, flags, flagsp, flags_stride, datap, ci, orient, oneplushalf, vsc, curctx, a, c, ct, bp) \
+	{ \
+		OPJ_INT32 l_v = 1; \
+		if (!(partial)) { \
+			if (flags & ((T1_SIGMA_THIS | T1_PI_THIS) << (3U * (ci)))) { \
+				l_v = 0; \
+			} else { \
+				opj_t1_setcurctx(curctx, opj_t1_dec_getctxno_zc(flags >> (3U * (ci)), (OPJ_UINT32)(orient))); \
+				opj_mqc_decode_macro(l_v, curctx, a, c, ct, bp); \
+			} \
+		} \
+		if (l_v) { \
+			OPJ_UINT32 l_lu = opj_t1_dec_getsc_lut_index(flags, (flagsp)[-1], (flagsp)[1], ci); \
+			opj_t1_setcurctx(curctx, lut_ctxno_sc_dec[l_lu]); \
+			opj_mqc_decode_macro(l_v, curctx, a, c, ct, bp); \
+			l_v ^= lut_spb_dec[l_lu]; \
+			*(datap) = l_v ? -(oneplushalf) : (oneplushalf); \
+			opj_t1_dec_update_flags_macro(flags, flagsp, ci, l_v, flags_stride, vsc); \
+		} \
+	}
+
+/* ----------------------------------------------------------------------- */
+
 OPJ_BYTE opj_t1_getctxno_zc(OPJ_UINT32 f, OPJ_UINT32 orient) {
 	return lut_ctxno_zc[(orient << 8) | (f & T1_SIG_OTH)];
 }
@@ -404,78 +502,6 @@ void opj_t1_enc_sigpass_step(   opj_t1_t *t1,
 }
 
 
-static INLINE void opj_t1_dec_sigpass_step_raw(
-                opj_t1_t *t1,
-                opj_flag_t *flagsp,
-                OPJ_INT32 *datap,
-                OPJ_INT32 orient,
-                OPJ_INT32 oneplushalf,
-                OPJ_INT32 vsc)
-{
-        OPJ_INT32 v, flag;
-        opj_raw_t *raw = t1->raw;       /* RAW component */
-        OPJ_ARG_NOT_USED(orient);
-       
-        flag = vsc ? ((*flagsp) & (~(T1_SIG_S | T1_SIG_SE | T1_SIG_SW | T1_SGN_S))) : (*flagsp);
-        if ((flag & T1_SIG_OTH) && !(flag & (T1_SIG | T1_VISIT))) {
-                        if (opj_raw_decode(raw)) {
-                                v = (OPJ_INT32)opj_raw_decode(raw);    /* ESSAI */
-                                *datap = v ? -oneplushalf : oneplushalf;
-                                opj_t1_updateflags(flagsp, (OPJ_UINT32)v, t1->flags_stride);
-                        }
-                *flagsp |= T1_VISIT;
-        }
-}      
-
-INLINE void opj_t1_dec_sigpass_step_mqc(
-                opj_t1_t *t1,
-                opj_flag_t *flagsp,
-                OPJ_INT32 *datap,
-                OPJ_INT32 orient,
-                OPJ_INT32 oneplushalf)
-{
-        OPJ_INT32 v, flag;
-       
-        opj_mqc_t *mqc = t1->mqc;       /* MQC component */
-       
-        flag = *flagsp;
-        if ((flag & T1_SIG_OTH) && !(flag & (T1_SIG | T1_VISIT))) {
-                        opj_mqc_setcurctx(mqc, opj_t1_getctxno_zc((OPJ_UINT32)flag, (OPJ_UINT32)orient));
-                        if (opj_mqc_decode(mqc)) {
-                                opj_mqc_setcurctx(mqc, opj_t1_getctxno_sc((OPJ_UINT32)flag));
-                                v = opj_mqc_decode(mqc) ^ opj_t1_getspb((OPJ_UINT32)flag);
-                                *datap = v ? -oneplushalf : oneplushalf;
-                                opj_t1_updateflags(flagsp, (OPJ_UINT32)v, t1->flags_stride);
-                        }
-                *flagsp |= T1_VISIT;
-        }
-}                               /* VSC and  BYPASS by Antonin */
-
-INLINE void opj_t1_dec_sigpass_step_mqc_vsc(
-                opj_t1_t *t1,
-                opj_flag_t *flagsp,
-                OPJ_INT32 *datap,
-                OPJ_INT32 orient,
-                OPJ_INT32 oneplushalf,
-                OPJ_INT32 vsc)
-{
-        OPJ_INT32 v, flag;
-       
-        opj_mqc_t *mqc = t1->mqc;       /* MQC component */
-       
-        flag = vsc ? ((*flagsp) & (~(T1_SIG_S | T1_SIG_SE | T1_SIG_SW | T1_SGN_S))) : (*flagsp);
-        if ((flag & T1_SIG_OTH) && !(flag & (T1_SIG | T1_VISIT))) {
-                opj_mqc_setcurctx(mqc, opj_t1_getctxno_zc((OPJ_UINT32)flag, (OPJ_UINT32)orient));
-                if (opj_mqc_decode(mqc)) {
-                        opj_mqc_setcurctx(mqc, opj_t1_getctxno_sc((OPJ_UINT32)flag));
-                        v = opj_mqc_decode(mqc) ^ opj_t1_getspb((OPJ_UINT32)flag);
-                        *datap = v ? -oneplushalf : oneplushalf;
-                        opj_t1_updateflags(flagsp, (OPJ_UINT32)v, t1->flags_stride);
-                }
-                *flagsp |= T1_VISIT;
-        }
-}                               /* VSC and  BYPASS by Antonin */
-
 
 
 void opj_t1_enc_sigpass(opj_t1_t *t1,
@@ -513,26 +539,37 @@ void opj_t1_enc_sigpass(opj_t1_t *t1,
 void opj_t1_dec_sigpass_raw(
                 opj_t1_t *t1,
                 OPJ_INT32 bpno,
-                OPJ_INT32 orient,
                 OPJ_INT32 cblksty)
 {
-        OPJ_INT32 one, half, oneplushalf, vsc;
-        OPJ_UINT32 i, j, k; 
+        OPJ_INT32 one, half, oneplushalf;
+        OPJ_UINT32 i, j, k;
+        OPJ_INT32 *data1 = t1->data;
+        opj_dec_flag_t *flagsp = &t1->dec_flags[t1->flags_stride + 1];
+        const OPJ_UINT32 l_w = t1->w;
+        const OPJ_UINT32 vsc = (OPJ_UINT32)cblksty & J2K_CCP_CBLKSTY_VSC;
+        opj_raw_t *raw = t1->raw;       /* RAW component */
+
         one = 1 << bpno;
         half = one >> 1;
         oneplushalf = one | half;
-        for (k = 0; k < t1->h; k += 4) {
-                for (i = 0; i < t1->w; ++i) {
-                        for (j = k; j < k + 4 && j < t1->h; ++j) {
-                                vsc = ((cblksty & J2K_CCP_CBLKSTY_VSC) && (j == k + 3 || j == t1->h - 1)) ? 1 : 0;
-                                opj_t1_dec_sigpass_step_raw(
-                                                t1,
-                                                &t1->flags[((j+1) * t1->flags_stride) + i + 1],
-                                                &t1->data[(j * t1->w) + i],
-                                                orient,
-                                                oneplushalf,
-                                                vsc);
+        for (k = 0; k < t1->h; k += 4, flagsp += 2, data1 += 3 * l_w) {
+                for (i = 0; i < l_w; ++i, ++flagsp, ++data1) {
+                        opj_dec_flag_t flags = *flagsp;
+                        if (flags == 0U) {
+                                continue;
                         }
+                        for (j = 0; j < 4 && k + j < t1->h; ++j) {
+                                if ((flags & ((T1_SIGMA_THIS | T1_PI_THIS) << (3U * j))) == 0U &&
+                                                (flags & (T1_SIGMA_NEIGHBOURS << (3U * j))) != 0U) {
+                                        if (opj_raw_decode(raw)) {
+                                                OPJ_UINT32 v = opj_raw_decode(raw);    /* ESSAI */
+                                                data1[j * l_w] = v ? -oneplushalf : oneplushalf;
+                                                opj_t1_dec_update_flags_macro(flags, flagsp, j, v, t1->flags_stride, vsc);
+                                        }
+                                        flags |= T1_PI_THIS << (3U * j);
+                                }
+                        }
+                        *flagsp = flags;
                 }
         }
 }                               /* VSC and  BYPASS by Antonin */
@@ -540,74 +577,53 @@ void opj_t1_dec_sigpass_raw(
 void opj_t1_dec_sigpass_mqc(
                 opj_t1_t *t1,
                 OPJ_INT32 bpno,
-                OPJ_INT32 orient)
+                OPJ_INT32 orient,
+                OPJ_UINT32 vsc)
 {
         OPJ_INT32 one, half, oneplushalf;
         OPJ_UINT32 i, j, k;
         OPJ_INT32 *data1 = t1->data;
-        opj_flag_t *flags1 = &t1->flags[1];
+        opj_dec_flag_t *flagsp = &t1->dec_flags[t1->flags_stride + 1];
+        const OPJ_UINT32 l_w = t1->w;
+        const OPJ_UINT32 l_flags_stride = t1->flags_stride;
+        opj_mqc_t *mqc = t1->mqc;       /* MQC component */
+        opj_mqc_state_t **curctx;
+        OPJ_UINT32 a, c, ct;
+        OPJ_BYTE *bp;
+
+        opj_mqc_load_dec(mqc, curctx, a, c, ct, bp);
         one = 1 << bpno;
         half = one >> 1;
         oneplushalf = one | half;
-        for (k = 0; k < (t1->h & ~3u); k += 4) {
-                for (i = 0; i < t1->w; ++i) {
-                        OPJ_INT32 *data2 = data1 + i;
-                        opj_flag_t *flags2 = flags1 + i;
-                        flags2 += t1->flags_stride;
-                        opj_t1_dec_sigpass_step_mqc(t1, flags2, data2, orient, oneplushalf);
-                        data2 += t1->w;
-                        flags2 += t1->flags_stride;
-                        opj_t1_dec_sigpass_step_mqc(t1, flags2, data2, orient, oneplushalf);
-                        data2 += t1->w;
-                        flags2 += t1->flags_stride;
-                        opj_t1_dec_sigpass_step_mqc(t1, flags2, data2, orient, oneplushalf);
-                        data2 += t1->w;
-                        flags2 += t1->flags_stride;
-                        opj_t1_dec_sigpass_step_mqc(t1, flags2, data2, orient, oneplushalf);
-                        data2 += t1->w;
-                }
-                data1 += t1->w << 2;
-                flags1 += t1->flags_stride << 2;
-        }
-        for (i = 0; i < t1->w; ++i) {
-                OPJ_INT32 *data2 = data1 + i;
-                opj_flag_t *flags2 = flags1 + i;
-                for (j = k; j < t1->h; ++j) {
-                        flags2 += t1->flags_stride;
-                        opj_t1_dec_sigpass_step_mqc(t1, flags2, data2, orient, oneplushalf);
-                        data2 += t1->w;
+        for (k = 0; k < (t1->h & ~3u); k += 4, flagsp += 2, data1 += 3 * l_w) {
+                for (i = 0; i < l_w; ++i, ++flagsp, ++data1) {
+                        opj_dec_flag_t flags = *flagsp;
+                        if (flags == 0U) {
+                                continue;
+                        }
+                        opj_t1_dec_sigpass_step_mqc_macro(flags, flagsp, l_flags_stride, data1, 0U, orient, oneplushalf, vsc, curctx, a, c, ct, bp);
+                        opj_t1_dec_sigpass_step_mqc_macro(flags, flagsp, l_flags_stride, data1 + l_w, 1U, orient, oneplushalf, vsc, curctx, a, c, ct, bp);
+                        opj_t1_dec_sigpass_step_mqc_macro(flags, flagsp, l_flags_stride, data1 + 2 * l_w, 2U, orient, oneplushalf, vsc, curctx, a, c, ct, bp);
+                        opj_t1_dec_sigpass_step_mqc_macro(flags, flagsp, l_flags_stride, data1 + 3 * l_w, 3U, orient, oneplushalf, vsc, curctx, a, c, ct, bp);
+                        *flagsp = flags;
                 }
         }
-}                               /* VSC and  BYPASS by Antonin */
-
-void opj_t1_dec_sigpass_mqc_vsc(
-                opj_t1_t *t1,
-                OPJ_INT32 bpno,
-                OPJ_INT32 orient)
-{
-        OPJ_INT32 one, half, oneplushalf, vsc;
-        OPJ_UINT32 i, j, k;
-        one = 1 << bpno;
-        half = one >> 1;
-        oneplushalf = one | half;
-        for (k = 0; k < t1->h; k += 4) {
-                for (i = 0; i < t1->w; ++i) {
-                        for (j = k; j < k + 4 && j < t1->h; ++j) {
-                                vsc = (j == k + 3 || j == t1->h - 1) ? 1 : 0;
-                                opj_t1_dec_sigpass_step_mqc_vsc(
-                                                t1,
-                                                &t1->flags[((j+1) * t1->flags_stride) + i + 1],
-                                                &t1->data[(j * t1->w) + i],
-                                                orient,
-                                                oneplushalf,
-                                                vsc);
+        if (k < t1->h) {
+                for (i = 0; i < l_w; ++i, ++flagsp, ++data1) {
+                        opj_dec_flag_t flags = *flagsp;
+                        for (j = 0; j < t1->h - k; ++j) {
+                                opj_t1_dec_sigpass_step_mqc_macro(flags, flagsp, l_flags_stride, data1 + j * l_w, j, orient, oneplushalf, vsc, curctx, a, c, ct, bp);
                         }
+                        *flagsp = flags;
                 }
         }
+        opj_mqc_store_dec(mqc, curctx, a, c, ct, bp);
 }                               /* VSC and  BYPASS by Antonin */
 
 
 
+
+
 void opj_t1_enc_refpass_step(   opj_t1_t *t1,
                                 opj_flag_t *flagsp,
                                 OPJ_INT32 *datap,
@@ -636,69 +652,6 @@ void opj_t1_enc_refpass_step(   opj_t1_t *t1,
 	}
 }
 
-INLINE void opj_t1_dec_refpass_step_raw(
-                opj_t1_t *t1,
-                opj_flag_t *flagsp,
-                OPJ_INT32 *datap,
-                OPJ_INT32 poshalf,
-                OPJ_INT32 neghalf,
-                OPJ_INT32 vsc)
-{
-        OPJ_INT32 v, t, flag;
-       
-        opj_raw_t *raw = t1->raw;       /* RAW component */
-       
-        flag = vsc ? ((*flagsp) & (~(T1_SIG_S | T1_SIG_SE | T1_SIG_SW | T1_SGN_S))) : (*flagsp);
-        if ((flag & (T1_SIG | T1_VISIT)) == T1_SIG) {
-                        v = (OPJ_INT32)opj_raw_decode(raw);
-                t = v ? poshalf : neghalf;
-                *datap += *datap < 0 ? -t : t;
-                *flagsp |= T1_REFINE;
-        }
-}                               /* VSC and  BYPASS by Antonin  */
-
-INLINE void opj_t1_dec_refpass_step_mqc(
-                opj_t1_t *t1,
-                opj_flag_t *flagsp,
-                OPJ_INT32 *datap,
-                OPJ_INT32 poshalf,
-                OPJ_INT32 neghalf)
-{
-        OPJ_INT32 v, t, flag;
-       
-        opj_mqc_t *mqc = t1->mqc;       /* MQC component */
-       
-        flag = *flagsp;
-        if ((flag & (T1_SIG | T1_VISIT)) == T1_SIG) {
-                opj_mqc_setcurctx(mqc, opj_t1_getctxno_mag((OPJ_UINT32)flag));      /* ESSAI */
-                        v = opj_mqc_decode(mqc);
-                t = v ? poshalf : neghalf;
-                *datap += *datap < 0 ? -t : t;
-                *flagsp |= T1_REFINE;
-                }
-}                               /* VSC and  BYPASS by Antonin  */
-
-INLINE void opj_t1_dec_refpass_step_mqc_vsc(
-                opj_t1_t *t1,
-                opj_flag_t *flagsp,
-                OPJ_INT32 *datap,
-                OPJ_INT32 poshalf,
-                OPJ_INT32 neghalf,
-                OPJ_INT32 vsc)
-{
-        OPJ_INT32 v, t, flag;
-       
-        opj_mqc_t *mqc = t1->mqc;       /* MQC component */
-       
-        flag = vsc ? ((*flagsp) & (~(T1_SIG_S | T1_SIG_SE | T1_SIG_SW | T1_SGN_S))) : (*flagsp);
-        if ((flag & (T1_SIG | T1_VISIT)) == T1_SIG) {
-                opj_mqc_setcurctx(mqc, opj_t1_getctxno_mag((OPJ_UINT32)flag));      /* ESSAI */
-                v = opj_mqc_decode(mqc);
-                t = v ? poshalf : neghalf;
-                *datap += *datap < 0 ? -t : t;
-                *flagsp |= T1_REFINE;
-        }
-}                               /* VSC and  BYPASS by Antonin  */
 
 
 void opj_t1_enc_refpass(
@@ -733,27 +686,33 @@ void opj_t1_enc_refpass(
 
 void opj_t1_dec_refpass_raw(
                 opj_t1_t *t1,
-                OPJ_INT32 bpno,
-                OPJ_INT32 cblksty)
+                OPJ_INT32 bpno)
 {
         OPJ_INT32 one, poshalf, neghalf;
         OPJ_UINT32 i, j, k;
-        OPJ_INT32 vsc;
+        OPJ_INT32 *data1 = t1->data;
+        opj_dec_flag_t *flagsp = &t1->dec_flags[t1->flags_stride + 1];
+        const OPJ_UINT32 l_w = t1->w;
+        opj_raw_t *raw = t1->raw;       /* RAW component */
+
         one = 1 << bpno;
         poshalf = one >> 1;
         neghalf = bpno > 0 ? -poshalf : -1;
-        for (k = 0; k < t1->h; k += 4) {
-                for (i = 0; i < t1->w; ++i) {
-                        for (j = k; j < k + 4 && j < t1->h; ++j) {
-                                vsc = ((cblksty & J2K_CCP_CBLKSTY_VSC) && (j == k + 3 || j == t1->h - 1)) ? 1 : 0;
-                                opj_t1_dec_refpass_step_raw(
-                                                t1,
-                                                &t1->flags[((j+1) * t1->flags_stride) + i + 1],
-                                                &t1->data[(j * t1->w) + i],
-                                                poshalf,
-                                                neghalf,
-                                                vsc);
+        for (k = 0; k < t1->h; k += 4, flagsp += 2, data1 += 3 * l_w) {
+                for (i = 0; i < l_w; ++i, ++flagsp, ++data1) {
+                        opj_dec_flag_t flags = *flagsp;
+                        if (flags == 0U) {
+                                continue;
+                        }
+                        for (j = 0; j < 4 && k + j < t1->h; ++j) {
+                                if ((flags & ((T1_SIGMA_THIS | T1_PI_THIS) << (3U * j))) == (T1_SIGMA_THIS << (3U * j))) {
+                                        OPJ_INT32 *datap = &data1[j * l_w];
+                                        OPJ_INT32 t = opj_raw_decode(raw) ? poshalf : neghalf;
+                                        *datap += *datap < 0 ? -t : t;
+                                        flags |= T1_MU_THIS << (3U * j);
+                                }
                         }
+                        *flagsp = flags;
                 }
         }
 }                               /* VSC and  BYPASS by Antonin */
@@ -765,68 +724,45 @@ void opj_t1_dec_refpass_mqc(
         OPJ_INT32 one, poshalf, neghalf;
         OPJ_UINT32 i, j, k;
         OPJ_INT32 *data1 = t1->data;
-        opj_flag_t *flags1 = &t1->flags[1];
+        opj_dec_flag_t *flagsp = &t1->dec_flags[t1->flags_stride + 1];
+        const OPJ_UINT32 l_w = t1->w;
+        opj_mqc_t *mqc = t1->mqc;       /* MQC component */
+        opj_mqc_state_t **curctx;
+        OPJ_UINT32 a, c, ct;
+        OPJ_BYTE *bp;
+
+        opj_mqc_load_dec(mqc, curctx, a, c, ct, bp);
         one = 1 << bpno;
         poshalf = one >> 1;
         neghalf = bpno > 0 ? -poshalf : -1;
-        for (k = 0; k < (t1->h & ~3u); k += 4) {
-                for (i = 0; i < t1->w; ++i) {
-                        OPJ_INT32 *data2 = data1 + i;
-                        opj_flag_t *flags2 = flags1 + i;
-                        flags2 += t1->flags_stride;
-                        opj_t1_dec_refpass_step_mqc(t1, flags2, data2, poshalf, neghalf);
-                        data2 += t1->w;
-                        flags2 += t1->flags_stride;
-                        opj_t1_dec_refpass_step_mqc(t1, flags2, data2, poshalf, neghalf);
-                        data2 += t1->w;
-                        flags2 += t1->flags_stride;
-                        opj_t1_dec_refpass_step_mqc(t1, flags2, data2, poshalf, neghalf);
-                        data2 += t1->w;
-                        flags2 += t1->flags_stride;
-                        opj_t1_dec_refpass_step_mqc(t1, flags2, data2, poshalf, neghalf);
-                        data2 += t1->w;
-                }
-                data1 += t1->w << 2;
-                flags1 += t1->flags_stride << 2;
-        }
-        for (i = 0; i < t1->w; ++i) {
-                OPJ_INT32 *data2 = data1 + i;
-                opj_flag_t *flags2 = flags1 + i;
-                for (j = k; j < t1->h; ++j) {
-                        flags2 += t1->flags_stride;
-                        opj_t1_dec_refpass_step_mqc(t1, flags2, data2, poshalf, neghalf);
-                        data2 += t1->w;
+        for (k = 0; k < (t1->h & ~3u); k += 4, flagsp += 2, data1 += 3 * l_w) {
+                for (i = 0; i < l_w; ++i, ++flagsp, ++data1) {
+                        opj_dec_flag_t flags = *flagsp;
+                        if (flags == 0U) {
+                                continue;
+                        }
+                        opj_t1_dec_refpass_step_mqc_macro(flags, data1, 0U, poshalf, neghalf, curctx, a, c, ct, bp);
+                        opj_t1_dec_refpass_step_mqc_macro(flags, data1 + l_w, 1U, poshalf, neghalf, curctx, a, c, ct, bp);
+                        opj_t1_dec_refpass_step_mqc_macro(flags, data1 + 2 * l_w, 2U, poshalf, neghalf, curctx, a, c, ct, bp);
+                        opj_t1_dec_refpass_step_mqc_macro(flags, data1 + 3 * l_w, 3U, poshalf, neghalf, curctx, a, c, ct, bp);
+                        *flagsp = flags;
                 }
         }
-}                               /* VSC and  BYPASS by Antonin */
-
-void opj_t1_dec_refpass_mqc_vsc(
-                opj_t1_t *t1,
-                OPJ_INT32 bpno)
-{
-        OPJ_INT32 one, poshalf, neghalf;
-        OPJ_UINT32 i, j, k;
-        OPJ_INT32 vsc;
-        one = 1 << bpno;
-        poshalf = one >> 1;
-        neghalf = bpno > 0 ? -poshalf : -1;
-        for (k = 0; k < t1->h; k += 4) {
-                for (i = 0; i < t1->w; ++i) {
-                        for (j = k; j < k + 4 && j < t1->h; ++j) {
-                                vsc = ((j == k + 3 || j == t1->h - 1)) ? 1 : 0;
-                                opj_t1_dec_refpass_step_mqc_vsc(
-                                                t1,
-                                                &t1->flags[((j+1) * t1->flags_stride) + i + 1],
-                                                &t1->data[(j * t1->w) + i],
-                                                poshalf,
-                                                neghalf,
-                                                vsc);
+        if (k < t1->h) {
+                for (i = 0; i < l_w; ++i, ++flagsp, ++data1) {
+                        opj_dec_flag_t flags = *flagsp;
+                        for (j = 0; j < t1->h - k; ++j) {
+                                opj_t1_dec_refpass_step_mqc_macro(flags, data1 + j * l_w, j, poshalf, neghalf, curctx, a, c, ct, bp);
                         }
+                        *flagsp = flags;
                 }
         }
+        opj_mqc_store_dec(mqc, curctx, a, c, ct, bp);
 }                               /* VSC and  BYPASS by Antonin */
 
 
+
+
 void opj_t1_enc_clnpass_step(
 		opj_t1_t *t1,
 		opj_flag_t *flagsp,
@@ -863,80 +799,6 @@ LABEL_PARTIAL:
 	*flagsp &= ~T1_VISIT;
 }
 
-static void opj_t1_dec_clnpass_step_partial(
-		opj_t1_t *t1,
-		opj_flag_t *flagsp,
-		OPJ_INT32 *datap,
-		OPJ_INT32 orient,
-		OPJ_INT32 oneplushalf)
-{
-	OPJ_INT32 v, flag;
-	opj_mqc_t *mqc = t1->mqc;	/* MQC component */
-	
-	OPJ_ARG_NOT_USED(orient);
-	
-	flag = *flagsp;
-	opj_mqc_setcurctx(mqc, opj_t1_getctxno_sc((OPJ_UINT32)flag));
-	v = opj_mqc_decode(mqc) ^ opj_t1_getspb((OPJ_UINT32)flag);
-	*datap = v ? -oneplushalf : oneplushalf;
-	opj_t1_updateflags(flagsp, (OPJ_UINT32)v, t1->flags_stride);
-	*flagsp &= ~T1_VISIT;
-}				/* VSC and  BYPASS by Antonin */
-
-static void opj_t1_dec_clnpass_step(
-		opj_t1_t *t1,
-		opj_flag_t *flagsp,
-		OPJ_INT32 *datap,
-		OPJ_INT32 orient,
-		OPJ_INT32 oneplushalf)
-{
-	OPJ_INT32 v, flag;
-	
-	opj_mqc_t *mqc = t1->mqc;	/* MQC component */
-	
-	flag = *flagsp;
-	if (!(flag & (T1_SIG | T1_VISIT))) {
-		opj_mqc_setcurctx(mqc, opj_t1_getctxno_zc((OPJ_UINT32)flag, (OPJ_UINT32)orient));
-		if (opj_mqc_decode(mqc)) {
-			opj_mqc_setcurctx(mqc, opj_t1_getctxno_sc((OPJ_UINT32)flag));
-			v = opj_mqc_decode(mqc) ^ opj_t1_getspb((OPJ_UINT32)flag);
-			*datap = v ? -oneplushalf : oneplushalf;
-			opj_t1_updateflags(flagsp, (OPJ_UINT32)v, t1->flags_stride);
-		}
-	}
-	*flagsp &= ~T1_VISIT;
-}				/* VSC and  BYPASS by Antonin */
-
-static void opj_t1_dec_clnpass_step_vsc(
-		opj_t1_t *t1,
-		opj_flag_t *flagsp,
-		OPJ_INT32 *datap,
-		OPJ_INT32 orient,
-		OPJ_INT32 oneplushalf,
-		OPJ_INT32 partial,
-		OPJ_INT32 vsc)
-{
-	OPJ_INT32 v, flag;
-	
-	opj_mqc_t *mqc = t1->mqc;	/* MQC component */
-	
-	flag = vsc ? ((*flagsp) & (~(T1_SIG_S | T1_SIG_SE | T1_SIG_SW | T1_SGN_S))) : (*flagsp);
-	if (partial) {
-		goto LABEL_PARTIAL;
-	}
-	if (!(flag & (T1_SIG | T1_VISIT))) {
-		opj_mqc_setcurctx(mqc, opj_t1_getctxno_zc((OPJ_UINT32)flag, (OPJ_UINT32)orient));
-		if (opj_mqc_decode(mqc)) {
-LABEL_PARTIAL:
-			opj_mqc_setcurctx(mqc, opj_t1_getctxno_sc((OPJ_UINT32)flag));
-			v = opj_mqc_decode(mqc) ^ opj_t1_getspb((OPJ_UINT32)flag);
-			*datap = v ? -oneplushalf : oneplushalf;
-			opj_t1_updateflags(flagsp, (OPJ_UINT32)v, t1->flags_stride);
-		}
-	}
-	*flagsp &= ~T1_VISIT;
-}
-
 void opj_t1_enc_clnpass(
 		opj_t1_t *t1,
 		OPJ_INT32 bpno,
@@ -1009,123 +871,89 @@ static void opj_t1_dec_clnpass(
 		OPJ_INT32 orient,
 		OPJ_INT32 cblksty)
 {
-	OPJ_INT32 one, half, oneplushalf, agg, runlen, vsc;
-    OPJ_UINT32 i, j, k;
+	OPJ_INT32 one, half, oneplushalf, runlen;
+	OPJ_UINT32 i, j, k;
 	OPJ_INT32 segsym = cblksty & J2K_CCP_CBLKSTY_SEGSYM;
+	const OPJ_UINT32 vsc = (OPJ_UINT32)cblksty & J2K_CCP_CBLKSTY_VSC;
+	OPJ_INT32 *data1 = t1->data;
+	opj_dec_flag_t *flagsp = &t1->dec_flags[t1->flags_stride + 1];
+	const OPJ_UINT32 l_w = t1->w;
+	const OPJ_UINT32 l_flags_stride = t1->flags_stride;
 	
 	opj_mqc_t *mqc = t1->mqc;	/* MQC component */
+	opj_mqc_state_t **curctx;
+	OPJ_UINT32 a, c, ct;
+	OPJ_BYTE *bp;
 	
+	opj_mqc_load_dec(mqc, curctx, a, c, ct, bp);
 	one = 1 << bpno;
 	half = one >> 1;
 	oneplushalf = one | half;
-	if (cblksty & J2K_CCP_CBLKSTY_VSC) {
-	for (k = 0; k < t1->h; k += 4) {
-		for (i = 0; i < t1->w; ++i) {
-			if (k + 3 < t1->h) {
-					agg = !(MACRO_t1_flags(1 + k,1 + i) & (T1_SIG | T1_VISIT | T1_SIG_OTH)
-						|| MACRO_t1_flags(1 + k + 1,1 + i) & (T1_SIG | T1_VISIT | T1_SIG_OTH)
-						|| MACRO_t1_flags(1 + k + 2,1 + i) & (T1_SIG | T1_VISIT | T1_SIG_OTH)
-						|| (MACRO_t1_flags(1 + k + 3,1 + i) 
-						& (~(T1_SIG_S | T1_SIG_SE | T1_SIG_SW |	T1_SGN_S))) & (T1_SIG | T1_VISIT | T1_SIG_OTH));
-				} else {
-				agg = 0;
-			}
-			if (agg) {
-				opj_mqc_setcurctx(mqc, T1_CTXNO_AGG);
-				if (!opj_mqc_decode(mqc)) {
+	for (k = 0; k < (t1->h & ~3u); k += 4, flagsp += 2, data1 += 3 * l_w) {
+		for (i = 0; i < l_w; ++i, ++flagsp, ++data1) {
+			opj_dec_flag_t flags = *flagsp;
+			if (flags == 0U) {
+				/* no sample of the column nor any of their neighbours is significant: run-length mode. */
+				/* The run-length symbols of consecutive such columns are decoded back to back, as */
+				/* their flags words stay zero until one of them holds a significant sample. */
+				OPJ_INT32 l_bit;
+				opj_t1_setcurctx(curctx, T1_CTXNO_AGG);
+				for (;;) {
+					opj_mqc_decode_macro(runlen, curctx, a, c, ct, bp);
+					if (runlen || i + 1 == l_w || flagsp[1] != 0U) {
+						break;
+					}
+					++i;
+					++flagsp;
+					++data1;
+				}
+				if (!runlen) {
 					continue;
 				}
-				opj_mqc_setcurctx(mqc, T1_CTXNO_UNI);
-				runlen = opj_mqc_decode(mqc);
-				runlen = (runlen << 1) | opj_mqc_decode(mqc);
+				opj_t1_setcurctx(curctx, T1_CTXNO_UNI);
+				opj_mqc_decode_macro(runlen, curctx, a, c, ct, bp);
+				opj_mqc_decode_macro(l_bit, curctx, a, c, ct, bp);
+				runlen = (runlen << 1) | l_bit;
+				for (j = (OPJ_UINT32)runlen; j < 4; ++j) {
+					opj_t1_dec_clnpass_step_mqc_macro(j == (OPJ_UINT32)runlen, flags, flagsp, l_flags_stride, data1 + j * l_w, j, orient, oneplushalf, vsc, curctx, a, c, ct, bp);
+				}
 			} else {
-				runlen = 0;
-			}
-			for (j = k + (OPJ_UINT32)runlen; j < k + 4 && j < t1->h; ++j) {
-					vsc = (j == k + 3 || j == t1->h - 1) ? 1 : 0;
-					opj_t1_dec_clnpass_step_vsc(
-						t1,
-						&t1->flags[((j+1) * t1->flags_stride) + i + 1],
-						&t1->data[(j * t1->w) + i],
-						orient,
-						oneplushalf,
-						agg && (j == k + (OPJ_UINT32)runlen),
-						vsc);
+				opj_t1_dec_clnpass_step_mqc_macro(0, flags, flagsp, l_flags_stride, data1, 0U, orient, oneplushalf, vsc, curctx, a, c, ct, bp);
+				opj_t1_dec_clnpass_step_mqc_macro(0, flags, flagsp, l_flags_stride, data1 + l_w, 1U, orient, oneplushalf, vsc, curctx, a, c, ct, bp);
+				opj_t1_dec_clnpass_step_mqc_macro(0, flags, flagsp, l_flags_stride, data1 + 2 * l_w, 2U, orient, oneplushalf, vsc, curctx, a, c, ct, bp);
+				opj_t1_dec_clnpass_step_mqc_macro(0, flags, flagsp, l_flags_stride, data1 + 3 * l_w, 3U, orient, oneplushalf, vsc, curctx, a, c, ct, bp);
 			}
+			*flagsp = flags & ~(T1_PI_0 | T1_PI_1 | T1_PI_2 | T1_PI_3);
 		}
 	}
-	} else {
-		OPJ_INT32 *data1 = t1->data;
-		opj_flag_t *flags1 = &t1->flags[1];
-		for (k = 0; k < (t1->h & ~3u); k += 4) {
-			for (i = 0; i < t1->w; ++i) {
-				OPJ_INT32 *data2 = data1 + i;
-				opj_flag_t *flags2 = flags1 + i;
-				agg = !(MACRO_t1_flags(1 + k,1 + i) & (T1_SIG | T1_VISIT | T1_SIG_OTH)
-					|| MACRO_t1_flags(1 + k + 1,1 + i) & (T1_SIG | T1_VISIT | T1_SIG_OTH)
-					|| MACRO_t1_flags(1 + k + 2,1 + i) & (T1_SIG | T1_VISIT | T1_SIG_OTH)
-					|| MACRO_t1_flags(1 + k + 3,1 + i) & (T1_SIG | T1_VISIT | T1_SIG_OTH));
-				if (agg) {
-					opj_mqc_setcurctx(mqc, T1_CTXNO_AGG);
-					if (!opj_mqc_decode(mqc)) {
-						continue;
-					}
-					opj_mqc_setcurctx(mqc, T1_CTXNO_UNI);
-					runlen = opj_mqc_decode(mqc);
-					runlen = (runlen << 1) | opj_mqc_decode(mqc);
-					flags2 += (OPJ_UINT32)runlen * t1->flags_stride;
-					data2 += (OPJ_UINT32)runlen * t1->w;
-					for (j = k + (OPJ_UINT32)runlen; j < k + 4 && j < t1->h; ++j) {
-						flags2 += t1->flags_stride;
-						if (agg && (j == k + (OPJ_UINT32)runlen)) {
-							opj_t1_dec_clnpass_step_partial(t1, flags2, data2, orient, oneplushalf);
-						} else {
-							opj_t1_dec_clnpass_step(t1, flags2, data2, orient, oneplushalf);
-						}
-						data2 += t1->w;
-					}
-				} else {
-					flags2 += t1->flags_stride;
-					opj_t1_dec_clnpass_step(t1, flags2, data2, orient, oneplushalf);
-					data2 += t1->w;
-					flags2 += t1->flags_stride;
-					opj_t1_dec_clnpass_step(t1, flags2, data2, orient, oneplushalf);
-					data2 += t1->w;
-					flags2 += t1->flags_stride;
-					opj_t1_dec_clnpass_step(t1, flags2, data2, orient, oneplushalf);
-					data2 += t1->w;
-					flags2 += t1->flags_stride;
-					opj_t1_dec_clnpass_step(t1, flags2, data2, orient, oneplushalf);
-					data2 += t1->w;
-				}
-			}
-			data1 += t1->w << 2;
-			flags1 += t1->flags_stride << 2;
-		}
-		for (i = 0; i < t1->w; ++i) {
-			OPJ_INT32 *data2 = data1 + i;
-			opj_flag_t *flags2 = flags1 + i;
-			for (j = k; j < t1->h; ++j) {
-				flags2 += t1->flags_stride;
-				opj_t1_dec_clnpass_step(t1, flags2, data2, orient, oneplushalf);
-				data2 += t1->w;
+	if (k < t1->h) {
+		for (i = 0; i < l_w; ++i, ++flagsp, ++data1) {
+			opj_dec_flag_t flags = *flagsp;
+			for (j = 0; j < t1->h - k; ++j) {
+				opj_t1_dec_clnpass_step_mqc_macro(0, flags, flagsp, l_flags_stride, data1 + j * l_w, j, orient, oneplushalf, vsc, curctx, a, c, ct, bp);
 			}
+			*flagsp = flags & ~(T1_PI_0 | T1_PI_1 | T1_PI_2 | T1_PI_3);
 		}
 	}
 
 	if (segsym) {
-		OPJ_INT32 v = 0;
-		opj_mqc_setcurctx(mqc, T1_CTXNO_UNI);
-		v = opj_mqc_decode(mqc);
-		v = (v << 1) | opj_mqc_decode(mqc);
-		v = (v << 1) | opj_mqc_decode(mqc);
-		v = (v << 1) | opj_mqc_decode(mqc);
+		OPJ_INT32 v = 0, l_bit;
+		opj_t1_setcurctx(curctx, T1_CTXNO_UNI);
+		opj_mqc_decode_macro(l_bit, curctx, a, c, ct, bp);
+		v = l_bit;
+		opj_mqc_decode_macro(l_bit, curctx, a, c, ct, bp);
+		v = (v << 1) | l_bit;
+		opj_mqc_decode_macro(l_bit, curctx, a, c, ct, bp);
+		v = (v << 1) | l_bit;
+		opj_mqc_decode_macro(l_bit, curctx, a, c, ct, bp);
+		v = (v << 1) | l_bit;
 		/*
 		if (v!=0xa) {
 			opj_event_msg(t1->cinfo, EVT_WARNING, "Bad segmentation symbol %x\n", v);
 		} 
 		*/
 	}
+	opj_mqc_store_dec(mqc, curctx, a, c, ct, bp);
 }				/* VSC and  BYPASS by Antonin */
 
 
@@ -1183,18 +1011,34 @@ OPJ_BOOL opj_t1_allocate_buffers(
 		memset(t1->data,0,datasize * sizeof(OPJ_INT32));
 	}
 	t1->flags_stride=w+2;
-	flagssize=t1->flags_stride * (h+2);
-
-	if(flagssize > t1->flagssize){
-		opj_aligned_free(t1->flags);
-		t1->flags = (opj_flag_t*) opj_aligned_malloc(flagssize * sizeof(opj_flag_t));
-		if(!t1->flags){
-			/* FIXME event manager error callback */
-			return OPJ_FALSE;
+	if (t1->encoder) {
+		flagssize=t1->flags_stride * (h+2);
+
+		if(flagssize > t1->flagssize){
+			opj_aligned_free(t1->flags);
+			t1->flags = (opj_flag_t*) opj_aligned_malloc(flagssize * sizeof(opj_flag_t));
+			if(!t1->flags){
+				/* FIXME event manager error callback */
+				return OPJ_FALSE;
+			}
+			t1->flagssize=flagssize;
+		}
+		memset(t1->flags,0,flagssize * sizeof(opj_flag_t));
+	} else {
+		/* one word per column of each stripe, plus the stripes above and below the code-block */
+		flagssize=t1->flags_stride * ((h + 3) / 4 + 2);
+
+		if(flagssize > t1->dec_flagssize){
+			opj_aligned_free(t1->dec_flags);
+			t1->dec_flags = (opj_dec_flag_t*) opj_aligned_malloc(flagssize * sizeof(opj_dec_flag_t));
+			if(!t1->dec_flags){
+				/* FIXME event manager error callback */
+				return OPJ_FALSE;
+			}
+			t1->dec_flagssize=flagssize;
 		}
-		t1->flagssize=flagssize;
+		memset(t1->dec_flags,0,flagssize * sizeof(opj_dec_flag_t));
 	}
-	memset(t1->flags,0,flagssize * sizeof(opj_flag_t));
 
 	t1->w=w;
 	t1->h=h;
@@ -1265,16 +1109,242 @@ void opj_t1_destroy(opj_t1_t *p_t1)
 		p_t1->flags = 00;
 	}
 
+	if (p_t1->dec_flags) {
+		opj_aligned_free(p_t1->dec_flags);
+		p_t1->dec_flags = 00;
+	}
+
+	if (p_t1->cblkdata) {
+		opj_free(p_t1->cblkdata);
+		p_t1->cblkdata = 00;
+	}
+
 	opj_free(p_t1);
 }
 
-OPJ_BOOL opj_t1_decode_cblks(   opj_t1_t* t1,
+void opj_t1_dequant(OPJ_INT32* restrict tiledp, OPJ_UINT32 tile_w, const OPJ_INT32* restrict datap, OPJ_UINT32 cblk_w, OPJ_UINT32 cblk_h)
+{
+	OPJ_UINT32 i, j;
+	for (j = 0; j < cblk_h; ++j) {
+		for (i = 0; i < cblk_w; ++i) {
+			OPJ_INT32 tmp = datap[(j * cblk_w) + i];
+			tiledp[(j * tile_w) + i] = tmp / 2;
+		}
+	}
+}
+
+void opj_t1_dequant_real(OPJ_FLOAT32* restrict tiledp, OPJ_UINT32 tile_w, const OPJ_INT32* restrict datap, OPJ_UINT32 cblk_w, OPJ_UINT32 cblk_h, OPJ_FLOAT32 stepsize)
+{
+	OPJ_UINT32 i, j;
+	for (j = 0; j < cblk_h; ++j) {
+		OPJ_FLOAT32* restrict tiledp2 = tiledp;
+		for (i = 0; i < cblk_w; ++i) {
+			OPJ_FLOAT32 tmp = (OPJ_FLOAT32)*datap * stepsize;
+			*tiledp2 = tmp;
+			datap++;
+			tiledp2++;
+		}
+		tiledp += tile_w;
+	}
+}
+
+#ifdef OPJ_HAVE_X86_KERNELS
+
+/* x / 2, rounded toward zero as in C: (x + (x < 0)) >> 1 */
+
+OPJ_TARGET_SSE2
+void opj_t1_dequant_sse2(OPJ_INT32* restrict tiledp, OPJ_UINT32 tile_w, const OPJ_INT32* restrict datap, OPJ_UINT32 cblk_w, OPJ_UINT32 cblk_h)
+{
+	OPJ_UINT32 i, j;
+	for (j = 0; j < cblk_h; ++j) {
+		for (i = 0; i + 4 <= cblk_w; i += 4) {
+			__m128i x = _mm_loadu_si128((const __m128i*)(datap + i));
+			x = _mm_srai_epi32(_mm_add_epi32(x, _mm_srli_epi32(x, 31)), 1);
+			_mm_storeu_si128((__m128i*)(tiledp + i), x);
+		}
+		for (; i < cblk_w; ++i) {
+			tiledp[i] = datap[i] / 2;
+		}
+		datap += cblk_w;
+		tiledp += tile_w;
+	}
+}
+
+OPJ_TARGET_SSE2
+void opj_t1_dequant_real_sse2(OPJ_FLOAT32* restrict tiledp, OPJ_UINT32 tile_w, const OPJ_INT32* restrict datap, OPJ_UINT32 cblk_w, OPJ_UINT32 cblk_h, OPJ_FLOAT32 stepsize)
+{
+	const __m128 c = _mm_set1_ps(stepsize);
+	OPJ_UINT32 i, j;
+	for (j = 0; j < cblk_h; ++j) {
+		for (i = 0; i + 4 <= cblk_w; i += 4) {
+			__m128 x = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)(datap + i)));
+			_mm_storeu_ps(tiledp + i, _mm_mul_ps(x, c));
+		}
+		for (; i < cblk_w; ++i) {
+			tiledp[i] = (OPJ_FLOAT32)datap[i] * stepsize;
+		}
+		datap += cblk_w;
+		tiledp += tile_w;
+	}
+}
+
+OPJ_TARGET_AVX2
+void opj_t1_dequant_avx2(OPJ_INT32* restrict tiledp, OPJ_UINT32 tile_w, const OPJ_INT32* restrict datap, OPJ_UINT32 cblk_w, OPJ_UINT32 cblk_h)
+{
+	OPJ_UINT32 i, j;
+	for (j = 0; j < cblk_h; ++j) {
+		for (i = 0; i + 8 <= cblk_w; i += 8) {
+			__m256i x = _mm256_loadu_si256((const __m256i*)(datap + i));
+			x = _mm256_srai_epi32(_mm256_add_epi32(x, _mm256_srli_epi32(x, 31)), 1);
+			_mm256_storeu_si256((__m256i*)(tiledp + i), x);
+		}
+		for (; i < cblk_w; ++i) {
+			tiledp[i] = datap[i] / 2;
+		}
+		datap += cblk_w;
+		tiledp += tile_w;
+	}
+}
+
+OPJ_TARGET_AVX2
+void opj_t1_dequant_real_avx2(OPJ_FLOAT32* restrict tiledp, OPJ_UINT32 tile_w, const OPJ_INT32* restrict datap, OPJ_UINT32 cblk_w, OPJ_UINT32 cblk_h, OPJ_FLOAT32 stepsize)
+{
+	const __m256 c = _mm256_set1_ps(stepsize);
+	OPJ_UINT32 i, j;
+	for (j = 0; j < cblk_h; ++j) {
+		for (i = 0; i + 8 <= cblk_w; i += 8) {
+			__m256 x = _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i*)(datap + i)));
+			_mm256_storeu_ps(tiledp + i, _mm256_mul_ps(x, c));
+		}
+		for (; i < cblk_w; ++i) {
+			tiledp[i] = (OPJ_FLOAT32)datap[i] * stepsize;
+		}
+		datap += cblk_w;
+		tiledp += tile_w;
+	}
+}
+
+#endif /* OPJ_HAVE_X86_KERNELS */
+
+void opj_t1_init_kernels(opj_kernels_t* p_kernels, OPJ_UINT32 p_level)
+{
+	p_kernels->t1_dequant = opj_t1_dequant;
+	p_kernels->t1_dequant_real = opj_t1_dequant_real;
+#ifdef OPJ_HAVE_X86_KERNELS
+	if (p_level >= OPJ_CPU_LEVEL_SSE2) {
+		p_kernels->t1_dequant = opj_t1_dequant_sse2;
+		p_kernels->t1_dequant_real = opj_t1_dequant_real_sse2;
+	}
+	if (p_level >= OPJ_CPU_LEVEL_AVX2) {
+		p_kernels->t1_dequant = opj_t1_dequant_avx2;
+		p_kernels->t1_dequant_real = opj_t1_dequant_real_avx2;
+	}
+#else
+	(void)p_level;
+#endif
+}
+
+typedef struct
+{
+        opj_tcd_cblk_dec_t* cblk;
+        opj_tcd_band_t* band;
+        opj_tcd_tilecomp_t* tilec;
+        opj_tccp_t* tccp;
+        const opj_kernels_t* kernels;
+        OPJ_INT32 x;
+        OPJ_INT32 y;
+        volatile OPJ_BOOL* pret;
+} opj_t1_cblk_decode_processing_job_t;
+
+static void opj_t1_destroy_wrapper(void* t1)
+{
+	opj_t1_destroy( (opj_t1_t*) t1 );
+}
+
+/**
+ * Decodes one code-block and stores its coefficients in the tile component.
+ * Run by the thread pool; each worker uses its own T1 handle, kept in its
+ * thread local storage.
+ */
+static void opj_t1_clbl_decode_processor(void* user_data, opj_tls_t* tls)
+{
+	opj_t1_cblk_decode_processing_job_t* job = (opj_t1_cblk_decode_processing_job_t*) user_data;
+	opj_tcd_cblk_dec_t* cblk = job->cblk;
+	opj_tcd_band_t* band = job->band;
+	opj_tcd_tilecomp_t* tilec = job->tilec;
+	opj_tccp_t* tccp = job->tccp;
+	OPJ_UINT32 tile_w = (OPJ_UINT32)(tilec->x1 - tilec->x0);
+	OPJ_INT32* restrict datap;
+	OPJ_UINT32 cblk_w, cblk_h;
+	OPJ_UINT32 i, j;
+	opj_t1_t* t1;
+
+	if (! *(job->pret)) {
+		opj_free(job);
+		return;
+	}
+
+	t1 = (opj_t1_t*) opj_tls_get(tls, OPJ_TLS_KEY_T1_DEC);
+	if (t1 == 00) {
+		t1 = opj_t1_create(OPJ_FALSE);
+		if (t1 == 00 || ! opj_tls_set(tls, OPJ_TLS_KEY_T1_DEC, t1, opj_t1_destroy_wrapper)) {
+			opj_t1_destroy(t1);
+			*(job->pret) = OPJ_FALSE;
+			opj_free(job);
+			return;
+		}
+	}
+
+	if (OPJ_FALSE == opj_t1_decode_cblk(
+	                        t1,
+	                        cblk,
+	                        band->bandno,
+	                        (OPJ_UINT32)tccp->roishift,
+	                        tccp->cblksty)) {
+		*(job->pret) = OPJ_FALSE;
+		opj_free(job);
+		return;
+	}
+
+	datap=t1->data;
+	cblk_w = t1->w;
+	cblk_h = t1->h;
+
+	if (tccp->roishift) {
+		OPJ_INT32 thresh = 1 << tccp->roishift;
+		for (j = 0; j < cblk_h; ++j) {
+			for (i = 0; i < cblk_w; ++i) {
+				OPJ_INT32 val = datap[(j * cblk_w) + i];
+				OPJ_INT32 mag = abs(val);
+				if (mag >= thresh) {
+					mag >>= tccp->roishift;
+					datap[(j * cblk_w) + i] = val < 0 ? -mag : mag;
+				}
+			}
+		}
+	}
+
+	if (tccp->qmfbid == 1) {
+		job->kernels->t1_dequant(&tilec->data[(OPJ_UINT32)job->y * tile_w + (OPJ_UINT32)job->x], tile_w,
+		                         datap, cblk_w, cblk_h);
+	} else {		/* if (tccp->qmfbid == 0) */
+		job->kernels->t1_dequant_real((OPJ_FLOAT32*) &tilec->data[(OPJ_UINT32)job->y * tile_w + (OPJ_UINT32)job->x], tile_w,
+		                              datap, cblk_w, cblk_h, band->stepsize);
+	}
+
+	opj_free(job);
+}
+
+OPJ_BOOL opj_t1_decode_cblks(   opj_tcd_t* tcd,
+                            volatile OPJ_BOOL* pret,
+                            OPJ_UINT32 compno,
                             opj_tcd_tilecomp_t* tilec,
                             opj_tccp_t* tccp
                             )
 {
-	OPJ_UINT32 resno, bandno, precno, cblkno;
+	opj_thread_pool_t* tp = tcd->thread_pool;
 	OPJ_UINT32 tile_w = (OPJ_UINT32)(tilec->x1 - tilec->x0);
+	OPJ_UINT32 resno, bandno, precno, cblkno;
 
 	for (resno = 0; resno < tilec->minimum_num_resolutions; ++resno) {
 		opj_tcd_resolution_t* res = &tilec->resolutions[resno];
@@ -1287,20 +1357,8 @@ OPJ_BOOL opj_t1_decode_cblks(   opj_t1_t* t1,
 
 				for (cblkno = 0; cblkno < precinct->cw * precinct->ch; ++cblkno) {
 					opj_tcd_cblk_dec_t* cblk = &precinct->cblks.dec[cblkno];
-					OPJ_INT32* restrict datap;
-					/*void* restrict tiledp;*/
-					OPJ_UINT32 cblk_w, cblk_h;
+					opj_t1_cblk_decode_processing_job_t* job;
 					OPJ_INT32 x, y;
-					OPJ_UINT32 i, j;
-
-                    if (OPJ_FALSE == opj_t1_decode_cblk(
-                                            t1,
-                                            cblk,
-                                            band->bandno,
-                                            (OPJ_UINT32)tccp->roishift,
-                                            tccp->cblksty)) {
-                            return OPJ_FALSE;
-                    }
 
 					x = cblk->x0 - band->x0;
 					y = cblk->y0 - band->y0;
@@ -1313,58 +1371,48 @@ OPJ_BOOL opj_t1_decode_cblks(   opj_t1_t* t1,
 						y += pres->y1 - pres->y0;
 					}
 
-					datap=t1->data;
-					cblk_w = t1->w;
-					cblk_h = t1->h;
-
-					if (tccp->roishift) {
-						OPJ_INT32 thresh = 1 << tccp->roishift;
+					if (! opj_tcd_is_subband_area_of_interest(tcd, compno, resno, band->bandno,
+					                                          (OPJ_UINT32)cblk->x0, (OPJ_UINT32)cblk->y0,
+					                                          (OPJ_UINT32)cblk->x1, (OPJ_UINT32)cblk->y1)) {
+						/* the code-block does not contribute to the decoded area: */
+						/* only clear its coefficients so that the DWT reads defined values */
+						OPJ_INT32* restrict tiledp = &tilec->data[(OPJ_UINT32)y * tile_w + (OPJ_UINT32)x];
+						OPJ_UINT32 cblk_w = (OPJ_UINT32)(cblk->x1 - cblk->x0);
+						OPJ_UINT32 cblk_h = (OPJ_UINT32)(cblk->y1 - cblk->y0);
+						OPJ_UINT32 j;
 						for (j = 0; j < cblk_h; ++j) {
-							for (i = 0; i < cblk_w; ++i) {
-								OPJ_INT32 val = datap[(j * cblk_w) + i];
-								OPJ_INT32 mag = abs(val);
-								if (mag >= thresh) {
-									mag >>= tccp->roishift;
-									datap[(j * cblk_w) + i] = val < 0 ? -mag : mag;
-								}
-							}
+							memset(tiledp + j * tile_w, 0, cblk_w * sizeof(OPJ_INT32));
 						}
+						continue;
 					}
 
-					/*tiledp=(void*)&tilec->data[(y * tile_w) + x];*/
-					if (tccp->qmfbid == 1) {
-                        OPJ_INT32* restrict tiledp = &tilec->data[(OPJ_UINT32)y * tile_w + (OPJ_UINT32)x];
-						for (j = 0; j < cblk_h; ++j) {
-							for (i = 0; i < cblk_w; ++i) {
-								OPJ_INT32 tmp = datap[(j * cblk_w) + i];
-								((OPJ_INT32*)tiledp)[(j * tile_w) + i] = tmp / 2;
-							}
-						}
-					} else {		/* if (tccp->qmfbid == 0) */
-                        OPJ_FLOAT32* restrict tiledp = (OPJ_FLOAT32*) &tilec->data[(OPJ_UINT32)y * tile_w + (OPJ_UINT32)x];
-						for (j = 0; j < cblk_h; ++j) {
-                            OPJ_FLOAT32* restrict tiledp2 = tiledp;
-							for (i = 0; i < cblk_w; ++i) {
-                                OPJ_FLOAT32 tmp = (OPJ_FLOAT32)*datap * band->stepsize;
-                                *tiledp2 = tmp;
-                                datap++;
-                                tiledp2++;
-								/*float tmp = datap[(j * cblk_w) + i] * band->stepsize;
-								((float*)tiledp)[(j * tile_w) + i] = tmp;*/
-
-							}
-                            tiledp += tile_w;
-						}
+					job = (opj_t1_cblk_decode_processing_job_t*) opj_malloc(sizeof(opj_t1_cblk_decode_processing_job_t));
+					if (! job) {
+						*pret = OPJ_FALSE;
+						return OPJ_FALSE;
+					}
+					job->cblk = cblk;
+					job->band = band;
+					job->tilec = tilec;
+					job->tccp = tccp;
+					job->kernels = tcd->kernels;
+					job->x = x;
+					job->y = y;
+					job->pret = pret;
+					if (! opj_thread_pool_submit_job(tp, opj_t1_clbl_decode_processor, job)) {
+						opj_free(job);
+						*pret = OPJ_FALSE;
+						return OPJ_FALSE;
+					}
+					if (! *pret) {
+						return OPJ_FALSE;
 					}
-                    /*opj_free(cblk->data);
-					opj_free(cblk->segs);*/
-					/*cblk->segs = 00;*/
 				} /* cblkno */
-                /*opj_free(precinct->cblks.dec);*/
 			} /* precno */
 		} /* bandno */
 	} /* resno */
-        return OPJ_TRUE;
+
+	return OPJ_TRUE;
 }
 
 
@@ -1410,7 +1458,21 @@ OPJ_BOOL opj_t1_decode_cblk(opj_t1_t *t1,
 		if (type == T1_TYPE_RAW) {
 			opj_raw_init_dec(raw, (*seg->data) + seg->dataindex, seg->len);
 		} else {
-            if (OPJ_FALSE == opj_mqc_init_dec(mqc, (*seg->data) + seg->dataindex, seg->len)) {
+			/* Copy the segment and pad it for the MQ decoder, which then needs no bounds check */
+			if (seg->len + MQC_DEC_PADDING > t1->cblkdatasize) {
+				OPJ_BYTE* l_new_data = (OPJ_BYTE*) opj_realloc(t1->cblkdata, seg->len + MQC_DEC_PADDING);
+				if (! l_new_data) {
+					opj_free(t1->cblkdata);
+					t1->cblkdata = 00;
+					t1->cblkdatasize = 0;
+					return OPJ_FALSE;
+				}
+				t1->cblkdata = l_new_data;
+				t1->cblkdatasize = seg->len + MQC_DEC_PADDING;
+			}
+			memcpy(t1->cblkdata, (*seg->data) + seg->dataindex, seg->len);
+			memset(t1->cblkdata + seg->len, 0xff, MQC_DEC_PADDING);
+            if (OPJ_FALSE == opj_mqc_init_dec(mqc, t1->cblkdata, seg->len)) {
                     return OPJ_FALSE;
             }
 		}
@@ -1419,24 +1481,16 @@ OPJ_BOOL opj_t1_decode_cblk(opj_t1_t *t1,
             switch (passtype) {
                 case 0:
                     if (type == T1_TYPE_RAW) {
-                        opj_t1_dec_sigpass_raw(t1, bpno+1, (OPJ_INT32)orient, (OPJ_INT32)cblksty);
+                        opj_t1_dec_sigpass_raw(t1, bpno+1, (OPJ_INT32)cblksty);
                     } else {
-                        if (cblksty & J2K_CCP_CBLKSTY_VSC) {
-                            opj_t1_dec_sigpass_mqc_vsc(t1, bpno+1, (OPJ_INT32)orient);
-                        } else {
-                            opj_t1_dec_sigpass_mqc(t1, bpno+1, (OPJ_INT32)orient);
-                        }
+                        opj_t1_dec_sigpass_mqc(t1, bpno+1, (OPJ_INT32)orient, cblksty & J2K_CCP_CBLKSTY_VSC);
                     }
                     break;
                 case 1:
                     if (type == T1_TYPE_RAW) {
-                            opj_t1_dec_refpass_raw(t1, bpno+1, (OPJ_INT32)cblksty);
+                        opj_t1_dec_refpass_raw(t1, bpno+1);
                     } else {
-                        if (cblksty & J2K_CCP_CBLKSTY_VSC) {
-                            opj_t1_dec_refpass_mqc_vsc(t1, bpno+1);
-                        } else {
-                            opj_t1_dec_refpass_mqc(t1, bpno+1);
-                        }
+                        opj_t1_dec_refpass_mqc(t1, bpno+1);
                     }
                     break;
                 case 2:
@@ -1462,106 +1516,211 @@ OPJ_BOOL opj_t1_decode_cblk(opj_t1_t *t1,
 
 
 
-OPJ_BOOL opj_t1_encode_cblks(   opj_t1_t *t1,
+typedef struct
+{
+        opj_tcd_cblk_enc_t* cblk;
+        opj_tcd_band_t* band;
+        opj_tcd_tilecomp_t* tilec;
+        opj_tccp_t* tccp;
+        OPJ_UINT32 compno;
+        OPJ_UINT32 resno;
+        OPJ_UINT32 numcomps;
+        const OPJ_FLOAT64 * mct_norms;
+        OPJ_UINT32 mct_numcomps;
+        volatile OPJ_BOOL* pret;
+} opj_t1_cblk_encode_processing_job_t;
+
+/**
+ * Quantizes the coefficients of one code-block in the tile component and encodes them.
+ * Run by the thread pool; each worker uses its own T1 handle, kept in its
+ * thread local storage.
+ */
+static void opj_t1_cblk_encode_processor(void* user_data, opj_tls_t* tls)
+{
+	opj_t1_cblk_encode_processing_job_t* job = (opj_t1_cblk_encode_processing_job_t*) user_data;
+	opj_tcd_cblk_enc_t* cblk = job->cblk;
+	const opj_tcd_band_t* band = job->band;
+	const opj_tcd_tilecomp_t* tilec = job->tilec;
+	const opj_tccp_t* tccp = job->tccp;
+	const OPJ_UINT32 resno = job->resno;
+	opj_t1_t* t1;
+	OPJ_UINT32 tile_w = (OPJ_UINT32)(tilec->x1 - tilec->x0);
+
+	OPJ_INT32* restrict tiledp;
+	OPJ_UINT32 cblk_w;
+	OPJ_UINT32 cblk_h;
+	OPJ_UINT32 i, j, tileIndex=0, tileLineAdvance;
+
+	OPJ_INT32 x = cblk->x0 - band->x0;
+	OPJ_INT32 y = cblk->y0 - band->y0;
+
+	if (! *(job->pret)) {
+		opj_free(job);
+		return;
+	}
+
+	t1 = (opj_t1_t*) opj_tls_get(tls, OPJ_TLS_KEY_T1_ENC);
+	if (t1 == 00) {
+		t1 = opj_t1_create(OPJ_TRUE);
+		if (t1 == 00 || ! opj_tls_set(tls, OPJ_TLS_KEY_T1_ENC, t1, opj_t1_destroy_wrapper)) {
+			opj_t1_destroy(t1);
+			*(job->pret) = OPJ_FALSE;
+			opj_free(job);
+			return;
+		}
+	}
+
+	if (band->bandno & 1) {
+		opj_tcd_resolution_t *pres = &tilec->resolutions[resno - 1];
+		x += pres->x1 - pres->x0;
+	}
+	if (band->bandno & 2) {
+		opj_tcd_resolution_t *pres = &tilec->resolutions[resno - 1];
+		y += pres->y1 - pres->y0;
+	}
+
+	if(!opj_t1_allocate_buffers(
+				t1,
+				(OPJ_UINT32)(cblk->x1 - cblk->x0),
+				(OPJ_UINT32)(cblk->y1 - cblk->y0)))
+	{
+		*(job->pret) = OPJ_FALSE;
+		opj_free(job);
+		return;
+	}
+
+	cblk_w = t1->w;
+	cblk_h = t1->h;
+	tileLineAdvance = tile_w - cblk_w;
+
+	tiledp=&tilec->data[(OPJ_UINT32)y * tile_w + (OPJ_UINT32)x];
+	t1->data = tiledp;
+	t1->data_stride = tile_w;
+	if (tccp->qmfbid == 1) {
+		for (j = 0; j < cblk_h; ++j) {
+			for (i = 0; i < cblk_w; ++i) {
+				tiledp[tileIndex] <<= T1_NMSEDEC_FRACBITS;
+				tileIndex++;
+			}
+			tileIndex += tileLineAdvance;
+		}
+	} else {		/* if (tccp->qmfbid == 0) */
+		OPJ_INT32 bandconst = 8192 * 8192 / ((OPJ_INT32) floor(band->stepsize * 8192));
+		for (j = 0; j < cblk_h; ++j) {
+			for (i = 0; i < cblk_w; ++i) {
+				OPJ_INT32 tmp = tiledp[tileIndex];
+				tiledp[tileIndex] =
+					opj_int_fix_mul_t1(
+					tmp,
+					bandconst);
+				tileIndex++;
+			}
+			tileIndex += tileLineAdvance;
+		}
+	}
+
+	opj_t1_encode_cblk(
+			t1,
+			cblk,
+			band->bandno,
+			job->compno,
+			tilec->numresolutions - 1 - resno,
+			tccp->qmfbid,
+			band->stepsize,
+			tccp->cblksty,
+			job->numcomps,
+			job->mct_norms,
+			job->mct_numcomps);
+
+	opj_free(job);
+}
+
+OPJ_BOOL opj_t1_encode_cblks(   opj_thread_pool_t* tp,
                                 opj_tcd_tile_t *tile,
                                 opj_tcp_t *tcp,
                                 const OPJ_FLOAT64 * mct_norms,
                                 OPJ_UINT32 mct_numcomps
                                 )
 {
-	OPJ_UINT32 compno, resno, bandno, precno, cblkno;
+	volatile OPJ_BOOL ret = OPJ_TRUE;
+	OPJ_UINT32 compno, resno, bandno, precno, cblkno, passno;
 
 	tile->distotile = 0;		/* fixed_quality */
 
-	for (compno = 0; compno < tile->numcomps; ++compno) {
+	for (compno = 0; compno < tile->numcomps && ret; ++compno) {
 		opj_tcd_tilecomp_t* tilec = &tile->comps[compno];
 		opj_tccp_t* tccp = &tcp->tccps[compno];
-		OPJ_UINT32 tile_w = (OPJ_UINT32)(tilec->x1 - tilec->x0);
 
-		for (resno = 0; resno < tilec->numresolutions; ++resno) {
+		for (resno = 0; resno < tilec->numresolutions && ret; ++resno) {
 			opj_tcd_resolution_t *res = &tilec->resolutions[resno];
 
-			for (bandno = 0; bandno < res->numbands; ++bandno) {
+			for (bandno = 0; bandno < res->numbands && ret; ++bandno) {
 				opj_tcd_band_t* restrict band = &res->bands[bandno];
-                OPJ_INT32 bandconst = 8192 * 8192 / ((OPJ_INT32) floor(band->stepsize * 8192));
 
-				for (precno = 0; precno < res->pw * res->ph; ++precno) {
+				for (precno = 0; precno < res->pw * res->ph && ret; ++precno) {
 					opj_tcd_precinct_t *prc = &band->precincts[precno];
 
 					for (cblkno = 0; cblkno < prc->cw * prc->ch; ++cblkno) {
-						opj_tcd_cblk_enc_t* cblk = &prc->cblks.enc[cblkno];
-						OPJ_INT32* restrict tiledp;
-						OPJ_UINT32 cblk_w;
-						OPJ_UINT32 cblk_h;
-						OPJ_UINT32 i, j, tileIndex=0, tileLineAdvance;
-
-						OPJ_INT32 x = cblk->x0 - band->x0;
-						OPJ_INT32 y = cblk->y0 - band->y0;
-						if (band->bandno & 1) {
-							opj_tcd_resolution_t *pres = &tilec->resolutions[resno - 1];
-							x += pres->x1 - pres->x0;
+						opj_t1_cblk_encode_processing_job_t* job;
+
+						job = (opj_t1_cblk_encode_processing_job_t*) opj_malloc(sizeof(opj_t1_cblk_encode_processing_job_t));
+						if (! job) {
+							ret = OPJ_FALSE;
+							break;
 						}
-						if (band->bandno & 2) {
-							opj_tcd_resolution_t *pres = &tilec->resolutions[resno - 1];
-							y += pres->y1 - pres->y0;
+						job->cblk = &prc->cblks.enc[cblkno];
+						job->band = band;
+						job->tilec = tilec;
+						job->tccp = tccp;
+						job->compno = compno;
+						job->resno = resno;
+						job->numcomps = tile->numcomps;
+						job->mct_norms = mct_norms;
+						job->mct_numcomps = mct_numcomps;
+						job->pret = &ret;
+						if (! opj_thread_pool_submit_job(tp, opj_t1_cblk_encode_processor, job)) {
+							opj_free(job);
+							ret = OPJ_FALSE;
+							break;
 						}
+					} /* cblkno */
+				} /* precno */
+			} /* bandno */
+		} /* resno  */
+	} /* compno  */
 
-						if(!opj_t1_allocate_buffers(
-									t1,
-									(OPJ_UINT32)(cblk->x1 - cblk->x0),
-									(OPJ_UINT32)(cblk->y1 - cblk->y0)))
-						{
-							return OPJ_FALSE;
-						}
+	opj_thread_pool_wait_completion(tp, 0);
+	if (! ret) {
+		return OPJ_FALSE;
+	}
 
-						cblk_w = t1->w;
-						cblk_h = t1->h;
-						tileLineAdvance = tile_w - cblk_w;
-
-						tiledp=&tilec->data[(OPJ_UINT32)y * tile_w + (OPJ_UINT32)x];
-						t1->data = tiledp;
-						t1->data_stride = tile_w;
-						if (tccp->qmfbid == 1) {
-							for (j = 0; j < cblk_h; ++j) {
-								for (i = 0; i < cblk_w; ++i) {
-									tiledp[tileIndex] <<= T1_NMSEDEC_FRACBITS;
-									tileIndex++;
-								}
-								tileIndex += tileLineAdvance;
-							}
-						} else {		/* if (tccp->qmfbid == 0) */
-							for (j = 0; j < cblk_h; ++j) {
-								for (i = 0; i < cblk_w; ++i) {
-									OPJ_INT32 tmp = tiledp[tileIndex];
-									tiledp[tileIndex] =
-										opj_int_fix_mul_t1(
-										tmp,
-										bandconst);
-									tileIndex++;
-								}
-								tileIndex += tileLineAdvance;
-							}
-						}
+	/* The code-blocks may have been encoded in any order: sum their distortion */
+	/* in the code-block order, so that the rate allocation does not depend on */
+	/* the number of threads. */
+	for (compno = 0; compno < tile->numcomps; ++compno) {
+		opj_tcd_tilecomp_t* tilec = &tile->comps[compno];
 
-						opj_t1_encode_cblk(
-								t1,
-								cblk,
-								band->bandno,
-								compno,
-								tilec->numresolutions - 1 - resno,
-								tccp->qmfbid,
-								band->stepsize,
-								tccp->cblksty,
-								tile->numcomps,
-								tile,
-								mct_norms,
-								mct_numcomps);
+		for (resno = 0; resno < tilec->numresolutions; ++resno) {
+			opj_tcd_resolution_t *res = &tilec->resolutions[resno];
+
+			for (bandno = 0; bandno < res->numbands; ++bandno) {
+				opj_tcd_band_t* band = &res->bands[bandno];
+
+				for (precno = 0; precno < res->pw * res->ph; ++precno) {
+					opj_tcd_precinct_t *prc = &band->precincts[precno];
+
+					for (cblkno = 0; cblkno < prc->cw * prc->ch; ++cblkno) {
+						opj_tcd_cblk_enc_t* cblk = &prc->cblks.enc[cblkno];
 
+						for (passno = 0; passno < cblk->totalpasses; ++passno) {
+							tile->distotile += cblk->passes[passno].distortion;
+						}
 					} /* cblkno */
 				} /* precno */
 			} /* bandno */
 		} /* resno  */
 	} /* compno  */
+
 	return OPJ_TRUE;
 }
 
@@ -1575,7 +1734,6 @@ void opj_t1_encode_cblk(opj_t1_t *t1,
                         OPJ_FLOAT64 stepsize,
                         OPJ_UINT32 cblksty,
                         OPJ_UINT32 numcomps,
-                        opj_tcd_tile_t * tile,
                         const OPJ_FLOAT64 * mct_norms,
                         OPJ_UINT32 mct_numcomps)
 {
@@ -1634,7 +1792,8 @@ void opj_t1_encode_cblk(opj_t1_t *t1,
 		/* fixed_quality */
 		tempwmsedec = opj_t1_getwmsedec(nmsedec, compno, level, orient, bpno, qmfbid, stepsize, numcomps,mct_norms, mct_numcomps) ;
 		cumwmsedec += tempwmsedec;
-		tile->distotile += tempwmsedec;
+		/* summed in tile->distotile by opj_t1_encode_cblks(), in the code-block order */
+		pass->distortion = tempwmsedec;
 
 		/* Code switch "RESTART" (i.e. TERMALL) */
 		if ((cblksty & J2K_CCP_CBLKSTY_TERMALL)	&& !((passtype == 2) && (bpno - 1 < 0))) {
@@ -93,6 +93,69 @@ in T1.C are used by some function in TCD.C.
 
 typedef OPJ_INT16 opj_flag_t;
 
+/*
+The decoder keeps the state of a column of 4 samples of a stripe in a single
+32-bit word: the significance (SIGMA) of the 3 columns x 6 rows around the
+4 samples, the sign (CHI) of the 6 rows of the column, and for each of the
+4 samples whether it has been refined (MU) and visited by the significance
+propagation pass (PI). The row r of the column has the same layout as the
+row 0, shifted left by 3*r bits, so T1_SIGMA_NEIGHBOURS << (3*r) gives the
+significance of its 8 neighbours.
+*/
+typedef OPJ_UINT32 opj_dec_flag_t;
+
+#define T1_SIGMA_0  (1U << 0)
+#define T1_SIGMA_1  (1U << 1)
+#define T1_SIGMA_2  (1U << 2)
+#define T1_SIGMA_3  (1U << 3)
+#define T1_SIGMA_4  (1U << 4)
+#define T1_SIGMA_5  (1U << 5)
+#define T1_SIGMA_6  (1U << 6)
+#define T1_SIGMA_7  (1U << 7)
+#define T1_SIGMA_8  (1U << 8)
+#define T1_SIGMA_15 (1U << 15)
+#define T1_SIGMA_16 (1U << 16)
+#define T1_SIGMA_17 (1U << 17)
+
+#define T1_CHI_0_I  18		/**< Sign of the row above the stripe */
+#define T1_CHI_1_I  19		/**< Sign of the row 0, the one of row r is at 19 + 3*r */
+#define T1_CHI_2_I  22
+#define T1_CHI_5_I  31		/**< Sign of the row below the stripe */
+#define T1_CHI_0    (1U << T1_CHI_0_I)
+#define T1_CHI_1    (1U << T1_CHI_1_I)
+#define T1_CHI_5    (1U << T1_CHI_5_I)
+#define T1_MU_0     (1U << 20)
+#define T1_PI_0     (1U << 21)
+#define T1_PI_1     (1U << 24)
+#define T1_PI_2     (1U << 27)
+#define T1_PI_3     (1U << 30)
+
+#define T1_SIGMA_NW   T1_SIGMA_0
+#define T1_SIGMA_N    T1_SIGMA_1
+#define T1_SIGMA_NE   T1_SIGMA_2
+#define T1_SIGMA_W    T1_SIGMA_3
+#define T1_SIGMA_THIS T1_SIGMA_4
+#define T1_SIGMA_E    T1_SIGMA_5
+#define T1_SIGMA_SW   T1_SIGMA_6
+#define T1_SIGMA_S    T1_SIGMA_7
+#define T1_SIGMA_SE   T1_SIGMA_8
+#define T1_SIGMA_NEIGHBOURS (T1_SIGMA_NW | T1_SIGMA_N | T1_SIGMA_NE | T1_SIGMA_W | T1_SIGMA_E | T1_SIGMA_SW | T1_SIGMA_S | T1_SIGMA_SE)
+
+#define T1_CHI_THIS   T1_CHI_1
+#define T1_CHI_THIS_I T1_CHI_1_I
+#define T1_MU_THIS    T1_MU_0
+#define T1_PI_THIS    T1_PI_0
+
+/* Bits of the index of lut_ctxno_sc_dec and lut_spb_dec */
+#define T1_LUT_SGN_W (1U << 0)
+#define T1_LUT_SIG_N (1U << 1)
+#define T1_LUT_SGN_E (1U << 2)
+#define T1_LUT_SIG_W (1U << 3)
+#define T1_LUT_SGN_N (1U << 4)
+#define T1_LUT_SIG_E (1U << 5)
+#define T1_LUT_SGN_S (1U << 6)
+#define T1_LUT_SIG_S (1U << 7)
+
 /**
 Tier-1 coding (coding of code-block coefficients)
 */
@@ -112,6 +175,14 @@ typedef struct opj_t1 {
 	OPJ_UINT32 flags_stride;
 	OPJ_UINT32 data_stride;
 	OPJ_BOOL   encoder;
+
+	/** Decoder flags, one word per column of each 4-row stripe, see opj_dec_flag_t */
+	opj_dec_flag_t *dec_flags;
+	OPJ_UINT32 dec_flagssize;
+
+	/** Copy of the code-block segment being decoded, padded for the MQ decoder */
+	OPJ_BYTE   *cblkdata;
+	OPJ_UINT32 cblkdatasize;
 } opj_t1_t;
 
 #define MACRO_t1_flags(x,y) t1->flags[((x)*(t1->flags_stride))+(y)]
@@ -121,29 +192,46 @@ typedef struct opj_t1 {
 /* ----------------------------------------------------------------------- */
 
 /**
-Encode the code-blocks of a tile
-@param t1 T1 handle
+Encode the code-blocks of a tile.
+Each code-block is submitted as a job to the thread pool; the function
+returns once all of them are encoded.
+@param tp Thread pool used to encode the code-blocks
 @param tile The tile to encode
 @param tcp Tile coding parameters
 @param mct_norms  FIXME DOC
 @param mct_numcomps Number of components used for MCT
 */
-OPJ_BOOL opj_t1_encode_cblks(   opj_t1_t *t1,
+OPJ_BOOL opj_t1_encode_cblks(   opj_thread_pool_t* tp,
                                 opj_tcd_tile_t *tile,
                                 opj_tcp_t *tcp,
                                 const OPJ_FLOAT64 * mct_norms,
                                 OPJ_UINT32 mct_numcomps);
 
 /**
-Decode the code-blocks of a tile
-@param t1 T1 handle
+Decode the code-blocks of a tile component.
+Each code-block is submitted as a job to the thread pool of the tile coder;
+the caller must call opj_thread_pool_wait_completion() before using the
+decoded coefficients. Code-blocks that do not contribute to the area to
+decode of the tile coder are not decoded: their coefficients are set to zero.
+@param tcd TCD handle (thread pool, kernels and area to decode)
+@param pret Set to OPJ_FALSE by the jobs in case of error (must be OPJ_TRUE on input)
+@param compno Component number of tilec
 @param tilec The tile to decode
 @param tccp Tile coding parameters
+@return OPJ_FALSE if a job could not be submitted
 */
-OPJ_BOOL opj_t1_decode_cblks(   opj_t1_t* t1,
+OPJ_BOOL opj_t1_decode_cblks(   opj_tcd_t* tcd,
+                                volatile OPJ_BOOL* pret,
+                                OPJ_UINT32 compno,
                                 opj_tcd_tilecomp_t* tilec,
                                 opj_tccp_t* tccp);
 
+/**
+Fills the T1 entries of a kernel table.
+@param p_kernels Table to fill
+@param p_level Level of the kernels (OPJ_CPU_LEVEL_xxx)
+*/
+void opj_t1_init_kernels(opj_kernels_t* p_kernels, OPJ_UINT32 p_level);
 
 
 /**
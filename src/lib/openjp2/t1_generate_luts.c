@@ -176,6 +176,34 @@ static int t1_init_spb(int f) {
 	return n;
 }
 
+/* Converts the 3x3 significance window of a decoder flags word to the per-sample flags */
+static int t1_sigma_to_flags(unsigned int sigma) {
+	int f = 0;
+	if (sigma & T1_SIGMA_NW) f |= T1_SIG_NW;
+	if (sigma & T1_SIGMA_N) f |= T1_SIG_N;
+	if (sigma & T1_SIGMA_NE) f |= T1_SIG_NE;
+	if (sigma & T1_SIGMA_W) f |= T1_SIG_W;
+	if (sigma & T1_SIGMA_E) f |= T1_SIG_E;
+	if (sigma & T1_SIGMA_SW) f |= T1_SIG_SW;
+	if (sigma & T1_SIGMA_S) f |= T1_SIG_S;
+	if (sigma & T1_SIGMA_SE) f |= T1_SIG_SE;
+	return f;
+}
+
+/* Converts an index of lut_ctxno_sc_dec and lut_spb_dec to the per-sample flags */
+static int t1_lut_index_to_flags(unsigned int lu) {
+	int f = 0;
+	if (lu & T1_LUT_SGN_W) f |= T1_SGN_W;
+	if (lu & T1_LUT_SIG_N) f |= T1_SIG_N;
+	if (lu & T1_LUT_SGN_E) f |= T1_SGN_E;
+	if (lu & T1_LUT_SIG_W) f |= T1_SIG_W;
+	if (lu & T1_LUT_SGN_N) f |= T1_SGN_N;
+	if (lu & T1_LUT_SIG_E) f |= T1_SIG_E;
+	if (lu & T1_LUT_SGN_S) f |= T1_SGN_S;
+	if (lu & T1_LUT_SIG_S) f |= T1_SIG_S;
+	return f;
+}
+
 static void dump_array16(int array[],int size){
 	int i;
 	--size;
@@ -240,6 +268,36 @@ int main(int argc, char **argv)
 	}
 	printf("%i\n};\n\n", t1_init_spb(255 << 4));
 
+	/* lut_ctxno_zc_dec */
+	printf("static OPJ_BYTE lut_ctxno_zc_dec[2048] = {\n  ");
+	for (i = 0; i < 2048; ++i) {
+		int orient = i >> 9;
+		if (orient == 2) {
+			orient = 1;
+		} else if (orient == 1) {
+			orient = 2;
+		}
+		printf(i < 2047 ? "%i, " : "%i\n};\n\n", t1_init_ctxno_zc(t1_sigma_to_flags((unsigned int)i & 0x1ff), orient));
+		if(i < 2047 && !((i+1)&0x1f))
+			printf("\n  ");
+	}
+
+	/* lut_ctxno_sc_dec */
+	printf("static OPJ_BYTE lut_ctxno_sc_dec[256] = {\n  ");
+	for (i = 0; i < 256; ++i) {
+		printf(i < 255 ? "0x%x, " : "0x%x\n};\n\n", t1_init_ctxno_sc(t1_lut_index_to_flags((unsigned int)i)));
+		if(i < 255 && !((i+1)&0xf))
+			printf("\n  ");
+	}
+
+	/* lut_spb_dec */
+	printf("static OPJ_BYTE lut_spb_dec[256] = {\n  ");
+	for (i = 0; i < 256; ++i) {
+		printf(i < 255 ? "%i, " : "%i\n};\n\n", t1_init_spb(t1_lut_index_to_flags((unsigned int)i)));
+		if(i < 255 && !((i+1)&0x1f))
+			printf("\n  ");
+	}
+
 	/* FIXME FIXME FIXME */
 	/* fprintf(stdout,"nmsedec luts:\n"); */
 	for (i = 0; i < (1 << T1_NMSEDEC_BITS); ++i) {
@@ -108,6 +108,24 @@ static OPJ_BOOL opj_t2_skip_packet( opj_t2_t* p_t2,
                                     OPJ_UINT32 p_max_length,
                                     opj_packet_info_t *p_pack_info);
 
+/**
+Reads the header of a packet that is not decoded, for the state of its precinct: the headers
+of its next packets go on from it. The body of the packet does not have to follow its header.
+@param t2 T2 handle
+@param tile Tile for which to read the header
+@param tcp Tile coding parameters
+@param pi Packet identity
+@param src Source buffer
+@param length Number of bytes of the packet at src, from its packet length
+@return OPJ_FALSE if the header is invalid
+*/
+static OPJ_BOOL opj_t2_read_packet_state(   opj_t2_t* p_t2,
+                                            opj_tcd_tile_t *p_tile,
+                                            opj_tcp_t *p_tcp,
+                                            opj_pi_iterator_t *p_pi,
+                                            OPJ_BYTE *p_src,
+                                            OPJ_UINT32 p_length);
+
 static OPJ_BOOL opj_t2_read_packet_header(  opj_t2_t* p_t2,
                                             opj_tcd_tile_t *p_tile,
                                             opj_tcp_t *p_tcp,
@@ -362,9 +380,27 @@ OPJ_BOOL opj_t2_decode_packets( opj_t2_t *p_t2,
 #endif 
         opj_packet_info_t *l_pack_info = 00;
         opj_image_comp_t* l_img_comp = 00;
+        const OPJ_UINT32 *l_packet_lengths = p_t2->packet_lengths;
+        OPJ_UINT32 l_packet_no = 0;
+        OPJ_BOOL l_read_headers = OPJ_FALSE;
 
         OPJ_ARG_NOT_USED(p_cstr_index);
 
+        /* with packed packet headers (PPM/PPT), every header has to be read in turn */
+        if (l_cp->ppm || l_tcp->ppt) {
+                l_packet_lengths = 00;
+        }
+        else if (l_packet_lengths) {
+                /* when the packets known do not take all the data, the packets after */
+                /* them are found from their headers */
+                OPJ_UINT64 l_known_length = 0;
+                OPJ_UINT32 i;
+                for (i = 0; i < p_t2->nb_packet_lengths; ++i) {
+                        l_known_length += l_packet_lengths[i];
+                }
+                l_read_headers = (l_known_length < p_max_len);
+        }
+
 #ifdef TODO_MSD
         if (p_cstr_index) {
                 l_pack_info = p_cstr_index->tile_index[p_tile_no].packet;
@@ -419,9 +455,34 @@ OPJ_BOOL opj_t2_decode_packets( opj_t2_t *p_t2,
                                         return OPJ_FALSE;
                                 }
 
+                                /* the packet lengths are trusted as long as they match the packets decoded */
+                                if (l_packet_lengths && l_packet_no < p_t2->nb_packet_lengths
+                                    && l_packet_lengths[l_packet_no] != l_nb_bytes_read) {
+                                        l_packet_lengths = 00;
+                                }
+
                                 l_img_comp = &(l_image->comps[l_current_pi->compno]);
                                 l_img_comp->resno_decoded = opj_uint_max(l_current_pi->resno, l_img_comp->resno_decoded);
                         }
+                        else if (l_packet_lengths && l_packet_no < p_t2->nb_packet_lengths
+                                 && l_packet_lengths[l_packet_no] <= p_max_len) {
+                                /* the packet is not needed and its length is known (PLT/PLM): */
+                                /* its body is not read. The later packets of its precinct are not */
+                                /* needed either, so its state only matters when their headers are */
+                                /* read, after the lengths known */
+                                l_nb_bytes_read = l_packet_lengths[l_packet_no];
+                                if (l_read_headers && l_nb_bytes_read > 0
+                                    && ! opj_t2_read_packet_state(p_t2,p_tile,l_tcp,l_current_pi,l_current_data,l_nb_bytes_read)) {
+                                        opj_pi_destroy(l_pi,l_nb_pocs);
+                                        opj_free(first_pass_failed);
+                                        return OPJ_FALSE;
+                                }
+                        }
+                        else if (p_max_len == 0) {
+                                /* the data of the tile stops at its last packet needed (see */
+                                /* opj_j2k_read_sod()): the packets after it are left out */
+                                l_nb_bytes_read = 0;
+                        }
                         else {
                                 l_nb_bytes_read = 0;
                                 if (! opj_t2_skip_packet(p_t2,p_tile,l_tcp,l_current_pi,l_current_data,&l_nb_bytes_read,p_max_len,l_pack_info)) {
@@ -430,6 +491,7 @@ OPJ_BOOL opj_t2_decode_packets( opj_t2_t *p_t2,
                                         return OPJ_FALSE;
                                 }
                         }
+                        ++l_packet_no;
 
                         if (first_pass_failed[l_current_pi->compno]) {
                                 l_img_comp = &(l_image->comps[l_current_pi->compno]);
@@ -511,6 +573,143 @@ void opj_t2_destroy(opj_t2_t *t2) {
         }
 }
 
+opj_t2_scan_t* opj_t2_create_scan(opj_t2_t *p_t2, OPJ_UINT32 p_tile_no, opj_tcd_tile_t *p_tile)
+{
+        opj_t2_scan_t *l_scan = (opj_t2_scan_t*)opj_calloc(1,sizeof(opj_t2_scan_t));
+        if (!l_scan) {
+                return NULL;
+        }
+
+        l_scan->pi = opj_pi_create_decode(p_t2->image, p_t2->cp, p_tile_no);
+        if (!l_scan->pi) {
+                opj_free(l_scan);
+                return NULL;
+        }
+        l_scan->t2 = p_t2;
+        l_scan->tileno = p_tile_no;
+        l_scan->tile = p_tile;
+        l_scan->nb_pocs = p_t2->cp->tcps[p_tile_no].numpocs + 1;
+        l_scan->pino = 0;
+
+        return l_scan;
+}
+
+OPJ_BOOL opj_t2_scan_next(opj_t2_scan_t *p_scan)
+{
+        while (p_scan->pino < p_scan->nb_pocs) {
+                opj_pi_iterator_t *l_current_pi = &p_scan->pi[p_scan->pino];
+
+                if (l_current_pi->poc.prg == OPJ_PROG_UNKNOWN) {
+                        return OPJ_FALSE;
+                }
+                if (opj_pi_next(l_current_pi)) {
+                        return OPJ_TRUE;
+                }
+                ++p_scan->pino;
+        }
+
+        return OPJ_FALSE;
+}
+
+OPJ_BOOL opj_t2_scan_packet(opj_t2_scan_t *p_scan,
+                            OPJ_BYTE *p_src,
+                            OPJ_UINT32 p_available,
+                            OPJ_UINT32 p_max_length,
+                            OPJ_UINT32 * p_header_length,
+                            OPJ_UINT32 * p_length)
+{
+        opj_pi_iterator_t *l_current_pi = &p_scan->pi[p_scan->pino];
+        opj_tcp_t *l_tcp = &(p_scan->t2->cp->tcps[p_scan->tileno]);
+        OPJ_BOOL l_read_data;
+        OPJ_UINT32 l_header_length = 0;
+        OPJ_UINT32 l_body_length = 0;
+
+        *p_header_length = 0;
+        *p_length = 0;
+
+        if (! opj_t2_read_packet_header(p_scan->t2,p_scan->tile,l_tcp,l_current_pi,&l_read_data,p_src,&l_header_length,p_available,00)) {
+                return OPJ_FALSE;
+        }
+
+        /* the bits of a header stop where the data does: a header that reaches */
+        /* the end of the bytes available may not be complete */
+        if (p_available < p_max_length && l_header_length >= p_available) {
+                return OPJ_FALSE;
+        }
+
+        if (l_read_data) {
+                if (! opj_t2_skip_packet_data(p_scan->t2,p_scan->tile,l_current_pi,&l_body_length,p_max_length - l_header_length,00)) {
+                        return OPJ_FALSE;
+                }
+        }
+
+        *p_header_length = l_header_length;
+        *p_length = l_header_length + l_body_length;
+        return OPJ_TRUE;
+}
+
+void opj_t2_destroy_scan(opj_t2_scan_t *p_scan)
+{
+        if (p_scan) {
+                opj_pi_destroy(p_scan->pi, p_scan->nb_pocs);
+                opj_free(p_scan);
+        }
+}
+
+OPJ_BOOL opj_t2_get_needed_packets(	opj_t2_t *p_t2,
+                                    OPJ_UINT32 p_tile_no,
+                                    OPJ_BYTE ** p_needed,
+                                    OPJ_UINT32 * p_nb_packets)
+{
+        opj_tcp_t *l_tcp = &(p_t2->cp->tcps[p_tile_no]);
+        OPJ_UINT32 l_reduce = p_t2->cp->m_specific_param.m_dec.m_reduce;
+        opj_t2_scan_t *l_scan = 00;
+        OPJ_BYTE *l_needed = 00;
+        OPJ_UINT32 l_nb_packets = 0;
+        OPJ_UINT32 l_max_packets = 0;
+
+        *p_needed = 00;
+        *p_nb_packets = 0;
+
+        l_scan = opj_t2_create_scan(p_t2, p_tile_no, 00);
+        if (!l_scan) {
+                return OPJ_FALSE;
+        }
+
+        while (opj_t2_scan_next(l_scan)) {
+                opj_pi_iterator_t *l_current_pi = &l_scan->pi[l_scan->pino];
+                OPJ_UINT32 l_numresolutions = l_tcp->tccps[l_current_pi->compno].numresolutions;
+                /* as the minimum_num_resolutions of the tile components (see opj_tcd_init_tile()) */
+                OPJ_UINT32 l_min_resolutions = (l_numresolutions < l_reduce) ? 1 : l_numresolutions - l_reduce;
+
+                if (l_nb_packets == l_max_packets) {
+                        OPJ_BYTE *l_new_needed;
+                        if (l_max_packets > ((OPJ_UINT32)-1) / 2) {
+                                opj_free(l_needed);
+                                opj_t2_destroy_scan(l_scan);
+                                return OPJ_FALSE;
+                        }
+                        l_max_packets = l_max_packets ? 2 * l_max_packets : 256;
+                        l_new_needed = (OPJ_BYTE*)opj_realloc(l_needed, l_max_packets);
+                        if (!l_new_needed) {
+                                opj_free(l_needed);
+                                opj_t2_destroy_scan(l_scan);
+                                return OPJ_FALSE;
+                        }
+                        l_needed = l_new_needed;
+                }
+
+                /* the same test as opj_t2_decode_packets() */
+                l_needed[l_nb_packets++] = (OPJ_BYTE)(l_tcp->num_layers_to_decode > l_current_pi->layno
+                                                      && l_current_pi->resno < l_min_resolutions);
+        }
+        opj_t2_destroy_scan(l_scan);
+
+        *p_needed = l_needed;
+        *p_nb_packets = l_nb_packets;
+        return OPJ_TRUE;
+}
+
 OPJ_BOOL opj_t2_decode_packet(  opj_t2_t* p_t2,
                                 opj_tcd_tile_t *p_tile,
                                 opj_tcp_t *p_tcp,
@@ -824,6 +1023,31 @@ static OPJ_BOOL opj_t2_skip_packet( opj_t2_t* p_t2,
         return OPJ_TRUE;
 }
 
+static OPJ_BOOL opj_t2_read_packet_state(   opj_t2_t* p_t2,
+                                            opj_tcd_tile_t *p_tile,
+                                            opj_tcp_t *p_tcp,
+                                            opj_pi_iterator_t *p_pi,
+                                            OPJ_BYTE *p_src,
+                                            OPJ_UINT32 p_length)
+{
+        OPJ_BOOL l_read_data;
+        OPJ_UINT32 l_nb_bytes_read = 0;
+
+        if (! opj_t2_read_packet_header(p_t2,p_tile,p_tcp,p_pi,&l_read_data,p_src,&l_nb_bytes_read,p_length,00)) {
+                return OPJ_FALSE;
+        }
+
+        /* the segments of the code-blocks are counted, their data is not looked at */
+        if (l_read_data) {
+                l_nb_bytes_read = 0;
+                if (! opj_t2_skip_packet_data(p_t2,p_tile,p_pi,&l_nb_bytes_read,(OPJ_UINT32)-1,00)) {
+                        return OPJ_FALSE;
+                }
+        }
+
+        return OPJ_TRUE;
+}
+
 
 OPJ_BOOL opj_t2_read_packet_header( opj_t2_t* p_t2,
                                     opj_tcd_tile_t *p_tile,
@@ -56,8 +56,31 @@ typedef struct opj_t2 {
 	opj_image_t *image;
 	/** pointer to the image coding parameters */
 	opj_cp_t *cp;
+	/** Decoding: lengths of the packets of the tile from PLT/PLM markers, NULL if unknown */
+	const OPJ_UINT32 *packet_lengths;
+	/** Decoding: number of packet lengths */
+	OPJ_UINT32 nb_packet_lengths;
 } opj_t2_t;
 
+/**
+Reading of the packet headers of a tile one after the other, in the progression order,
+to find the length of each packet without its body
+*/
+typedef struct opj_t2_scan {
+	/** T2 handle */
+	opj_t2_t *t2;
+	/** number of the tile */
+	OPJ_UINT32 tileno;
+	/** tile whose precincts keep the state of the packet headers, NULL if headers are not read */
+	opj_tcd_tile_t *tile;
+	/** packet iterators of the tile, one per progression order change */
+	opj_pi_iterator_t *pi;
+	/** number of packet iterators */
+	OPJ_UINT32 nb_pocs;
+	/** packet iterator of the current packet */
+	OPJ_UINT32 pino;
+} opj_t2_scan_t;
+
 /** @name Exported functions */
 /*@{*/
 /* ----------------------------------------------------------------------- */
@@ -110,6 +133,58 @@ OPJ_BOOL opj_t2_decode_packets(	opj_t2_t *t2,
                                 OPJ_UINT32 len,
                                 opj_codestream_index_t *cstr_info);
 
+/**
+Lists the packets of a tile that the decoding needs, with the reduction and the number of layers to decode
+@param t2           T2 handle
+@param tileno       number of the tile
+@param p_needed     set to an array telling for each packet, in the progression order, if it is needed (to free with opj_free)
+@param p_nb_packets set to the number of packets of the tile
+@return OPJ_FALSE if the packets cannot be listed
+*/
+OPJ_BOOL opj_t2_get_needed_packets(	opj_t2_t *t2,
+                                    OPJ_UINT32 tileno,
+                                    OPJ_BYTE ** p_needed,
+                                    OPJ_UINT32 * p_nb_packets);
+
+/**
+Starts reading the packet headers of a tile, before its first packet
+@param t2     T2 handle
+@param tileno number of the tile
+@param tile   tile whose precincts keep the state of the headers (see opj_tcd_init_decode_tile()), NULL to only iterate
+@return a new scan handle if successful, NULL otherwise
+*/
+opj_t2_scan_t* opj_t2_create_scan(opj_t2_t *t2, OPJ_UINT32 tileno, opj_tcd_tile_t *tile);
+
+/**
+Moves a scan to the next packet of its tile
+@param scan scan handle
+@return OPJ_FALSE if there is no more packet
+*/
+OPJ_BOOL opj_t2_scan_next(opj_t2_scan_t *scan);
+
+/**
+Reads the header of the current packet of a scan to find the length of the packet
+@param scan        scan handle
+@param src         the data of the packet
+@param available   number of bytes available at src
+@param max_length  number of bytes left in the tile-part from src, not all of them being available
+@param p_header_length set to the length of the header of the packet
+@param p_length    set to the length of the packet, header and body
+@return OPJ_FALSE if the header is invalid or may go on past the bytes available
+*/
+OPJ_BOOL opj_t2_scan_packet(opj_t2_scan_t *scan,
+                            OPJ_BYTE *src,
+                            OPJ_UINT32 available,
+                            OPJ_UINT32 max_length,
+                            OPJ_UINT32 * p_header_length,
+                            OPJ_UINT32 * p_length);
+
+/**
+Destroys a scan handle
+@param scan scan handle to destroy
+*/
+void opj_t2_destroy_scan(opj_t2_scan_t *scan);
+
 /**
  * Creates a Tier 2 handle
  *
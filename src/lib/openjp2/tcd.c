@@ -154,7 +154,12 @@ static OPJ_BOOL opj_tcd_dwt_decode (opj_tcd_t *p_tcd);
 
 static OPJ_BOOL opj_tcd_mct_decode (opj_tcd_t *p_tcd);
 
-static OPJ_BOOL opj_tcd_dc_level_shift_decode (opj_tcd_t *p_tcd);
+/**
+Inverse MCT, DC level shift and clamp of the decoded tile. The reversible and
+irreversible MCT of the first three components are fused with the DC level
+shift, so that the samples are read and written once.
+*/
+static OPJ_BOOL opj_tcd_mct_dc_level_shift_decode (opj_tcd_t *p_tcd);
 
 
 static OPJ_BOOL opj_tcd_dc_level_shift_encode ( opj_tcd_t *p_tcd );
@@ -586,10 +591,34 @@ OPJ_BOOL opj_tcd_rateallocate(  opj_tcd_t *tcd,
 
 OPJ_BOOL opj_tcd_init( opj_tcd_t *p_tcd,
                                            opj_image_t * p_image,
-                                           opj_cp_t * p_cp )
+                                           opj_cp_t * p_cp,
+                                           opj_thread_pool_t* p_tp,
+                                           const opj_kernels_t* p_kernels )
 {
         p_tcd->image = p_image;
         p_tcd->cp = p_cp;
+        p_tcd->thread_pool = p_tp;
+        p_tcd->kernels = p_kernels;
+
+        if (p_tcd->tcd_image->tiles) {
+                opj_tcd_tile_t * l_tile = p_tcd->tcd_image->tiles;
+                if (l_tile->comps && l_tile->numcomps == p_image->numcomps) {
+                        /* recycle the resolutions, precincts, code-blocks and samples of the */
+                        /* previous tile: opj_tcd_init_tile() only reallocates what must grow */
+                        OPJ_UINT32 compno;
+                        for (compno = 0; compno < l_tile->numcomps; ++compno) {
+                                opj_tcd_tilecomp_t * l_tilec = l_tile->comps + compno;
+                                if (! l_tilec->ownsData) {
+                                        /* samples borrowed from the previous image */
+                                        l_tilec->data = 00;
+                                        l_tilec->data_size = 0;
+                                }
+                        }
+                        p_tcd->tp_pos = p_cp->m_specific_param.m_enc.m_tp_pos;
+                        return OPJ_TRUE;
+                }
+                opj_tcd_free_tile(p_tcd);
+        }
 
         p_tcd->tcd_image->tiles = (opj_tcd_tile_t *) opj_calloc(1,sizeof(opj_tcd_tile_t));
         if (! p_tcd->tcd_image->tiles) {
@@ -1083,7 +1112,10 @@ static OPJ_BOOL opj_tcd_code_block_enc_allocate_data (opj_tcd_cblk_enc_t * p_cod
 {
 	OPJ_UINT32 l_data_size;
 	
-	l_data_size = (OPJ_UINT32)((p_code_block->x1 - p_code_block->x0) * (p_code_block->y1 - p_code_block->y0) * (OPJ_INT32)sizeof(OPJ_UINT32));
+	/* The byte preceding the data is read by opj_mqc_init_enc(), and the flushes of the */
+	/* MQ coder (one per terminated pass) may output more bytes than the samples of tiny */
+	/* code-blocks: keep some room for them, even for empty code-blocks. */
+	l_data_size = 26 + (OPJ_UINT32)((p_code_block->x1 - p_code_block->x0) * (p_code_block->y1 - p_code_block->y0) * (OPJ_INT32)sizeof(OPJ_UINT32));
 	
 	if (l_data_size > p_code_block->data_size) {
 		if (p_code_block->data) {
@@ -1263,8 +1295,14 @@ OPJ_BOOL opj_tcd_encode_tile(   opj_tcd_t *p_tcd,
 }
 
 OPJ_BOOL opj_tcd_decode_tile(   opj_tcd_t *p_tcd,
+                                OPJ_UINT32 p_win_x0,
+                                OPJ_UINT32 p_win_y0,
+                                OPJ_UINT32 p_win_x1,
+                                OPJ_UINT32 p_win_y1,
                                 OPJ_BYTE *p_src,
                                 OPJ_UINT32 p_max_length,
+                                const OPJ_UINT32 *p_packet_lengths,
+                                OPJ_UINT32 p_nb_packet_lengths,
                                 OPJ_UINT32 p_tile_no,
                                 opj_codestream_index_t *p_cstr_index
                                 )
@@ -1272,6 +1310,12 @@ OPJ_BOOL opj_tcd_decode_tile(   opj_tcd_t *p_tcd,
         OPJ_UINT32 l_data_read;
         p_tcd->tcd_tileno = p_tile_no;
         p_tcd->tcp = &(p_tcd->cp->tcps[p_tile_no]);
+        p_tcd->win_x0 = p_win_x0;
+        p_tcd->win_y0 = p_win_y0;
+        p_tcd->win_x1 = p_win_x1;
+        p_tcd->win_y1 = p_win_y1;
+        p_tcd->packet_lengths = p_nb_packet_lengths ? p_packet_lengths : 00;
+        p_tcd->nb_packet_lengths = p_nb_packet_lengths;
 
 #ifdef TODO_MSD /* FIXME */
         /* INDEX >>  */
@@ -1325,23 +1369,15 @@ OPJ_BOOL opj_tcd_decode_tile(   opj_tcd_t *p_tcd,
         }
         /* FIXME _ProfStop(PGROUP_DWT); */
 
-        /*----------------MCT-------------------*/
+        /*----------------MCT + DC SHIFT--------*/
         /* FIXME _ProfStart(PGROUP_MCT); */
         if
-                (! opj_tcd_mct_decode(p_tcd))
+                (! opj_tcd_mct_dc_level_shift_decode(p_tcd))
         {
                 return OPJ_FALSE;
         }
         /* FIXME _ProfStop(PGROUP_MCT); */
 
-        /* FIXME _ProfStart(PGROUP_DC_SHIFT); */
-        if
-                (! opj_tcd_dc_level_shift_decode(p_tcd))
-        {
-                return OPJ_FALSE;
-        }
-        /* FIXME _ProfStop(PGROUP_DC_SHIFT); */
-
 
         /*---------------TILE-------------------*/
         return OPJ_TRUE;
@@ -1462,7 +1498,7 @@ OPJ_BOOL opj_tcd_update_tile_data ( opj_tcd_t *p_tcd,
 
 
 
-void opj_tcd_free_tile(opj_tcd_t *p_tcd)
+void opj_tcd_release_tile(opj_tcd_t *p_tcd)
 {
         OPJ_UINT32 compno, resno, bandno, precno;
         opj_tcd_tile_t *l_tile = 00;
@@ -1526,6 +1562,7 @@ void opj_tcd_free_tile(opj_tcd_t *p_tcd)
 
                         opj_free(l_tile_comp->resolutions);
                         l_tile_comp->resolutions = 00;
+                        l_tile_comp->resolutions_size = 0;
                 }
 
                 if (l_tile_comp->ownsData && l_tile_comp->data) {
@@ -1537,6 +1574,18 @@ void opj_tcd_free_tile(opj_tcd_t *p_tcd)
                 }
                 ++l_tile_comp;
         }
+}
+
+void opj_tcd_free_tile(opj_tcd_t *p_tcd)
+{
+        opj_tcd_tile_t *l_tile = 00;
+
+        if (! p_tcd || ! p_tcd->tcd_image || ! p_tcd->tcd_image->tiles) {
+                return;
+        }
+        l_tile = p_tcd->tcd_image->tiles;
+
+        opj_tcd_release_tile(p_tcd);
 
         opj_free(l_tile->comps);
         l_tile->comps = 00;
@@ -1558,6 +1607,8 @@ OPJ_BOOL opj_tcd_t2_decode (opj_tcd_t *p_tcd,
         if (l_t2 == 00) {
                 return OPJ_FALSE;
         }
+        l_t2->packet_lengths = p_tcd->packet_lengths;
+        l_t2->nb_packet_lengths = p_tcd->nb_packet_lengths;
 
         if (! opj_t2_decode_packets(
                                         l_t2,
@@ -1580,30 +1631,23 @@ OPJ_BOOL opj_tcd_t2_decode (opj_tcd_t *p_tcd,
 OPJ_BOOL opj_tcd_t1_decode ( opj_tcd_t *p_tcd )
 {
         OPJ_UINT32 compno;
-        opj_t1_t * l_t1;
         opj_tcd_tile_t * l_tile = p_tcd->tcd_image->tiles;
         opj_tcd_tilecomp_t* l_tile_comp = l_tile->comps;
         opj_tccp_t * l_tccp = p_tcd->tcp->tccps;
-
-
-        l_t1 = opj_t1_create(OPJ_FALSE);
-        if (l_t1 == 00) {
-                return OPJ_FALSE;
-        }
+        volatile OPJ_BOOL ret = OPJ_TRUE;
 
         for (compno = 0; compno < l_tile->numcomps; ++compno) {
-                /* The +3 is headroom required by the vectorized DWT */
-                if (OPJ_FALSE == opj_t1_decode_cblks(l_t1, l_tile_comp, l_tccp)) {
-                        opj_t1_destroy(l_t1);
-                        return OPJ_FALSE;
+                if (OPJ_FALSE == opj_t1_decode_cblks(p_tcd, &ret, compno, l_tile_comp, l_tccp)) {
+                        break;
                 }
                 ++l_tile_comp;
                 ++l_tccp;
         }
 
-        opj_t1_destroy(l_t1);
+        /* the code-blocks of all components are decoded concurrently */
+        opj_thread_pool_wait_completion(p_tcd->thread_pool, 0);
 
-        return OPJ_TRUE;
+        return ret;
 }
 
 
@@ -1616,6 +1660,13 @@ OPJ_BOOL opj_tcd_dwt_decode ( opj_tcd_t *p_tcd )
         opj_image_comp_t * l_img_comp = p_tcd->image->comps;
 
         for (compno = 0; compno < l_tile->numcomps; compno++) {
+                /* area to decode, in coordinates of the last decoded resolution level */
+                opj_tcd_resolution_t * l_res = l_tile_comp->resolutions + l_img_comp->resno_decoded;
+                OPJ_UINT32 l_level = l_tile_comp->numresolutions - 1 - l_img_comp->resno_decoded;
+                OPJ_UINT32 l_win_x0 = opj_uint_max((OPJ_UINT32)l_res->x0, opj_uint_ceildivpow2(opj_uint_ceildiv(p_tcd->win_x0, l_img_comp->dx), l_level));
+                OPJ_UINT32 l_win_y0 = opj_uint_max((OPJ_UINT32)l_res->y0, opj_uint_ceildivpow2(opj_uint_ceildiv(p_tcd->win_y0, l_img_comp->dy), l_level));
+                OPJ_UINT32 l_win_x1 = opj_uint_min((OPJ_UINT32)l_res->x1, opj_uint_ceildivpow2(opj_uint_ceildiv(p_tcd->win_x1, l_img_comp->dx), l_level));
+                OPJ_UINT32 l_win_y1 = opj_uint_min((OPJ_UINT32)l_res->y1, opj_uint_ceildivpow2(opj_uint_ceildiv(p_tcd->win_y1, l_img_comp->dy), l_level));
                 /*
                 if (tcd->cp->reduce != 0) {
                         tcd->image->comps[compno].resno_decoded =
@@ -1630,12 +1681,12 @@ OPJ_BOOL opj_tcd_dwt_decode ( opj_tcd_t *p_tcd )
                 */
 
                 if (l_tccp->qmfbid == 1) {
-                        if (! opj_dwt_decode(l_tile_comp, l_img_comp->resno_decoded+1)) {
+                        if (! opj_dwt_decode(p_tcd->kernels, l_tile_comp, l_img_comp->resno_decoded+1, l_win_x0, l_win_y0, l_win_x1, l_win_y1)) {
                                 return OPJ_FALSE;
                         }
                 }
                 else {
-                        if (! opj_dwt_decode_real(l_tile_comp, l_img_comp->resno_decoded+1)) {
+                        if (! opj_dwt_decode_real(p_tcd->kernels, l_tile_comp, l_img_comp->resno_decoded+1, l_win_x0, l_win_y0, l_win_x1, l_win_y1)) {
                                 return OPJ_FALSE;
                         }
                 }
@@ -1703,16 +1754,16 @@ OPJ_BOOL opj_tcd_mct_decode ( opj_tcd_t *p_tcd )
                 }
                 else {
                         if (l_tcp->tccps->qmfbid == 1) {
-                                opj_mct_decode(     l_tile->comps[0].data,
-                                                        l_tile->comps[1].data,
-                                                        l_tile->comps[2].data,
-                                                        l_samples);
+                                p_tcd->kernels->mct_decode(l_tile->comps[0].data,
+                                                           l_tile->comps[1].data,
+                                                           l_tile->comps[2].data,
+                                                           l_samples);
                         }
                         else {
-                            opj_mct_decode_real((OPJ_FLOAT32*)l_tile->comps[0].data,
-                                                (OPJ_FLOAT32*)l_tile->comps[1].data,
-                                                (OPJ_FLOAT32*)l_tile->comps[2].data,
-                                                l_samples);
+                            p_tcd->kernels->mct_decode_real((OPJ_FLOAT32*)l_tile->comps[0].data,
+                                                            (OPJ_FLOAT32*)l_tile->comps[1].data,
+                                                            (OPJ_FLOAT32*)l_tile->comps[2].data,
+                                                            l_samples);
                         }
                 }
         }
@@ -1725,62 +1776,178 @@ OPJ_BOOL opj_tcd_mct_decode ( opj_tcd_t *p_tcd )
 }
 
 
-OPJ_BOOL opj_tcd_dc_level_shift_decode ( opj_tcd_t *p_tcd )
+/**
+ * Job of the DC level shift (and inverse MCT) of a band of rows of a tile.
+ */
+typedef struct
 {
-        OPJ_UINT32 compno;
+        const opj_kernels_t* kernels;
+        /** first sample of the band in each component (only c[0] without MCT) */
+        OPJ_INT32* c[3];
+        /** OPJ_TRUE to apply the inverse MCT to the three components */
+        OPJ_BOOL mct;
+        /** OPJ_TRUE if the samples are floats (9-7 transform) */
+        OPJ_BOOL real;
+        OPJ_UINT32 width;
+        OPJ_UINT32 height;
+        /** distance between two rows, in samples */
+        OPJ_UINT32 stride;
+        OPJ_INT32 shift[3];
+        OPJ_INT32 min[3];
+        OPJ_INT32 max[3];
+} opj_tcd_dc_shift_job_t;
+
+/** Minimum number of rows of a band run as a separate job */
+#define OPJ_TCD_DC_SHIFT_MIN_ROWS 32
+
+static void opj_tcd_dc_level_shift_processor(void* user_data, opj_tls_t* tls)
+{
+        opj_tcd_dc_shift_job_t* l_job = (opj_tcd_dc_shift_job_t*) user_data;
+        OPJ_INT32 *c0 = l_job->c[0], *c1 = l_job->c[1], *c2 = l_job->c[2];
+        OPJ_UINT32 j;
+
+        (void)tls;
+
+        for (j = 0; j < l_job->height; ++j) {
+                if (l_job->mct) {
+                        if (l_job->real) {
+                                l_job->kernels->mct_decode_real_shift(c0, c1, c2, l_job->width, l_job->shift, l_job->min, l_job->max);
+                        }
+                        else {
+                                l_job->kernels->mct_decode_shift(c0, c1, c2, l_job->width, l_job->shift, l_job->min, l_job->max);
+                        }
+                        c1 += l_job->stride;
+                        c2 += l_job->stride;
+                }
+                else if (l_job->real) {
+                        l_job->kernels->dc_shift_real(c0, l_job->width, l_job->shift[0], l_job->min[0], l_job->max[0]);
+                }
+                else {
+                        l_job->kernels->dc_shift(c0, l_job->width, l_job->shift[0], l_job->min[0], l_job->max[0]);
+                }
+                c0 += l_job->stride;
+        }
+}
+
+/**
+ * Runs a DC level shift job, split in bands of rows run by the threads of
+ * the pool when it has some and the tile component is high enough.
+ */
+static void opj_tcd_dc_level_shift_run(opj_tcd_t *p_tcd, opj_tcd_dc_shift_job_t* p_job)
+{
+        OPJ_UINT32 l_nb_bands = (OPJ_UINT32)opj_thread_pool_get_thread_count(p_tcd->thread_pool);
+        opj_tcd_dc_shift_job_t* l_bands = 00;
+        OPJ_UINT32 i, l_y0 = 0;
+
+        l_nb_bands = opj_uint_min(l_nb_bands, p_job->height / OPJ_TCD_DC_SHIFT_MIN_ROWS);
+        if (l_nb_bands > 1) {
+                l_bands = (opj_tcd_dc_shift_job_t*) opj_malloc(l_nb_bands * sizeof(opj_tcd_dc_shift_job_t));
+        }
+        if (! l_bands) {
+                /* single band, or not enough memory to split: run in the caller */
+                opj_tcd_dc_level_shift_processor(p_job, 00);
+                return;
+        }
+
+        for (i = 0; i < l_nb_bands; ++i) {
+                OPJ_UINT32 l_y1 = (OPJ_UINT32)(((OPJ_UINT64)p_job->height * (i + 1)) / l_nb_bands);
+                OPJ_SIZE_T l_offset = (OPJ_SIZE_T)l_y0 * p_job->stride;
+                l_bands[i] = *p_job;
+                l_bands[i].c[0] = p_job->c[0] + l_offset;
+                if (p_job->mct) {
+                        l_bands[i].c[1] = p_job->c[1] + l_offset;
+                        l_bands[i].c[2] = p_job->c[2] + l_offset;
+                }
+                l_bands[i].height = l_y1 - l_y0;
+                if (! opj_thread_pool_submit_job(p_tcd->thread_pool, opj_tcd_dc_level_shift_processor, &l_bands[i])) {
+                        opj_tcd_dc_level_shift_processor(&l_bands[i], 00);
+                }
+                l_y0 = l_y1;
+        }
+        opj_thread_pool_wait_completion(p_tcd->thread_pool, 0);
+        opj_free(l_bands);
+}
+
+/**
+ * Sets the DC level shift and the range of a component in a job.
+ */
+static void opj_tcd_dc_level_shift_set(opj_tcd_dc_shift_job_t* p_job, OPJ_UINT32 p_index,
+                                       const opj_tccp_t* p_tccp, const opj_image_comp_t* p_img_comp)
+{
+        p_job->shift[p_index] = p_tccp->m_dc_level_shift;
+        if (p_img_comp->sgnd) {
+                p_job->min[p_index] = -(1 << (p_img_comp->prec - 1));
+                p_job->max[p_index] = (1 << (p_img_comp->prec - 1)) - 1;
+        }
+        else {
+                p_job->min[p_index] = 0;
+                p_job->max[p_index] = (1 << p_img_comp->prec) - 1;
+        }
+}
+
+OPJ_BOOL opj_tcd_mct_dc_level_shift_decode ( opj_tcd_t *p_tcd )
+{
+        OPJ_UINT32 compno = 0;
         opj_tcd_tilecomp_t * l_tile_comp = 00;
         opj_tccp_t * l_tccp = 00;
         opj_image_comp_t * l_img_comp = 00;
         opj_tcd_resolution_t* l_res = 00;
         opj_tcd_tile_t * l_tile;
-        OPJ_UINT32 l_width,l_height,i,j;
-        OPJ_INT32 * l_current_ptr;
-        OPJ_INT32 l_min, l_max;
-        OPJ_UINT32 l_stride;
+        opj_tcp_t * l_tcp = p_tcd->tcp;
+        opj_tcd_dc_shift_job_t l_job;
 
         l_tile = p_tcd->tcd_image->tiles;
         l_tile_comp = l_tile->comps;
-        l_tccp = p_tcd->tcp->tccps;
+        l_tccp = l_tcp->tccps;
         l_img_comp = p_tcd->image->comps;
 
-        for (compno = 0; compno < l_tile->numcomps; compno++) {
+        memset(&l_job, 0, sizeof(l_job));
+        l_job.kernels = p_tcd->kernels;
+
+        /* The reversible and irreversible MCT of three components with the same */
+        /* dimensions and transform are fused with the DC level shift. Other cases */
+        /* (custom MCT, inconsistent components) are handled separately. */
+        if (l_tcp->mct == 1 && l_tile->numcomps >= 3 &&
+            l_tile_comp[1].x1 - l_tile_comp[1].x0 == l_tile_comp[0].x1 - l_tile_comp[0].x0 &&
+            l_tile_comp[2].x1 - l_tile_comp[2].x0 == l_tile_comp[0].x1 - l_tile_comp[0].x0 &&
+            l_tile_comp[1].y1 - l_tile_comp[1].y0 == l_tile_comp[0].y1 - l_tile_comp[0].y0 &&
+            l_tile_comp[2].y1 - l_tile_comp[2].y0 == l_tile_comp[0].y1 - l_tile_comp[0].y0 &&
+            l_img_comp[1].resno_decoded == l_img_comp[0].resno_decoded &&
+            l_img_comp[2].resno_decoded == l_img_comp[0].resno_decoded &&
+            l_tccp[1].qmfbid == l_tccp[0].qmfbid && l_tccp[2].qmfbid == l_tccp[0].qmfbid) {
                 l_res = l_tile_comp->resolutions + l_img_comp->resno_decoded;
-                l_width = (OPJ_UINT32)(l_res->x1 - l_res->x0);
-                l_height = (OPJ_UINT32)(l_res->y1 - l_res->y0);
-                l_stride = (OPJ_UINT32)(l_tile_comp->x1 - l_tile_comp->x0) - l_width;
+                l_job.mct = OPJ_TRUE;
+                l_job.real = (l_tccp->qmfbid != 1);
+                l_job.width = (OPJ_UINT32)(l_res->x1 - l_res->x0);
+                l_job.height = (OPJ_UINT32)(l_res->y1 - l_res->y0);
+                l_job.stride = (OPJ_UINT32)(l_tile_comp->x1 - l_tile_comp->x0);
+                for (compno = 0; compno < 3; ++compno) {
+                        l_job.c[compno] = l_tile_comp[compno].data;
+                        opj_tcd_dc_level_shift_set(&l_job, compno, &l_tccp[compno], &l_img_comp[compno]);
+                }
+                opj_tcd_dc_level_shift_run(p_tcd, &l_job);
 
-                assert(l_height == 0 || l_width + l_stride <= l_tile_comp->data_size / l_height); /*MUPDF*/
+                l_tile_comp += 3;
+                l_tccp += 3;
+                l_img_comp += 3;
+        }
+        else if (! opj_tcd_mct_decode(p_tcd)) {
+                return OPJ_FALSE;
+        }
 
-                if (l_img_comp->sgnd) {
-                        l_min = -(1 << (l_img_comp->prec - 1));
-                        l_max = (1 << (l_img_comp->prec - 1)) - 1;
-                }
-                else {
-            l_min = 0;
-                        l_max = (1 << l_img_comp->prec) - 1;
-                }
+        l_job.mct = OPJ_FALSE;
+        for (; compno < l_tile->numcomps; compno++) {
+                l_res = l_tile_comp->resolutions + l_img_comp->resno_decoded;
+                l_job.real = (l_tccp->qmfbid != 1);
+                l_job.width = (OPJ_UINT32)(l_res->x1 - l_res->x0);
+                l_job.height = (OPJ_UINT32)(l_res->y1 - l_res->y0);
+                l_job.stride = (OPJ_UINT32)(l_tile_comp->x1 - l_tile_comp->x0);
 
-                l_current_ptr = l_tile_comp->data;
+                assert(l_job.height == 0 || l_job.stride <= l_tile_comp->data_size / l_job.height); /*MUPDF*/
 
-                if (l_tccp->qmfbid == 1) {
-                        for (j=0;j<l_height;++j) {
-                                for (i = 0; i < l_width; ++i) {
-                                        *l_current_ptr = opj_int_clamp(*l_current_ptr + l_tccp->m_dc_level_shift, l_min, l_max);
-                                        ++l_current_ptr;
-                                }
-                                l_current_ptr += l_stride;
-                        }
-                }
-                else {
-                        for (j=0;j<l_height;++j) {
-                                for (i = 0; i < l_width; ++i) {
-                                        OPJ_FLOAT32 l_value = *((OPJ_FLOAT32 *) l_current_ptr);
-                                        *l_current_ptr = opj_int_clamp((OPJ_INT32)lrintf(l_value) + l_tccp->m_dc_level_shift, l_min, l_max); ;
-                                        ++l_current_ptr;
-                                }
-                                l_current_ptr += l_stride;
-                        }
-                }
+                l_job.c[0] = l_tile_comp->data;
+                opj_tcd_dc_level_shift_set(&l_job, 0, l_tccp, l_img_comp);
+                opj_tcd_dc_level_shift_run(p_tcd, &l_job);
 
                 ++l_img_comp;
                 ++l_tccp;
@@ -1980,10 +2147,10 @@ OPJ_BOOL opj_tcd_mct_encode ( opj_tcd_t *p_tcd )
                 opj_free(l_data);
         }
         else if (l_tcp->tccps->qmfbid == 0) {
-                opj_mct_encode_real(l_tile->comps[0].data, l_tile->comps[1].data, l_tile->comps[2].data, samples);
+                p_tcd->kernels->mct_encode_real(l_tile->comps[0].data, l_tile->comps[1].data, l_tile->comps[2].data, samples);
         }
         else {
-                opj_mct_encode(l_tile->comps[0].data, l_tile->comps[1].data, l_tile->comps[2].data, samples);
+                p_tcd->kernels->mct_encode(l_tile->comps[0].data, l_tile->comps[1].data, l_tile->comps[2].data, samples);
         }
 
         return OPJ_TRUE;
@@ -1998,12 +2165,12 @@ OPJ_BOOL opj_tcd_dwt_encode ( opj_tcd_t *p_tcd )
 
         for (compno = 0; compno < l_tile->numcomps; ++compno) {
                 if (l_tccp->qmfbid == 1) {
-                        if (! opj_dwt_encode(l_tile_comp)) {
+                        if (! opj_dwt_encode(p_tcd->kernels, l_tile_comp)) {
                                 return OPJ_FALSE;
                         }
                 }
                 else if (l_tccp->qmfbid == 0) {
-                        if (! opj_dwt_encode_real(l_tile_comp)) {
+                        if (! opj_dwt_encode_real(p_tcd->kernels, l_tile_comp)) {
                                 return OPJ_FALSE;
                         }
                 }
@@ -2017,16 +2184,10 @@ OPJ_BOOL opj_tcd_dwt_encode ( opj_tcd_t *p_tcd )
 
 OPJ_BOOL opj_tcd_t1_encode ( opj_tcd_t *p_tcd )
 {
-        opj_t1_t * l_t1;
         const OPJ_FLOAT64 * l_mct_norms;
         OPJ_UINT32 l_mct_numcomps = 0U;
         opj_tcp_t * l_tcp = p_tcd->tcp;
 
-        l_t1 = opj_t1_create(OPJ_TRUE);
-        if (l_t1 == 00) {
-                return OPJ_FALSE;
-        }
-
         if (l_tcp->mct == 1) {
                 l_mct_numcomps = 3U;
                 /* irreversible encoding */
@@ -2042,14 +2203,7 @@ OPJ_BOOL opj_tcd_t1_encode ( opj_tcd_t *p_tcd )
                 l_mct_norms = (const OPJ_FLOAT64 *) (l_tcp->mct_norms);
         }
 
-        if (! opj_t1_encode_cblks(l_t1, p_tcd->tcd_image->tiles , l_tcp, l_mct_norms, l_mct_numcomps)) {
-        opj_t1_destroy(l_t1);
-                return OPJ_FALSE;
-        }
-
-        opj_t1_destroy(l_t1);
-
-        return OPJ_TRUE;
+        return opj_t1_encode_cblks(p_tcd->thread_pool, p_tcd->tcd_image->tiles , l_tcp, l_mct_norms, l_mct_numcomps);
 }
 
 OPJ_BOOL opj_tcd_t2_encode (opj_tcd_t *p_tcd,
@@ -2207,3 +2361,53 @@ OPJ_BOOL opj_tcd_copy_tile_data (       opj_tcd_t *p_tcd,
 
         return OPJ_TRUE;
 }
+
+OPJ_BOOL opj_tcd_is_subband_area_of_interest(	opj_tcd_t *p_tcd,
+						OPJ_UINT32 p_compno,
+						OPJ_UINT32 p_resno,
+						OPJ_UINT32 p_bandno,
+						OPJ_UINT32 p_band_x0,
+						OPJ_UINT32 p_band_y0,
+						OPJ_UINT32 p_band_x1,
+						OPJ_UINT32 p_band_y1 )
+{
+	/* Number of sub-band samples, on each side of the area, the inverse transform */
+	/* reads: one level needs 1 (5-3) or 2 (9-7) samples and, summed over all the */
+	/* coarser levels, this is less than twice as much */
+	OPJ_UINT32 l_filter_margin = (p_tcd->tcp->tccps[p_compno].qmfbid == 1) ? 2 : 4;
+	opj_tcd_tilecomp_t *l_tilec = &(p_tcd->tcd_image->tiles->comps[p_compno]);
+	opj_image_comp_t *l_img_comp = &(p_tcd->image->comps[p_compno]);
+	/* area of interest in tile component coordinates */
+	OPJ_UINT32 l_tcx0 = opj_uint_max((OPJ_UINT32)l_tilec->x0, opj_uint_ceildiv(p_tcd->win_x0, l_img_comp->dx));
+	OPJ_UINT32 l_tcy0 = opj_uint_max((OPJ_UINT32)l_tilec->y0, opj_uint_ceildiv(p_tcd->win_y0, l_img_comp->dy));
+	OPJ_UINT32 l_tcx1 = opj_uint_min((OPJ_UINT32)l_tilec->x1, opj_uint_ceildiv(p_tcd->win_x1, l_img_comp->dx));
+	OPJ_UINT32 l_tcy1 = opj_uint_min((OPJ_UINT32)l_tilec->y1, opj_uint_ceildiv(p_tcd->win_y1, l_img_comp->dy));
+	/* number of decompositions of the sub-band (table F-1) */
+	OPJ_UINT32 l_nb = (p_resno == 0) ? l_tilec->numresolutions - 1 : l_tilec->numresolutions - p_resno;
+	OPJ_UINT32 l_xob = p_bandno & 1;
+	OPJ_UINT32 l_yob = p_bandno >> 1;
+	OPJ_UINT32 l_tbx0, l_tby0, l_tbx1, l_tby1;
+
+	/* area of interest in sub-band coordinates (equation B-15) */
+	if (l_nb == 0) {
+		l_tbx0 = l_tcx0;
+		l_tby0 = l_tcy0;
+		l_tbx1 = l_tcx1;
+		l_tby1 = l_tcy1;
+	}
+	else {
+		OPJ_UINT32 l_xoff = (1U << (l_nb - 1)) * l_xob;
+		OPJ_UINT32 l_yoff = (1U << (l_nb - 1)) * l_yob;
+		l_tbx0 = (l_tcx0 <= l_xoff) ? 0 : opj_uint_ceildivpow2(l_tcx0 - l_xoff, l_nb);
+		l_tby0 = (l_tcy0 <= l_yoff) ? 0 : opj_uint_ceildivpow2(l_tcy0 - l_yoff, l_nb);
+		l_tbx1 = (l_tcx1 <= l_xoff) ? 0 : opj_uint_ceildivpow2(l_tcx1 - l_xoff, l_nb);
+		l_tby1 = (l_tcy1 <= l_yoff) ? 0 : opj_uint_ceildivpow2(l_tcy1 - l_yoff, l_nb);
+	}
+
+	l_tbx0 = (l_tbx0 < l_filter_margin) ? 0 : l_tbx0 - l_filter_margin;
+	l_tby0 = (l_tby0 < l_filter_margin) ? 0 : l_tby0 - l_filter_margin;
+	l_tbx1 = opj_uint_adds(l_tbx1, l_filter_margin);
+	l_tby1 = opj_uint_adds(l_tby1, l_filter_margin);
+
+	return p_band_x0 < l_tbx1 && p_band_y0 < l_tby1 && p_band_x1 > l_tbx0 && p_band_y1 > l_tby0;
+}
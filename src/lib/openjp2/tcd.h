@@ -69,6 +69,7 @@ FIXME DOC
 typedef struct opj_tcd_pass {
 	OPJ_UINT32 rate;
 	OPJ_FLOAT64 distortiondec;
+	OPJ_FLOAT64 distortion;		/* distortion decrease of this pass only (fixed_quality) */
 	OPJ_UINT32 len;
 	OPJ_UINT32 term : 1;
 } opj_tcd_pass_t;
@@ -220,6 +221,18 @@ typedef struct opj_tcd
 	OPJ_UINT32 tcd_tileno;
 	/** tell if the tcd is a decoder. */
 	OPJ_UINT32 m_is_decoder : 1;
+	/** thread pool used to process the code-blocks (owned by the codec) */
+	opj_thread_pool_t* thread_pool;
+	/** kernels selected for the CPU (owned by the codec) */
+	const opj_kernels_t* kernels;
+	/** area to decode, in reference grid coordinates (set by opj_tcd_decode_tile()) */
+	OPJ_UINT32 win_x0;
+	OPJ_UINT32 win_y0;
+	OPJ_UINT32 win_x1;
+	OPJ_UINT32 win_y1;
+	/** lengths of the packets of the tile, NULL if unknown (set by opj_tcd_decode_tile()) */
+	const OPJ_UINT32 *packet_lengths;
+	OPJ_UINT32 nb_packet_lengths;
 } opj_tcd_t;
 
 /** @name Exported functions */
@@ -246,15 +259,22 @@ void opj_tcd_destroy(opj_tcd_t *tcd);
 
 /**
  * Initialize the tile coder and may reuse some memory.
+ * A tile coder already initialized for an image with the same number of
+ * components keeps the structures of its last tile, which are recycled by
+ * the next opj_tcd_init_decode_tile() or opj_tcd_init_encode_tile().
  * @param	p_tcd		TCD handle.
  * @param	p_image		raw image.
  * @param	p_cp		coding parameters.
+ * @param	p_tp		thread pool used to process the code-blocks.
+ * @param	p_kernels	kernels selected for the CPU.
  *
  * @return true if the encoding values could be set (false otherwise).
 */
 OPJ_BOOL opj_tcd_init(	opj_tcd_t *p_tcd,
 						opj_image_t * p_image,
-						opj_cp_t * p_cp );
+						opj_cp_t * p_cp,
+						opj_thread_pool_t* p_tp,
+						const opj_kernels_t* p_kernels );
 
 /**
  * Allocates memory for decoding a specific tile.
@@ -267,6 +287,14 @@ OPJ_BOOL opj_tcd_init(	opj_tcd_t *p_tcd,
  */
 OPJ_BOOL opj_tcd_init_decode_tile(opj_tcd_t *p_tcd, OPJ_UINT32 p_tile_no);
 
+/**
+ * Releases the samples, resolutions, precincts and code-blocks of the current tile,
+ * which the next opj_tcd_init_decode_tile() or opj_tcd_init_encode_tile() allocates again.
+ *
+ * @param	p_tcd		the tile coder.
+ */
+void opj_tcd_release_tile(opj_tcd_t *p_tcd);
+
 void opj_tcd_makelayer_fixed(opj_tcd_t *tcd, OPJ_UINT32 layno, OPJ_UINT32 final);
 
 void opj_tcd_rateallocate_fixed(opj_tcd_t *tcd);
@@ -306,16 +334,30 @@ OPJ_BOOL opj_tcd_encode_tile(   opj_tcd_t *p_tcd,
 
 
 /**
-Decode a tile from a buffer into a raw image
+Decode a tile from a buffer into a raw image.
+Only the code-blocks that contribute to the given area are decoded: the
+samples of the tile outside of this area are not meaningful.
 @param tcd TCD handle
+@param win_x0 Left of the area to decode, in reference grid coordinates
+@param win_y0 Top of the area to decode, in reference grid coordinates
+@param win_x1 Right of the area to decode, in reference grid coordinates
+@param win_y1 Bottom of the area to decode, in reference grid coordinates
 @param src Source buffer
 @param len Length of source buffer
+@param packet_lengths Lengths of the packets of the tile, from PLT/PLM markers, or NULL
+@param nb_packet_lengths Number of packet lengths
 @param tileno Number that identifies one of the tiles to be decoded
 @param cstr_info  FIXME DOC
 */
 OPJ_BOOL opj_tcd_decode_tile(   opj_tcd_t *tcd,
+							    OPJ_UINT32 win_x0,
+							    OPJ_UINT32 win_y0,
+							    OPJ_UINT32 win_x1,
+							    OPJ_UINT32 win_y1,
 							    OPJ_BYTE *src,
 							    OPJ_UINT32 len,
+							    const OPJ_UINT32 *packet_lengths,
+							    OPJ_UINT32 nb_packet_lengths,
 							    OPJ_UINT32 tileno,
 							    opj_codestream_index_t *cstr_info);
 
@@ -357,6 +399,31 @@ OPJ_BOOL opj_tcd_copy_tile_data (opj_tcd_t *p_tcd,
  */
 OPJ_BOOL opj_alloc_tile_component_data(opj_tcd_tilecomp_t *l_tilec);
 
+/**
+ * Tells whether an area of a sub-band contributes to the area to decode
+ * (win_x0, win_y0, win_x1, win_y1) of the tile coder, taking into account
+ * the support of the inverse wavelet filters.
+ *
+ * @param	p_tcd		TCD handle.
+ * @param	p_compno	component number.
+ * @param	p_resno		resolution number.
+ * @param	p_bandno	band number (0 for the lowest resolution, 1 to 3 otherwise).
+ * @param	p_band_x0	left of the area, in sub-band coordinates.
+ * @param	p_band_y0	top of the area, in sub-band coordinates.
+ * @param	p_band_x1	right of the area, in sub-band coordinates.
+ * @param	p_band_y1	bottom of the area, in sub-band coordinates.
+ *
+ * @return true if the area is needed to decode the area of interest.
+ */
+OPJ_BOOL opj_tcd_is_subband_area_of_interest(	opj_tcd_t *p_tcd,
+						OPJ_UINT32 p_compno,
+						OPJ_UINT32 p_resno,
+						OPJ_UINT32 p_bandno,
+						OPJ_UINT32 p_band_x0,
+						OPJ_UINT32 p_band_y0,
+						OPJ_UINT32 p_band_x1,
+						OPJ_UINT32 p_band_y1 );
+
 /* ----------------------------------------------------------------------- */
 /*@}*/
 
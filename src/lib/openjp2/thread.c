@@ -0,0 +1,542 @@
+/*
+ * The copyright in this software is being made available under the 2-clauses
+ * BSD License, included below. This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such rights
+ * are granted under this license.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "opj_config_private.h"
+
+#if defined(MUTEX_win32)
+#include <windows.h>
+#include <process.h>
+#elif defined(MUTEX_pthread)
+#include <pthread.h>
+#endif
+
+#include "opj_includes.h"
+
+/* ----------------------------------------------------------------------- */
+/* Low level primitives */
+
+#if defined(MUTEX_win32)
+
+struct opj_mutex_t
+{
+	CRITICAL_SECTION cs;
+};
+
+typedef struct opj_cond_t
+{
+	CONDITION_VARIABLE cv;
+} opj_cond_t;
+
+typedef HANDLE opj_thread_handle_t;
+
+#elif defined(MUTEX_pthread)
+
+struct opj_mutex_t
+{
+	pthread_mutex_t mutex;
+};
+
+typedef struct opj_cond_t
+{
+	pthread_cond_t cond;
+} opj_cond_t;
+
+typedef pthread_t opj_thread_handle_t;
+
+#else
+
+struct opj_mutex_t
+{
+	int dummy;
+};
+
+typedef struct opj_cond_t
+{
+	int dummy;
+} opj_cond_t;
+
+typedef int opj_thread_handle_t;
+
+#endif
+
+OPJ_BOOL opj_has_thread_support(void)
+{
+#if defined(MUTEX_win32) || defined(MUTEX_pthread)
+	return OPJ_TRUE;
+#else
+	return OPJ_FALSE;
+#endif
+}
+
+opj_mutex_t* opj_mutex_create(void)
+{
+#if defined(MUTEX_win32) || defined(MUTEX_pthread)
+	opj_mutex_t* l_mutex = (opj_mutex_t*) opj_malloc(sizeof(opj_mutex_t));
+	if (! l_mutex) {
+		return 00;
+	}
+#if defined(MUTEX_win32)
+	InitializeCriticalSection(&l_mutex->cs);
+#else
+	if (pthread_mutex_init(&l_mutex->mutex, NULL) != 0) {
+		opj_free(l_mutex);
+		return 00;
+	}
+#endif
+	return l_mutex;
+#else
+	return 00;
+#endif
+}
+
+void opj_mutex_lock(opj_mutex_t* p_mutex)
+{
+	if (! p_mutex) {
+		return;
+	}
+#if defined(MUTEX_win32)
+	EnterCriticalSection(&p_mutex->cs);
+#elif defined(MUTEX_pthread)
+	pthread_mutex_lock(&p_mutex->mutex);
+#endif
+}
+
+void opj_mutex_unlock(opj_mutex_t* p_mutex)
+{
+	if (! p_mutex) {
+		return;
+	}
+#if defined(MUTEX_win32)
+	LeaveCriticalSection(&p_mutex->cs);
+#elif defined(MUTEX_pthread)
+	pthread_mutex_unlock(&p_mutex->mutex);
+#endif
+}
+
+void opj_mutex_destroy(opj_mutex_t* p_mutex)
+{
+	if (! p_mutex) {
+		return;
+	}
+#if defined(MUTEX_win32)
+	DeleteCriticalSection(&p_mutex->cs);
+#elif defined(MUTEX_pthread)
+	pthread_mutex_destroy(&p_mutex->mutex);
+#endif
+	opj_free(p_mutex);
+}
+
+static OPJ_BOOL opj_cond_init(opj_cond_t* p_cond)
+{
+#if defined(MUTEX_win32)
+	InitializeConditionVariable(&p_cond->cv);
+	return OPJ_TRUE;
+#elif defined(MUTEX_pthread)
+	return pthread_cond_init(&p_cond->cond, NULL) == 0;
+#else
+	(void)p_cond;
+	return OPJ_FALSE;
+#endif
+}
+
+/* The mutex must be locked by the caller */
+static void opj_cond_wait(opj_cond_t* p_cond, opj_mutex_t* p_mutex)
+{
+#if defined(MUTEX_win32)
+	SleepConditionVariableCS(&p_cond->cv, &p_mutex->cs, INFINITE);
+#elif defined(MUTEX_pthread)
+	pthread_cond_wait(&p_cond->cond, &p_mutex->mutex);
+#else
+	(void)p_cond;
+	(void)p_mutex;
+#endif
+}
+
+static void opj_cond_broadcast(opj_cond_t* p_cond)
+{
+#if defined(MUTEX_win32)
+	WakeAllConditionVariable(&p_cond->cv);
+#elif defined(MUTEX_pthread)
+	pthread_cond_broadcast(&p_cond->cond);
+#else
+	(void)p_cond;
+#endif
+}
+
+static void opj_cond_destroy(opj_cond_t* p_cond)
+{
+#if defined(MUTEX_pthread)
+	pthread_cond_destroy(&p_cond->cond);
+#else
+	(void)p_cond;
+#endif
+}
+
+/* ----------------------------------------------------------------------- */
+/* Thread local storage */
+
+typedef struct opj_tls_key_val_t
+{
+	int key;
+	void* value;
+	opj_tls_free_func free_func;
+} opj_tls_key_val_t;
+
+struct opj_tls_t
+{
+	opj_tls_key_val_t* key_val;
+	int key_val_count;
+};
+
+static opj_tls_t* opj_tls_new(void)
+{
+	return (opj_tls_t*) opj_calloc(1, sizeof(opj_tls_t));
+}
+
+static void opj_tls_destroy(opj_tls_t* p_tls)
+{
+	int i;
+	if (! p_tls) {
+		return;
+	}
+	for (i = 0; i < p_tls->key_val_count; ++i) {
+		if (p_tls->key_val[i].free_func) {
+			p_tls->key_val[i].free_func(p_tls->key_val[i].value);
+		}
+	}
+	opj_free(p_tls->key_val);
+	opj_free(p_tls);
+}
+
+void* opj_tls_get(opj_tls_t* p_tls, int p_key)
+{
+	int i;
+	for (i = 0; i < p_tls->key_val_count; ++i) {
+		if (p_tls->key_val[i].key == p_key) {
+			return p_tls->key_val[i].value;
+		}
+	}
+	return 00;
+}
+
+OPJ_BOOL opj_tls_set(opj_tls_t* p_tls, int p_key, void* p_value, opj_tls_free_func p_free_func)
+{
+	opj_tls_key_val_t* l_new_key_val;
+	int i;
+
+	for (i = 0; i < p_tls->key_val_count; ++i) {
+		if (p_tls->key_val[i].key == p_key) {
+			if (p_tls->key_val[i].free_func) {
+				p_tls->key_val[i].free_func(p_tls->key_val[i].value);
+			}
+			p_tls->key_val[i].value = p_value;
+			p_tls->key_val[i].free_func = p_free_func;
+			return OPJ_TRUE;
+		}
+	}
+
+	l_new_key_val = (opj_tls_key_val_t*) opj_realloc(p_tls->key_val,
+	                   ((OPJ_SIZE_T)p_tls->key_val_count + 1U) * sizeof(opj_tls_key_val_t));
+	if (! l_new_key_val) {
+		return OPJ_FALSE;
+	}
+	p_tls->key_val = l_new_key_val;
+	l_new_key_val[p_tls->key_val_count].key = p_key;
+	l_new_key_val[p_tls->key_val_count].value = p_value;
+	l_new_key_val[p_tls->key_val_count].free_func = p_free_func;
+	p_tls->key_val_count ++;
+	return OPJ_TRUE;
+}
+
+/* ----------------------------------------------------------------------- */
+/* Thread pool */
+
+typedef struct opj_job_t
+{
+	opj_job_fn job_fn;
+	void* user_data;
+	struct opj_job_t* next;
+} opj_job_t;
+
+typedef struct opj_worker_thread_t
+{
+	opj_thread_pool_t* tp;
+	opj_thread_handle_t thread;
+	opj_tls_t* tls;
+} opj_worker_thread_t;
+
+struct opj_thread_pool_t
+{
+	/** worker threads (NULL if jobs are run by the caller) */
+	opj_worker_thread_t* worker_threads;
+	/** number of worker threads */
+	int worker_threads_count;
+	/** thread local storage of the caller, for synchronous jobs */
+	opj_tls_t* caller_tls;
+	/** protects all the fields below */
+	opj_mutex_t* mutex;
+	/** signaled when a job is queued or when the pool is stopped */
+	opj_cond_t job_cond;
+	/** signaled when a job is completed */
+	opj_cond_t done_cond;
+	/** FIFO of queued jobs */
+	opj_job_t* job_queue_head;
+	opj_job_t* job_queue_tail;
+	/** number of queued or running jobs */
+	int pending_jobs_count;
+	/** set to request the worker threads to exit */
+	OPJ_BOOL stop;
+};
+
+#if defined(MUTEX_win32) || defined(MUTEX_pthread)
+
+static void opj_worker_thread_run(opj_worker_thread_t* p_worker)
+{
+	opj_thread_pool_t* l_tp = p_worker->tp;
+
+	for (;;) {
+		opj_job_t* l_job;
+
+		opj_mutex_lock(l_tp->mutex);
+		while (l_tp->job_queue_head == 00 && ! l_tp->stop) {
+			opj_cond_wait(&l_tp->job_cond, l_tp->mutex);
+		}
+		l_job = l_tp->job_queue_head;
+		if (! l_job) {
+			/* stop requested and no more job */
+			opj_mutex_unlock(l_tp->mutex);
+			break;
+		}
+		l_tp->job_queue_head = l_job->next;
+		if (! l_tp->job_queue_head) {
+			l_tp->job_queue_tail = 00;
+		}
+		opj_mutex_unlock(l_tp->mutex);
+
+		l_job->job_fn(l_job->user_data, p_worker->tls);
+		opj_free(l_job);
+
+		opj_mutex_lock(l_tp->mutex);
+		l_tp->pending_jobs_count --;
+		opj_cond_broadcast(&l_tp->done_cond);
+		opj_mutex_unlock(l_tp->mutex);
+	}
+}
+
+#if defined(MUTEX_win32)
+static unsigned __stdcall opj_worker_thread_function(void* p_user_data)
+{
+	opj_worker_thread_run((opj_worker_thread_t*) p_user_data);
+	return 0;
+}
+#else
+static void* opj_worker_thread_function(void* p_user_data)
+{
+	opj_worker_thread_run((opj_worker_thread_t*) p_user_data);
+	return 00;
+}
+#endif
+
+static OPJ_BOOL opj_thread_create(opj_worker_thread_t* p_worker)
+{
+#if defined(MUTEX_win32)
+	p_worker->thread = (HANDLE) _beginthreadex(NULL, 0, opj_worker_thread_function, p_worker, 0, NULL);
+	return p_worker->thread != NULL;
+#else
+	return pthread_create(&p_worker->thread, NULL, opj_worker_thread_function, p_worker) == 0;
+#endif
+}
+
+static void opj_thread_join(opj_worker_thread_t* p_worker)
+{
+#if defined(MUTEX_win32)
+	WaitForSingleObject(p_worker->thread, INFINITE);
+	CloseHandle(p_worker->thread);
+#else
+	void* l_status;
+	pthread_join(p_worker->thread, &l_status);
+#endif
+}
+
+#endif /* MUTEX_win32 || MUTEX_pthread */
+
+static OPJ_BOOL opj_thread_pool_setup(opj_thread_pool_t* p_tp, int p_num_threads)
+{
+#if defined(MUTEX_win32) || defined(MUTEX_pthread)
+	int i;
+
+	p_tp->mutex = opj_mutex_create();
+	if (! p_tp->mutex) {
+		return OPJ_FALSE;
+	}
+	if (! opj_cond_init(&p_tp->job_cond)) {
+		return OPJ_FALSE;
+	}
+	if (! opj_cond_init(&p_tp->done_cond)) {
+		opj_cond_destroy(&p_tp->job_cond);
+		return OPJ_FALSE;
+	}
+
+	p_tp->worker_threads = (opj_worker_thread_t*) opj_calloc((OPJ_SIZE_T)p_num_threads, sizeof(opj_worker_thread_t));
+	if (! p_tp->worker_threads) {
+		return OPJ_FALSE;
+	}
+
+	for (i = 0; i < p_num_threads; ++i) {
+		opj_worker_thread_t* l_worker = &p_tp->worker_threads[i];
+		l_worker->tp = p_tp;
+		l_worker->tls = opj_tls_new();
+		if (! l_worker->tls || ! opj_thread_create(l_worker)) {
+			opj_tls_destroy(l_worker->tls);
+			l_worker->tls = 00;
+			break;
+		}
+		p_tp->worker_threads_count ++;
+	}
+	return p_tp->worker_threads_count == p_num_threads;
+#else
+	(void)p_tp;
+	(void)p_num_threads;
+	return OPJ_FALSE;
+#endif
+}
+
+opj_thread_pool_t* opj_thread_pool_create(int p_num_threads)
+{
+	opj_thread_pool_t* l_tp = (opj_thread_pool_t*) opj_calloc(1, sizeof(opj_thread_pool_t));
+	if (! l_tp) {
+		return 00;
+	}
+	l_tp->caller_tls = opj_tls_new();
+	if (! l_tp->caller_tls) {
+		opj_free(l_tp);
+		return 00;
+	}
+
+	if (p_num_threads >= 2 && opj_has_thread_support()) {
+		if (! opj_thread_pool_setup(l_tp, p_num_threads)) {
+			opj_thread_pool_destroy(l_tp);
+			return 00;
+		}
+	}
+
+	return l_tp;
+}
+
+OPJ_BOOL opj_thread_pool_submit_job(opj_thread_pool_t* p_tp, opj_job_fn p_job_fn, void* p_user_data)
+{
+	opj_job_t* l_job;
+
+	if (p_tp->worker_threads_count == 0) {
+		p_job_fn(p_user_data, p_tp->caller_tls);
+		return OPJ_TRUE;
+	}
+
+	l_job = (opj_job_t*) opj_malloc(sizeof(opj_job_t));
+	if (! l_job) {
+		return OPJ_FALSE;
+	}
+	l_job->job_fn = p_job_fn;
+	l_job->user_data = p_user_data;
+	l_job->next = 00;
+
+	opj_mutex_lock(p_tp->mutex);
+	if (p_tp->job_queue_tail) {
+		p_tp->job_queue_tail->next = l_job;
+	}
+	else {
+		p_tp->job_queue_head = l_job;
+	}
+	p_tp->job_queue_tail = l_job;
+	p_tp->pending_jobs_count ++;
+	opj_cond_broadcast(&p_tp->job_cond);
+	opj_mutex_unlock(p_tp->mutex);
+
+	return OPJ_TRUE;
+}
+
+void opj_thread_pool_wait_completion(opj_thread_pool_t* p_tp, int p_max_remaining_jobs)
+{
+	if (p_tp->worker_threads_count == 0) {
+		return;
+	}
+	if (p_max_remaining_jobs < 0) {
+		p_max_remaining_jobs = 0;
+	}
+	opj_mutex_lock(p_tp->mutex);
+	while (p_tp->pending_jobs_count > p_max_remaining_jobs) {
+		opj_cond_wait(&p_tp->done_cond, p_tp->mutex);
+	}
+	opj_mutex_unlock(p_tp->mutex);
+}
+
+int opj_thread_pool_get_thread_count(opj_thread_pool_t* p_tp)
+{
+	return p_tp->worker_threads_count;
+}
+
+opj_tls_t* opj_thread_pool_get_caller_tls(opj_thread_pool_t* p_tp)
+{
+	return p_tp->caller_tls;
+}
+
+void opj_thread_pool_destroy(opj_thread_pool_t* p_tp)
+{
+	if (! p_tp) {
+		return;
+	}
+
+#if defined(MUTEX_win32) || defined(MUTEX_pthread)
+	if (p_tp->worker_threads) {
+		int i;
+
+		if (p_tp->worker_threads_count > 0) {
+			opj_thread_pool_wait_completion(p_tp, 0);
+
+			opj_mutex_lock(p_tp->mutex);
+			p_tp->stop = OPJ_TRUE;
+			opj_cond_broadcast(&p_tp->job_cond);
+			opj_mutex_unlock(p_tp->mutex);
+		}
+
+		for (i = 0; i < p_tp->worker_threads_count; ++i) {
+			opj_thread_join(&p_tp->worker_threads[i]);
+			opj_tls_destroy(p_tp->worker_threads[i].tls);
+		}
+		opj_free(p_tp->worker_threads);
+		opj_cond_destroy(&p_tp->job_cond);
+		opj_cond_destroy(&p_tp->done_cond);
+	}
+	opj_mutex_destroy(p_tp->mutex);
+#endif
+
+	opj_tls_destroy(p_tp->caller_tls);
+	opj_free(p_tp);
+}
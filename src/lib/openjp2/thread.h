@@ -0,0 +1,211 @@
+/*
+ * The copyright in this software is being made available under the 2-clauses
+ * BSD License, included below. This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such rights
+ * are granted under this license.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __THREAD_H
+#define __THREAD_H
+
+/**
+@file thread.h
+@brief Thread API
+
+The functions in thread.c implement a portable thread pool (POSIX threads or
+Win32 threads) used to run the independent jobs of the codec (code-blocks,
+tiles) concurrently. When the library is built without thread support, or
+when a pool is created with less than two threads, jobs are run synchronously
+by the caller.
+*/
+
+/** @defgroup THREAD THREAD - Thread pool */
+/*@{*/
+
+/* ----------------------------------------------------------------------- */
+
+/**
+ * Opaque type for a mutex
+ */
+typedef struct opj_mutex_t opj_mutex_t;
+
+/**
+ * Creates a mutex.
+ *
+ * @return the new mutex, or NULL in case of error (or if threads are not supported)
+ */
+opj_mutex_t* opj_mutex_create(void);
+
+/**
+ * Locks a mutex. Does nothing if p_mutex is NULL.
+ *
+ * @param p_mutex the mutex to lock.
+ */
+void opj_mutex_lock(opj_mutex_t* p_mutex);
+
+/**
+ * Unlocks a mutex. Does nothing if p_mutex is NULL.
+ *
+ * @param p_mutex the mutex to unlock.
+ */
+void opj_mutex_unlock(opj_mutex_t* p_mutex);
+
+/**
+ * Destroys a mutex. Does nothing if p_mutex is NULL.
+ *
+ * @param p_mutex the mutex to destroy.
+ */
+void opj_mutex_destroy(opj_mutex_t* p_mutex);
+
+/**
+ * Thread local storage of a worker, used by jobs to keep per-thread scratch
+ * objects (T1 handles, ...) alive across the jobs run by the same worker.
+ */
+typedef struct opj_tls_t opj_tls_t;
+
+/**
+ * Function used to free a value stored in the thread local storage.
+ */
+typedef void (*opj_tls_free_func)(void* p_value);
+
+/**
+ * Gets a value from the thread local storage.
+ *
+ * @param p_tls   thread local storage handle.
+ * @param p_key   key of the value.
+ *
+ * @return the value associated with p_key, or NULL.
+ */
+void* opj_tls_get(opj_tls_t* p_tls, int p_key);
+
+/**
+ * Sets a value in the thread local storage. A previous value associated with
+ * the same key is freed with its own free function.
+ *
+ * @param p_tls       thread local storage handle.
+ * @param p_key       key of the value.
+ * @param p_value     value to store.
+ * @param p_free_func function used to free p_value when the storage is destroyed (may be NULL).
+ *
+ * @return OPJ_TRUE in case of success.
+ */
+OPJ_BOOL opj_tls_set(opj_tls_t* p_tls, int p_key, void* p_value, opj_tls_free_func p_free_func);
+
+/** Key used to store the per-thread decoding T1 handle */
+#define OPJ_TLS_KEY_T1_DEC      0
+/** Key used to store the per-thread encoding T1 handle */
+#define OPJ_TLS_KEY_T1_ENC      1
+/** Key used to store the thread pool (without thread) used by a tile job */
+#define OPJ_TLS_KEY_TILE_TP     2
+/** Key used to store the tile decoder recycled by the tile jobs of a thread */
+#define OPJ_TLS_KEY_TILE_TCD_DEC 3
+/** Key used to store the tile encoder recycled by the tile jobs of a thread */
+#define OPJ_TLS_KEY_TILE_TCD_ENC 4
+
+/**
+ * Opaque type for a thread pool
+ */
+typedef struct opj_thread_pool_t opj_thread_pool_t;
+
+/**
+ * Job function.
+ *
+ * @param p_user_data user data given to opj_thread_pool_submit_job().
+ * @param p_tls       thread local storage of the worker running the job.
+ */
+typedef void (*opj_job_fn)(void* p_user_data, opj_tls_t* p_tls);
+
+/**
+ * Creates a thread pool.
+ *
+ * @param p_num_threads number of worker threads. If less than 2, or if the
+ *                      library was built without thread support, jobs are
+ *                      run synchronously in opj_thread_pool_submit_job().
+ *
+ * @return the new thread pool, or NULL in case of error.
+ */
+opj_thread_pool_t* opj_thread_pool_create(int p_num_threads);
+
+/**
+ * Submits a new job to the thread pool. The job function must not submit
+ * jobs to the same pool and wait for them, as that could dead-lock the pool.
+ *
+ * @param p_tp        the thread pool.
+ * @param p_job_fn    the job function.
+ * @param p_user_data user data given to the job function.
+ *
+ * @return OPJ_TRUE in case of success.
+ */
+OPJ_BOOL opj_thread_pool_submit_job(opj_thread_pool_t* p_tp, opj_job_fn p_job_fn, void* p_user_data);
+
+/**
+ * Waits until the number of pending (queued or running) jobs is at most
+ * p_max_remaining_jobs.
+ *
+ * @param p_tp                 the thread pool.
+ * @param p_max_remaining_jobs maximum number of jobs that may still be pending.
+ */
+void opj_thread_pool_wait_completion(opj_thread_pool_t* p_tp, int p_max_remaining_jobs);
+
+/**
+ * Gets the number of worker threads of a pool.
+ *
+ * @param p_tp the thread pool.
+ *
+ * @return the number of worker threads, 0 if jobs are run synchronously.
+ */
+int opj_thread_pool_get_thread_count(opj_thread_pool_t* p_tp);
+
+/**
+ * Gets the thread local storage used for the jobs run synchronously by the
+ * caller of a pool without worker threads.
+ *
+ * @param p_tp the thread pool.
+ *
+ * @return the thread local storage of the caller.
+ */
+opj_tls_t* opj_thread_pool_get_caller_tls(opj_thread_pool_t* p_tp);
+
+/**
+ * Destroys a thread pool, after having waited for all its jobs to be completed.
+ *
+ * @param p_tp the thread pool (may be NULL).
+ */
+void opj_thread_pool_destroy(opj_thread_pool_t* p_tp);
+
+/**
+ * Tells whether the library was built with thread support.
+ *
+ * @return OPJ_TRUE if threads are supported.
+ */
+OPJ_BOOL opj_has_thread_support(void);
+
+/* ----------------------------------------------------------------------- */
+/*@}*/
+
+/*@}*/
+
+#endif /* __THREAD_H */
@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2016, OpenJPEG contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Micro-benchmark of the decoding of a highly compressed image.
+ *
+ * A smooth synthetic image is encoded at a high compression ratio, so that
+ * most code-blocks of the high-frequency sub-bands are almost entirely
+ * insignificant and their clean-up passes are dominated by run-length
+ * symbols. The codestream is then decoded several times and the best time
+ * is reported.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+#include "opj_config.h"
+#include "openjpeg.h"
+
+/* -------------------------------------------------------------------------- */
+
+/**
+sample error debug callback expecting no client object
+*/
+static void error_callback(const char *msg, void *client_data) {
+	(void)client_data;
+	fprintf(stdout, "[ERROR] %s", msg);
+}
+/**
+sample warning debug callback expecting no client object
+*/
+static void warning_callback(const char *msg, void *client_data) {
+	(void)client_data;
+	fprintf(stdout, "[WARNING] %s", msg);
+}
+
+/* -------------------------------------------------------------------------- */
+
+static OPJ_BOOL encode_sparse_image(const char *output_file,
+                                    OPJ_UINT32 image_width,
+                                    OPJ_UINT32 image_height,
+                                    float ratio)
+{
+	opj_cparameters_t l_param;
+	opj_image_cmptparm_t l_cmptparm;
+	opj_image_t * l_image;
+	opj_codec_t * l_codec;
+	opj_stream_t * l_stream;
+	OPJ_UINT32 i, j;
+	OPJ_BOOL l_ok;
+
+	memset(&l_cmptparm, 0, sizeof(l_cmptparm));
+	l_cmptparm.dx = 1;
+	l_cmptparm.dy = 1;
+	l_cmptparm.w = image_width;
+	l_cmptparm.h = image_height;
+	l_cmptparm.prec = 8;
+	l_cmptparm.bpp = 8;
+	l_cmptparm.sgnd = 0;
+
+	l_image = opj_image_create(1, &l_cmptparm, OPJ_CLRSPC_GRAY);
+	if (! l_image) {
+		return OPJ_FALSE;
+	}
+	l_image->x0 = 0;
+	l_image->y0 = 0;
+	l_image->x1 = image_width;
+	l_image->y1 = image_height;
+
+	/* a slow gradient with a few soft ripples: nearly all the energy lands in the lowest band */
+	for (j = 0; j < image_height; ++j) {
+		for (i = 0; i < image_width; ++i) {
+			double l_v = 64.0 + 96.0 * (double)(i + j) / (double)(image_width + image_height)
+			             + 24.0 * sin((double)i / 97.0) * cos((double)j / 131.0);
+			l_image->comps[0].data[j * image_width + i] = (OPJ_INT32)l_v;
+		}
+	}
+
+	opj_set_default_encoder_parameters(&l_param);
+	l_param.tcp_numlayers = 1;
+	l_param.tcp_rates[0] = ratio;
+	l_param.cp_disto_alloc = 1;
+	l_param.irreversible = 1;
+	l_param.numresolution = 6;
+
+	l_codec = opj_create_compress(OPJ_CODEC_J2K);
+	if (! l_codec) {
+		opj_image_destroy(l_image);
+		return OPJ_FALSE;
+	}
+	opj_set_warning_handler(l_codec, warning_callback, 00);
+	opj_set_error_handler(l_codec, error_callback, 00);
+
+	l_stream = NULL;
+	l_ok = opj_setup_encoder(l_codec, &l_param, l_image);
+	if (l_ok) {
+		l_stream = opj_stream_create_default_file_stream(output_file, OPJ_FALSE);
+		l_ok = (l_stream != NULL);
+	}
+	l_ok = l_ok && opj_start_compress(l_codec, l_image, l_stream)
+	            && opj_encode(l_codec, l_stream)
+	            && opj_end_compress(l_codec, l_stream);
+
+	if (l_stream) {
+		opj_stream_destroy(l_stream);
+	}
+	opj_destroy_codec(l_codec);
+	opj_image_destroy(l_image);
+	return l_ok;
+}
+
+static OPJ_BOOL decode_once(const char *input_file, double *p_seconds)
+{
+	opj_dparameters_t l_param;
+	opj_codec_t * l_codec;
+	opj_stream_t * l_stream;
+	opj_image_t * l_image = NULL;
+	clock_t l_start;
+	OPJ_BOOL l_ok;
+
+	l_stream = opj_stream_create_default_file_stream(input_file, OPJ_TRUE);
+	if (! l_stream) {
+		return OPJ_FALSE;
+	}
+	l_codec = opj_create_decompress(OPJ_CODEC_J2K);
+	if (! l_codec) {
+		opj_stream_destroy(l_stream);
+		return OPJ_FALSE;
+	}
+	opj_set_warning_handler(l_codec, warning_callback, 00);
+	opj_set_error_handler(l_codec, error_callback, 00);
+
+	opj_set_default_decoder_parameters(&l_param);
+
+	l_start = clock();
+	l_ok = opj_setup_decoder(l_codec, &l_param)
+	    && opj_read_header(l_stream, l_codec, &l_image)
+	    && opj_decode(l_codec, l_stream, l_image)
+	    && opj_end_decompress(l_codec, l_stream);
+	*p_seconds = (double)(clock() - l_start) / CLOCKS_PER_SEC;
+
+	opj_stream_destroy(l_stream);
+	opj_destroy_codec(l_codec);
+	if (l_image) {
+		opj_image_destroy(l_image);
+	}
+	return l_ok;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int main(int argc, char *argv[])
+{
+	OPJ_UINT32 image_width = 2048;
+	OPJ_UINT32 image_height = 2048;
+	float ratio = 400.0f;
+	int iterations = 10;
+	const char *output_file = "bench_sparse_decode.j2k";
+	double l_best = -1.0;
+	int i;
+
+	/* should be bench_sparse_decode [width height ratio iterations] */
+	if (argc == 5) {
+		image_width = (OPJ_UINT32)atoi(argv[1]);
+		image_height = (OPJ_UINT32)atoi(argv[2]);
+		ratio = (float)atof(argv[3]);
+		iterations = atoi(argv[4]);
+	} else if (argc != 1) {
+		fprintf(stderr, "Usage: %s [width height ratio iterations]\n", argv[0]);
+		return 1;
+	}
+	if (image_width == 0 || image_height == 0 || ratio <= 1.0f || iterations <= 0) {
+		fprintf(stderr, "ERROR -> bench_sparse_decode: invalid arguments\n");
+		return 1;
+	}
+
+	if (! encode_sparse_image(output_file, image_width, image_height, ratio)) {
+		fprintf(stderr, "ERROR -> bench_sparse_decode: failed to encode %s\n", output_file);
+		return 1;
+	}
+
+	for (i = 0; i < iterations; ++i) {
+		double l_seconds;
+		if (! decode_once(output_file, &l_seconds)) {
+			fprintf(stderr, "ERROR -> bench_sparse_decode: failed to decode %s\n", output_file);
+			return 1;
+		}
+		if (l_best < 0.0 || l_seconds < l_best) {
+			l_best = l_seconds;
+		}
+	}
+
+	fprintf(stdout, "%ux%u at %g:1, best of %d decodes: %.3f ms\n",
+	        image_width, image_height, (double)ratio, iterations, l_best * 1000.0);
+	return 0;
+}
@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2016, OpenJPEG contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Round trip through memory streams.
+ *
+ * A synthetic image is losslessly encoded into a memory output stream, starting
+ * with a buffer small enough to be grown several times. The codestream is then
+ * decoded from a memory stream over the encoded bytes, and the decoded samples
+ * must be those of the image.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "opj_config.h"
+#include "openjpeg.h"
+
+/* -------------------------------------------------------------------------- */
+
+/**
+sample error debug callback expecting no client object
+*/
+static void error_callback(const char *msg, void *client_data) {
+	(void)client_data;
+	fprintf(stdout, "[ERROR] %s", msg);
+}
+/**
+sample warning debug callback expecting no client object
+*/
+static void warning_callback(const char *msg, void *client_data) {
+	(void)client_data;
+	fprintf(stdout, "[WARNING] %s", msg);
+}
+
+/* -------------------------------------------------------------------------- */
+
+static opj_image_t * create_image(OPJ_UINT32 image_width, OPJ_UINT32 image_height)
+{
+	opj_image_cmptparm_t l_cmptparm[3];
+	opj_image_t * l_image;
+	OPJ_UINT32 i, j, c;
+
+	memset(l_cmptparm, 0, sizeof(l_cmptparm));
+	for (c = 0; c < 3; ++c) {
+		l_cmptparm[c].dx = 1;
+		l_cmptparm[c].dy = 1;
+		l_cmptparm[c].w = image_width;
+		l_cmptparm[c].h = image_height;
+		l_cmptparm[c].prec = 8;
+		l_cmptparm[c].bpp = 8;
+		l_cmptparm[c].sgnd = 0;
+	}
+
+	l_image = opj_image_create(3, l_cmptparm, OPJ_CLRSPC_SRGB);
+	if (! l_image) {
+		return NULL;
+	}
+	l_image->x0 = 0;
+	l_image->y0 = 0;
+	l_image->x1 = image_width;
+	l_image->y1 = image_height;
+
+	for (c = 0; c < 3; ++c) {
+		for (j = 0; j < image_height; ++j) {
+			for (i = 0; i < image_width; ++i) {
+				l_image->comps[c].data[j * image_width + i] = (OPJ_INT32)((i * (c + 1) + j * 3 + (i ^ j)) & 0xff);
+			}
+		}
+	}
+	return l_image;
+}
+
+static opj_stream_t * encode_image(opj_image_t * p_image, OPJ_CODEC_FORMAT p_format)
+{
+	opj_cparameters_t l_param;
+	opj_codec_t * l_codec;
+	opj_stream_t * l_stream;
+	OPJ_BOOL l_ok;
+
+	opj_set_default_encoder_parameters(&l_param);
+	l_param.tcp_numlayers = 1;
+	l_param.tcp_rates[0] = 0;
+	l_param.cp_disto_alloc = 1;
+	l_param.tcp_mct = 1;
+	l_param.tile_size_on = OPJ_TRUE;
+	l_param.cp_tdx = 128;
+	l_param.cp_tdy = 128;
+
+	l_codec = opj_create_compress(p_format);
+	if (! l_codec) {
+		return NULL;
+	}
+	opj_set_warning_handler(l_codec, warning_callback, 00);
+	opj_set_error_handler(l_codec, error_callback, 00);
+
+	/* a small initial buffer, to grow it while encoding */
+	l_stream = opj_stream_create_memory_output_stream(1024);
+	l_ok = (l_stream != NULL)
+	    && opj_setup_encoder(l_codec, &l_param, p_image)
+	    && opj_start_compress(l_codec, p_image, l_stream)
+	    && opj_encode(l_codec, l_stream)
+	    && opj_end_compress(l_codec, l_stream);
+
+	opj_destroy_codec(l_codec);
+	if (! l_ok && l_stream) {
+		opj_stream_destroy(l_stream);
+		l_stream = NULL;
+	}
+	return l_stream;
+}
+
+static OPJ_BOOL decode_and_compare(const OPJ_BYTE * p_data, OPJ_SIZE_T p_size,
+                                   OPJ_CODEC_FORMAT p_format, const opj_image_t * p_ref)
+{
+	opj_dparameters_t l_param;
+	opj_codec_t * l_codec;
+	opj_stream_t * l_stream;
+	opj_image_t * l_image = NULL;
+	OPJ_UINT32 c;
+	OPJ_BOOL l_ok;
+
+	l_stream = opj_stream_create_memory_stream(p_data, p_size);
+	if (! l_stream) {
+		return OPJ_FALSE;
+	}
+	l_codec = opj_create_decompress(p_format);
+	if (! l_codec) {
+		opj_stream_destroy(l_stream);
+		return OPJ_FALSE;
+	}
+	opj_set_warning_handler(l_codec, warning_callback, 00);
+	opj_set_error_handler(l_codec, error_callback, 00);
+
+	opj_set_default_decoder_parameters(&l_param);
+
+	l_ok = opj_setup_decoder(l_codec, &l_param)
+	    && opj_read_header(l_stream, l_codec, &l_image)
+	    && opj_decode(l_codec, l_stream, l_image)
+	    && opj_end_decompress(l_codec, l_stream);
+
+	if (l_ok && l_image->numcomps != p_ref->numcomps) {
+		fprintf(stderr, "ERROR -> test_memory_stream: %u components decoded instead of %u\n",
+		        l_image->numcomps, p_ref->numcomps);
+		l_ok = OPJ_FALSE;
+	}
+	for (c = 0; l_ok && c < p_ref->numcomps; ++c) {
+		if (l_image->comps[c].w != p_ref->comps[c].w || l_image->comps[c].h != p_ref->comps[c].h
+		    || memcmp(l_image->comps[c].data, p_ref->comps[c].data,
+		              (size_t)p_ref->comps[c].w * p_ref->comps[c].h * sizeof(OPJ_INT32)) != 0) {
+			fprintf(stderr, "ERROR -> test_memory_stream: component %u differs from the image encoded\n", c);
+			l_ok = OPJ_FALSE;
+		}
+	}
+
+	opj_stream_destroy(l_stream);
+	opj_destroy_codec(l_codec);
+	if (l_image) {
+		opj_image_destroy(l_image);
+	}
+	return l_ok;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int main(int argc, char *argv[])
+{
+	OPJ_CODEC_FORMAT l_format = OPJ_CODEC_J2K;
+	opj_image_t * l_image;
+	opj_image_t * l_ref_image;
+	opj_stream_t * l_stream;
+	const OPJ_BYTE * l_data;
+	OPJ_SIZE_T l_size = 0;
+	int l_ret = 0;
+
+	/* should be test_memory_stream [j2k|jp2] */
+	if (argc == 2 && strcmp(argv[1], "jp2") == 0) {
+		l_format = OPJ_CODEC_JP2;
+	} else if (argc != 1 && ! (argc == 2 && strcmp(argv[1], "j2k") == 0)) {
+		fprintf(stderr, "Usage: %s [j2k|jp2]\n", argv[0]);
+		return 1;
+	}
+
+	/* the encoder takes the samples of the image it encodes: compare with a copy */
+	l_image = create_image(320, 200);
+	l_ref_image = create_image(320, 200);
+	if (! l_image || ! l_ref_image) {
+		fprintf(stderr, "ERROR -> test_memory_stream: failed to create the image\n");
+		if (l_image) {
+			opj_image_destroy(l_image);
+		}
+		if (l_ref_image) {
+			opj_image_destroy(l_ref_image);
+		}
+		return 1;
+	}
+
+	l_stream = encode_image(l_image, l_format);
+	opj_image_destroy(l_image);
+	if (! l_stream) {
+		fprintf(stderr, "ERROR -> test_memory_stream: failed to encode the image\n");
+		opj_image_destroy(l_ref_image);
+		return 1;
+	}
+
+	l_data = opj_stream_get_memory_data(l_stream, &l_size);
+	if (! l_data || l_size == 0) {
+		fprintf(stderr, "ERROR -> test_memory_stream: no data in the memory stream\n");
+		l_ret = 1;
+	}
+	else if (! decode_and_compare(l_data, l_size, l_format, l_ref_image)) {
+		fprintf(stderr, "ERROR -> test_memory_stream: failed to decode the %lu bytes encoded\n", (unsigned long)l_size);
+		l_ret = 1;
+	}
+
+	opj_stream_destroy(l_stream);
+	opj_image_destroy(l_ref_image);
+	return l_ret;
+}